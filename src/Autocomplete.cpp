@@ -39,6 +39,14 @@
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
 #include <wx/utils.h>
+#include <wx/bufstrm.h>
+#include <wx/datstrm.h>
+#include <wx/filefn.h>
+
+//! Identifies a loadable files cache file
+static constexpr wxUint32 cacheMagic = 0x666c4d57; // "WMlf"
+//! The version of the format of the cache file
+static constexpr wxUint32 cacheFormat = 1;
 
 AutoComplete::AutoComplete(Configuration *configuration)
 {
@@ -47,17 +55,13 @@ AutoComplete::AutoComplete(Configuration *configuration)
 
 void AutoComplete::ClearWorksheetWords()
 {
-  WaitForBackgroundThreads();
+  WaitForBackgroundThread_Symbols();
   m_worksheetWords.clear();
 }
 
 void AutoComplete::ClearDemofileList()
 {
-  if(m_addFiles_backgroundThread)
-  {
-    WaitForBackgroundThread_Files();
-    m_addFiles_backgroundThread.reset();
-  }
+  UseScannedLoadableFiles();
   m_wordList[demofile] = m_builtInDemoFiles;
 }
 
@@ -159,7 +163,7 @@ void AutoComplete::WaitForBackgroundThreads()
 
 void AutoComplete::AddWorksheetWords(WordList::const_iterator const begin, WordList::const_iterator const end)
 {
-  WaitForBackgroundThreads();
+  WaitForBackgroundThread_Symbols();
   for (auto word = begin; word != end; std::advance(word, 1))
     m_worksheetWords[*word] = 1;
 }
@@ -177,31 +181,43 @@ AutoComplete::~AutoComplete()
 void AutoComplete::LoadSymbols()
 {
   WaitForBackgroundThreads();
-  m_addSymbols_backgroundThread =
-    std::unique_ptr<std::thread>(
-      new std::thread(&AutoComplete::BuiltinSymbols_BackgroundTask, this));  
-  m_addFiles_backgroundThread =
-    std::unique_ptr<std::thread>(
-      new std::thread(&AutoComplete::LoadableFiles_BackgroundTask, this));  
-}
-
-void AutoComplete::BuiltinSymbols_BackgroundTask()
-{
   m_wordList[command].Clear();
   m_wordList[tmplte].Clear();
   m_wordList[esccommand].Clear();
   m_wordList[unit].Clear();
-  
+
+  // The built-in lists are sorted already.
   LoadBuiltinSymbols();
-  
+
   for (auto it = Configuration::EscCodesBegin(); it != Configuration::EscCodesEnd(); ++it)
     m_wordList[esccommand].Add(it->first);
-  
-  m_wordList[command].Sort();
-  m_wordList[tmplte].Sort();
-  m_wordList[unit].Sort();
   m_wordList[esccommand].Sort();
-  
+
+  LoadPrivateSymbols();
+
+  // Start with the lists of loadable files the last wxMaxima run has found
+  // and check for changes in the background => Autocompleting a file name
+  // never needs to wait for maxima's share directory to be scanned.
+  LoadableFiles cached;
+  cached.shareDir = m_configuration->MaximaShareDir();
+  cached.shareDir.Replace("\n","");
+  cached.shareDir.Replace("\r","");
+  cached.userDir = Dirstructure::Get()->UserConfDir();
+  if(ReadLoadableFilesCache(cached))
+  {
+    m_builtInLoadFiles = cached.loadFiles;
+    m_builtInDemoFiles = cached.demoFiles;
+  }
+  else
+    cached.dirs.clear();
+  m_filesScanned = false;
+  m_addFiles_backgroundThread =
+    std::unique_ptr<std::thread>(
+      new std::thread(&AutoComplete::LoadableFiles_BackgroundTask, this, cached));
+}
+
+void AutoComplete::LoadPrivateSymbols()
+{
   wxString line;
   
   /// Load private symbol list (do something different on Windows).
@@ -220,6 +236,7 @@ void AutoComplete::BuiltinSymbols_BackgroundTask()
     wxRegEx option  ("^[oO][pP][tT][iI][oO][nN] *: *");
     wxRegEx templte ("^[tT][eE][mM][pP][lL][aA][tT][eE] *: *");
     wxRegEx unt    ("^[uU][nN][iI][tT] *: *");
+    bool symbolsAdded = false;
     for (line = priv.GetFirstLine(); !priv.Eof(); line = priv.GetNextLine())
     {
       line.Trim(true);
@@ -235,11 +252,21 @@ void AutoComplete::BuiltinSymbols_BackgroundTask()
         else if (unt.Replace(&line, ""))
           m_wordList[unit].Add(line);
         else
+        {
           wxLogMessage(privateList +
                        wxString::Format(_(": Can't interpret line: %s")), line.utf8_str());
+          continue;
+        }
+        symbolsAdded = true;
       }
     }
     priv.Close();
+    if(symbolsAdded)
+    {
+      m_wordList[command].Sort();
+      m_wordList[tmplte].Sort();
+      m_wordList[unit].Sort();
+    }
   }
   else
   {
@@ -264,23 +291,52 @@ void AutoComplete::BuiltinSymbols_BackgroundTask()
   }
 }
 
-
-void AutoComplete::LoadableFiles_BackgroundTask()
+void AutoComplete::LoadableFiles_BackgroundTask(LoadableFiles cached)
 {
   // Error dialogues need to be created by the foreground thread.
   SuppressErrorDialogs suppressor;
-    
+
+  // Adding or removing a file changes the modification time of the directory
+  // it is in => if no directory has changed, neither have our lists.
+  bool upToDate = !cached.dirs.empty();
+  for(auto const &dir : cached.dirs)
+  {
+    if((!wxDirExists(dir.path)) || (wxFileModificationTime(dir.path) != dir.modified))
+    {
+      upToDate = false;
+      break;
+    }
+  }
+  if(upToDate)
+  {
+    wxLogMessage(_("Autocompletion: The cached lists of loadable files are up-to-date."));
+    m_filesScanned = true;
+    return;
+  }
+
+  m_scannedFiles.shareDir = cached.shareDir;
+  m_scannedFiles.userDir = cached.userDir;
+  ScanLoadableFiles(m_scannedFiles);
+  WriteLoadableFilesCache(m_scannedFiles);
+  m_scannedFilesChanged = true;
+  m_filesScanned = true;
+}
+
+void AutoComplete::ScanLoadableFiles(LoadableFiles &files)
+{
+  files.loadFiles.Clear();
+  files.demoFiles.Clear();
+  files.dirs.clear();
+  wxArrayString scannedDirs;
+
   // Prepare a list of all built-in loadable files of maxima.
   {
-    GetMacFiles_includingSubdirs maximaLispIterator (m_builtInLoadFiles);
-    wxString sharedir = m_configuration->MaximaShareDir();
-    sharedir.Replace("\n","");
-    sharedir.Replace("\r","");
-    if(sharedir.IsEmpty())
+    GetMacFiles_includingSubdirs maximaLispIterator (files.loadFiles);
+    if(files.shareDir.IsEmpty())
       wxLogMessage(_("Seems like the package with the maxima share files isn't installed."));
     else
     {
-      wxFileName shareDir(sharedir + "/");
+      wxFileName shareDir(files.shareDir + "/");
       shareDir.MakeAbsolute();
       wxLogMessage(
         wxString::Format(
@@ -288,10 +344,15 @@ void AutoComplete::LoadableFiles_BackgroundTask()
           shareDir.GetFullPath().utf8_str()));
       wxDir maximadir(shareDir.GetFullPath());
       if(maximadir.IsOpened())
+      {
+        scannedDirs.Add(shareDir.GetFullPath());
         maximadir.Traverse(maximaLispIterator); //todo
+      }
     }
-    GetMacFiles userLispIterator (m_builtInLoadFiles);
-    wxFileName userDir(Dirstructure::Get()->UserConfDir() + "/");
+    scannedDirs.insert(scannedDirs.end(), maximaLispIterator.GetDirs().begin(),
+                       maximaLispIterator.GetDirs().end());
+    GetMacFiles userLispIterator (files.loadFiles);
+    wxFileName userDir(files.userDir + "/");
     userDir.MakeAbsolute();
     wxDir maximauserfilesdir(userDir.GetFullPath());
     wxLogMessage(
@@ -299,8 +360,11 @@ void AutoComplete::LoadableFiles_BackgroundTask()
         _("Autocompletion: Scanning %s for loadable lisp files."),
         userDir.GetFullPath().utf8_str()));
     if(maximauserfilesdir.IsOpened())
+    {
+      scannedDirs.Add(userDir.GetFullPath());
       maximauserfilesdir.Traverse(userLispIterator);
-    int num = m_builtInLoadFiles.GetCount();
+    }
+    int num = files.loadFiles.GetCount();
     wxLogMessage(
       wxString::Format(
         _("Found %i loadable files."),
@@ -312,10 +376,10 @@ void AutoComplete::LoadableFiles_BackgroundTask()
 
   // Prepare a list of all built-in demos of maxima.
   {
-    wxFileName demoDir(m_configuration->MaximaShareDir() + "/");
+    wxFileName demoDir(files.shareDir + "/");
     demoDir.MakeAbsolute();
     demoDir.RemoveLastDir();
-    GetDemoFiles_includingSubdirs maximaLispIterator (m_builtInDemoFiles);
+    GetDemoFiles_includingSubdirs maximaLispIterator (files.demoFiles);
     wxLogMessage(
       wxString::Format(
         _("Autocompletion: Scanning %s for loadable demo files."),
@@ -323,8 +387,13 @@ void AutoComplete::LoadableFiles_BackgroundTask()
 
     wxDir maximadir(demoDir.GetFullPath());
     if(maximadir.IsOpened())
+    {
+      scannedDirs.Add(demoDir.GetFullPath());
       maximadir.Traverse(maximaLispIterator);
-    int num = m_builtInDemoFiles.GetCount();
+    }
+    scannedDirs.insert(scannedDirs.end(), maximaLispIterator.GetDirs().begin(),
+                       maximaLispIterator.GetDirs().end());
+    int num = files.demoFiles.GetCount();
     wxLogMessage(
       wxString::Format(
         _("Found %i demo files."),
@@ -332,14 +401,98 @@ void AutoComplete::LoadableFiles_BackgroundTask()
         )
       );
   }
-  m_builtInLoadFiles.Sort();
-  m_builtInDemoFiles.Sort();
+  files.loadFiles.Sort();
+  files.demoFiles.Sort();
+
+  // The demo file scan normally includes the share directory
+  scannedDirs.Sort();
+  for(size_t i = 0; i < scannedDirs.GetCount(); i++)
+    if((i == 0) || (scannedDirs[i] != scannedDirs[i - 1]))
+      files.dirs.push_back({scannedDirs[i], wxFileModificationTime(scannedDirs[i])});
 }
 
+bool AutoComplete::ReadLoadableFilesCache(LoadableFiles &files)
+{
+  wxString const cacheFile = Dirstructure::LoadableFilesCacheFile();
+  if(!wxFileExists(cacheFile))
+    return false;
+  SuppressErrorDialogs suppressor;
+  wxFileInputStream fileStream(cacheFile);
+  if(!fileStream.IsOk())
+    return false;
+  wxBufferedInputStream input(fileStream);
+  wxDataInputStream data(input);
+  if((data.Read32() != cacheMagic) || (data.Read32() != cacheFormat))
+    return false;
+  // A cache for a different maxima installation is of no use.
+  if((data.ReadString() != files.shareDir) || (data.ReadString() != files.userDir))
+    return false;
+  wxUint32 count = data.Read32();
+  for(wxUint32 i = 0; (i < count) && input.IsOk(); i++)
+  {
+    wxString path = data.ReadString();
+    time_t const modified = static_cast<time_t>(data.Read64());
+    files.dirs.push_back({path, modified});
+  }
+  count = data.Read32();
+  for(wxUint32 i = 0; (i < count) && input.IsOk(); i++)
+    files.loadFiles.Add(data.ReadString());
+  count = data.Read32();
+  for(wxUint32 i = 0; (i < count) && input.IsOk(); i++)
+    files.demoFiles.Add(data.ReadString());
+  // A file that has been cut short doesn't end in the magic number.
+  return data.Read32() == cacheMagic;
+}
 
-void AutoComplete::UpdateDemoFiles(wxString partial, wxString maximaDir)
+void AutoComplete::WriteLoadableFilesCache(const LoadableFiles &files)
+{
+  SuppressErrorDialogs suppressor;
+  // The file only replaces the old cache after it has been written completely.
+  wxTempFileOutputStream fileStream(Dirstructure::LoadableFilesCacheFile());
+  if(!fileStream.IsOk())
+    return;
+  wxBufferedOutputStream output(fileStream);
+  wxDataOutputStream data(output);
+  data.Write32(cacheMagic);
+  data.Write32(cacheFormat);
+  data.WriteString(files.shareDir);
+  data.WriteString(files.userDir);
+  data.Write32(static_cast<wxUint32>(files.dirs.size()));
+  for(auto const &dir : files.dirs)
+  {
+    data.WriteString(dir.path);
+    data.Write64(static_cast<wxUint64>(dir.modified));
+  }
+  data.Write32(static_cast<wxUint32>(files.loadFiles.GetCount()));
+  for(auto const &file : files.loadFiles)
+    data.WriteString(file);
+  data.Write32(static_cast<wxUint32>(files.demoFiles.GetCount()));
+  for(auto const &file : files.demoFiles)
+    data.WriteString(file);
+  data.Write32(cacheMagic);
+  output.Sync();
+  if(output.IsOk())
+    fileStream.Commit();
+  else
+    fileStream.Discard();
+}
+
+void AutoComplete::UseScannedLoadableFiles()
 {
+  if((!m_addFiles_backgroundThread) || (!m_filesScanned))
+    return;
   WaitForBackgroundThread_Files();
+  if(m_scannedFilesChanged)
+  {
+    m_builtInLoadFiles = std::move(m_scannedFiles.loadFiles);
+    m_builtInDemoFiles = std::move(m_scannedFiles.demoFiles);
+    m_scannedFiles = LoadableFiles();
+    m_scannedFilesChanged = false;
+  }
+}
+
+void AutoComplete::UpdateDemoFiles(wxString partial, wxString maximaDir)
+{
   // Remove the opening quote from the partial.
   if(partial[0] == wxT('\"'))
     partial = partial.Right(partial.Length()-1);
@@ -378,7 +531,6 @@ void AutoComplete::UpdateDemoFiles(wxString partial, wxString maximaDir)
 
 void AutoComplete::UpdateGeneralFiles(wxString partial, wxString maximaDir)
 {
-  WaitForBackgroundThread_Files();
   // Remove the opening quote from the partial.
   if(partial[0] == wxT('\"'))
     partial = partial.Right(partial.Length()-1);
@@ -414,8 +566,7 @@ void AutoComplete::UpdateGeneralFiles(wxString partial, wxString maximaDir)
 
 void AutoComplete::UpdateLoadFiles(wxString partial, wxString maximaDir)
 {
-  wxLogMessage(_("Scheduling a background task that scans for autocompletable file names."));
-  WaitForBackgroundThread_Files();
+  UseScannedLoadableFiles();
   // Remove the opening quote from the partial.
   if(partial[0] == wxT('\"'))
     partial = partial.Right(partial.Length()-1);
@@ -458,7 +609,7 @@ wxArrayString AutoComplete::CompleteSymbol(wxString partial, autoCompletionType
   wxArrayString completions;
   wxArrayString perfectCompletions;
 
-  WaitForBackgroundThreads();
+  WaitForBackgroundThread_Symbols();
   if(
     ((type == AutoComplete::demofile) || (type == AutoComplete::loadfile)) &&
     (partial.EndsWith("\""))
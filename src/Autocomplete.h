@@ -31,6 +31,8 @@
 #define AUTOCOMPLETE_H
 
 #include "precomp.h"
+#include <atomic>
+#include <ctime>
 #include <thread>
 #include <memory>
 #include <wx/wx.h>
@@ -78,9 +80,8 @@ public:
 
   /*! Makes wxMaxima know all its builtin symbols.
 
-    This function might cause a compiler warning because it is 
-    suspiciously long. 
-    For the same reason it has been split into a separate file.
+    The symbols are compiled into wxMaxima as sorted tables that can be found
+    in a separate file.
   */
   bool LoadBuiltinSymbols();
 
@@ -117,10 +118,41 @@ private:
   void AddSymbol_nowait(wxString fun, autoCompletionType type = command);
   //! The configuration storage
   Configuration *m_configuration;
-  //! Loads the list of loadable files and can be run in a background task
-  void LoadableFiles_BackgroundTask();
-  //! Prepares the list of built-in symbols and can be run in a background task
-  void BuiltinSymbols_BackgroundTask();
+  //! A directory the lists of loadable files have been compiled from
+  struct ScannedDir
+  {
+    wxString path;
+    //! The modification time of the directory. Changes if files are added or removed.
+    time_t modified;
+  };
+  //! The lists of loadable files and demo files maxima provides
+  struct LoadableFiles
+  {
+    //! The share directory of maxima the lists were compiled for
+    wxString shareDir;
+    //! The user config directory the lists were compiled for
+    wxString userDir;
+    wxArrayString loadFiles;
+    wxArrayString demoFiles;
+    //! All directories that were scanned in order to compile the lists
+    std::vector<ScannedDir> dirs;
+  };
+  /*! Makes sure the lists of loadable files are up-to-date and can be run in a background task
+
+    Scans maxima's share directory only if one of the directories the cached
+    lists were compiled from has been modified since.
+  */
+  void LoadableFiles_BackgroundTask(LoadableFiles cached);
+  //! Scans the directories for loadable files
+  static void ScanLoadableFiles(LoadableFiles &files);
+  //! Reads the lists of loadable files from the cache, if they were compiled for these directories
+  static bool ReadLoadableFilesCache(LoadableFiles &files);
+  //! Writes the lists of loadable files to the cache
+  static void WriteLoadableFilesCache(const LoadableFiles &files);
+  //! Use the lists of loadable files the background task has compiled, if it has finished
+  void UseScannedLoadableFiles();
+  //! Loads the user's private list of autocompletable symbols
+  void LoadPrivateSymbols();
 
   //! Replace the list of files in the directory the worksheet file is in to the load files list
   void UpdateLoadFiles_BackgroundTask(wxString partial, wxString maximaDir);
@@ -128,6 +160,12 @@ private:
   wxArrayString m_builtInLoadFiles;
   //! The list of demo files maxima provides
   wxArrayString m_builtInDemoFiles;
+  //! The lists LoadableFiles_BackgroundTask() has compiled, if the cached ones were outdated
+  LoadableFiles m_scannedFiles;
+  //! Has LoadableFiles_BackgroundTask() compiled new lists of loadable files?
+  bool m_scannedFilesChanged = false;
+  //! Has LoadableFiles_BackgroundTask() finished?
+  std::atomic<bool> m_filesScanned{false};
 
   //! Scans the maxima directory for a list of loadable files
   class GetGeneralFiles : public wxDirTraverser
@@ -191,12 +229,18 @@ private:
           )
           return wxDIR_STOP;
         else
+        {
+          m_dirs.Add(dirname);
           return wxDIR_CONTINUE;
+        }
       }
     wxArrayString& GetResult(){return m_files;}
+    //! The subdirectories that have been scanned
+    const wxArrayString& GetDirs() const {return m_dirs;}
   protected: 
     wxArrayString& m_files;
     wxString m_prefix;
+    wxArrayString m_dirs;
   };
   
   //! Scans the user directory for a list of .mac files
@@ -244,12 +288,18 @@ private:
           )
           return wxDIR_STOP;
         else
+        {
+          m_dirs.Add(dirname);
           return wxDIR_CONTINUE;
+        }
       }
     wxArrayString& GetResult(){return m_files;}
+    //! The subdirectories that have been scanned
+    const wxArrayString& GetDirs() const {return m_dirs;}
   protected: 
     wxArrayString& m_files;
     wxString m_prefix;
+    wxArrayString m_dirs;
   };
   
   //! Scans the maxima directory for a list of demo files
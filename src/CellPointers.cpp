@@ -38,44 +38,67 @@ wxString CellPointers::WXMXGetNewFileName()
   return file;
 }
 
-void CellPointers::SetTimerIdForCell(Cell *const cell, int const timerId)
+constexpr std::chrono::milliseconds CellPointers::animationFrameInterval;
+
+void CellPointers::ScheduleAnimation(Cell *const cell, int const interval)
 {
-  auto match = std::find_if(m_timerIds.begin(), m_timerIds.end(),
-                            [cell](auto const &ctid) { return ctid.cell == cell; });
-  if (match != m_timerIds.end())
-  {
-    match->timerId = timerId;
+  if (IsAnimationScheduled(cell))
     return;
-  }
+  m_scheduledAnimations.push_back({cell, AnimationClock::now() + std::chrono::milliseconds(interval)});
+  StartAnimationTimer();
+}
 
-  m_timerIds.emplace_back(cell, timerId);
+bool CellPointers::IsAnimationScheduled(const Cell *const cell) const
+{
+  return std::any_of(m_scheduledAnimations.begin(), m_scheduledAnimations.end(),
+                     [cell](auto const &anim) { return anim.cell == cell; });
 }
 
-int CellPointers::GetTimerIdForCell(Cell *const cell) const
+void CellPointers::UnscheduleAnimation(Cell *const cell)
 {
-  auto match = std::find_if(m_timerIds.begin(), m_timerIds.end(),
-                            [cell](auto const &ctid) { return ctid.cell == cell; });
-  if (match != m_timerIds.end())
-    return match->timerId;
-  return -1;
+  m_scheduledAnimations.erase(
+    std::remove_if(m_scheduledAnimations.begin(), m_scheduledAnimations.end(),
+                   [cell](auto const &anim) { return anim.cell == cell; }),
+    m_scheduledAnimations.end());
+  if (m_scheduledAnimations.empty())
+    m_animationTimer.Stop();
 }
 
-Cell *CellPointers::GetCellForTimerId(int const timerId) const
+std::vector<Cell *> CellPointers::TakeDueAnimations()
 {
-  auto match = std::find_if(m_timerIds.begin(), m_timerIds.end(),
-                            [timerId](auto const &ctid) { return ctid.timerId == timerId; });
-  if (match != m_timerIds.end())
-    return match->cell;
-  return nullptr;
+  std::vector<Cell *> due;
+  auto const frameEnd = AnimationClock::now() + animationFrameInterval / 2;
+  auto const isDue = [frameEnd](auto const &anim) { return anim.due <= frameEnd; };
+  for (auto const &anim : m_scheduledAnimations)
+    if (isDue(anim))
+      due.push_back(anim.cell);
+  m_scheduledAnimations.erase(
+    std::remove_if(m_scheduledAnimations.begin(), m_scheduledAnimations.end(), isDue),
+    m_scheduledAnimations.end());
+  StartAnimationTimer();
+  return due;
 }
 
-void CellPointers::RemoveTimerIdForCell(Cell *const cell)
+void CellPointers::StartAnimationTimer()
 {
-  auto it = m_timerIds.begin();
-  while (it != m_timerIds.end() && it->cell != cell)
-    std::advance(it, 1);
-  if (it != m_timerIds.end())
-    m_timerIds.erase(it);
+  if (m_scheduledAnimations.empty())
+  {
+    m_animationTimer.Stop();
+    return;
+  }
+  // Without a worksheet there is nobody to step the animations.
+  if (!m_animationTimer.GetOwner())
+    return;
+
+  auto const next = std::min_element(m_scheduledAnimations.begin(), m_scheduledAnimations.end(),
+                                     [](auto const &a, auto const &b) { return a.due < b.due; });
+  auto const wait = std::chrono::duration_cast<std::chrono::milliseconds>(next->due - AnimationClock::now());
+  // Wake up at a whole number of display frames from now: Animations that are
+  // due at about the same time thus are stepped by the same timer event.
+  auto frames = (wait.count() + animationFrameInterval.count() - 1) / animationFrameInterval.count();
+  if (frames < 1)
+    frames = 1;
+  m_animationTimer.StartOnce(static_cast<int>(frames * animationFrameInterval.count()));
 }
 
 void CellPointers::ErrorList::Remove(GroupCell * cell)
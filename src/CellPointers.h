@@ -26,6 +26,8 @@
 
 #include "Cell.h"
 #include <wx/string.h>
+#include <wx/timer.h>
+#include <chrono>
 #include <vector>
 
 class wxWindow;
@@ -167,22 +169,50 @@ public:
   */
   CellPtr<Cell> m_selectionEnd;
 
-  void SetTimerIdForCell(Cell *cell, int timerId);
-  int GetTimerIdForCell(Cell *cell) const;
-  Cell *GetCellForTimerId(int timerId) const;
-  void RemoveTimerIdForCell(Cell *cell);
+  /*! Tells which object handles the animation timer and which id its events carry
+
+    All animations of a worksheet share this one timer: It wakes up once for
+    each frame any animation needs to be stepped at, which is much cheaper than
+    one timer per animation, and allows the worksheet to redraw all animations
+    that are stepped at the same time in one go.
+  */
+  void SetAnimationTimerOwner(wxEvtHandler *owner, int timerId)
+    { m_animationTimer.SetOwner(owner, timerId); }
+  /*! Asks for the next frame of an animation to be shown in interval milliseconds
+
+    Ignored if the cell is already waiting for its next frame.
+  */
+  void ScheduleAnimation(Cell *cell, int interval);
+  //! Is the cell waiting for its next frame?
+  bool IsAnimationScheduled(const Cell *cell) const;
+  //! Forgets about an animation, for example since it has been stopped or deleted
+  void UnscheduleAnimation(Cell *cell);
+  /*! Returns all animations whose next frame is due and forgets about them
+
+    Animations whose next frame is due within the current display frame are
+    returned, too, so animations with similar frame rates are stepped together.
+    The animation timer is restarted for the animations that aren't due, yet.
+  */
+  std::vector<Cell *> TakeDueAnimations();
 
   wxScrolledCanvas *GetWorksheet() { return m_worksheet; }
 
 private:
-  struct CellTimerId {
+  using AnimationClock = std::chrono::steady_clock;
+  //! The time between two frames of a 60Hz display
+  static constexpr std::chrono::milliseconds animationFrameInterval{16};
+  //! Starts the animation timer for the first animation that will be due
+  void StartAnimationTimer();
+
+  //! An animation that waits for its next frame
+  struct ScheduledAnimation {
     Cell *cell;
-    int timerId;
-    CellTimerId() = default;
-    CellTimerId(Cell *cell, int timerId) : cell(cell), timerId(timerId) {}
+    AnimationClock::time_point due;
   };
-  //! Timer ids for animation cells
-  std::vector<CellTimerId> m_timerIds;
+  //! The animations that wait for their next frame
+  std::vector<ScheduledAnimation> m_scheduledAnimations;
+  //! The one timer that steps all animations
+  wxTimer m_animationTimer;
   //! If m_scrollToCell = true: Which cell do we need to scroll to?
   CellPtr<Cell> m_cellToScrollTo;
   //! The object of the function to call if an animation has to be stepped.
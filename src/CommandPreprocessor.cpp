@@ -0,0 +1,344 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the class CommandPreprocessor
+ */
+
+#define wxNO_UNSAFE_WXSTRING_CONV 1
+#include "CommandPreprocessor.h"
+#include <wx/intl.h>
+#include <wx/tokenzr.h>
+
+CommandPreprocessor::CommandPreprocessor(const wxString &command, Configuration *configuration,
+                                         Mode mode)
+{
+  // Find the end of the command, ignoring trailing whitespace
+  size_t end = command.length();
+  while ((end > 0) && wxIsspace(command[end - 1]))
+    end--;
+  if (end == 0)
+    return;
+  if (command[end - 1] == wxT('\\'))
+  {
+    m_error = _("Cell ends in a backslash");
+    return;
+  }
+
+  if (mode == convert)
+    m_command.reserve(command.length() + 1);
+
+  // Empty statements are only removed from maxima commands.
+  bool const isLisp = command.StartsWith(wxT(":lisp ")) || command.StartsWith(wxT(":lisp\n"));
+
+  int index = 0;
+  bool endingNeeded = true;
+  wxChar lastnonWhitespace;
+  wxChar lastnonWhitespace_Next = wxT(' ');
+  std::vector<wxChar> delimiters;
+
+  // The position in m_command the current statement starts at
+  size_t statementPos = 0;
+  bool statementHasContent = false;
+  wxChar lastTerminator = wxT(';');
+
+  for (auto const &tok : MaximaTokenizer(command, configuration).PopTokens())
+  {
+    auto &itemText = tok.GetText();
+    const TextStyle itemStyle = tok.GetStyle();
+    if (itemText.IsEmpty())
+      continue;
+    index += itemText.Length();
+
+    lastnonWhitespace = lastnonWhitespace_Next;
+
+    // Step 1: Check for unmatched parenthesis and similar
+    bool const isComment = (itemStyle == TS_CODE_COMMENT);
+    wxChar firstC = itemText[0];
+    wxChar lastC = itemText.Last();
+    bool const isWhitespace = (firstC == ' ') || (firstC == '\t') || (firstC == '\r') || (firstC == '\n');
+    if (isComment)
+    {
+      if (!itemText.EndsWith("*/"))
+        m_error = _("Unterminated comment.");
+    }
+    else
+    {
+      // Remember the last non-whitespace character that isn't part
+      // of a comment.
+      if (!isWhitespace)
+        lastnonWhitespace_Next = lastC;
+
+      if (itemText == "(")
+        delimiters.push_back(wxT(')'));
+      else if (itemText == "[")
+        delimiters.push_back(wxT(']'));
+      else if (itemText == "{")
+        delimiters.push_back(wxT('}'));
+      else if ((itemText == ')') || (itemText == ']') || (itemText == '}'))
+      {
+        endingNeeded = true;
+        if (delimiters.empty() || (firstC != delimiters.back()))
+          m_error = _("Mismatched parenthesis");
+        else
+        {
+          delimiters.pop_back();
+          if (lastnonWhitespace == wxT(','))
+            m_error = _("Comma directly followed by a closing parenthesis");
+        }
+      }
+      else if (itemStyle == TS_CODE_STRING)
+      {
+        endingNeeded = true;
+        if (!itemText.EndsWith("\""))
+          m_error = _("Unterminated string.");
+      }
+      else if (itemStyle == TS_CODE_ENDOFLINE)
+      {
+        if (!delimiters.empty())
+          m_error = _("Un-closed parenthesis on encountering ; or $");
+        endingNeeded = false;
+      }
+      else if (itemStyle == TS_CODE_LISP)
+        endingNeeded = false;
+    }
+    if (!m_error.IsEmpty())
+    {
+      m_errorIndex = index;
+      m_command.Clear();
+      return;
+    }
+
+    if (mode == checkOnly)
+      continue;
+
+    // Step 2: Drop statements that consist of nothing but whitespace and
+    // comments, as maxima would see them as an error. What is left over is
+    // at most one empty statement at the beginning of the command.
+    if (itemStyle == TS_CODE_ENDOFLINE)
+    {
+      bool dropTerminator = false;
+      if ((!isLisp) && (!statementHasContent) && (firstC == wxT(';')))
+      {
+        if (statementPos == 0)
+          m_command.Clear();
+        else if (lastTerminator == wxT(';'))
+        {
+          m_command.Truncate(statementPos);
+          dropTerminator = true;
+        }
+      }
+      if (!dropTerminator)
+      {
+        m_command += firstC;
+        lastTerminator = firstC;
+      }
+      statementPos = m_command.length();
+      statementHasContent = false;
+      m_definitionState = statementStart;
+      continue;
+    }
+
+    // Step 3: Convert the token to something maxima understands
+    AppendToCommand(tok);
+
+    // Step 4: Search for definitions the autocompletion should know about
+    if ((!isComment) && (!isWhitespace))
+    {
+      statementHasContent = true;
+      DetectDefinitions(tok);
+    }
+  }
+
+  if (!delimiters.empty())
+    m_error = _("Un-closed parenthesis");
+  else if ((endingNeeded) && (!configuration->InLispMode()))
+    m_error = _("No dollar ($) or semicolon (;) at the end of command");
+  if (!m_error.IsEmpty())
+  {
+    m_errorIndex = index;
+    m_command.Clear();
+  }
+}
+
+void CommandPreprocessor::AppendToCommand(const MaximaTokenizer::Token &token)
+{
+  auto const &text = token.GetText();
+  const wxChar *replacement = NULL;
+  if (text.Length() == 1)
+  {
+    switch (token.GetStyle())
+    {
+    case TS_DEFAULT:
+    case TS_CODE_OPERATOR:
+    case TS_CODE_VARIABLE:
+    case TS_CODE_FUNCTION:
+      switch (text[0].GetValue())
+      {
+      case 0x221A: replacement = wxT(" sqrt "); break;
+      case 0x222B: replacement = wxT(" integrate "); break;
+      case 0x2211: replacement = wxT(" sum "); break;
+      case 0x220F: replacement = wxT(" product "); break;
+      case 0x2148: replacement = wxT(" %i "); break;
+      case 0x2147: replacement = wxT(" %e "); break;
+      case 0x22C0: replacement = wxT(" and "); break;
+      case 0x22C1: replacement = wxT(" or "); break;
+      case 0x22BB: replacement = wxT(" xor "); break;
+      case 0x22BC: replacement = wxT(" nand "); break;
+      case 0x22BD: replacement = wxT(" nor "); break;
+      case 0x21D2: replacement = wxT(" implies "); break;
+      case 0x21D4: replacement = wxT(" equiv "); break;
+      case 0x00AC: replacement = wxT(" not "); break;
+      case 0x03C0: replacement = wxT(" %pi "); break;
+      }
+      break;
+    default:
+      if (text[0].GetValue() == 0x221E)
+        replacement = wxT(" inf ");
+    }
+  }
+  if (replacement)
+    m_command += replacement;
+  else
+    AppendChars(text);
+}
+
+void CommandPreprocessor::AppendChars(const wxString &text)
+{
+  // Most tokens are plain ASCII and therefore can be appended as they are.
+  bool ascii = true;
+  for (auto const ch : text)
+    if (ch.GetValue() >= 0x80)
+    {
+      ascii = false;
+      break;
+    }
+  if (ascii)
+  {
+    m_command += text;
+    return;
+  }
+
+  for (auto const ch : text)
+  {
+    switch (ch.GetValue())
+    {
+    case 0x00B2: m_command += wxT("^2"); break;
+    case 0x00B3: m_command += wxT("^3"); break;
+    case 0x00BD: m_command += wxT("(1/2)"); break;
+    case 0x2205: m_command += wxT("[]"); break; // An empty list
+    case 0x2260: m_command += wxT("#"); break;  // The "not equal" sign
+    case 0x2264: m_command += wxT("<="); break;
+    case 0x2265: m_command += wxT(">="); break;
+    case 0x00B7: m_command += wxT("*"); break;  // An unicode multiplication sign
+    case 0x2212:                                // An unicode minus sign
+    case 0x2052:                                // commercial minus sign
+    case 0xFE63:                                // unicode small minus sign
+    case 0xFF0D:                                // unicode big minus sign
+      m_command += wxT("-");
+      break;
+    case 0xFF0B:                                // unicode big plus
+    case 0xFB29:                                // hebrew alternate plus
+      m_command += wxT("+");
+      break;
+    default:
+      m_command += ch;
+    }
+  }
+}
+
+void CommandPreprocessor::DetectDefinitions(const MaximaTokenizer::Token &token)
+{
+  auto const &text = token.GetText();
+  TextStyle const style = token.GetStyle();
+  switch (m_definitionState)
+  {
+  case statementStart:
+    if ((style == TS_CODE_VARIABLE) || (style == TS_CODE_FUNCTION))
+    {
+      m_definitionName = text;
+      m_definitionState = afterName;
+    }
+    else
+      m_definitionState = noDefinition;
+    break;
+  case afterName:
+    if (text == wxT(":"))
+    {
+      m_variables.push_back(m_definitionName);
+      m_definitionState = noDefinition;
+    }
+    else if (text == wxT("("))
+    {
+      m_definitionArgs.Clear();
+      m_definitionState = inArguments;
+    }
+    else
+      m_definitionState = noDefinition;
+    break;
+  case inArguments:
+    if (text == wxT(")"))
+      m_definitionState = afterArguments;
+    else if ((style == TS_CODE_VARIABLE) || (style == TS_CODE_FUNCTION) ||
+             (style == TS_CODE_NUMBER) ||
+             (text == wxT(",")) || (text == wxT("[")) || (text == wxT("]")))
+      m_definitionArgs += text;
+    else
+      m_definitionState = noDefinition;
+    break;
+  case afterArguments:
+    if (text == wxT(":"))
+      m_definitionState = afterColon;
+    else
+      m_definitionState = noDefinition;
+    break;
+  case afterColon:
+    if (text == wxT("="))
+      m_functions.push_back({m_definitionName, m_definitionName + ArgumentTemplate(m_definitionArgs)});
+    m_definitionState = noDefinition;
+    break;
+  case noDefinition:
+    break;
+  }
+}
+
+wxString CommandPreprocessor::ArgumentTemplate(const wxString &args)
+{
+  wxString result = wxT("(");
+  wxStringTokenizer argTokens(args, wxT(","));
+  int count = 0;
+  while (argTokens.HasMoreTokens())
+  {
+    if (count > 0)
+      result << wxT(",");
+    wxString a = argTokens.GetNextToken().Trim().Trim(false);
+    if (a != wxEmptyString)
+    {
+      if (a[0] == '[')
+        result << wxT("[<") << a.SubString(1, a.Length() - 2) << wxT(">]");
+      else
+        result << wxT("<") << a << wxT(">");
+      count++;
+    }
+  }
+  result << wxT(")");
+  return result;
+}
@@ -0,0 +1,111 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#ifndef COMMANDPREPROCESSOR_H
+#define COMMANDPREPROCESSOR_H
+
+/*! \file
+
+  This file declares the class CommandPreprocessor.
+ */
+
+#include "Configuration.h"
+#include "MaximaTokenizer.h"
+#include <wx/string.h>
+#include <vector>
+
+/*! Prepares a command for being sent to maxima
+
+  Sending a command used to involve one tokenizer run that checked for
+  unmatched parenthesis, one that converted unicode operators to something
+  maxima understands, a regex that removed empty statements and two regexes
+  that searched for variable and function definitions for the autocompletion.
+  This class does all of this in a single run over the tokens of the command.
+ */
+class CommandPreprocessor
+{
+public:
+  //! A function definition found in the command
+  struct FunctionDefinition
+  {
+    wxString name;
+    //! The template for the autocompletion, for example "f(<x>,[<y>])"
+    wxString functionTemplate;
+  };
+
+  //! What the preprocessor should do with the command
+  enum Mode
+  {
+    convert,   //!< Check the command, convert it and search it for definitions
+    checkOnly  //!< Only check the command. GetCommand() and the definitions stay empty.
+  };
+
+  CommandPreprocessor(const wxString &command, Configuration *configuration,
+                      Mode mode = convert);
+
+  /*! Why the command cannot be sent to maxima
+
+    An empty string if there are no unmatched parenthesis, unterminated strings
+    or comments or similar.
+  */
+  const wxString &GetError() const { return m_error; }
+  //! The number of chars of the command that had been processed when the error was found
+  int GetErrorIndex() const { return m_errorIndex; }
+  //! The command in the form maxima expects it. Only valid if GetError() is empty.
+  wxString &GetCommand() { return m_command; }
+  //! The variables the command assigns a value to
+  const std::vector<wxString> &GetVariables() const { return m_variables; }
+  //! The functions the command defines
+  const std::vector<FunctionDefinition> &GetFunctions() const { return m_functions; }
+
+private:
+  //! Appends a token to m_command, converting unicode operators on the way.
+  void AppendToCommand(const MaximaTokenizer::Token &token);
+  //! Appends a text to m_command, converting chars maxima doesn't understand on the way.
+  void AppendChars(const wxString &text);
+  //! Called for every token that is neither whitespace nor a comment
+  void DetectDefinitions(const MaximaTokenizer::Token &token);
+  //! Converts a list of function arguments to an autocompletion template
+  static wxString ArgumentTemplate(const wxString &args);
+
+  //! Where DetectDefinitions() is in the current statement
+  enum DefinitionState
+  {
+    statementStart,   //!< At the start of a statement
+    afterName,        //!< After the first symbol of a statement
+    inArguments,      //!< In a list of function arguments
+    afterArguments,   //!< After the closing parenthesis of the argument list
+    afterColon,       //!< After "f(...):"
+    noDefinition      //!< The current statement cannot be a definition any more
+  };
+
+  wxString m_error;
+  int m_errorIndex = 0;
+  wxString m_command;
+  std::vector<wxString> m_variables;
+  std::vector<FunctionDefinition> m_functions;
+
+  DefinitionState m_definitionState = statementStart;
+  wxString m_definitionName;
+  wxString m_definitionArgs;
+};
+
+#endif // COMMANDPREPROCESSOR_H
@@ -55,6 +55,7 @@ void CompositeDataObject::Add(wxDataObject *object, bool preferred)
       {
         priorEntry.format = *addedFormat;
         priorEntry.object = objPtr;
+        priorEntry.renderer.reset();
         addedFormat = addedFormats.erase(addedFormat);
         continue;
       }
@@ -67,6 +68,52 @@ void CompositeDataObject::Add(wxDataObject *object, bool preferred)
     m_entries.emplace_back(addedFormat, objPtr);
 }
 
+void CompositeDataObject::AddDeferred(std::unique_ptr<wxDataObject> &&prototype,
+                                      Renderer &&renderer, bool preferred)
+{
+  if (!prototype || !renderer)
+    return;
+
+  auto rendererPtr = std::make_shared<Renderer>(std::move(renderer));
+
+  std::vector<wxDataFormat> addedFormats(prototype->GetFormatCount());
+  prototype->GetAllFormats(addedFormats.data());
+
+  if (preferred && !addedFormats.empty())
+    SetPreferredFormat(addedFormats.front());
+
+  for (auto &addedFormat : addedFormats)
+  {
+    bool replaced = false;
+    for (auto &priorEntry : m_entries)
+      if (priorEntry.format == addedFormat)
+      {
+        priorEntry.object.reset();
+        priorEntry.renderer = rendererPtr;
+        replaced = true;
+      }
+    if (!replaced)
+      m_entries.emplace_back(addedFormat, nullptr, rendererPtr);
+  }
+}
+
+wxDataObject *CompositeDataObject::GetEntryObject(Entry &entry) const
+{
+  if (entry.object || !entry.renderer)
+    return entry.object.get();
+
+  // Generate the data and hand it to all formats the renderer is responsible for
+  auto const renderer = entry.renderer;
+  std::shared_ptr<wxDataObject> object{(*renderer)()};
+  for (auto &other : m_entries)
+    if (other.renderer == renderer)
+    {
+      other.object = object;
+      other.renderer.reset();
+    }
+  return object.get();
+}
+
 wxDataObject *CompositeDataObject::GetObject(const wxDataFormat& format,
                                              wxDataObjectBase::Direction dir) const
 {
@@ -76,7 +123,7 @@ wxDataObject *CompositeDataObject::GetObject(const wxDataFormat& format,
   for (auto &entry : m_entries)
     // cppcheck-suppress useStlAlgorithm
     if (entry.format == format)
-      return entry.object.get();
+      return GetEntryObject(entry);
 
   return {};
 }
@@ -107,22 +154,14 @@ void CompositeDataObject::GetAllFormats(wxDataFormat *formats, Direction dir) co
 
 size_t CompositeDataObject::GetDataSize(const wxDataFormat &format) const
 {
-  for (auto &entry : m_entries)
-    // cppcheck-suppress useStlAlgorithm
-    if (entry.format == format)
-      return entry.object->GetDataSize(format);
-
-  return 0;
+  auto *object = GetObject(format);
+  return object ? object->GetDataSize(format) : 0;
 }
 
 bool CompositeDataObject::GetDataHere(const wxDataFormat &format, void *buf) const
 {
-  for (auto &entry : m_entries)
-    // cppcheck-suppress useStlAlgorithm
-    if (entry.format == format)
-      return entry.object->GetDataHere(format, buf);
-
-  return false;
+  auto *object = GetObject(format);
+  return object && object->GetDataHere(format, buf);
 }
 
 #ifdef __WXMSW__
@@ -23,6 +23,7 @@
 #define COMPOSITEDATAOBJECT_H
 
 #include <wx/clipbrd.h>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -32,8 +33,12 @@
  * of the wxDataObjectComposite functionality.
  */
 
-//! A composite data object like wxDataObjectComposite, but accepts also
-//! non-simple data objects. Only the Get direction is supported.
+/*! A composite data object like wxDataObjectComposite, but accepts also
+  non-simple data objects. Only the Get direction is supported.
+
+  Formats that are expensive to generate can be added using AddDeferred():
+  Their data is only generated when an application asks for it.
+ */
 class CompositeDataObject final : public wxDataObject
 {
 public:
@@ -41,6 +46,18 @@ public:
   ~CompositeDataObject() override;
 
   void Add(wxDataObject *object, bool preferred = false);
+  //! Generates the data object for a deferred format
+  using Renderer = std::function<wxDataObject *()>;
+  /*! Adds formats whose data is only generated on the first request
+
+    \param prototype A data object that supports the same formats as the ones
+    renderer generates. It is only used for querying these formats.
+    \param renderer Is called when an application asks for any of these formats
+    for the first time. May return nullptr if it fails to generate the data.
+    \param preferred true = This is the format applications should use if they can.
+  */
+  void AddDeferred(std::unique_ptr<wxDataObject> &&prototype, Renderer &&renderer,
+                   bool preferred = false);
   wxDataObject *GetObject(const wxDataFormat& format,
                                 wxDataObjectBase::Direction dir = Get) const;
   wxDataFormat GetPreferredFormat(Direction dir=Get) const override;
@@ -63,10 +80,16 @@ private:
   {
     wxDataFormat format;
     std::shared_ptr<wxDataObject> object;
-    Entry(const wxDataFormat &format, std::shared_ptr<wxDataObject> object) :
-        format(format), object(object) {}
+    //! Generates object, if it hasn't been generated, yet. Shared by all formats it generates.
+    std::shared_ptr<Renderer> renderer;
+    Entry(const wxDataFormat &format, std::shared_ptr<wxDataObject> object,
+          std::shared_ptr<Renderer> renderer = {}) :
+        format(format), object(object), renderer(renderer) {}
   };
-  std::vector<Entry> m_entries;
+  //! Returns the object for an entry, generating it if necessary
+  wxDataObject *GetEntryObject(Entry &entry) const;
+  //! Mutable, as the objects of deferred formats are generated by const methods
+  mutable std::vector<Entry> m_entries;
   wxDataFormat m_preferredFormat;
 };
 
@@ -341,6 +341,8 @@ void ConfigDialogue::SetCheckboxValues()
   m_mathJaxURL->SetToolTip(_("The URL MathJaX.js should be downloaded from by our HTML export."));
   m_texPreamble->SetToolTip(_("Additional commands to be added to the preamble of LaTeX output for pdftex."));
   m_useUnicodeMaths->SetToolTip(_("If the font provides big parenthesis symbols: Use them when big parenthesis are needed for maths display."));
+  m_embedOutputPreviews->SetToolTip(
+          _("Makes .wxmx files bigger, but allows wxMaxima to display them without waiting until all output has been converted from XML: The pictures are shown until the output has been converted."));
   m_autoSave->SetToolTip(
           _("If this checkbox is checked wxMaxima automatically saves the file closing and every few minutes giving wxMaxima a more cellphone-app-like feel as the file is virtually always saved. If this checkbox is unchecked from time to time a backup is made in the temp folder instead."));
   m_defaultFramerate->SetToolTip(_("Define the default speed (in frames per second) animations are played back with."));
@@ -376,6 +378,7 @@ void ConfigDialogue::SetCheckboxValues()
   m_showMatchingParens->SetToolTip(
           _("Highlight the opening or closing parenthesis for the parenthesis the cursor is at."));
   m_showLength->SetToolTip(_("Show long expressions in wxMaxima document."));
+  m_keepNewestOutput->SetToolTip(_("If a command outputs more lines than \"Show long expressions\" allows (for example progress messages from a long computation) keep the newest lines and discard the oldest ones instead of suppressing the rest of the output."));
   m_autosubscript->SetToolTip(
           _("false=Don't generate subscripts\ntrue=Automatically convert underscores to subscript markers if the would-be subscript is a number or a single letter\nall=_ marks subscripts."));
   m_language->SetToolTip(_("Language used for wxMaxima GUI."));
@@ -391,6 +394,7 @@ void ConfigDialogue::SetCheckboxValues()
   m_hidemultiplicationSign->SetToolTip(_("Hide all multiplication signs that aren't really necessary for understanding the equation"));
   m_latin2Greek->SetToolTip(_("Change the text \"alpha\" and \"beta\" to the corresponding greek letter?"));
   m_defaultPort->SetToolTip(_("The default port used for communication between Maxima and wxMaxima."));
+  m_framedMaximaProtocol->SetToolTip(_("Ask Maxima to announce the length of each of its messages so wxMaxima can display them as soon as they are complete, instead of guessing where a message ends. Takes effect when Maxima is restarted."));
   m_undoLimit->SetToolTip(
           _("Save only this number of actions in the undo buffer. 0 means: save an infinite number of actions."));
   m_recentItems->SetToolTip(_("The number of recently opened files that is to be remembered."));
@@ -451,6 +455,7 @@ void ConfigDialogue::SetCheckboxValues()
   m_matchParens->SetValue(configuration->GetMatchParens());
   m_showMatchingParens->SetValue(configuration->ShowMatchingParens());
   m_showLength->SetSelection(configuration->ShowLength());
+  m_keepNewestOutput->SetValue(configuration->KeepNewestOutput());
   m_autosubscript->SetSelection(configuration->GetAutosubscript_Num());
   m_changeAsterisk->SetValue(configuration->GetChangeAsterisk());
   m_hidemultiplicationSign->SetValue(configuration->HidemultiplicationSign());
@@ -478,6 +483,7 @@ void ConfigDialogue::SetCheckboxValues()
   m_bitmapScale->SetValue(configuration->BitmapScale());
   m_printScale->SetValue(configuration->PrintScale());
   m_fixReorderedIndices->SetValue(configuration->FixReorderedIndices());
+  m_embedOutputPreviews->SetValue(configuration->EmbedOutputPreviews());
   m_incrementalSearch->SetValue(configuration->IncrementalSearch());
   m_notifyIfIdle->SetValue(configuration->NotifyIfIdle());
   m_fixedFontInTC->SetValue(configuration->FixedFontInTextControls());
@@ -538,6 +544,7 @@ void ConfigDialogue::SetCheckboxValues()
   m_noAutodetectMaxima->SetValue(!m_configuration->AutodetectMaxima());
   m_helpBrowserUserLocation->SetValue(m_configuration->HelpBrowserUserLocation());
   m_defaultPort->SetValue(m_configuration->DefaultPort());
+  m_framedMaximaProtocol->SetValue(m_configuration->FramedMaximaProtocol());
   m_copyBitmap->SetValue(m_configuration->CopyBitmap());
   m_copyMathML->SetValue(m_configuration->CopyMathML());
   m_copyMathMLHTML->SetValue(m_configuration->CopyMathMLHTML());
@@ -674,6 +681,10 @@ wxWindow *ConfigDialogue::CreateWorksheetPanel()
   m_antialiasLines = new wxCheckBox(displaySizer->GetStaticBox(), -1, _("Antialias lines."));
   displaySizer->Add(m_antialiasLines, wxSizerFlags());
 
+  m_keepNewestOutput = new wxCheckBox(displaySizer->GetStaticBox(), -1,
+                                      _("Keep the newest lines of overlong output"));
+  displaySizer->Add(m_keepNewestOutput, wxSizerFlags());
+
   m_showMatchingParens = new wxCheckBox(displaySizer->GetStaticBox(), -1, _("Highlight the matching parenthesis"));
   displaySizer->Add(m_showMatchingParens, wxSizerFlags());
 
@@ -1130,6 +1141,10 @@ wxWindow *ConfigDialogue::CreateOptionsPanel()
                                          _("Fix reordered reference indices (of %i, %o) before saving"));
   stdOpts_sizer->Add(m_fixReorderedIndices, wxSizerFlags().Border(wxALL, 5*GetContentScaleFactor()));
 
+  m_embedOutputPreviews = new wxCheckBox(stdOpts_sizer->GetStaticBox(), -1,
+                                         _("Store previews of the output in .wxmx files"));
+  stdOpts_sizer->Add(m_embedOutputPreviews, wxSizerFlags().Border(wxALL, 5*GetContentScaleFactor()));
+
   m_notifyIfIdle = new wxCheckBox(stdOpts_sizer->GetStaticBox(), -1, _("Warn if an inactive window is idle"));
   stdOpts_sizer->Add(m_notifyIfIdle, wxSizerFlags().Border(wxALL, 5*GetContentScaleFactor()));
 
@@ -1246,6 +1261,8 @@ wxWindow *ConfigDialogue::CreateMaximaPanel()
 
   sizer->Add(10*GetContentScaleFactor(), 10*GetContentScaleFactor());
   configSizer->Add(sizer);
+  m_framedMaximaProtocol = new wxCheckBox(configSizer->GetStaticBox(), -1, _("Length-prefixed messages from Maxima"));
+  configSizer->Add(m_framedMaximaProtocol, wxSizerFlags().Border(wxUP | wxDOWN, 5*GetContentScaleFactor()));
   wxStaticText *ap = new wxStaticText(configSizer->GetStaticBox(), -1, _("Additional parameters for maxima"));
   sizer2->Add(ap, wxSizerFlags());
   sizer2->Add(10*GetContentScaleFactor(), 10*GetContentScaleFactor());
@@ -1747,6 +1764,7 @@ void ConfigDialogue::WriteSettings()
   configuration->SetMatchParens(m_matchParens->GetValue());
   configuration->ShowMatchingParens(m_showMatchingParens->GetValue());
   configuration->ShowLength(m_showLength->GetSelection());
+  configuration->KeepNewestOutput(m_keepNewestOutput->GetValue());
   configuration->SetAutosubscript_Num(m_autosubscript->GetSelection());
   configuration->FixedFontInTextControls(m_fixedFontInTC->GetValue());
   configuration->OfferKnownAnswers(m_offerKnownAnswers->GetValue());
@@ -1770,10 +1788,12 @@ void ConfigDialogue::WriteSettings()
   configuration->BitmapScale(m_bitmapScale->GetValue());
   configuration->PrintScale(m_printScale->GetValue());
   configuration->FixReorderedIndices(m_fixReorderedIndices->GetValue());
+  configuration->EmbedOutputPreviews(m_embedOutputPreviews->GetValue());
   configuration->IncrementalSearch(m_incrementalSearch->GetValue());
   configuration->NotifyIfIdle(m_notifyIfIdle->GetValue());
   configuration->SetLabelChoice((Configuration::showLabels) m_showUserDefinedLabels->GetSelection());
   configuration->DefaultPort(m_defaultPort->GetValue());
+  configuration->FramedMaximaProtocol(m_framedMaximaProtocol->GetValue());
   configuration->UseSVG(m_usesvg->GetValue());
   configuration->AntiAliasLines(m_antialiasLines->GetValue());
   configuration->DefaultFramerate(m_defaultFramerate->GetValue());
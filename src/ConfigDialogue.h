@@ -317,6 +317,7 @@ protected:
   wxCheckBox *m_matchParens;
   wxCheckBox *m_showMatchingParens;
   wxChoice *m_showLength;
+  wxCheckBox *m_keepNewestOutput;
   wxChoice *m_autosubscript;
   wxRadioButton *m_enterEvaluates;
   wxRadioButton *m_ctrlEnterEvaluates;
@@ -336,6 +337,7 @@ protected:
   wxSpinCtrl *m_bitmapScale;
   wxSpinCtrlDouble *m_printScale;
   wxCheckBox *m_fixReorderedIndices;
+  wxCheckBox *m_embedOutputPreviews;
   wxCheckBox *m_incrementalSearch;
   wxCheckBox *m_notifyIfIdle;
   wxChoice *m_showUserDefinedLabels;
@@ -358,6 +360,7 @@ protected:
   wxBookCtrlBase *m_notebook;
   wxButton *m_saveStyle, *m_loadStyle;
   wxSpinCtrl *m_defaultPort;
+  wxCheckBox *m_framedMaximaProtocol;
   ExamplePanel *m_examplePanel;
   wxSpinCtrl *m_maxGnuplotMegabytes;
   wxSpinCtrl *m_autosaveMinutes;
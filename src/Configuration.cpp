@@ -192,6 +192,7 @@ void Configuration::ResetAllToDefaults(InitOpt options)
   m_TeXFonts = false;
   m_notifyIfIdle = true;
   m_fixReorderedIndices = true;
+  m_embedOutputPreviews = false;
   m_showBrackets = true;
   m_printBrackets = false;
   m_hideBrackets = true;
@@ -202,6 +203,7 @@ void Configuration::ResetAllToDefaults(InitOpt options)
   m_showLabelChoice = labels_prefer_user;
   m_abortOnError = true;
   m_defaultPort = 49152;
+  m_framedMaximaProtocol = true;
   m_maxGnuplotMegabytes = 12;
   m_clientWidth = 1024;
   m_clientHeight = 768;
@@ -228,6 +230,7 @@ void Configuration::ResetAllToDefaults(InitOpt options)
   m_copySVG = true;
   m_copyEMF = false;
   m_showLength = 2;
+  m_keepNewestOutput = false;
   m_useUnicodeMaths = true;
   m_offerKnownAnswers = true;
   m_parenthesisDrawMode = unknown;
@@ -712,8 +715,11 @@ void Configuration::ReadConfig()
   config->Read(wxT("indentMaths"), &m_indentMaths);
   config->Read(wxT("abortOnError"),&m_abortOnError);
   config->Read("defaultPort",&m_defaultPort);
+  config->Read("framedMaximaProtocol",&m_framedMaximaProtocol);
   config->Read(wxT("fixReorderedIndices"), &m_fixReorderedIndices);
+  config->Read(wxT("embedOutputPreviews"), &m_embedOutputPreviews);
   config->Read(wxT("showLength"), &m_showLength);
+  config->Read(wxT("keepNewestOutput"), &m_keepNewestOutput);
   config->Read(wxT("printScale"), &m_printScale);
   config->Read(wxT("useSVG"), &m_useSVG);
   config->Read(wxT("copyBitmap"), &m_copyBitmap);
@@ -1531,6 +1537,7 @@ void Configuration::WriteStyles(wxConfigBase *config)
   config->Write(wxT("autodetectHelpBrowser"), m_autodetectHelpBrowser);
   config->Write(wxT("helpBrowser"), m_helpBrowserUserLocation);
   config->Write(wxT("fixReorderedIndices"), m_fixReorderedIndices);
+  config->Write(wxT("embedOutputPreviews"), m_embedOutputPreviews);
   config->Write(wxT("mathJaxURL_UseUser"), m_mathJaxURL_UseUser);
   config->Write(wxT("enterEvaluates"), m_enterEvaluates);
   config->Write(wxT("mathJaxURL"), m_mathJaxURL);
@@ -1543,9 +1550,11 @@ void Configuration::WriteStyles(wxConfigBase *config)
   config->Write(wxT("copyEMF"), m_copyEMF);
   config->Write(wxT("useSVG"), m_useSVG);
   config->Write(wxT("showLength"), m_showLength);
+  config->Write(wxT("keepNewestOutput"), m_keepNewestOutput);
   config->Write(wxT("TOCshowsSectionNumbers"), m_TOCshowsSectionNumbers);
   config->Write(wxT("useUnicodeMaths"), m_useUnicodeMaths);
   config->Write("defaultPort",m_defaultPort);
+  config->Write("framedMaximaProtocol",m_framedMaximaProtocol);
   config->Write("abortOnError",m_abortOnError);
   config->Write("language",m_language);
   config->Write("maxGnuplotMegabytes",m_maxGnuplotMegabytes);
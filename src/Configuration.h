@@ -702,6 +702,12 @@ public:
 
   void FixReorderedIndices(bool fix) { m_fixReorderedIndices = fix;}
 
+  //! Store pictures of the outputs in .wxmx files that can be displayed while opening them?
+  bool EmbedOutputPreviews() const
+    { return m_embedOutputPreviews; }
+
+  void EmbedOutputPreviews(bool embed) { m_embedOutputPreviews = embed;}
+
   //! Returns the URL MathJaX can be found at.
   wxString MathJaXURL() const {if(m_mathJaxURL_UseUser) return m_mathJaxURL; else return MathJaXURL_Auto();}
   wxString MathJaXURL_User() const { return m_mathJaxURL;}
@@ -740,6 +746,12 @@ public:
   void UseSVG(bool useSVG) { m_useSVG = useSVG ;}
   void ShowLength(long length) { m_showLength = length; }
   long ShowLength() const {return m_showLength;}
+  /*! Keep the newest lines of a command's output if it is longer than ShowLength() allows?
+
+    If false the lines that exceed the limit are suppressed instead.
+  */
+  bool KeepNewestOutput() const {return m_keepNewestOutput;}
+  void KeepNewestOutput(bool keep) { m_keepNewestOutput = keep; }
   void LispType(wxString type) { m_lispType = type; }
   wxString LispType() const {return m_lispType;}
   
@@ -785,6 +797,11 @@ public:
   void MaxGnuplotMegabytes(long megaBytes)
     {m_maxGnuplotMegabytes = megaBytes;}
 
+  //! Ask Maxima to send its output as length-prefixed frames?
+  bool FramedMaximaProtocol() const {return m_framedMaximaProtocol;}
+  void FramedMaximaProtocol(bool framed)
+    {m_framedMaximaProtocol = framed;}
+
   bool OfferKnownAnswers() const {return m_offerKnownAnswers;}
   void OfferKnownAnswers(bool offerKnownAnswers)
     {m_offerKnownAnswers = offerKnownAnswers;}
@@ -821,6 +838,9 @@ wxString DocumentclassOptions() const {return m_documentclassOptions;}
     { return m_adjustWorksheetSizeNeeded; }
   void SetVisibleRegion(wxRect visibleRegion){m_visibleRegion = visibleRegion;}
   wxRect GetVisibleRegion() const {return m_visibleRegion;}
+  //! The part of the worksheet that is shown on the screen, in worksheet coordinates
+  wxRect GetVisibleWorksheetRegion() const
+    {return wxRect(wxPoint(-m_visibleRegion.x, -m_visibleRegion.y), m_visibleRegion.GetSize());}
   void SetWorksheetPosition(wxPoint worksheetPosition){m_worksheetPosition = worksheetPosition;}
   wxPoint GetWorksheetPosition() const {return m_worksheetPosition;}
   wxString MaximaShareDir() const {return m_maximaShareDir;}
@@ -977,6 +997,7 @@ private:
   long m_lineWidth_em;
   showLabels m_showLabelChoice;
   bool m_fixReorderedIndices;
+  bool m_embedOutputPreviews;
   wxString m_mathJaxURL;
   bool m_mathJaxURL_UseUser;
   bool m_showCodeCells;
@@ -984,6 +1005,7 @@ private:
   bool m_copyMathML;
   bool m_copyMathMLHTML;
   long m_showLength;
+  bool m_keepNewestOutput;
   //!< don't add ; in lisp mode
   bool m_inLispMode;
   bool m_usepngCairo;
@@ -1000,6 +1022,7 @@ private:
   bool m_showMatchingParens;
   bool m_hidemultiplicationsign;
   bool m_offerKnownAnswers;
+  bool m_framedMaximaProtocol;
   long m_defaultPort;
   long m_maxGnuplotMegabytes;
   long m_defaultPlotHeight;
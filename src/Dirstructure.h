@@ -102,9 +102,33 @@ public:
 
   static wxString
     AnchorsCacheFile()
+    {
+      return UserConfDir() + "/manual_anchors.cache";
+    }
+
+  //! The file older wxMaxima versions cached the anchors of the manual in
+  static wxString OldAnchorsCacheFile()
     {
       return UserConfDir() + "/manual_anchors.xml";
     }
+
+  //! The file the lists of loadable files maxima provides are cached in
+  static wxString LoadableFilesCacheFile()
+    {
+      return UserConfDir() + "/loadable_files.cache";
+    }
+
+  //! The file the commands the user has issued are stored in
+  static wxString HistoryFile()
+    {
+      return UserConfDir() + "/history.log";
+    }
+
+  //! The directory pre-rendered icons are cached in
+  static wxString IconCacheDir()
+    {
+      return UserConfDir() + "/iconcache";
+    }
   
   static Dirstructure *Get()
     {
@@ -0,0 +1,193 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+/*! \file
+  This file defines the class DocumentImporter
+ */
+
+#define wxNO_UNSAFE_WXSTRING_CONV 1
+#include "DocumentImporter.h"
+#include "CellList.h"
+#include "Worksheet.h"
+#include <wx/filename.h>
+#include <wx/intl.h>
+#include <wx/log.h>
+#include <wx/textfile.h>
+#include <wx/txtstrm.h>
+#include <wx/wfstream.h>
+#include <chrono>
+
+//! How many cells are created at once
+static constexpr size_t cellsPerBatch = 64;
+
+DocumentImporter::DocumentImporter(const wxString &file, FileType type, Worksheet *worksheet) :
+  m_file(file),
+  m_fileType(type),
+  m_worksheet(worksheet)
+{
+  wxASSERT(worksheet);
+  m_readerThread = std::unique_ptr<std::thread>(
+    new std::thread(&DocumentImporter::ReaderThread_Backgroundtask, this));
+}
+
+DocumentImporter::~DocumentImporter()
+{
+  m_stopReader = true;
+  if (m_readerThread && m_readerThread->joinable())
+    m_readerThread->join();
+}
+
+bool DocumentImporter::IsWorthStreaming(const wxString &file)
+{
+  // Smaller files are read faster than the user would notice.
+  wxULongLong const size = wxFileName::GetSize(file);
+  return (size != wxInvalidSize) && (size >= 1024 * 1024);
+}
+
+bool DocumentImporter::HasWXMHeader(const wxString &file)
+{
+  wxFileInputStream input(file);
+  if (!input.IsOk())
+    return false;
+  wxTextInputStream text(input);
+  return text.ReadLine() == Format::WXMFirstLine;
+}
+
+void DocumentImporter::ReaderThread_Backgroundtask()
+{
+  Batch batch;
+  wxTextFile inputFile(m_file);
+  if (!inputFile.Open())
+  {
+    batch.failed = true;
+    batch.last = true;
+    PushBatch(std::move(batch));
+    return;
+  }
+
+  auto const sink = [this, &batch](Format::CellSource &&cell)
+  {
+    batch.cells.emplace_back(std::move(cell));
+    if (batch.cells.size() < cellsPerBatch)
+      return true;
+    bool const pushed = PushBatch(std::move(batch));
+    batch = {};
+    return pushed;
+  };
+
+  bool complete;
+  if (m_fileType == wxm)
+  {
+    wxArrayString wxmLines;
+    for (auto line = inputFile.GetFirstLine(); ; line = inputFile.GetNextLine())
+    {
+      wxmLines.Add(line);
+      if (inputFile.Eof())
+        break;
+    }
+    inputFile.Close();
+    complete = Format::SplitWXM(wxmLines, sink);
+  }
+  else
+  {
+    wxString contents = Format::MACContentsFromFile(inputFile, m_fileType == xMaximaOutput);
+    inputFile.Close();
+    complete = Format::SplitMACContents(contents, sink);
+  }
+
+  if (complete)
+  {
+    batch.last = true;
+    PushBatch(std::move(batch));
+  }
+}
+
+bool DocumentImporter::PushBatch(Batch &&batch)
+{
+  // The GUI thread creates cells much slower than we can split the file =>
+  // we only keep a few batches in advance.
+  while (!m_batches.Push(std::move(batch)))
+  {
+    if (m_stopReader)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  if (!m_appendRequested.exchange(true))
+    CallAfter(&DocumentImporter::AppendCells);
+  return true;
+}
+
+void DocumentImporter::AppendCells()
+{
+  m_appendRequested = false;
+
+  // Only one batch per event, so the user can scroll and type in between.
+  Batch batch;
+  if (!m_batches.Pop(batch))
+    return;
+
+  if (batch.failed)
+    wxLogError(_("wxMaxima encountered an error loading %s"), m_file.utf8_str());
+
+  CellListBuilder<GroupCell> tree;
+  for (auto &cell : batch.cells)
+  {
+    auto cells = Format::CellsFromSource(std::move(cell), &m_worksheet->m_configuration);
+    for (auto &group : OnList(cells.get()))
+      if (group.IsFoldable() || (group.GetGroupType() == GC_TYPE_IMAGE))
+        m_hasSections = true;
+    tree.Append(std::move(cells));
+  }
+
+  // Loading the rest of a file doesn't change it and isn't something the user
+  // would want to undo. The sections are numbered and the table of contents
+  // is updated only once, after the last batch.
+  bool const saved = m_worksheet->IsSaved();
+  m_worksheet->InsertGroupCells(std::move(tree), m_worksheet->GetLastCell(), NULL, false);
+  m_worksheet->SetSaved(saved);
+
+  if (batch.last)
+  {
+    m_finished = true;
+    if (m_hasSections)
+    {
+      m_worksheet->NumberSections();
+      m_worksheet->Recalculate();
+      m_worksheet->RequestRedraw();
+    }
+    m_worksheet->UpdateTableOfContents();
+  }
+  else if (!m_batches.IsEmpty() && !m_appendRequested.exchange(true))
+    CallAfter(&DocumentImporter::AppendCells);
+}
+
+void DocumentImporter::Finish()
+{
+  while (!m_finished)
+  {
+    if (m_batches.IsEmpty())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    else
+      AppendCells();
+  }
+}
@@ -0,0 +1,114 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#ifndef DOCUMENTIMPORTER_H
+#define DOCUMENTIMPORTER_H
+
+/*! \file
+
+  This file declares the class DocumentImporter that loads big .wxm and .mac
+  files in the background.
+ */
+
+#include "SPSCQueue.h"
+#include "WXMformat.h"
+#include <wx/event.h>
+#include <wx/string.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class Worksheet;
+
+/*! Appends the cells of a .wxm, .mac or .out file to the worksheet while it is being read
+
+  Reading, decoding and splitting the file into the sources of the individual
+  cells is done by a background thread. The cell sources are handed over to the
+  GUI thread in batches using a lock-free queue; the GUI thread creates the
+  cells of one batch per event and appends them to the end of the worksheet.
+  This way the first cells of a big file can be seen and edited long before the
+  last ones have been created.
+ */
+class DocumentImporter : public wxEvtHandler
+{
+public:
+  //! The kinds of files we can import
+  enum FileType
+  {
+    wxm,
+    mac,
+    xMaximaOutput //!< A .out file from xMaxima
+  };
+
+  DocumentImporter(const wxString &file, FileType type, Worksheet *worksheet);
+  ~DocumentImporter() override;
+
+  //! Is the file big enough to be worth being loaded in the background?
+  static bool IsWorthStreaming(const wxString &file);
+
+  //! Does the file start with the first line every .wxm file has?
+  static bool HasWXMHeader(const wxString &file);
+
+  //! Have all cells been appended to the worksheet?
+  bool IsFinished() const { return m_finished; }
+
+  /*! Appends all cells that are still missing to the worksheet
+
+    Waits for the background thread, if necessary. Needed before the worksheet
+    is saved, for example.
+  */
+  void Finish();
+
+private:
+  //! The cell sources the background thread hands over in one go
+  struct Batch
+  {
+    std::vector<Format::CellSource> cells;
+    //! Is this the last batch?
+    bool last = false;
+    //! True if the file could not be read
+    bool failed = false;
+  };
+
+  void ReaderThread_Backgroundtask();
+  //! Hands a batch over to the GUI thread. Called by the background thread.
+  bool PushBatch(Batch &&batch);
+  //! Creates the cells of the next batch and appends them to the worksheet
+  void AppendCells();
+
+  wxString m_file;
+  FileType m_fileType;
+  Worksheet *m_worksheet;
+  bool m_finished = false;
+  //! Have we appended cells that need to be numbered?
+  bool m_hasSections = false;
+
+  SPSCQueue<Batch, 16> m_batches;
+  //! True while an AppendCells() call the background thread has requested is pending
+  std::atomic<bool> m_appendRequested{false};
+  //! Tells the background thread to exit
+  std::atomic<bool> m_stopReader{false};
+  std::unique_ptr<std::thread> m_readerThread;
+};
+
+#endif // DOCUMENTIMPORTER_H
@@ -29,6 +29,9 @@
 
 #define wxNO_UNSAFE_WXSTRING_CONV 1
 #include "History.h"
+#include "Dirstructure.h"
+#include "ErrorRedirector.h"
+#include "StringUtils.h"
 
 #include <wx/sizer.h>
 #include <wx/menu.h>
@@ -36,16 +39,19 @@
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
 #include <wx/config.h>
+#include <wx/ffile.h>
+#include <wx/file.h>
+#include <wx/filefn.h>
+#include <wx/datetime.h>
 #include <algorithm>
+#include <iterator>
 #include <memory>
 #include <wx/wupdlock.h>
 
 History::History(wxWindow *parent, int id) : wxPanel(parent, id)
 {
   wxConfig::Get()->Read(m_showCurrentSessionOnlyKey, &m_showCurrentSessionOnly);
-  // wxLB_MULTIPLE and wxLB_EXTENDED are mutually exclusive and will assert on Windows
-  m_history = new wxListBox(this, history_ctrl_id, wxDefaultPosition, wxDefaultSize, 0, NULL,
-                            wxLB_EXTENDED | wxLB_HSCROLL | wxLB_NEEDED_SB);
+  m_history = new CommandList(this, history_ctrl_id);
   m_regex = new RegexCtrl(this, wxID_ANY);
   wxBoxSizer *box = new wxBoxSizer(wxVERTICAL);
 
@@ -60,22 +66,36 @@ History::History(wxWindow *parent, int id) : wxPanel(parent, id)
           wxCommandEventHandler(History::OnMenu), NULL, this);
   m_regex->Connect(REGEX_EVENT,
           wxCommandEventHandler(History::OnRegExEvent), NULL, this);
+  ReadHistoryFile();
+  RebuildDisplay();
+}
+
+History::CommandList::CommandList(History *history, wxWindowID id) :
+  wxListCtrl(history, id, wxDefaultPosition, wxDefaultSize,
+             wxLC_REPORT | wxLC_VIRTUAL | wxLC_NO_HEADER),
+  m_historyPane(history)
+{
+  InsertColumn(0, wxEmptyString);
+}
+
+wxString History::CommandList::OnGetItemText(long item, long WXUNUSED(column)) const
+{
+  return m_historyPane->GetShownCommand(item);
 }
 
 void History::OnMouseRightDown(wxMouseEvent &WXUNUSED(event))
 {
-  wxArrayInt selections;
-  bool const hasSelections = (m_history->GetSelections(selections) > 0);
+  bool const hasSelections = !GetSelections().empty();
   wxString number;
 
   wxMenu popupMenu;
-  if(m_commands.size() > 0)
+  if(m_entries.size() > 0)
   {
     popupMenu.Append(export_all, _("Export all history to a .mac file"));
     popupMenu.Append(export_session, _("Export commands from the current maxima session to a .mac file"));
     if (hasSelections)
       popupMenu.Append(export_selected, _("Export selected commands to a .mac file"));
-    if(m_history->GetCount() > 0)
+    if(m_history->GetItemCount() > 0)
       popupMenu.Append(export_visible, _("Export visible commands to a .mac file"));
     if(popupMenu.GetMenuItemCount() > 0)
       popupMenu.AppendSeparator();
@@ -92,32 +112,58 @@ void History::OnMouseRightDown(wxMouseEvent &WXUNUSED(event))
 
 void History::MaximaSessionStart()
 {
-  if(m_commands.size() != 0)
+  // Only sessions that did something in this wxMaxima instance end in a quit():
+  // The entries loaded from the history file don't belong to any of them.
+  if (std::any_of(m_entries.begin(), m_entries.end(),
+                  [](const Entry &entry) { return entry.inSession; }))
     AddToHistory(wxT("quit();"));
-  m_sessionCommands = 0;
+  for (auto &entry : m_entries)
+    entry.inSession = false;
   if(m_showCurrentSessionOnly)
-    m_history->Clear();
+    RebuildDisplay();
 }
 
 bool History::UpdateDeferred()
 {
-  if (!m_deferredCommands.empty())
-  {
-    std::reverse(m_deferredCommands.begin(), m_deferredCommands.end());
-    m_history->Insert(m_deferredCommands, 0);
-    m_current += m_deferredCommands.size();
-    m_deferredCommands.clear();
-    SetCurrent(0);
-    return true;
-  }
-  else
+  if (!m_displayOutdated)
     return false;
+  UpdateDisplay();
+  return true;
+}
+
+void History::UpdateDisplay()
+{
+  m_displayOutdated = false;
+  long const count = m_shown.size();
+  m_history->SetItemCount(count);
+  m_history->SetColumnWidth(0, std::max(m_history->GetClientSize().x,
+                                        int(m_longestCommand + 1) * m_history->GetCharWidth()));
+  m_history->Refresh();
+  m_current = -1;
+  if(count > 0)
+    SetCurrent(0);
 }
 
 void History::UnselectAll() const
 {
-  // Unselect all, See: https://forums.wxwidgets.org/viewtopic.php?t=29463
-  m_history->SetSelection(-1, false);
+  for (auto const item : GetSelections())
+    m_history->SetItemState(item, 0, wxLIST_STATE_SELECTED);
+}
+
+std::vector<long> History::GetSelections() const
+{
+  std::vector<long> selections;
+  long item = -1;
+  while ((item = m_history->GetNextItem(item, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)) >= 0)
+    selections.push_back(item);
+  return selections;
+}
+
+const wxString &History::GetShownCommand(long item) const
+{
+  if ((item < 0) || (size_t(item) >= m_shown.size()))
+    return wxm::emptyString;
+  return m_shown[m_shown.size() - 1 - item]->command;
 }
 
 static wxString AskForFileName(wxPanel *parent)
@@ -135,8 +181,7 @@ static wxString AskForFileName(wxPanel *parent)
 void History::OnMenu(wxCommandEvent &event)
 {
   bool indicateError = false;
-  int start = 0;
-  int const size = m_commands.size();
+  bool sessionOnly = false;
 
   switch (event.GetId())
   {
@@ -147,8 +192,8 @@ void History::OnMenu(wxCommandEvent &event)
     break;
   case export_selected:
   {
-    wxArrayInt selections;
-    if (m_history->GetSelections(selections) > 0)
+    auto const selections = GetSelections();
+    if (!selections.empty())
     {
       auto file = AskForFileName(this);
       if (!file.empty())
@@ -158,7 +203,7 @@ void History::OnMenu(wxCommandEvent &event)
         {
           wxTextOutputStream text(output);
           for (auto sel = selections.rbegin(); sel != selections.rend(); ++sel)
-            text << m_history->GetString(*sel) << "\n";
+            text << GetShownCommand(*sel) << "\n";
         }
         indicateError = !output.IsOk() || !output.Close();
       }
@@ -166,7 +211,7 @@ void History::OnMenu(wxCommandEvent &event)
     break;
   }
   case export_session:
-    start = size - m_sessionCommands;
+    sessionOnly = true;
     //fallthrough
     
   case export_all:
@@ -178,8 +223,9 @@ void History::OnMenu(wxCommandEvent &event)
       if(output.IsOk())
       {
         wxTextOutputStream text(output);
-        for(int i = start; i < size; ++i)
-          text << m_commands[i] << "\n";
+        for(auto const &entry : m_entries)
+          if(entry.inSession || !sessionOnly)
+            text << entry.command << "\n";
       }
       indicateError = !output.IsOk() || !output.Close();
     }
@@ -194,20 +240,27 @@ void History::OnMenu(wxCommandEvent &event)
       if(output.IsOk())
       {
         wxTextOutputStream text(output);
-        for(int i = m_history->GetCount()-1; i >= 0; --i)
-          text << m_history->GetString(i) << "\n";
+        for(auto const entry : m_shown)
+          text << entry->command << "\n";
       }
       indicateError = !output.IsOk() || !output.Close();
     }
   break;
   }
   case clear_history:
-    m_history->Clear();
-    m_commands.clear();
-    m_sessionCommands = 0;
+  {
+    m_shown.clear();
+    m_entryIndex.clear();
+    m_entries.clear();
+    m_longestCommand = 0;
+    SuppressErrorDialogs suppressor;
+    if(wxFileExists(Dirstructure::HistoryFile()))
+      wxRemoveFile(Dirstructure::HistoryFile());
+    UpdateDisplay();
     break;
+  }
   case clear_selection:
-    m_history->DeselectAll();
+    UnselectAll();
     break;
   }
   if (indicateError)
@@ -219,60 +272,102 @@ History::~History()
 {
 }
 
+History::Entry &History::UseEntry(const wxString &cmd)
+{
+  auto const existing = m_entryIndex.find(cmd);
+  if (existing == m_entryIndex.end())
+  {
+    Entry entry;
+    entry.command = cmd;
+    m_entries.push_back(std::move(entry));
+    m_entryIndex[cmd] = std::prev(m_entries.end());
+    m_longestCommand = std::max(m_longestCommand, cmd.Length());
+  }
+  else
+    m_entries.splice(m_entries.end(), m_entries, existing->second);
+  return m_entries.back();
+}
+
 void History::AddToHistory(const wxString &cmd)
 {
   if (cmd.IsEmpty())
     return;
 
-  m_sessionCommands ++;
-  m_commands.push_back(cmd);
+  Entry &entry = UseEntry(cmd);
+  // The entry now is the most recent one => it moves to the top of the list.
+  auto const shown = std::find(m_shown.rbegin(), m_shown.rend(), &entry);
+  if (shown != m_shown.rend())
+    m_shown.erase(std::next(shown).base());
+  entry.lastUsed = wxDateTime::GetTimeNow();
+  entry.count++;
+  entry.inSession = true;
+  if (Matches(entry))
+    m_shown.push_back(&entry);
+  m_displayOutdated = true;
+
+  AppendToHistoryFile(entry);
+}
+
+bool History::Matches(const Entry &entry) const
+{
+  if (m_showCurrentSessionOnly && !entry.inSession)
+    return false;
+  // Searching for a plain text is much faster than running a regex
+  if (IsLiteral(m_regex_Old))
+    return entry.command.Contains(m_regex_Old);
+  return m_regex->Matches(entry.command);
+}
 
-  if (m_regex->Matches(cmd))
-    m_deferredCommands.Add(cmd);
+bool History::IsLiteral(const wxString &regex)
+{
+  static const wxString specialChars(wxT("\\^$.|?*+()[]{}"));
+  for (auto const &ch : regex)
+    if (specialChars.Find(ch) != wxNOT_FOUND)
+      return false;
+  return true;
 }
 
 void History::RebuildDisplay()
 {
-  wxWindowUpdateLocker speedUp(this);
-  wxArrayString display;
-  std::vector<wxString>::reverse_iterator sessionEnd;
-  if(m_showCurrentSessionOnly)
-    sessionEnd = m_commands.rbegin() + m_sessionCommands;
-  else
-    sessionEnd = m_commands.rend();
-  
-  display.reserve(m_commands.size());
-  display.reserve(m_commands.size());
-  for (auto cmd = m_commands.rbegin(); cmd != sessionEnd; ++cmd)
-  {
-    if (m_regex->Matches(*cmd))
-      display.Add(*cmd);
-  }
-  m_history->Set(display);
-  m_current = -1;
-  if(m_history->GetCount()>0)
-    SetCurrent(0);
+  m_regex_Old = m_regex->GetValue();
+  m_shown.clear();
+  for (auto const &entry : m_entries)
+    if (Matches(entry))
+      m_shown.push_back(&entry);
+  UpdateDisplay();
 }
 
 void History::OnRegExEvent(wxCommandEvent &WXUNUSED(ev))
 {
+  wxString const regex = m_regex->GetValue();
   UnselectAll();
-  RebuildDisplay();
+  // If the user has typed more of a plain text only the commands that
+  // contained the old text can contain the new one.
+  if (IsLiteral(regex) && IsLiteral(m_regex_Old) && regex.Contains(m_regex_Old))
+  {
+    m_shown.erase(std::remove_if(m_shown.begin(), m_shown.end(),
+                                 [&regex](const Entry *entry) { return !entry->command.Contains(regex); }),
+                  m_shown.end());
+    m_regex_Old = regex;
+    UpdateDisplay();
+  }
+  else
+    RebuildDisplay();
 }
 
 wxString History::GetCommand(bool next)
 {
-  if (m_commands.size() == 0)
+  if (m_shown.empty())
     return {};
 
   auto current = m_current + (next ? +1 : -1);
   SetCurrent(current);
-  return m_history->GetString(m_current);
+  return GetShownCommand(m_current);
 }
 
 void History::SetCurrent(long current)
 {
-  auto const count = long(m_history->GetCount());
+  auto const count = long(m_shown.size());
   if (current < 0) current = count-1;
   else if (current >= count) current = 0;
   if (count < 1) current = -1;
@@ -285,8 +380,119 @@ void History::SetCurrent(long current)
     m_current = current;
     m_history->EnsureVisible(m_current);
     UnselectAll();
-    m_history->SetSelection(m_current);
+    m_history->SetItemState(m_current, wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED,
+                            wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
+  }
+}
+
+void History::ReadHistoryFile()
+{
+  wxString const filename = Dirstructure::HistoryFile();
+  if(!wxFileExists(filename))
+    return;
+  SuppressErrorDialogs suppressor;
+  wxFileInputStream input(filename);
+  if(!input.IsOk())
+    return;
+  wxTextInputStream text(input, wxT("\t"), wxConvUTF8);
+  // Every line is "<time the command was used>\t<how often>\t<command>"
+  size_t lines = 0;
+  while(!input.Eof())
+  {
+    wxString const line = text.ReadLine();
+    wxString const count = line.AfterFirst(wxT('\t'));
+    wxString const cmd = Unescape(count.AfterFirst(wxT('\t')));
+    long long lastUsed;
+    unsigned long uses;
+    if(cmd.IsEmpty() ||
+       !line.BeforeFirst(wxT('\t')).ToLongLong(&lastUsed) ||
+       !count.BeforeFirst(wxT('\t')).ToULong(&uses))
+      continue;
+    lines++;
+    Entry &entry = UseEntry(cmd);
+    entry.lastUsed = std::max(entry.lastUsed, static_cast<std::time_t>(lastUsed));
+    entry.count += uses;
+  }
+  // The file grows by a line every time a command is issued. If most of
+  // these lines are repetitions the file is shortened to one line per command.
+  if(lines > 2 * m_entries.size() + 1000)
+    WriteHistoryFile();
+}
+
+wxString History::HistoryFileLine(const Entry &entry, unsigned long count)
+{
+  return wxString::Format(wxT("%lld\t%lu\t"), static_cast<long long>(entry.lastUsed), count) +
+    Escape(entry.command) + wxT("\n");
+}
+
+void History::AppendToHistoryFile(const Entry &entry) const
+{
+  SuppressErrorDialogs suppressor;
+  wxFFile file(Dirstructure::HistoryFile(), wxT("a"));
+  if(file.IsOpened())
+    file.Write(HistoryFileLine(entry, 1), wxConvUTF8);
+}
+
+void History::WriteHistoryFile() const
+{
+  SuppressErrorDialogs suppressor;
+  wxTempFile file(Dirstructure::HistoryFile());
+  if(!file.IsOpened())
+    return;
+  bool ok = true;
+  for (auto const &entry : m_entries)
+    ok = ok && file.Write(HistoryFileLine(entry, entry.count), wxConvUTF8);
+  if(ok)
+    file.Commit();
+  else
+    file.Discard();
+}
+
+wxString History::Escape(const wxString &cmd)
+{
+  wxString result;
+  result.reserve(cmd.Length());
+  for (auto const &ch : cmd)
+  {
+    if (ch == wxT('\\'))
+      result += wxT("\\\\");
+    else if (ch == wxT('\n'))
+      result += wxT("\\n");
+    else if (ch == wxT('\r'))
+      result += wxT("\\r");
+    else if (ch == wxT('\t'))
+      result += wxT("\\t");
+    else
+      result += ch;
+  }
+  return result;
+}
+
+wxString History::Unescape(const wxString &line)
+{
+  wxString result;
+  result.reserve(line.Length());
+  bool escaped = false;
+  for (auto const &ch : line)
+  {
+    if (escaped)
+    {
+      if (ch == wxT('n'))
+        result += wxT('\n');
+      else if (ch == wxT('r'))
+        result += wxT('\r');
+      else if (ch == wxT('t'))
+        result += wxT('\t');
+      else
+        result += ch;
+      escaped = false;
+    }
+    else if (ch == wxT('\\'))
+      escaped = true;
+    else
+      result += ch;
   }
+  return result;
 }
 
 wxString History::m_showCurrentSessionOnlyKey(wxT("history/ShowCurrentSessionOnly"));
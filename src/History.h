@@ -34,8 +34,12 @@
 #include "RegexCtrl.h"
 #include <wx/wx.h>
 #include <wx/regex.h>
+#include <wx/listctrl.h>
+#include <wx/hashmap.h>
+#include <ctime>
+#include <list>
+#include <unordered_map>
 #include <vector>
-#include <wx/arrstr.h>
 enum
 {
   history_ctrl_id = 1,
@@ -51,6 +55,11 @@ enum
 
 /*! This class generates a pane containing the last commands that were issued.
 
+  Each command is kept only once, together with the time it was issued the
+  last time and the number of times it was issued. Every command that is
+  issued is appended to a file, so the history survives the session without
+  ever re-writing all of it. The pane is a virtual list control that only asks
+  for the commands that are on the screen.
  */
 class History final : public wxPanel
 {
@@ -73,22 +82,80 @@ public:
   //! Actually update the history sidebar. Called when no other work is to be done.
   bool UpdateDeferred();
 
+  //! The command in a line of the list control. Line 0 is the most recent command.
+  const wxString &GetShownCommand(long item) const;
+
 private:
+  //! A command that has been issued
+  struct Entry
+  {
+    wxString command;
+    //! When the command was issued the last time
+    std::time_t lastUsed = 0;
+    //! How often the command has been issued
+    unsigned long count = 0;
+    //! Has the command been issued in the current maxima session?
+    bool inSession = false;
+  };
+  //! The commands, the least recently used one first
+  using EntryList = std::list<Entry>;
+
+  //! A list control that only asks for the commands that are on the screen
+  class CommandList : public wxListCtrl
+  {
+  public:
+    CommandList(History *history, wxWindowID id);
+  protected:
+    wxString OnGetItemText(long item, long column) const override;
+  private:
+    History *const m_historyPane;
+  };
+
   //! Called on right-clicks on the history panel
   void OnMouseRightDown(wxMouseEvent &event);
   void OnMenu(wxCommandEvent &event);
 
   void UnselectAll() const;
   void SetCurrent(long);
-
-  int m_sessionCommands = 0;
-  wxListBox *m_history;
+  //! The items of the list control the user has selected, the topmost first
+  std::vector<long> GetSelections() const;
+  //! Tells the list control how many commands pass the filter
+  void UpdateDisplay();
+
+  //! Makes cmd the most recently used entry, adding it if necessary
+  Entry &UseEntry(const wxString &cmd);
+  //! Does this entry pass the filter?
+  bool Matches(const Entry &entry) const;
+  //! Does this regex only match its literal text?
+  static bool IsLiteral(const wxString &regex);
+
+  //! Reads the history file
+  void ReadHistoryFile();
+  //! Appends one use of an entry to the history file
+  void AppendToHistoryFile(const Entry &entry) const;
+  //! Replaces the history file by one that contains every entry only once
+  void WriteHistoryFile() const;
+  //! The line of the history file that describes count uses of an entry
+  static wxString HistoryFileLine(const Entry &entry, unsigned long count);
+  //! Makes a command fit in a single line of the history file
+  static wxString Escape(const wxString &cmd);
+  //! The inverse of Escape()
+  static wxString Unescape(const wxString &line);
+
+  CommandList *m_history;
   RegexCtrl *m_regex;
-  std::vector<wxString> m_commands;
-  //! Commands we want to add to the history sidebar, once we have time to
-  wxArrayString m_deferredCommands;
+  EntryList m_entries;
+  //! The entries, by their command
+  std::unordered_map<wxString, EntryList::iterator, wxStringHash, wxStringEqual> m_entryIndex;
+  //! The entries that pass the filter, the least recently used one first
+  std::vector<const Entry *> m_shown;
+  //! Do the list control and m_shown disagree?
+  bool m_displayOutdated = true;
+  //! The length of the longest command
+  size_t m_longestCommand = 0;
   //! The currently selected item. -1=none.
   long m_current = 0;
+  //! The regex m_shown has been determined for and new commands are filtered with
   wxString m_regex_Old;
   //! Show only commands from the current session?
   bool m_showCurrentSessionOnly = true;
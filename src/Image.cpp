@@ -31,11 +31,13 @@
 #include <wx/wfstream.h>
 #include <wx/zstream.h>
 #include <wx/txtstrm.h>
-#include <wx/regex.h>
 #include <wx/stdpaths.h>
 #include "SvgBitmap.h"
 #include "ErrorRedirector.h"
+#include "Profiler.h"
 #include "StringUtils.h"
+#include <cstring>
+#include <string>
 
 Image::Image(Configuration **config)
 {
@@ -77,6 +79,25 @@ Image::Image(Configuration **config, wxMemoryBuffer image, wxString type)
   m_maxHeight = -1;
 }
 
+Image::Image(Configuration **config, const FileContents &file)
+{
+  m_svgImage = NULL;
+  m_configuration = config;
+  m_scaledBitmap.Create(1, 1);
+  m_isOk = false;
+  m_width = 1;
+  m_height = 1;
+  m_maxWidth = -1;
+  m_maxHeight = -1;
+  m_originalWidth = 640;
+  m_originalHeight = 480;
+  m_ppi = (*m_configuration)->GetDC()->GetPPI().x;
+  m_extension = wxFileName(file.name).GetExt().Lower();
+  m_imageName = file.name;
+  m_compressedImage = file.data;
+  DecodeCompressedImage();
+}
+
 Image::Image(Configuration **config, const wxBitmap &bitmap)
 {
   m_configuration = config;
@@ -132,6 +153,8 @@ Image::Image(Configuration **config, const Image &image)
 
 Image::~Image()
 {
+  // The background task might still be reading the files we are about to delete
+  WaitForGnuplotSource();
   m_isOk = false;
   if(!m_gnuplotSource.IsEmpty())
   {
@@ -180,12 +203,13 @@ wxBitmap Image::GetUnscaledBitmap()
   }
 
   SuppressErrorDialogs logNull;
+  Profiler::Scope timer(Profiler::imageDecode);
   if (m_svgRast)
   {
     std::vector<unsigned char> imgdata(m_originalWidth*m_originalHeight*4);
 
-    nsvgRasterize(m_svgRast.get(), m_svgImage, 0,0,1, imgdata.data(),
-                  m_originalWidth, m_originalHeight, m_originalWidth*4);
+    SvgBitmap::Rasterize(m_svgRast.get(), m_svgImage, 1, imgdata.data(),
+                         m_originalWidth, m_originalHeight);
     return SvgBitmap::RGBA2wxBitmap(imgdata.data(), m_originalWidth, m_originalHeight);
   }
   else
@@ -220,210 +244,189 @@ bool Image::IsOk()
 }
 
 
+//! Are the chars between begin and end the name of a data file maxima has written for gnuplot?
+static bool IsGnuplotDataFileName(const std::string &script, size_t begin, size_t end)
+{
+  // The names look like ".../maxout_<pid>_<number>.data"
+  static const std::string suffix = ".data";
+  if ((end - begin < suffix.length()) ||
+      (script.compare(end - suffix.length(), suffix.length(), suffix) != 0))
+    return false;
+  size_t const maxout = script.find("maxout_", begin);
+  if ((maxout == std::string::npos) || (maxout + 7 > end - suffix.length()))
+    return false;
+  size_t number = end - suffix.length();
+  while ((number > begin) && (script[number - 1] >= '0') && (script[number - 1] <= '9'))
+    number--;
+  return (number > maxout + 7) && (script[number - 1] == '_');
+}
+
+/*! Replaces the names of the data files in gnuplot commands by '<DATAFILENAME>'
+
+  Needed if we ever want to move a data file into the temp directory of a new
+  computer that locates its temp data somewhere strange. Does the same as the
+  regex "'[^']*maxout_[^']*_[0-9]*\.data'" applied to each line, but works on
+  the raw bytes of the file.
+ */
+static void ReplaceGnuplotDataFileNames(std::string &script)
+{
+  std::string result;
+  result.reserve(script.length());
+  size_t pos = 0;
+  while (pos < script.length())
+  {
+    size_t const open = script.find('\'', pos);
+    if (open == std::string::npos)
+      break;
+    size_t const close = script.find_first_of("'\n", open + 1);
+    if (close == std::string::npos)
+      break;
+    if ((script[close] == '\'') && IsGnuplotDataFileName(script, open + 1, close))
+    {
+      result.append(script, pos, open - pos);
+      result += "'<DATAFILENAME>'";
+      pos = close + 1;
+    }
+    else
+    {
+      // A closing quote might be the opening quote of the file name
+      result.append(script, pos, close - pos);
+      pos = close;
+    }
+  }
+  result.append(script, pos, std::string::npos);
+  script = std::move(result);
+}
+
+wxMemoryBuffer Image::CompressGnuplotFile(wxInputStream &input, bool isScript)
+{
+  wxMemoryBuffer retval;
+  if (!input.IsOk())
+    return retval;
+
+  // We only keep the result in memory and the files can be tens of MB in size
+  // => speed matters more than the last few percent of compression.
+  wxMemoryOutputStream mstream;
+  {
+    int zlib_flags;
+    if(wxZlibOutputStream::CanHandleGZip())
+      zlib_flags = wxZLIB_GZIP;
+    else
+      zlib_flags = wxZLIB_ZLIB;
+    wxZlibOutputStream zstream(mstream, wxZ_BEST_SPEED, zlib_flags);
+    if(!zstream.IsOk())
+      return retval;
+
+    std::vector<char> buf(65536);
+    std::string script;
+    while (input.CanRead())
+    {
+      input.Read(buf.data(), buf.size());
+      if (isScript)
+        script.append(buf.data(), input.LastRead());
+      else
+        zstream.Write(buf.data(), input.LastRead());
+    }
+    if (isScript)
+    {
+      ReplaceGnuplotDataFileNames(script);
+      zstream.Write(script.data(), script.length());
+    }
+    zstream.Close();
+  }
+  retval.AppendData(mstream.GetOutputStreamBuffer()->GetBufferStart(),
+                    mstream.GetOutputStreamBuffer()->GetBufferSize());
+  return retval;
+}
+
 // filesystem cannot be passed by const reference as we want to keep the
 // pointer to the file system alive in a background task
 // cppcheck-suppress performance symbolName=filesystem
 void Image::GnuplotSource(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<wxFileSystem> filesystem)
 {
-  m_fs_keepalive_gnuplotdata = filesystem;
-  LoadGnuplotSource_Backgroundtask(gnuplotFilename, dataFilename, filesystem);
+  WaitForGnuplotSource();
+  m_gnuplotSource = gnuplotFilename;
+  m_gnuplotData = dataFilename;
+
+  if(filesystem)
+  {
+    // A wxFileSystem must not be used by two threads at once, and the
+    // worksheet reads other files from the same one.
+    m_fs_keepalive_gnuplotdata = filesystem;
+    LoadGnuplotSource(filesystem);
+    m_fs_keepalive_gnuplotdata.reset();
+  }
+  else
+  {
+    // Reading and compressing the files can take a while => we don't let
+    // the GUI wait for it.
+    wxFileOffset const maxDataBytes =
+      static_cast<wxFileOffset>((*m_configuration)->MaxGnuplotMegabytes()) * 1000 * 1000;
+    m_gnuplotSourceThread =
+      std::unique_ptr<std::thread>(
+        new std::thread(&Image::LoadGnuplotSource_Backgroundtask, this,
+                        gnuplotFilename, dataFilename, maxDataBytes));
+  }
 }
 
-void Image::LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<wxFileSystem> filesystem)
+void Image::WaitForGnuplotSource()
 {
-  // Error dialogues need to be created by the foreground thread.
-  SuppressErrorDialogs suppressor;
+  if(m_gnuplotSourceThread)
+  {
+    if(m_gnuplotSourceThread->joinable())
+      m_gnuplotSourceThread->join();
+    m_gnuplotSourceThread.reset();
+  }
+}
 
-  m_gnuplotSource = gnuplotFilename;
-  m_gnuplotData = dataFilename;
+void Image::LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString dataFilename,
+                                             wxFileOffset maxDataBytes)
+{
+  // This function doesn't run in the GUI thread => it must neither open
+  // dialogues nor touch anything else than the members it fills.
+  if((!wxFileExists(dataFilename)) || (!wxFileExists(gnuplotFilename)))
+    return;
 
-  if(filesystem == NULL)
+  // Don't cache the data for unreasonably long files.
+  wxStructStat strucStat;
+  wxStat(dataFilename, &strucStat);
+  if (strucStat.st_size > maxDataBytes)
   {
-    if(wxFileExists(dataFilename))
-    {    
-      // Don't cache the data for unreasonably long files.
-      wxStructStat strucStat;
-      wxStat(dataFilename, &strucStat);
-      if (strucStat.st_size > (*m_configuration)->MaxGnuplotMegabytes()*1000*1000)
-      {
-        wxLogMessage(_("Too much gnuplot data => Not storing it in the worksheet"));
-        m_gnuplotData_Compressed.Clear();
-        return;
-      }
-      
-      // The gnuplot source of the image is cached in a compressed form:
-      //
-      // as it is text-only and contains many redundancies it will get way
-      // smaller this way.
-      {
-        wxFileInputStream input(m_gnuplotSource);
-        if(input.IsOk())
-        {
-          wxTextInputStream textIn(input, wxT('\t'), wxConvAuto(wxFONTENCODING_UTF8));
-      
-          wxMemoryOutputStream mstream;
-          int zlib_flags;
-          if(wxZlibOutputStream::CanHandleGZip())
-            zlib_flags = wxZLIB_GZIP;
-          else
-            zlib_flags = wxZLIB_ZLIB;
-          wxZlibOutputStream zstream(mstream,wxZ_BEST_COMPRESSION,zlib_flags);
-          wxTextOutputStream textOut(zstream);
-          wxString line;
-      
-          // A RegEx that matches the name of the data file (needed if we ever want to
-          // move a data file into the temp directory of a new computer that locates its
-          // temp data somewhere strange).
-          wxRegEx replaceDataFileName("'[^']*maxout_[^']*_[0-9]*\\.data'");
-          while(!input.Eof())
-          {
-            line = textIn.ReadLine();
-            if(replaceDataFileName.Matches(line))
-            {
-              wxString dataFileName;
-              dataFileName = replaceDataFileName.GetMatch(line);
-              replaceDataFileName.Replace(&line,wxT("'<DATAFILENAME>'"));
-            }
-            textOut << line + wxT("\n");
-          }
-          textOut.Flush();
-          zstream.Close();
-      
-          m_gnuplotSource_Compressed.Clear();
-          m_gnuplotSource_Compressed.AppendData(mstream.GetOutputStreamBuffer()->GetBufferStart(),
-                                                mstream.GetOutputStreamBuffer()->GetBufferSize());
-        }
-    
-        {
-          wxFileInputStream input2(m_gnuplotData);
-          if(input2.IsOk())
-          {
-            wxTextInputStream textIn(input2, wxT('\t'), wxConvAuto(wxFONTENCODING_UTF8));
-      
-            wxMemoryOutputStream mstream;
-            int zlib_flags;
-            if(wxZlibOutputStream::CanHandleGZip())
-              zlib_flags = wxZLIB_GZIP;
-            else
-              zlib_flags = wxZLIB_ZLIB;
-            wxZlibOutputStream zstream(mstream,wxZ_BEST_COMPRESSION,zlib_flags);
-            wxTextOutputStream textOut(zstream);
-            wxString line;
-      
-            while(!input2.Eof())
-            {
-              line = textIn.ReadLine();
-              textOut << line + wxT("\n");
-            }
-            textOut.Flush();
-            zstream.Close();
-      
-            m_gnuplotData_Compressed.Clear();
-            m_gnuplotData_Compressed.AppendData(mstream.GetOutputStreamBuffer()->GetBufferStart(),
-                                                mstream.GetOutputStreamBuffer()->GetBufferSize());
-          }
-        }
-      }
-    }
+    wxLogMessage(_("Too much gnuplot data => Not storing it in the worksheet"));
+    m_gnuplotData_Compressed.Clear();
+    return;
   }
-  else
+
+  // The gnuplot source of the image is cached in a compressed form:
+  //
+  // as it is text-only and contains many redundancies it will get way
+  // smaller this way.
   {
-    {
-      wxFSFile *fsfile;
-      fsfile = filesystem->OpenFile(m_gnuplotSource);
-      if (fsfile)
-      { // open successful
-        std::unique_ptr<wxInputStream> input(fsfile->GetStream());
-        if(input->IsOk())
-        {
-          wxTextInputStream textIn(*input, wxT('\t'), wxConvAuto(wxFONTENCODING_UTF8));
-          
-          wxMemoryOutputStream mstream;
-          int zlib_flags;
-          if(wxZlibOutputStream::CanHandleGZip())
-            zlib_flags = wxZLIB_GZIP;
-          else
-            zlib_flags = wxZLIB_ZLIB;
-          if(!input->Eof())
-          {
-            wxZlibOutputStream zstream(mstream,wxZ_BEST_COMPRESSION,zlib_flags);
-            if(zstream.IsOk())
-            {
-              wxTextOutputStream textOut(zstream);
-              wxString line;
-          
-              // A RegEx that matches the name of the data file (needed if we ever want to
-              // move a data file into the temp directory of a new computer that locates its
-              // temp data somewhere strange).
-              wxRegEx replaceDataFileName("'[^']*maxout_[^']*_[0-9*]\\.data'");
-              while(!input->Eof())
-              {
-                line = textIn.ReadLine();
-                if(replaceDataFileName.Matches(line))
-                {
-                  wxString dataFileName;
-                  dataFileName = replaceDataFileName.GetMatch(line);
-                  if(dataFileName != wxEmptyString)
-                    wxLogMessage(_("Gnuplot Data File Name: ") + dataFileName);
-                  replaceDataFileName.Replace(&line,wxT("'<DATAFILENAME>'"));
-                }
-                textOut << line + wxT("\n");
-              }
-              textOut.Flush();
-              zstream.Close();
-              m_gnuplotSource_Compressed.Clear();
-              m_gnuplotSource_Compressed.AppendData(mstream.GetOutputStreamBuffer()->GetBufferStart(),
-                                                    mstream.GetOutputStreamBuffer()->GetBufferSize());
-            }
-          }
-        }
-      }
-    }
-    {
-      wxFSFile *fsfile;
-      fsfile = filesystem->OpenFile(m_gnuplotData);
-      if (fsfile)
-      { // open successful
-        wxInputStream *input = fsfile->GetStream();
-        if(input->IsOk())
-        {
-          wxTextInputStream textIn(*input, wxT('\t'), wxConvAuto(wxFONTENCODING_UTF8));
-            
-          wxMemoryOutputStream mstream;
-          int zlib_flags;
-          if(wxZlibOutputStream::CanHandleGZip())
-            zlib_flags = wxZLIB_GZIP;
-          else
-            zlib_flags = wxZLIB_ZLIB;
-          if(!input->Eof())
-          {
-            wxZlibOutputStream zstream(mstream,wxZ_BEST_COMPRESSION,zlib_flags);
-            if(zstream.IsOk())
-            {
-              wxTextOutputStream textOut(zstream);
-              wxString line;
-              
-              while(!input->Eof())
-              {
-              line = textIn.ReadLine();
-              textOut << line + wxT("\n");
-              }
-              textOut.Flush();
-              zstream.Close();
-              
-              m_gnuplotData_Compressed.Clear();
-              m_gnuplotData_Compressed.AppendData(mstream.GetOutputStreamBuffer()->GetBufferStart(),
-                                                  mstream.GetOutputStreamBuffer()->GetBufferSize());
-            }
-          }
-        }
-      }
-    }
+    wxFileInputStream input(gnuplotFilename);
+    m_gnuplotSource_Compressed = CompressGnuplotFile(input, true);
+  }
+  {
+    wxFileInputStream input(dataFilename);
+    m_gnuplotData_Compressed = CompressGnuplotFile(input, false);
   }
-  m_fs_keepalive_gnuplotdata.reset();
+}
+
+void Image::LoadGnuplotSource(const std::shared_ptr<wxFileSystem> &filesystem)
+{
+  // Error dialogues need to be created by the foreground thread.
+  SuppressErrorDialogs suppressor;
+
+  std::unique_ptr<wxFSFile> sourceFile(filesystem->OpenFile(m_gnuplotSource));
+  if (sourceFile && !sourceFile->GetStream()->Eof())
+    m_gnuplotSource_Compressed = CompressGnuplotFile(*sourceFile->GetStream(), true);
+
+  std::unique_ptr<wxFSFile> dataFile(filesystem->OpenFile(m_gnuplotData));
+  if (dataFile && !dataFile->GetStream()->Eof())
+    m_gnuplotData_Compressed = CompressGnuplotFile(*dataFile->GetStream(), false);
 }
 wxMemoryBuffer Image::GetGnuplotSource()
 {
+  WaitForGnuplotSource();
   wxMemoryBuffer retval;
   if(
     (m_gnuplotSource_Compressed.GetDataLen() < 2) || 
@@ -459,6 +462,7 @@ wxMemoryBuffer Image::GetGnuplotSource()
 
 wxMemoryBuffer Image::GetGnuplotData()
 {
+  WaitForGnuplotSource();
   wxMemoryBuffer retval;
   if(
     (m_gnuplotSource_Compressed.GetDataLen() < 2) || 
@@ -494,6 +498,7 @@ wxMemoryBuffer Image::GetGnuplotData()
 
 wxString Image::GnuplotData()
 {
+  WaitForGnuplotSource();
   if((!m_gnuplotData.IsEmpty()) && (!wxFileExists(m_gnuplotData)))
   {
     // Move the gnuplot data and data file into our temp directory
@@ -532,6 +537,7 @@ wxString Image::GnuplotData()
 
 wxString Image::GnuplotSource()
 {
+  WaitForGnuplotSource();
   if((!m_gnuplotSource.IsEmpty()) && (!wxFileExists(m_gnuplotSource)))
   {
     // Move the gnuplot source and data file into our temp directory
@@ -662,16 +668,28 @@ wxBitmap Image::GetBitmap(double scale)
   // Let's see if we have cached the scaled bitmap with the right size
   if (m_scaledBitmap.GetWidth() == m_width)
     return m_scaledBitmap;
-  
+
+  // Zooming back and forth or toggling the window size often returns to a
+  // size we have already rendered the image at.
+  RetireScaledBitmap();
+  for (auto recent = m_recentBitmaps.begin(); recent != m_recentBitmaps.end(); ++recent)
+    if ((recent->GetWidth() == m_width) && (recent->GetHeight() == m_height))
+    {
+      m_scaledBitmap = *recent;
+      m_recentBitmaps.erase(recent);
+      return m_scaledBitmap;
+    }
+
   // Seems like we need to create a new scaled bitmap.
+  Profiler::Scope timer(Profiler::imageDecode);
   if (m_svgRast)
   {
     // First create rgba data
     std::vector<unsigned char> imgdata(m_width*m_height*4);
 
-    nsvgRasterize(m_svgRast.get(), m_svgImage, 0,0,
-                  ((double)m_width)/((double)m_originalWidth),
-                  imgdata.data(), m_width, m_height, m_width*4);
+    SvgBitmap::Rasterize(m_svgRast.get(), m_svgImage,
+                         ((double)m_width)/((double)m_originalWidth),
+                         imgdata.data(), m_width, m_height);
     return m_scaledBitmap = SvgBitmap::RGBA2wxBitmap(imgdata.data(), m_width, m_height);
   }
   else
@@ -793,30 +811,120 @@ void Image::LoadImage_Backgroundtask(wxString image, std::shared_ptr<wxFileSyste
     // "too many open files" error.
   }
   else
+    m_compressedImage = ReadImageFile(*m_configuration, image, remove);
+
+  DecodeCompressedImage();
+  m_fs_keepalive_imagedata.reset();
+}
+
+wxMemoryBuffer Image::ReadImageFile(Configuration *config, const wxString &image, bool remove)
+{
+  wxMemoryBuffer retval;
+  wxFile file;
+  // Support relative and absolute paths.
+  if(wxFileExists(config->GetWorkingDirectory() + wxT("/") + image))
+    file.Open(config->GetWorkingDirectory() + wxT("/") + image);
+  else
+    file.Open(image);
+
+  if (file.IsOpened())
   {
-    wxFile file;
-    // Support relative and absolute paths.
-    if(wxFileExists((*m_configuration)->GetWorkingDirectory() + wxT("/") + image))
-      file.Open((*m_configuration)->GetWorkingDirectory() + wxT("/") + image);
-    else
-      file.Open(image);
+    wxFileInputStream strm(file);
+    bool ok = strm.IsOk();
+    if (ok)
+      retval = ReadCompressedImage(&strm);
 
-    if (file.IsOpened())
+    file.Close();
+    if (ok && remove)
     {
-      wxFileInputStream strm(file);
-      bool ok = strm.IsOk();
-      if (ok)
-        m_compressedImage = ReadCompressedImage(&strm);
+      SuppressErrorDialogs logNull;
+      wxRemoveFile(image);
+    }
+  }
+  return retval;
+}
+
+Image::FileContents Image::ReadFile(Configuration *config, const wxString &file, bool remove)
+{
+  FileContents contents;
+  contents.name = file;
+  contents.data = ReadImageFile(config, file, remove);
+  contents.frames = CountFrames(contents.data);
+  return contents;
+}
+
+//! Skips the data sub-blocks of a GIF block. \returns false if the data ends prematurely.
+static bool SkipGIFSubBlocks(const unsigned char *data, size_t length, size_t &pos)
+{
+  while (pos < length)
+  {
+    size_t const blockSize = data[pos++];
+    if (blockSize == 0)
+      return true;
+    pos += blockSize;
+  }
+  return false;
+}
 
-      file.Close();
-      if (ok && remove)
+size_t Image::CountFrames(const wxMemoryBuffer &image)
+{
+  const unsigned char *data = static_cast<const unsigned char *>(image.GetData());
+  size_t const length = image.GetDataLen();
+  if (length == 0)
+    return 0;
+
+  // A GIF's frames can be counted without decoding them: Each frame starts
+  // with an image descriptor and consists of data blocks that tell their length.
+  if ((length >= 13) && (memcmp(data, "GIF8", 4) == 0))
+  {
+    size_t pos = 13;
+    if (data[10] & 0x80)
+      pos += 3 * (size_t(1) << ((data[10] & 0x07) + 1));
+    size_t frames = 0;
+    while (pos < length)
+    {
+      switch (data[pos++])
       {
-        SuppressErrorDialogs logNull;
-        wxRemoveFile(image);
+      case 0x21: // An extension: Its label and its data
+        pos++;
+        if (!SkipGIFSubBlocks(data, length, pos))
+          return wxMax(frames, size_t(1));
+        break;
+      case 0x2C: // An image descriptor, an optional color table and the image data
+        if (pos + 9 > length)
+          return wxMax(frames, size_t(1));
+        frames++;
+        if (data[pos + 8] & 0x80)
+          pos += 3 * (size_t(1) << ((data[pos + 8] & 0x07) + 1));
+        // Skip the descriptor and the minimum LZW code size
+        pos += 10;
+        if (!SkipGIFSubBlocks(data, length, pos))
+          return wxMax(frames, size_t(1));
+        break;
+      default: // The trailer or garbage
+        return wxMax(frames, size_t(1));
       }
     }
+    return wxMax(frames, size_t(1));
+  }
+
+  // TIFF, ICO, CUR and ANI files, the other formats wxWidgets can read several
+  // images from, are rare enough to let wxWidgets do the counting.
+  if ((length >= 12) &&
+      ((memcmp(data, "II*\0", 4) == 0) || (memcmp(data, "MM\0*", 4) == 0) ||
+       (memcmp(data, "\0\0\1\0", 4) == 0) || (memcmp(data, "\0\0\2\0", 4) == 0) ||
+       ((memcmp(data, "RIFF", 4) == 0) && (memcmp(data + 8, "ACON", 4) == 0))))
+  {
+    wxMemoryInputStream istream(data, length);
+    return wxImage::GetImageCount(istream);
   }
 
+  // All other formats contain exactly one image.
+  return 1;
+}
+
+void Image::DecodeCompressedImage()
+{
   m_isOk = false;
 
   wxImage Image;
@@ -918,7 +1026,6 @@ void Image::LoadImage_Backgroundtask(wxString image, std::shared_ptr<wxFileSyste
       }
     }
   }
-  m_fs_keepalive_imagedata.reset();
 }
 
 void Image::Recalculate(double scale)
@@ -980,10 +1087,20 @@ void Image::Recalculate(double scale)
     m_height = 1;
     m_width = 1;
   }
-  // Clear this cell's image cache if it doesn't contain an image of the size
-  // we need right now.
+  // Free the bitmap we display if it doesn't have the size we need right now.
+  // We might need it again, though, if the user returns to the old size.
   if (m_scaledBitmap.GetWidth() != m_width)
-    ClearCache();
+    RetireScaledBitmap();
+}
+
+void Image::RetireScaledBitmap()
+{
+  if ((m_scaledBitmap.GetWidth() <= 1) && (m_scaledBitmap.GetHeight() <= 1))
+    return;
+  m_recentBitmaps.insert(m_recentBitmaps.begin(), m_scaledBitmap);
+  if (m_recentBitmaps.size() > recentBitmaps)
+    m_recentBitmaps.pop_back();
+  m_scaledBitmap.Create(1, 1);
 }
 
 const wxString &Image::GetBadImageToolTip()
@@ -37,6 +37,9 @@
 #include <wx/filesys.h>
 #include <wx/fs_arc.h>
 #include <wx/buffer.h>
+#include <memory>
+#include <thread>
+#include <vector>
 #define NANOSVG_ALL_COLOR_KEYWORDS
 #include "nanoSVG/nanosvg.h"
 #include "nanoSVG/nanosvgrast.h"
@@ -68,12 +71,43 @@
 class Image final
 {
 public:
+  /*! The contents of an image file
+
+    Allows to decide if a file contains an animation and to create the cell
+    that displays it without reading the file a second time.
+   */
+  struct FileContents
+  {
+    //! The name of the file, which also tells its type
+    wxString name;
+    wxMemoryBuffer data;
+    //! The number of images the file contains. 0 = the file could not be read.
+    size_t frames = 0;
+  };
+
+  /*! Reads an image file
+
+    \param config The configuration that knows maxima's working directory
+    \param file The name of the file, absolute or relative to maxima's working directory
+    \param remove true = Delete the file after reading it
+  */
+  static FileContents ReadFile(Configuration *config, const wxString &file, bool remove);
+
+  /*! Counts the images in the contents of an image file
+
+    Only the headers are inspected, so this is fast even for big animations.
+  */
+  static size_t CountFrames(const wxMemoryBuffer &image);
+
   //! A constructor that generates an empty image. See LoadImage()
   explicit Image(Configuration **config);
 
   //! A constructor that loads the compressed file from a wxMemoryBuffer
   Image(Configuration **config, wxMemoryBuffer image, wxString type);
 
+  //! A constructor that uses the contents of a file ReadFile() has read
+  Image(Configuration **config, const FileContents &file);
+
   /*! A constructor that loads a bitmap
 
     This constructor actually has to do some compression since we got
@@ -108,7 +142,9 @@ public:
 
     Causes the files to be cached if they are not way too long; As the files
     are text-only they profit from being compressed and are stored in the 
-    memory in their compressed form.
+    memory in their compressed form. Files from the system's filesystem are
+    read and compressed by a background thread; every function that needs
+    the result waits for this thread to finish.
    */
   void GnuplotSource(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<wxFileSystem> filesystem);
 
@@ -152,6 +188,7 @@ public:
     {
       if ((m_scaledBitmap.GetWidth() > 1) || (m_scaledBitmap.GetHeight() > 1))
         m_scaledBitmap.Create(1, 1);
+      m_recentBitmaps.clear();
     }
   
   //! Returns the file name extension of the current image
@@ -219,6 +256,10 @@ private:
   size_t m_originalHeight;
   //! The bitmap, scaled down to the screen size
   wxBitmap m_scaledBitmap;
+  //! The number of bitmaps at other sizes we keep in m_recentBitmaps
+  static constexpr size_t recentBitmaps = 2;
+  //! The bitmaps we have scaled the image to before m_scaledBitmap, newest first
+  std::vector<wxBitmap> m_recentBitmaps;
   //! The file extension for the current image type
   wxString m_extension;
   //! Does this image contain an actual image?
@@ -228,11 +269,33 @@ private:
   //! The gnuplot data file for this image, if any.
   wxString m_gnuplotData;
   void LoadImage_Backgroundtask(wxString image, std::shared_ptr<wxFileSystem> filesystem, bool remove);
-  void LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<wxFileSystem> filesystem);
+  /*! Caches the gnuplot files from the system's filesystem. Runs in m_gnuplotSourceThread.
+
+    \param maxDataBytes The size of the data file above which we don't cache anything
+   */
+  void LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString dataFilename,
+                                        wxFileOffset maxDataBytes);
+  //! Caches the gnuplot files from a filesystem that isn't the system's one, e.g. a .wxmx file
+  void LoadGnuplotSource(const std::shared_ptr<wxFileSystem> &filesystem);
+  //! Waits until m_gnuplotSourceThread has finished caching the gnuplot files
+  void WaitForGnuplotSource();
+  /*! Compresses a gnuplot file
+
+    \param input The file
+    \param isScript true = Replace the name of the data file in the gnuplot
+           commands by a placeholder, so it can be moved to a new location.
+   */
+  static wxMemoryBuffer CompressGnuplotFile(wxInputStream &input, bool isScript);
   //! Loads an image from a file
   void LoadImage(wxString image, std::shared_ptr<wxFileSystem> filesystem, bool remove = true);
   //! Reads the compressed image into a memory buffer
   static wxMemoryBuffer ReadCompressedImage(wxInputStream *data);
+  //! Reads an image file from the system's filesystem
+  static wxMemoryBuffer ReadImageFile(Configuration *config, const wxString &image, bool remove);
+  //! Determines the size of m_compressedImage and prepares drawing it
+  void DecodeCompressedImage();
+  //! Moves m_scaledBitmap to m_recentBitmaps
+  void RetireScaledBitmap();
   Configuration **m_configuration;
   /*! The upper width limit for displaying this image
 
@@ -251,6 +314,8 @@ private:
 
   std::shared_ptr<wxFileSystem> m_fs_keepalive_gnuplotdata;
   std::shared_ptr<wxFileSystem> m_fs_keepalive_imagedata;
+  //! The thread that caches the gnuplot files, if it hasn't been joined yet
+  std::unique_ptr<std::thread> m_gnuplotSourceThread;
 };
 
 #endif // IMAGE_H
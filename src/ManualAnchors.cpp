@@ -0,0 +1,247 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+/*! \file
+  This file defines the class ManualAnchors
+ */
+
+#define wxNO_UNSAFE_WXSTRING_CONV 1
+#include "ManualAnchors.h"
+#include <wx/bufstrm.h>
+#include <wx/datstrm.h>
+#include <wx/file.h>
+#include <wx/filefn.h>
+#include <wx/wfstream.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+
+//! Identifies a binary anchors cache file
+static constexpr wxUint32 cacheMagic = 0x6d784d57; // "WMxm"
+//! The version of the format of the cache file
+static constexpr wxUint32 cacheFormat = 1;
+//! Manuals smaller than this are scanned by a single thread
+static constexpr size_t minChunkSize = 1024 * 1024;
+
+//! Can this char be part of the id of a keyword anchor?
+static inline bool IsIdChar(char ch)
+{
+  return ((ch >= 'a') && (ch <= 'z')) || ((ch >= 'A') && (ch <= 'Z')) ||
+    ((ch >= '0') && (ch <= '9')) || (ch == '_') || (ch == '-');
+}
+
+//! Does the text at pos start with the (NUL-terminated) string prefix?
+static inline bool StartsWith(const char *pos, const char *end, const char *prefix)
+{
+  size_t const len = std::strlen(prefix);
+  return (static_cast<size_t>(end - pos) >= len) && (std::memcmp(pos, prefix, len) == 0);
+}
+
+//! The value of a lowercase hex digit, or -1
+static inline int HexDigit(char ch)
+{
+  if ((ch >= '0') && (ch <= '9'))
+    return ch - '0';
+  if ((ch >= 'a') && (ch <= 'f'))
+    return ch - 'a' + 10;
+  return -1;
+}
+
+wxString ManualAnchors::KeywordFromId(const char *id, size_t len)
+{
+  // In anchors a space is represented by a hyphen. Keywords don't contain
+  // spaces, so anything with a hyphen describes something else.
+  if (std::find(id, id + len, '-') != id + len)
+    return wxEmptyString;
+
+  // Some other chars including the minus are represented by "_00xx"
+  // where xx is being the ascii code of the char.
+  static const char escapeChars[] = "<=>[]`%?;\\$%&+-*/.!\'@#:^_";
+  std::string keyword;
+  keyword.reserve(len);
+  for (size_t i = 0; i < len; i++)
+  {
+    if ((id[i] == '_') && (i + 4 < len) && (id[i + 1] == '0') && (id[i + 2] == '0'))
+    {
+      int const high = HexDigit(id[i + 3]);
+      int const low = HexDigit(id[i + 4]);
+      if ((high >= 0) && (low >= 0))
+      {
+        char const ch = static_cast<char>(high * 16 + low);
+        if ((ch != '\0') && std::strchr(escapeChars, ch))
+        {
+          keyword += ch;
+          i += 4;
+          continue;
+        }
+      }
+    }
+    keyword += id[i];
+  }
+
+  // What the g_t means I don't know. But we don't need it
+  if (keyword.compare(0, 3, "g_t") == 0)
+    keyword.erase(0, 3);
+  // Anchors that end with "-1" aren't too useful, normally.
+  if ((keyword.length() >= 2) && (keyword.compare(keyword.length() - 2, 2, "-1") == 0))
+    return wxEmptyString;
+  return wxString::FromAscii(keyword.data(), keyword.length());
+}
+
+void ManualAnchors::Scan(const char *html, size_t len, List &anchors)
+{
+  static const char spanTag[] = "<span id=\"";
+  static const char oldManualTag[] = "<a name=\"";
+  const char *const end = html + len;
+  const char *pos = html;
+  while ((pos < end) &&
+         ((pos = static_cast<const char *>(std::memchr(pos, '<', end - pos))) != NULL))
+  {
+    const char *idStart;
+    if (StartsWith(pos, end, spanTag))
+      idStart = pos + sizeof(spanTag) - 1;
+    else if (StartsWith(pos, end, oldManualTag))
+      idStart = pos + sizeof(oldManualTag) - 1;
+    else
+    {
+      pos++;
+      continue;
+    }
+    const char *idEnd = idStart;
+    while ((idEnd < end) && IsIdChar(*idEnd))
+      idEnd++;
+    pos = idEnd;
+    // The id has to be followed by the end of the tag or by more attributes
+    if ((idEnd == end) || (*idEnd != '"'))
+      continue;
+    const char *tagEnd = idEnd + 1;
+    if ((tagEnd < end) && (*tagEnd == ' '))
+      while ((tagEnd < end) && (*tagEnd != '>') && (*tagEnd != '<') && (*tagEnd != '\n'))
+        tagEnd++;
+    if ((tagEnd == end) || (*tagEnd != '>'))
+      continue;
+    wxString keyword = KeywordFromId(idStart, idEnd - idStart);
+    if (!keyword.IsEmpty())
+      anchors.emplace_back(std::move(keyword),
+                           wxString::FromAscii(idStart, idEnd - idStart));
+  }
+}
+
+bool ManualAnchors::ScanFile(const wxString &file, Map &anchors)
+{
+  wxFile input(file);
+  if (!input.IsOpened())
+    return false;
+  wxFileOffset const length = input.Length();
+  if (length <= 0)
+    return false;
+  std::vector<char> html(static_cast<size_t>(length));
+  if (input.Read(html.data(), html.size()) != static_cast<ssize_t>(html.size()))
+    return false;
+
+  // Split the manual into chunks that end at the end of a line. No anchor
+  // spans several lines => no anchor is split between two chunks.
+  size_t const chunkCount =
+    std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(),
+                                         html.size() / minChunkSize));
+  std::vector<size_t> chunkStarts = {0};
+  for (size_t i = 1; i < chunkCount; i++)
+  {
+    auto const lineEnd = std::find(html.begin() + std::max(chunkStarts.back(), i * html.size() / chunkCount),
+                                   html.end(), '\n');
+    if (lineEnd == html.end())
+      break;
+    chunkStarts.push_back(lineEnd - html.begin() + 1);
+  }
+  chunkStarts.push_back(html.size());
+
+  std::vector<List> results(chunkStarts.size() - 1);
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < results.size(); i++)
+    threads.emplace_back([&, i]() {
+      Scan(html.data() + chunkStarts[i], chunkStarts[i + 1] - chunkStarts[i], results[i]);
+    });
+  Scan(html.data(), chunkStarts[1], results[0]);
+  for (auto &thread : threads)
+    thread.join();
+
+  for (auto const &result : results)
+    for (auto const &anchor : result)
+      anchors[anchor.first] = anchor.second;
+  return true;
+}
+
+bool ManualAnchors::ReadCache(const wxString &file, const wxString &maximaVersion, Map &anchors)
+{
+  if (!wxFileExists(file))
+    return false;
+  wxFileInputStream fileStream(file);
+  if (!fileStream.IsOk())
+    return false;
+  wxBufferedInputStream input(fileStream);
+  wxDataInputStream data(input);
+  if ((data.Read32() != cacheMagic) || (data.Read32() != cacheFormat))
+    return false;
+  if (data.ReadString() != maximaVersion)
+    return false;
+  wxUint32 const count = data.Read32();
+  Map result;
+  for (wxUint32 i = 0; (i < count) && input.IsOk(); i++)
+  {
+    wxString key = data.ReadString();
+    result[key] = data.ReadString();
+  }
+  // A file that has been cut short doesn't end in the magic number.
+  if (data.Read32() != cacheMagic)
+    return false;
+  for (auto const &anchor : result)
+    anchors[anchor.first] = anchor.second;
+  return !result.empty();
+}
+
+bool ManualAnchors::WriteCache(const wxString &file, const wxString &maximaVersion, const Map &anchors)
+{
+  // The file only replaces the old cache after it has been written completely.
+  wxTempFileOutputStream fileStream(file);
+  if (!fileStream.IsOk())
+    return false;
+  wxBufferedOutputStream output(fileStream);
+  wxDataOutputStream data(output);
+  data.Write32(cacheMagic);
+  data.Write32(cacheFormat);
+  data.WriteString(maximaVersion);
+  data.Write32(static_cast<wxUint32>(anchors.size()));
+  for (auto const &anchor : anchors)
+  {
+    data.WriteString(anchor.first);
+    data.WriteString(anchor.second);
+  }
+  data.Write32(cacheMagic);
+  output.Sync();
+  if (!output.IsOk())
+  {
+    fileStream.Discard();
+    return false;
+  }
+  return fileStream.Commit();
+}
@@ -0,0 +1,77 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#ifndef MANUALANCHORS_H
+#define MANUALANCHORS_H
+
+/*! \file
+
+  This file declares the class ManualAnchors.
+ */
+
+#include "precomp.h"
+#include <wx/string.h>
+#include <wx/hashmap.h>
+#include <utility>
+#include <vector>
+
+/*! Finds and caches the anchors maxima's html manual provides for its keywords
+
+  The manual used to be scanned by splitting every line at each ">" and
+  running up to two regular expressions on every fragment. This class instead
+  searches the raw bytes of the manual for the start tags of anchors in a
+  single pass, and splits big manuals into chunks that are scanned in
+  parallel. The result is cached in a compact binary file.
+ */
+class ManualAnchors
+{
+public:
+  //! Maps keywords to the anchor of the manual entry that describes them
+  WX_DECLARE_STRING_HASH_MAP(wxString, Map);
+  //! A keyword and its anchor, in the order they were found in
+  typedef std::vector<std::pair<wxString, wxString>> List;
+
+  /*! Finds all keyword anchors in a html file of the manual
+
+    \returns false, if the file cannot be read. Anchors are added to anchors;
+    if a keyword is found twice the last anchor for it wins.
+  */
+  static bool ScanFile(const wxString &file, Map &anchors);
+  /*! Finds all keyword anchors in a chunk of html. Thread-safe.
+
+    Recognizes <span id="..."> and <a name="...">, if the id contains
+    nothing but letters, digits, underscores and hyphens.
+  */
+  static void Scan(const char *html, size_t len, List &anchors);
+  /*! Converts the id of an anchor to the keyword it describes
+
+    Returns an empty string if the anchor doesn't describe a keyword.
+  */
+  static wxString KeywordFromId(const char *id, size_t len);
+
+  //! Reads a cache written by WriteCache(), if it has been written for this maxima version
+  static bool ReadCache(const wxString &file, const wxString &maximaVersion, Map &anchors);
+  //! Writes the anchors to a binary cache file
+  static bool WriteCache(const wxString &file, const wxString &maximaVersion, const Map &anchors);
+};
+
+#endif // MANUALANCHORS_H
@@ -34,6 +34,7 @@
 #include "MathParser.h"
 
 #include "Version.h"
+#include "Profiler.h"
 #include "CellList.h"
 #include "ExptCell.h"
 #include "SubCell.h"
@@ -54,6 +55,8 @@
 #include "ImgCell.h"
 #include "LabelCell.h"
 #include "LongNumberCell.h"
+#include "OutputPreviewCell.h"
+#include "PagedOutputCell.h"
 #include "SubSupCell.h"
 #include "StringUtils.h"
 #include "VisiblyInvalidCell.h"
@@ -160,6 +163,7 @@ MathParser::MathParser(Configuration **cfg, const wxString &zipfile)
     m_groupTags[wxT("heading6")] = &MathParser::GroupCellHeading6Tag;
   }
   m_highlight = false;
+  m_wxmxFile = zipfile;
   if (zipfile.Length() > 0)
   {
     m_fileSystem = std::unique_ptr<wxFileSystem>(new wxFileSystem());
@@ -344,15 +348,8 @@ std::unique_ptr<Cell> MathParser::ParseImageTag(wxXmlNode *node)
   }
   else
   {
-    std::shared_ptr<wxFileSystem> system_fs = {};
-    if (node->GetAttribute(wxT("del"), wxT("yes")) != wxT("no"))
-    {
-      if (wxImage::GetImageCount(filename) < 2)
-        imageCell = std::make_unique<ImgCell>(m_group, m_configuration, filename, system_fs, true);
-      else
-        return std::make_unique<AnimationCell>(m_group, m_configuration, filename, true);
-    }
-    else
+    bool const remove = (node->GetAttribute(wxT("del"), wxT("yes")) != wxT("no"));
+    if (!remove)
     {
       // This is the only case show_image() produces ergo this is the only
       // case we might get a local path
@@ -361,11 +358,14 @@ std::unique_ptr<Cell> MathParser::ParseImageTag(wxXmlNode *node)
         (wxFileExists((*m_configuration)->GetWorkingDirectory() + wxT("/") + filename))
         )
         filename = (*m_configuration)->GetWorkingDirectory() + wxT("/") + filename;
-      if (wxImage::GetImageCount(filename) < 2)
-        imageCell = std::make_unique<ImgCell>(m_group, m_configuration, filename, system_fs, false);
-      else
-        return std::make_unique<AnimationCell>(m_group, m_configuration, filename, false);
     }
+    // Read the file only once, even if it turns out to be an animation.
+    Image::FileContents const file = Image::ReadFile(*m_configuration, filename, remove);
+    if (file.frames < 2)
+      imageCell = std::make_unique<ImgCell>(m_group, m_configuration, file);
+    else
+      return std::make_unique<AnimationCell>(m_group, m_configuration, file.data,
+                                             wxFileName(filename).GetExt());
   }
 
   wxString ppi = node->GetAttribute(wxT("ppi"), wxEmptyString);
@@ -453,6 +453,9 @@ std::unique_ptr<Cell> MathParser::ParseStringTag(wxXmlNode *node)
 std::unique_ptr<Cell> MathParser::ParseCellTag(wxXmlNode *node)
 {
   std::unique_ptr<GroupCell> group;
+  // The preview only applies to this cell, not to the cells folded into it.
+  const OutputPreview *preview = m_outputPreview;
+  m_outputPreview = NULL;
 
   // read hide status
   bool hide = (node->GetAttribute(wxT("hide"), wxT("false")) == wxT("true")) ? true : false;
@@ -495,6 +498,15 @@ std::unique_ptr<Cell> MathParser::ParseCellTag(wxXmlNode *node)
       if (editor)
         group->SetEditableContent(editor->GetValue());
     }
+    else if (preview && (children->GetName() == wxT("output")) &&
+             (group->GetGroupType() == GC_TYPE_CODE))
+    {
+      group->AppendOutput(std::make_unique<OutputPreviewCell>(
+                            group.get(), m_configuration,
+                            std::unique_ptr<wxXmlNode>(new wxXmlNode(*children)),
+                            m_wxmxFile, preview->png, preview->size, preview->zoom));
+      preview = NULL;
+    }
     else
     {
       group->AppendOutput(HandleNullPointer(ParseTag(children)));
@@ -1238,11 +1250,7 @@ std::unique_ptr<Cell> MathParser::ParseTag(wxXmlNode *node, bool all)
 
 std::unique_ptr<Cell> MathParser::ParseLine(wxString s, CellType style)
 {
-  m_ParserStyle = style;
-  m_FracStyle = FracCell::FC_NORMAL;
-  m_highlight = false;
-  std::unique_ptr<Cell> cell;
-
+  Profiler::Scope timer(Profiler::parseLine);
   int showLength;
 
   switch ((*m_configuration)->ShowLength())
@@ -1266,27 +1274,40 @@ std::unique_ptr<Cell> MathParser::ParseLine(wxString s, CellType style)
   m_graphRegex.Replace(&s, wxT("\uFFFD"));
 
   if (((long) s.Length() < showLength) || (showLength == 0))
-  {
+    return ParseFragment(s, style);
 
-    wxXmlDocument xml;
+  // Too long for being converted to cells all at once: Try to only convert
+  // the parts of it that are visible on the screen.
+  auto paged = std::make_unique<PagedOutputCell>(m_group, m_configuration, std::move(s),
+                                                 style, m_userDefinedLabel);
+  if (paged->GetPageCount() > 1)
+    return std::move(paged);
 
-    wxStringInputStream xmlStream(s);
+  std::unique_ptr<Cell> cell = std::make_unique<TextCell>(m_group, m_configuration,
+                        T_("(Expression longer than allowed by the configuration setting)"), TS_WARNING);
+  cell->SetToolTip(&T_("The maximum size of the expressions wxMaxima is allowed to display "
+                       "can be changed in the configuration dialogue."));
+  cell->ForceBreakLine(true);
+  return cell;
+}
 
-    xml.Load(xmlStream, wxT("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
+std::unique_ptr<Cell> MathParser::ParseFragment(const wxString &s, CellType style)
+{
+  m_ParserStyle = style;
+  m_FracStyle = FracCell::FC_NORMAL;
+  m_highlight = false;
+  std::unique_ptr<Cell> cell;
 
-    wxXmlNode *doc = xml.GetRoot();
+  wxXmlDocument xml;
 
-    if (doc != NULL)
-      cell = ParseTag(doc->GetChildren());
-  }
-  else
-  {
-    cell = std::make_unique<TextCell>(m_group, m_configuration,
-                        T_("(Expression longer than allowed by the configuration setting)"), TS_WARNING);
-    cell->SetToolTip(&T_("The maximum size of the expressions wxMaxima is allowed to display "
-                         "can be changed in the configuration dialogue."));
-    cell->ForceBreakLine(true);
-  }
+  wxStringInputStream xmlStream(s);
+
+  xml.Load(xmlStream, wxT("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
+
+  wxXmlNode *doc = xml.GetRoot();
+
+  if (doc != NULL)
+    cell = ParseTag(doc->GetChildren());
   return cell;
 }
 
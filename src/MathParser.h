@@ -36,6 +36,7 @@ The header file for the xml cell parser
 #include <wx/fs_arc.h>
 #include <wx/regex.h>
 #include <wx/hashmap.h>
+#include <wx/buffer.h>
 #include "Cell.h"
 #include "TextCell.h"
 #include "EditorCell.h"
@@ -68,6 +69,12 @@ public:
    * Put the result in line.
    */
   std::unique_ptr<Cell> ParseLine(wxString s, CellType style = MC_TYPE_DEFAULT);
+  /*! Parse the xml fragment s, regardless of its length
+
+    Used by PagedOutputCell for converting the parts of a long output to cells
+    that are visible on the screen.
+   */
+  std::unique_ptr<Cell> ParseFragment(const wxString &s, CellType style = MC_TYPE_DEFAULT);
   /***
    * Parse the node and return the corresponding tag.
    */
@@ -78,6 +85,23 @@ public:
   //! Sets the group the newly parsed cells are provided with
   void SetGroup(GroupCell *group) { m_group = group; }
 
+  //! A picture of the output of a code cell that has been stored in a .wxmx file
+  struct OutputPreview
+  {
+    //! The picture, as PNG data
+    wxMemoryBuffer png;
+    //! The size of the picture [in pixels]
+    wxSize size;
+    //! The zoom factor the picture was rendered for
+    double zoom = 1.0;
+  };
+  /*! Makes the next cell tag ParseTag() encounters display preview instead of its output
+
+    The output is then converted to cells by Worksheet::ReplaceOutputPreview(),
+    later. NULL means: Convert the output to cells immediately.
+   */
+  void SetOutputPreview(const OutputPreview *preview) { m_outputPreview = preview; }
+
 private:
   //! A pointer to a method that handles an XML tag for a type of Cell
   using MathCellFunc = std::unique_ptr<Cell> (MathParser::*)(wxXmlNode *node);
@@ -256,6 +280,10 @@ private:
   Configuration **m_configuration;
   bool m_highlight;
   std::shared_ptr<wxFileSystem> m_fileSystem; // used for loading pictures in <img> and <slide>
+  //! The .wxmx file we read from
+  wxString m_wxmxFile;
+  //! The picture the output of the next cell tag is to be displayed as
+  const OutputPreview *m_outputPreview = NULL;
   static wxString m_unknownXMLTagToolTip;
 };
 
@@ -23,23 +23,109 @@
 
 #define wxNO_UNSAFE_WXSTRING_CONV 1
 #include "Maxima.h"
+#include "Profiler.h"
+#include "StringUtils.h"
 #include "wxMaxima.h"
 #include <wx/app.h>
 #include <wx/debug.h>
+#include <wx/log.h>
+#include <wx/intl.h>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <limits>
+#ifdef __WINDOWS__
+#include <winsock2.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <cerrno>
+#endif
 
 //! The time, in ms, we'll wait for an end of string to arrive from maxima after
 //! the input was first read.
 static constexpr int STRING_END_TIMEOUT = 5000;
-//! The period, in ms, with which we may force a read from Maxima in case we expect
-//! some input but got no notifications for it.
+//! The time, in ms, the reader thread waits for data before checking if it should exit
+static constexpr int READER_POLL_PERIOD = 50;
+//! The time, in ms, we wait for the reader thread to hand over maxima's last words
+static constexpr int READER_DRAIN_TIMEOUT = 2000;
+//! The longest frame we accept. A longer "frame" can only be a stray frame header in normal output.
+static constexpr size_t MAX_FRAME_LENGTH = 16 * 1024 * 1024;
+
+wxDEFINE_EVENT(EVT_MAXIMA, MaximaEvent);
+
+//! The number of bytes at the start of data that form complete UTF-8 sequences
+static size_t CompleteUTF8Length(const char *data, size_t length)
+{
+  // A multi-byte sequence is at most 4 bytes long => its lead byte is at most
+  // 3 bytes before the end of the data.
+  for (size_t back = 1; (back <= 3) && (back <= length); back++)
+  {
+    auto const ch = static_cast<unsigned char>(data[length - back]);
+    if ((ch & 0xC0) == 0x80)
+      continue;
+    size_t sequenceLength = 1;
+    if ((ch & 0xE0) == 0xC0)
+      sequenceLength = 2;
+    else if ((ch & 0xF0) == 0xE0)
+      sequenceLength = 3;
+    else if ((ch & 0xF8) == 0xF0)
+      sequenceLength = 4;
+    if (sequenceLength > back)
+      return length - back;
+    return length;
+  }
+  return length;
+}
+
+//! Converts UTF-8 from maxima to a wxString without losing data that isn't valid UTF-8
+static wxString DecodeUTF8(const char *data, size_t length)
+{
+  if (length == 0)
+    return wxEmptyString;
+  wxString result = wxString::FromUTF8(data, length);
+  if (result.IsEmpty())
+    result = wxString(data, wxConvISO8859_1, length);
+  return result;
+}
+
+//! True if the last socket error only means "try again"
+static bool SocketErrorIsTransient()
+{
 #ifdef __WINDOWS__
-static constexpr int INPUT_RESTART_PERIOD = 3000;
+  int const error = WSAGetLastError();
+  return (error == WSAEWOULDBLOCK) || (error == WSAEINTR);
 #else
-static constexpr int INPUT_RESTART_PERIOD = -1;
+  return (errno == EWOULDBLOCK) || (errno == EAGAIN) || (errno == EINTR);
 #endif
+}
 
-wxDEFINE_EVENT(EVT_MAXIMA, MaximaEvent);
+/*! Waits up to timeout ms for data to arrive on a socket
+
+  On POSIX systems select() only works for file descriptors below FD_SETSIZE
+  => we use poll() there. Windows' fd_sets are lists of sockets instead of
+  bitmaps, so select() is safe there and works on all windows versions.
+  \returns >0 if there is data (or an error) to read, 0 on timeout and <0 on error
+ */
+static int WaitForInput(wxSOCKET_T fd, int timeout)
+{
+#ifdef __WINDOWS__
+  fd_set readSet;
+  FD_ZERO(&readSet);
+  FD_SET(fd, &readSet);
+  timeval timeoutVal;
+  timeoutVal.tv_sec = timeout / 1000;
+  timeoutVal.tv_usec = (timeout % 1000) * 1000;
+  return select(0, &readSet, NULL, NULL, &timeoutVal);
+#else
+  pollfd pollFd = {};
+  pollFd.fd = fd;
+  pollFd.events = POLLIN;
+  return poll(&pollFd, 1, timeout);
+#endif
+}
 
 Maxima::Maxima(wxSocketBase *socket) : m_socket(socket)
 {
@@ -48,21 +134,21 @@ Maxima::Maxima(wxSocketBase *socket) : m_socket(socket)
   Bind(wxEVT_SOCKET, wxSocketEventHandler(Maxima::SocketEvent), this);
 
   m_socket->SetEventHandler(*this);
-  m_socket->SetNotify(wxSOCKET_INPUT_FLAG|wxSOCKET_OUTPUT_FLAG|wxSOCKET_LOST_FLAG);
+  // Reading is done by the reader thread => we don't want input events.
+  m_socket->SetNotify(wxSOCKET_OUTPUT_FLAG|wxSOCKET_LOST_FLAG);
   m_socket->Notify(true);
   m_socket->SetFlags(wxSOCKET_NOWAIT|wxSOCKET_REUSEADDR);
   m_socket->SetTimeout(120);
 
-  // There are some hints in the code history that wxSOCKET_INPUT
-  // event may be "flaky". We don't want wxMaxima to get stuck, but we don't want
-  // to be forcing idle events for nothing. So this is a "way out" - we monitor
-  // the progress of input, and only act if we expected some but none came.
-  if (INPUT_RESTART_PERIOD > 0)
-    m_readIdleTimer.Start(INPUT_RESTART_PERIOD);
+  m_readerThread = std::unique_ptr<std::thread>(
+    new std::thread(&Maxima::ReaderThread_Backgroundtask, this));
 }
 
 Maxima::~Maxima()
 {
+  m_stopReader = true;
+  if (m_readerThread && m_readerThread->joinable())
+    m_readerThread->join();
   m_socket->Close();
 }
 
@@ -103,9 +189,18 @@ bool Maxima::Write(const void *buffer, size_t length)
   return true;
 }
 
-UTF8Decoder::DecodeResult Maxima::DecodeFromSocket(size_t maxRead)
+bool Maxima::Write(const wxString &data)
 {
-  return m_decoder.Decode(m_socketDecodeState, m_socketInput, maxRead, maxRead + 16);
+  if (data.IsEmpty())
+    return Write(nullptr, 0);
+  auto const wideData = data.wc_str();
+  size_t const length = wxConvUTF8.FromWChar(nullptr, 0, wideData, data.length());
+  if (length == wxCONV_FAILED)
+    return false;
+  auto *const dest = static_cast<char *>(m_socketOutputData.GetAppendBuf(length));
+  wxConvUTF8.FromWChar(dest, length, wideData, data.length());
+  m_socketOutputData.UngetAppendBuf(length);
+  return Write(nullptr, 0);
 }
 
 void Maxima::SocketEvent(wxSocketEvent &event)
@@ -113,7 +208,7 @@ void Maxima::SocketEvent(wxSocketEvent &event)
   switch (event.GetSocketEvent())
   {
   case wxSOCKET_INPUT:
-    ReadSocket();
+    // We don't ask for these events, as the reader thread does all reading.
     break;
   case wxSOCKET_OUTPUT:
     if (Write(nullptr, 0))
@@ -124,8 +219,15 @@ void Maxima::SocketEvent(wxSocketEvent &event)
     break;
   case wxSOCKET_LOST:
   {
-    MaximaEvent discEvent(MaximaEvent::DISCONNECTED, this);
-    ProcessEvent(discEvent);
+    // The reader thread may still be handing over maxima's last words. Its
+    // final chunk tells ReadSocket() about the disconnect => we only need to
+    // report it ourselves if that chunk doesn't arrive in time.
+    bool const readerFinished = m_readerFinished;
+    ReadSocket();
+    if (readerFinished)
+      ReportDisconnect();
+    else if (!m_disconnectReported)
+      m_drainTimer.StartOnce(READER_DRAIN_TIMEOUT);
     break;
   }
   case wxSOCKET_CONNECTION:
@@ -141,54 +243,262 @@ void Maxima::TimerEvent(wxTimerEvent &event)
     MaximaEvent sendevent(MaximaEvent::READ_TIMEOUT, this, std::move(m_socketInputData));
     ProcessEvent(sendevent);
   }
-  else if (&event.GetTimer() == &m_readIdleTimer)
+  if (&event.GetTimer() == &m_drainTimer)
   {
-    // Let's keep the input from Maxima flowing in. This is a platform-specific
-    // workaround, so this timer is not guaranteed to fire at all.
     ReadSocket();
+    ReportDisconnect();
   }
 }
 
-void Maxima::ReadSocket()
+void Maxima::ReportDisconnect()
 {
-  // It is theoretically possible that the client has exited after sending us
-  // data and before we had been able to process it.
-  if (!m_socket->IsConnected() || !m_socket->IsData())
+  if (m_disconnectReported)
     return;
+  m_disconnectReported = true;
+  m_drainTimer.Stop();
+  MaximaEvent discEvent(MaximaEvent::DISCONNECTED, this);
+  ProcessEvent(discEvent);
+}
+
+void Maxima::EnableFraming()
+{
+  m_framing = true;
+}
+
+void Maxima::ReaderThread_Backgroundtask()
+{
+  auto const fd = m_socket->GetSocket();
+  // Read up to 64k of data in one go - or the rest of the current frame, if that
+  // is longer.
+  constexpr size_t readChunkSize = 65536;
 
-  // Read up to 64k of data in one go
-  constexpr auto readChunkSize = 65536;
-  if (!m_socketInput.Eof())
+  // Tells the GUI thread that we won't push any more chunks, however we exit.
+  struct FinishedFlag
   {
-    auto const decoded = DecodeFromSocket(readChunkSize);
-    m_socketInputData.append(decoded.output, decoded.outputSize);
-    if (decoded.bytesRead >= (readChunkSize - 16))
+    explicit FinishedFlag(std::atomic<bool> &flag) : m_flag(flag) {}
+    ~FinishedFlag() { m_flag = true; }
+    std::atomic<bool> &m_flag;
+  } const finished(m_readerFinished);
+
+  // When we last received data
+  auto lastData = std::chrono::steady_clock::now();
+
+  while (!m_stopReader)
+  {
+    // A frame that doesn't arrive completely within the string end timeout
+    // most probably was a frame header that was part of ordinary output.
+    if (m_framePending &&
+        (std::chrono::steady_clock::now() - lastData > std::chrono::milliseconds(STRING_END_TIMEOUT)))
     {
-      // More data is possibly available for reading, so let's schedule another
-      // read. "Losing" the input triggers is a frequent source of bugs,
-      // so it's best to play it safe and trigger a "continuation" read anyway.
-      // The 16 byte "margin of safety" is probably unnecessary but at least it'd protect
-      // against platform-specific off-by-one errors.
-      MaximaEvent event(MaximaEvent::READ_PENDING, this);
-      ProcessEvent(event);
-      CallAfter(&Maxima::ReadSocket);
-      return; // Don't process pending data further
+      ReaderChunk chunk;
+      DecodeRawInput(chunk.data);
+      m_framePending = false;
+      m_frameBytesMissing = 0;
+      if (!chunk.data.IsEmpty())
+        PushChunk(std::move(chunk));
     }
-  }
 
-  wxm::NormalizeEOLsRemoveNULs(m_socketInputData);
+    int const ready = WaitForInput(fd, READER_POLL_PERIOD);
+    if (ready == 0)
+      continue;
+    if ((ready < 0) && SocketErrorIsTransient())
+      continue;
+
+    ReaderChunk chunk;
+    if (ready < 0)
+    {
+      chunk.disconnected = true;
+      PushChunk(std::move(chunk));
+      return;
+    }
+
+    // The data is read directly into the end of the raw input buffer.
+    size_t const toRead = std::min(std::max(readChunkSize, m_frameBytesMissing),
+                                   static_cast<size_t>(std::numeric_limits<int>::max()));
+    void *const dest = m_rawInput.GetAppendBuf(toRead);
+    auto const bytesRead = recv(fd, static_cast<char *>(dest), static_cast<int>(toRead), 0);
+    if ((bytesRead < 0) && SocketErrorIsTransient())
+      continue;
+    if (bytesRead <= 0)
+    {
+      // Maxima has closed the connection (or the connection has broken down).
+      DecodeRawInput(chunk.data);
+      chunk.disconnected = true;
+      PushChunk(std::move(chunk));
+      return;
+    }
+    m_rawInput.UngetAppendBuf(bytesRead);
+    lastData = std::chrono::steady_clock::now();
+
+    // Complete frames don't need to wait for anything else.
+    if (m_framing && ExtractFrames(chunk.data))
+    {
+      chunk.complete = true;
+      PushChunk(std::move(chunk));
+      chunk = {};
+    }
+
+    // If we know that the rest of the current frame is underway there is no
+    // need to guess if the data we have is complete.
+    if (!m_framePending)
+    {
+      DecodeRawInput(chunk.data);
+      if (!chunk.data.IsEmpty())
+        PushChunk(std::move(chunk));
+    }
+  }
+}
 
+void Maxima::PushChunk(ReaderChunk &&chunk)
+{
+  wxm::NormalizeEOLsRemoveNULs(chunk.data);
   if (m_pipeToStdout)
-    std::cout << m_socketInputData;
+    std::cout << chunk.data;
 
-  if (m_first || wxm::EndsWithChar(m_socketInputData, '\n') || m_socketInputData.EndsWith(wxMaxima::m_promptSuffix))
+  // If the GUI thread cannot keep up we stop reading for a while, which
+  // eventually makes Maxima wait, too.
+  while (!m_readerOutput.Push(std::move(chunk)))
   {
-    m_stringEndTimer.Stop();
-    MaximaEvent event(MaximaEvent::READ_DATA, this, std::move(m_socketInputData));
-    ProcessEvent(event);
+    if (m_stopReader)
+      return;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
-  else
-    m_stringEndTimer.StartOnce(STRING_END_TIMEOUT);
+
+  if (!m_readRequested.exchange(true))
+    CallAfter(&Maxima::ReadSocket);
+}
+
+bool Maxima::ExtractFrames(wxString &output)
+{
+  Profiler::Scope timer(Profiler::socketRead);
+  auto *const begin = static_cast<const char *>(m_rawInput.GetData());
+  auto *const end = begin + m_rawInput.GetDataLen();
+  const char *consumed = begin;
+  const char *searchFrom = begin;
+  bool frameFound = false;
+  m_framePending = false;
+  m_frameBytesMissing = 0;
+
+  while (searchFrom < end)
+  {
+    auto *const frameStart = static_cast<const char *>(memchr(searchFrom, FRAME_START, end - searchFrom));
+    if (!frameStart)
+      break;
+
+    // Parse the header
+    const char *pos = frameStart + 1;
+    if (pos == end)
+    {
+      m_framePending = true;
+      break;
+    }
+    char const type = *pos++;
+    // Until maxima has acknowledged the framed protocol the only frame we
+    // accept is its empty hello frame.
+    bool const validType = m_framesAcknowledged ?
+      ((type == FRAME_MATH) || (type == FRAME_STATUS)) :
+      (type == FRAME_HELLO);
+    size_t length = 0;
+    const char *const lengthStart = pos;
+    while (validType && (pos < end) && (*pos >= '0') && (*pos <= '9') &&
+           (length <= MAX_FRAME_LENGTH))
+      length = 10 * length + (*pos++ - '0');
+    if (validType && (pos == end) && (length <= MAX_FRAME_LENGTH))
+    {
+      m_framePending = true;
+      break;
+    }
+    if (!validType || (*pos != FRAME_HEADER_END) || (pos == lengthStart) ||
+        (length > MAX_FRAME_LENGTH) || ((type == FRAME_HELLO) && (length != 0)))
+    {
+      // Just a stray start-of-header char in the unframed data
+      searchFrom = frameStart + 1;
+      continue;
+    }
+
+    // Do we have the whole payload?
+    auto *const payload = pos + 1;
+    if (static_cast<size_t>(end - payload) < length)
+    {
+      m_framePending = true;
+      m_frameBytesMissing = length - (end - payload);
+      break;
+    }
+
+    output += DecodeUTF8(consumed, frameStart - consumed);
+    if (type == FRAME_HELLO)
+    {
+      m_framesAcknowledged = true;
+      // wxLog isn't thread-safe => let the GUI thread do the logging.
+      CallAfter([](){wxLogMessage(_("Maxima has acknowledged the framed protocol."));});
+    }
+    else
+      output += DecodeUTF8(payload, length);
+    consumed = searchFrom = payload + length;
+    frameFound = true;
+  }
+
+  if (consumed != begin)
+  {
+    size_t const left = end - consumed;
+    memmove(m_rawInput.GetData(), consumed, left);
+    m_rawInput.SetDataLen(left);
+  }
+  return frameFound;
+}
+
+void Maxima::DecodeRawInput(wxString &output)
+{
+  Profiler::Scope timer(Profiler::socketRead);
+  auto *const data = static_cast<const char *>(m_rawInput.GetData());
+  size_t const length = m_rawInput.GetDataLen();
+  size_t const complete = CompleteUTF8Length(data, length);
+  if (complete == 0)
+    return;
+  output += DecodeUTF8(data, complete);
+  memmove(m_rawInput.GetData(), data + complete, length - complete);
+  m_rawInput.SetDataLen(length - complete);
+}
+
+void Maxima::ReadSocket()
+{
+  m_readRequested = false;
+
+  ReaderChunk chunk;
+  bool disconnected = false;
+  while (m_readerOutput.Pop(chunk))
+  {
+    if (m_socketInputData.IsEmpty())
+      m_socketInputData.swap(chunk.data);
+    else
+      m_socketInputData += chunk.data;
+    if (chunk.complete)
+      DispatchInput();
+    disconnected = disconnected || chunk.disconnected;
+  }
+
+  if (!m_socketInputData.IsEmpty())
+  {
+    if (m_first || wxm::EndsWithChar(m_socketInputData, '\n') ||
+        m_socketInputData.EndsWith(wxMaxima::m_promptSuffix) || disconnected)
+      DispatchInput();
+    else
+    {
+      MaximaEvent event(MaximaEvent::READ_PENDING, this);
+      ProcessEvent(event);
+      m_stringEndTimer.StartOnce(STRING_END_TIMEOUT);
+    }
+  }
+
+  if (disconnected)
+    ReportDisconnect();
+}
+
+void Maxima::DispatchInput()
+{
+  m_stringEndTimer.Stop();
+  MaximaEvent event(MaximaEvent::READ_DATA, this, std::move(m_socketInputData));
+  ProcessEvent(event);
 }
 
 MaximaEvent::MaximaEvent(MaximaEvent::Cause cause, Maxima *source, wxString &&data)
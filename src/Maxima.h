@@ -29,14 +29,15 @@
  * Declares the interface to the Maxima process.
  */
 
-#include "StreamUtils.h"
+#include "SPSCQueue.h"
 #include <wx/buffer.h>
 #include <wx/event.h>
-#include <wx/sckstrm.h>
 #include <wx/socket.h>
 #include <wx/string.h>
 #include <wx/timer.h>
+#include <atomic>
 #include <memory>
+#include <thread>
 
 /*! Interface to the Maxima process
  *
@@ -45,8 +46,10 @@
  * socket I/O.
  *
  * It is a source of EVT_MAXIMA events, used to asynchronously
- * decouple the I/O from the front-end. In the future, this class could run
- * on a worker thread perhaps (after it'd do more work in string processing).
+ * decouple the I/O from the front-end. Reading from the socket, UTF-8 decoding
+ * and splitting up frames is done by a background thread, so Maxima can keep
+ * on sending data while the GUI is busy. The decoded chunks are handed over to
+ * the GUI thread using a lock-free queue.
  */
 class Maxima : public wxEvtHandler
 {
@@ -71,18 +74,73 @@ public:
    * \returns true if writing was attempted, false if there's nothing else left to send.
    */
   bool Write(const void *buffer, size_t length);
+  //! Encodes data as UTF-8 directly into the transmit buffer and sends it to maxima.
+  bool Write(const wxString &data);
 
-  //! Read whatever data is in the socket. This is normally handled by the event handler,
-  //! but can be called manually to poll for data. Ideally, this should be private.
+  //! Process whatever data the reader thread has decoded. This is normally triggered
+  //! by the reader thread, but can be called manually to poll for data.
   void ReadSocket();
 
   //! Clear the first prompt state, based on what was read from maxima.
   //! This is called from prompt recognizer code in the wxMaxima class.
   void ClearFirstPrompt() { m_first = false; }
 
+  /*! Start looking for length-prefixed frames in the data from Maxima
+
+    wxMathML.lisp can send the messages wxMaxima parses as frames of the form
+    <code>\x01</code>, a type character, the payload's length in bytes in decimal,
+    <code>\x02</code> and the payload. A frame can be handed over to the worksheet
+    as soon as its last byte has arrived, without waiting for a newline, a
+    prompt or the string end timeout. Anything outside frames is handled
+    exactly as in unframed mode, so this is safe to call even if the
+    wxMathML.lisp in use doesn't know about frames.
+
+    Frames are only looked for after Maxima has acknowledged the framed
+    protocol with an empty hello frame. Frame headers that announce more than
+    16 MiB and frames that don't arrive completely within the string end
+    timeout are treated as ordinary text.
+   */
+  void EnableFraming();
+  bool IsFramingEnabled() const { return m_framing; }
+
+  //! The byte that starts a frame
+  static constexpr char FRAME_START = '\x01';
+  //! The byte that separates the frame header from the payload
+  static constexpr char FRAME_HEADER_END = '\x02';
+  //! The type of the empty frame Maxima acknowledges the framed protocol with
+  static constexpr char FRAME_HELLO = 'H';
+  //! The type of the frames that contain maths
+  static constexpr char FRAME_MATH = 'M';
+  //! The type of the frames that contain status bar messages
+  static constexpr char FRAME_STATUS = 'S';
+
 private:
-  //! Decodes input data from the socket
-  UTF8Decoder::DecodeResult DecodeFromSocket(size_t maxRead);
+  //! A piece of decoded text the reader thread hands over to the GUI thread
+  struct ReaderChunk
+  {
+    wxString data;
+    //! True if data ends with a complete frame, which means it can be dispatched right away.
+    bool complete = false;
+    //! True if the reader thread has found that Maxima has closed the connection.
+    bool disconnected = false;
+  };
+
+  //! The reader thread's main loop
+  void ReaderThread_Backgroundtask();
+  //! Called by the reader thread: Hands a chunk to the GUI thread
+  void PushChunk(ReaderChunk &&chunk);
+  /*! Moves all complete frames from m_rawInput to output
+
+    Only to be called from the reader thread.
+    \returns true, if at least one frame was complete.
+   */
+  bool ExtractFrames(wxString &output);
+  //! Moves all complete UTF-8 chars from m_rawInput to output. Called from the reader thread.
+  void DecodeRawInput(wxString &output);
+  //! Sends m_socketInputData to the event handler
+  void DispatchInput();
+  //! Informs the event handler that maxima has disconnected, if we didn't do so before
+  void ReportDisconnect();
 
   //! Handles events on the open client socket
   void SocketEvent(wxSocketEvent &event);
@@ -90,17 +148,38 @@ private:
   void TimerEvent(wxTimerEvent &event);
 
   std::unique_ptr<wxSocketBase> m_socket;
-  wxSocketInputStream m_socketInput{*m_socket};
-  UTF8Decoder m_decoder;
-  UTF8Decoder::State m_socketDecodeState;
+  //! The data from maxima that has been decoded, but not yet dispatched. GUI thread only.
   wxString m_socketInputData;
   wxMemoryBuffer m_socketOutputData;
+  //! Bytes the reader thread hasn't decoded, yet. Reader thread only.
+  wxMemoryBuffer m_rawInput;
+  //! The number of bytes of the frame we are currently receiving that didn't arrive, yet.
+  size_t m_frameBytesMissing = 0;
+  //! Does m_rawInput end in an incomplete frame? Reader thread only.
+  bool m_framePending = false;
+  //! Has maxima sent the frame that acknowledges the framed protocol? Reader thread only.
+  bool m_framesAcknowledged = false;
 
   bool m_first = true;
-  bool m_pipeToStdout = false;
+  std::atomic<bool> m_pipeToStdout{false};
+  //! Are we reading length-prefixed frames?
+  std::atomic<bool> m_framing{false};
+  //! Have we already told the event handler about a disconnect?
+  bool m_disconnectReported = false;
+
+  //! The chunks the reader thread has decoded
+  SPSCQueue<ReaderChunk, 256> m_readerOutput;
+  //! True while a ReadSocket() call the reader thread has requested is pending
+  std::atomic<bool> m_readRequested{false};
+  //! Tells the reader thread to exit
+  std::atomic<bool> m_stopReader{false};
+  //! Set by the reader thread when it has pushed its last chunk
+  std::atomic<bool> m_readerFinished{false};
+  std::unique_ptr<std::thread> m_readerThread;
 
   wxTimer m_stringEndTimer{this};
-  wxTimer m_readIdleTimer{this};
+  //! Reports the disconnect if the reader thread doesn't hand over its last chunk in time
+  wxTimer m_drainTimer{this};
 };
 
 class MaximaEvent : public wxEvent
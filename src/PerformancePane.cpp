@@ -0,0 +1,269 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+/*! \file
+  This file defines the class PerformancePane
+ */
+
+#define wxNO_UNSAFE_WXSTRING_CONV 1
+#include "PerformancePane.h"
+#include "Profiler.h"
+#include "Worksheet.h"
+#include <wx/filedlg.h>
+#include <algorithm>
+#include <numeric>
+
+//! How often the display is updated, in milliseconds
+static constexpr int updateInterval = 500;
+//! The number of cells the list of expensive cells displays
+static constexpr size_t listedCells = 100;
+
+//! Formats a duration in µs as milliseconds
+static wxString Milliseconds(double microseconds)
+{
+  return wxString::Format(wxT("%.2f"), microseconds / 1000.0);
+}
+
+//! Describes a cell by the start of its input
+static wxString DescribeCell(const GroupCell &cell)
+{
+  wxString description;
+  if (cell.GetEditable())
+    description = cell.GetEditable()->GetValue().BeforeFirst(wxT('\n'));
+  if (description.Length() > 60)
+    description = description.Left(60) + wxT("…");
+  return description;
+}
+
+PerformancePane::PerformancePane(wxWindow *parent, Worksheet *worksheet, wxWindowID id) :
+  wxPanel(parent, id),
+  m_worksheet(worksheet),
+  m_sortColumn(Profiler::cellCostCount)
+{
+  wxBoxSizer *vbox = new wxBoxSizer(wxVERTICAL);
+
+  wxBoxSizer *buttons = new wxBoxSizer(wxHORIZONTAL);
+  m_record = new wxCheckBox(this, wxID_ANY, _("Record timings"));
+  m_record->SetValue(Profiler::IsEnabled());
+  buttons->Add(m_record, wxSizerFlags().Center().Border(wxALL, 5));
+  wxButton *reset = new wxButton(this, wxID_ANY, _("Reset"));
+  buttons->Add(reset, wxSizerFlags().Border(wxALL, 5));
+  wxButton *exportTrace = new wxButton(this, wxID_ANY, _("Export trace..."));
+  exportTrace->SetToolTip(_("Saves the timings in a file chrome://tracing or ui.perfetto.dev can open, "
+                            "for example for attaching them to a bug report."));
+  buttons->Add(exportTrace, wxSizerFlags().Border(wxALL, 5));
+  vbox->Add(buttons);
+
+  m_frameTimes = new wxStaticText(this, wxID_ANY, wxEmptyString);
+  vbox->Add(m_frameTimes, wxSizerFlags().Expand().Border(wxALL, 5));
+  m_tileCacheStats = new wxStaticText(this, wxID_ANY, wxEmptyString);
+  m_tileCacheStats->SetToolTip(_("The worksheet keeps the parts of it that already have been drawn "
+                                 "as tiles that can be copied to the screen instead of being drawn again."));
+  vbox->Add(m_tileCacheStats, wxSizerFlags().Expand().Border(wxALL, 5));
+
+  m_probes = new wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxDefaultSize,
+                            wxLC_REPORT | wxLC_SINGLE_SEL);
+  m_probes->InsertColumn(0, _("Activity"));
+  m_probes->InsertColumn(1, _("Count"), wxLIST_FORMAT_RIGHT);
+  m_probes->InsertColumn(2, _("Mean [ms]"), wxLIST_FORMAT_RIGHT);
+  m_probes->InsertColumn(3, _("Max [ms]"), wxLIST_FORMAT_RIGHT);
+  m_probes->InsertColumn(4, _("Total [ms]"), wxLIST_FORMAT_RIGHT);
+  m_probes->InsertColumn(5, _("<1ms / <10ms / <100ms / slower"));
+  for (int probe = 0; probe < Profiler::probeCount; probe++)
+    m_probes->InsertItem(probe, Profiler::GetName(static_cast<Profiler::Probe>(probe)));
+  vbox->Add(m_probes, wxSizerFlags().Expand().Proportion(1));
+
+  vbox->Add(new wxStaticText(this, wxID_ANY,
+                             _("The most expensive cells (double-click to go to a cell):")),
+            wxSizerFlags().Border(wxALL, 5));
+  m_cells = new wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxDefaultSize,
+                           wxLC_REPORT | wxLC_SINGLE_SEL);
+  for (int cost = 0; cost < Profiler::cellCostCount; cost++)
+    m_cells->InsertColumn(cost, Profiler::GetName(static_cast<Profiler::CellCost>(cost)) +
+                          wxT(" [ms]"), wxLIST_FORMAT_RIGHT);
+  m_cells->InsertColumn(Profiler::cellCostCount, _("Total [ms]"), wxLIST_FORMAT_RIGHT);
+  m_cells->InsertColumn(Profiler::cellCostCount + 1, _("Cell"));
+  vbox->Add(m_cells, wxSizerFlags().Expand().Proportion(1));
+
+  m_record->Bind(wxEVT_CHECKBOX, &PerformancePane::OnRecord, this);
+  reset->Bind(wxEVT_BUTTON, &PerformancePane::OnReset, this);
+  exportTrace->Bind(wxEVT_BUTTON, &PerformancePane::OnExport, this);
+  m_cells->Bind(wxEVT_LIST_COL_CLICK, &PerformancePane::OnCellColumnClick, this);
+  m_cells->Bind(wxEVT_LIST_ITEM_ACTIVATED, &PerformancePane::OnCellActivated, this);
+  m_updateTimer.SetOwner(this);
+  Bind(wxEVT_TIMER, &PerformancePane::OnTimer, this);
+
+  UpdateDisplay();
+  SetSizerAndFit(vbox);
+}
+
+void PerformancePane::OnRecord(wxCommandEvent &WXUNUSED(event))
+{
+  Profiler::Enable(m_record->GetValue());
+  // Only a pane that displays something that changes needs to be updated
+  if (m_record->GetValue())
+    m_updateTimer.Start(updateInterval);
+  else
+  {
+    m_updateTimer.Stop();
+    UpdateDisplay();
+  }
+  // Show or hide the heat-map next to the cell brackets
+  m_worksheet->RequestRedraw();
+}
+
+void PerformancePane::OnReset(wxCommandEvent &WXUNUSED(event))
+{
+  Profiler::Reset();
+  m_worksheet->ResetTileCacheStats();
+  for (auto &cell : OnList(m_worksheet->GetTree()))
+    cell.ClearCosts();
+  UpdateDisplay();
+  m_worksheet->RequestRedraw();
+}
+
+void PerformancePane::OnExport(wxCommandEvent &WXUNUSED(event))
+{
+  wxFileDialog dialog(this, _("Export trace"), wxEmptyString, wxT("wxmaxima-trace.json"),
+                      _("Chrome trace (*.json)|*.json"), wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+  if (dialog.ShowModal() != wxID_OK)
+    return;
+  if (!Profiler::ExportChromeTrace(dialog.GetPath()))
+    wxLogError(_("Cannot write the trace to %s"), dialog.GetPath().utf8_str());
+}
+
+void PerformancePane::OnTimer(wxTimerEvent &WXUNUSED(event))
+{
+  // The cost gutters are part of the worksheet's cached tiles => they need to
+  // be redrawn explicitly whenever their colour changes.
+  for (auto &cell : OnList(m_worksheet->GetTree()))
+    if (cell.CostGutterChanged())
+      m_worksheet->RequestRedraw(cell.GetCostGutterRect());
+  if (IsShownOnScreen())
+    UpdateDisplay();
+}
+
+void PerformancePane::UpdateDisplay()
+{
+  auto const frames = Profiler::GetStatistics(Profiler::paint);
+  if (frames.recent.empty())
+    m_frameTimes->SetLabel(_("No frames have been drawn while recording."));
+  else
+  {
+    double const mean = std::accumulate(frames.recent.begin(), frames.recent.end(), 0.0) /
+      frames.recent.size();
+    m_frameTimes->SetLabel(
+      wxString::Format(_("Last frame: %s ms, mean of the last %li frames: %s ms"),
+                       Milliseconds(frames.recent.back()),
+                       static_cast<long>(frames.recent.size()),
+                       Milliseconds(mean)));
+  }
+
+  auto const &tiles = m_worksheet->GetTileCacheStats();
+  m_tileCacheStats->SetLabel(
+    wxString::Format(_("Cached tiles: %li (%li KiB), reused: %lu, drawn: %lu, dropped: %lu"),
+                     static_cast<long>(tiles.tiles), static_cast<long>(tiles.bytes / 1024),
+                     tiles.hits, tiles.renders, tiles.evictions));
+
+  for (int probe = 0; probe < Profiler::probeCount; probe++)
+  {
+    auto const stats = Profiler::GetStatistics(static_cast<Profiler::Probe>(probe));
+    // Bucket i of the histogram counts durations below 10^i µs
+    static_assert(Profiler::histogramBuckets == 7, "The histogram no longer ends at 100ms");
+    size_t below1ms = 0;
+    for (size_t bucket = 0; bucket <= 3; bucket++)
+      below1ms += stats.histogram[bucket];
+    size_t const below10ms = stats.histogram[4];
+    size_t const below100ms = stats.histogram[5];
+    size_t const slower = stats.histogram[6];
+    m_probes->SetItem(probe, 1, wxString::Format(wxT("%li"), static_cast<long>(stats.count)));
+    m_probes->SetItem(probe, 2, stats.count ? Milliseconds(double(stats.total) / stats.count) : wxString());
+    m_probes->SetItem(probe, 3, Milliseconds(stats.max));
+    m_probes->SetItem(probe, 4, Milliseconds(stats.total));
+    m_probes->SetItem(probe, 5, wxString::Format(wxT("%li / %li / %li / %li"),
+                                                 static_cast<long>(below1ms),
+                                                 static_cast<long>(below10ms),
+                                                 static_cast<long>(below100ms),
+                                                 static_cast<long>(slower)));
+  }
+
+  UpdateCellList();
+}
+
+void PerformancePane::UpdateCellList()
+{
+  m_listedCells.clear();
+  for (auto &cell : OnList(m_worksheet->GetTree()))
+    if (cell.GetCosts().Total() > 0)
+      m_listedCells.push_back(&cell);
+
+  auto const sortKey = [this](const GroupCell *cell) {
+    auto const &costs = cell->GetCosts();
+    if (m_sortColumn < Profiler::cellCostCount)
+      return costs.time[m_sortColumn];
+    return costs.Total();
+  };
+  size_t const count = std::min(listedCells, m_listedCells.size());
+  std::partial_sort(m_listedCells.begin(), m_listedCells.begin() + count, m_listedCells.end(),
+                    [&sortKey](const GroupCell *a, const GroupCell *b)
+                      { return sortKey(a) > sortKey(b); });
+  m_listedCells.resize(count);
+
+  m_cells->Freeze();
+  m_cells->DeleteAllItems();
+  for (size_t i = 0; i < m_listedCells.size(); i++)
+  {
+    auto const &costs = m_listedCells[i]->GetCosts();
+    m_cells->InsertItem(i, Milliseconds(costs.time[0]));
+    for (int cost = 1; cost < Profiler::cellCostCount; cost++)
+      m_cells->SetItem(i, cost, Milliseconds(costs.time[cost]));
+    m_cells->SetItem(i, Profiler::cellCostCount, Milliseconds(costs.Total()));
+    m_cells->SetItem(i, Profiler::cellCostCount + 1, DescribeCell(*m_listedCells[i]));
+  }
+  m_cells->Thaw();
+}
+
+void PerformancePane::OnCellColumnClick(wxListEvent &event)
+{
+  // The description column cannot be sorted by
+  if (event.GetColumn() > Profiler::cellCostCount)
+    return;
+  m_sortColumn = event.GetColumn();
+  UpdateCellList();
+}
+
+void PerformancePane::OnCellActivated(wxListEvent &event)
+{
+  long const index = event.GetIndex();
+  if ((index < 0) || (static_cast<size_t>(index) >= m_listedCells.size()))
+    return;
+  // The cell might have been deleted since the list has been updated
+  GroupCell *const wanted = m_listedCells[index];
+  for (auto &cell : OnList(m_worksheet->GetTree()))
+    if (&cell == wanted)
+    {
+      m_worksheet->SetHCaret(&cell);
+      m_worksheet->ScrollToCaret();
+      m_worksheet->SetFocus();
+      return;
+    }
+}
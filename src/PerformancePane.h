@@ -0,0 +1,80 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#ifndef PERFORMANCEPANE_H
+#define PERFORMANCEPANE_H
+
+/*! \file
+
+  This file declares the class PerformancePane that displays what the
+  Profiler has measured.
+ */
+
+#include "precomp.h"
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include <wx/panel.h>
+#include <wx/timer.h>
+#include <vector>
+
+class GroupCell;
+class Worksheet;
+
+/*! A "performance" sidepane
+
+  Lets the user start and stop recording timings, displays the times the
+  worksheet needs for drawing, the statistics of all probes and a sortable
+  list of the time each cell has cost, and exports a trace that can be
+  attached to bug reports. While recording a heat-map left of the cell
+  brackets shows which cells are expensive.
+ */
+class PerformancePane : public wxPanel
+{
+public:
+  PerformancePane(wxWindow *parent, Worksheet *worksheet, wxWindowID id = wxID_ANY);
+
+private:
+  //! Displays the newest measurements
+  void UpdateDisplay();
+  //! Displays the costs of the most expensive cells, sorted by m_sortColumn
+  void UpdateCellList();
+  void OnTimer(wxTimerEvent &event);
+  void OnRecord(wxCommandEvent &event);
+  void OnReset(wxCommandEvent &event);
+  void OnExport(wxCommandEvent &event);
+  void OnCellColumnClick(wxListEvent &event);
+  void OnCellActivated(wxListEvent &event);
+
+  Worksheet *m_worksheet;
+  wxCheckBox *m_record;
+  wxStaticText *m_frameTimes;
+  wxStaticText *m_tileCacheStats;
+  wxListCtrl *m_probes;
+  wxListCtrl *m_cells;
+  //! The cells m_cells displays, in the order it displays them
+  std::vector<GroupCell *> m_listedCells;
+  //! The column of m_cells the cells are sorted by
+  int m_sortColumn;
+  wxTimer m_updateTimer;
+};
+
+#endif // PERFORMANCEPANE_H
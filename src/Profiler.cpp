@@ -0,0 +1,244 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+/*! \file
+  This file defines the class Profiler
+ */
+
+#define wxNO_UNSAFE_WXSTRING_CONV 1
+#include "Profiler.h"
+#include "GroupCell.h"
+#include <wx/ffile.h>
+#include <wx/intl.h>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+std::atomic<bool> Profiler::m_enabled{false};
+std::atomic<std::int64_t> Profiler::m_maxCellCost{0};
+
+namespace {
+//! One entry of the trace
+struct TraceEvent
+{
+  Profiler::Probe probe;
+  //! An identifier of the thread the event happened in
+  size_t thread;
+  //! The start of the event, in µs since the profiler was started
+  std::int64_t start;
+  std::int64_t duration;
+};
+
+//! The number of trace events we keep
+constexpr size_t traceEvents = 65536;
+
+//! Everything the profiler has recorded. Only accessed with mutex locked.
+struct Recording
+{
+  std::mutex mutex;
+  std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+  std::array<Profiler::Statistics, Profiler::probeCount> statistics;
+  //! The newest durations of each probe, a ring buffer
+  std::array<std::array<std::int64_t, Profiler::recentDurations>, Profiler::probeCount> recent = {};
+  std::vector<TraceEvent> trace;
+  //! Where the next trace event goes to once trace is full
+  size_t traceEnd = 0;
+};
+
+Recording &GetRecording()
+{
+  static Recording recording;
+  return recording;
+}
+
+//! Escapes a string for use in JSON
+wxString JSONEscape(const wxString &text)
+{
+  wxString retval;
+  for (auto const ch : text)
+  {
+    switch (ch.GetValue())
+    {
+    case '"': retval += wxT("\\\""); break;
+    case '\\': retval += wxT("\\\\"); break;
+    case '\n': retval += wxT("\\n"); break;
+    case '\r': retval += wxT("\\r"); break;
+    case '\t': retval += wxT("\\t"); break;
+    default:
+      if (ch.GetValue() < 0x20)
+        retval += wxString::Format(wxT("\\u%04x"), static_cast<unsigned>(ch.GetValue()));
+      else
+        retval += ch;
+    }
+  }
+  return retval;
+}
+} // namespace
+
+void Profiler::Enable(bool enable)
+{
+  m_enabled = enable;
+}
+
+void Profiler::Reset()
+{
+  Recording &recording = GetRecording();
+  std::lock_guard<std::mutex> lock(recording.mutex);
+  recording.origin = Clock::now();
+  recording.statistics = {};
+  recording.recent = {};
+  recording.trace.clear();
+  recording.traceEnd = 0;
+  m_maxCellCost = 0;
+}
+
+void Profiler::Record(Probe probe, Clock::time_point start, Clock::time_point end)
+{
+  Recording &recording = GetRecording();
+  std::lock_guard<std::mutex> lock(recording.mutex);
+
+  using std::chrono::microseconds;
+  using std::chrono::duration_cast;
+  std::int64_t const duration = duration_cast<microseconds>(end - start).count();
+
+  Statistics &stats = recording.statistics[probe];
+  recording.recent[probe][stats.count % recentDurations] = duration;
+  stats.count++;
+  stats.total += duration;
+  stats.max = std::max(stats.max, duration);
+  size_t bucket = 0;
+  for (std::int64_t limit = 1; (bucket + 1 < histogramBuckets) && (duration >= limit); limit *= 10)
+    bucket++;
+  stats.histogram[bucket]++;
+
+  TraceEvent const event{probe, std::hash<std::thread::id>()(std::this_thread::get_id()),
+      duration_cast<microseconds>(start - recording.origin).count(), duration};
+  if (recording.trace.size() < traceEvents)
+    recording.trace.push_back(event);
+  else
+  {
+    recording.trace[recording.traceEnd] = event;
+    recording.traceEnd = (recording.traceEnd + 1) % traceEvents;
+  }
+}
+
+wxString Profiler::GetName(Probe probe)
+{
+  switch (probe)
+  {
+  case socketRead: return _("Decoding data from maxima");
+  case interpretData: return _("Interpreting maxima's output");
+  case parseLine: return _("Converting XML to cells");
+  case recalculate: return _("Laying out cells");
+  case paint: return _("Drawing the worksheet");
+  case imageDecode: return _("Decoding images");
+  case save: return _("Saving");
+  case exportDocument: return _("Exporting");
+  case probeCount: break;
+  }
+  return wxEmptyString;
+}
+
+Profiler::Statistics Profiler::GetStatistics(Probe probe)
+{
+  Recording &recording = GetRecording();
+  std::lock_guard<std::mutex> lock(recording.mutex);
+  Statistics stats = recording.statistics[probe];
+  size_t const recent = std::min(stats.count, recentDurations);
+  for (size_t i = stats.count - recent; i < stats.count; i++)
+    stats.recent.push_back(recording.recent[probe][i % recentDurations]);
+  return stats;
+}
+
+std::int64_t Profiler::CellCosts::Total() const
+{
+  std::int64_t total = 0;
+  for (auto const t : time)
+    total += t;
+  return total;
+}
+
+wxString Profiler::GetName(CellCost cost)
+{
+  switch (cost)
+  {
+  case cellParse: return _("Parse");
+  case cellLayout: return _("Layout");
+  case cellDraw: return _("Draw");
+  case cellEvaluation: return _("Evaluation");
+  case cellCostCount: break;
+  }
+  return wxEmptyString;
+}
+
+void Profiler::AddCellCost(GroupCell *cell, CellCost cost, Clock::duration duration)
+{
+  if ((!cell) || (!IsEnabled()))
+    return;
+  std::int64_t const total = cell->AddCost(
+    cost, std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+  // Only the GUI thread changes the maximum => no compare-and-swap needed
+  if (total > m_maxCellCost.load(std::memory_order_relaxed))
+    m_maxCellCost.store(total, std::memory_order_relaxed);
+}
+
+void Profiler::UpdateMaxCellCost(const GroupCell *tree)
+{
+  std::int64_t maxCost = 0;
+  for (auto const &cell : OnList(tree))
+    maxCost = std::max(maxCost, cell.GetCosts().Total());
+  m_maxCellCost.store(maxCost, std::memory_order_relaxed);
+}
+
+bool Profiler::ExportChromeTrace(const wxString &file)
+{
+  std::vector<TraceEvent> trace;
+  {
+    Recording &recording = GetRecording();
+    std::lock_guard<std::mutex> lock(recording.mutex);
+    trace.reserve(recording.trace.size());
+    trace.insert(trace.end(), recording.trace.begin() + recording.traceEnd, recording.trace.end());
+    trace.insert(trace.end(), recording.trace.begin(), recording.trace.begin() + recording.traceEnd);
+  }
+
+  wxString json = wxT("{\"traceEvents\":[\n");
+  bool first = true;
+  for (auto const &event : trace)
+  {
+    if (!first)
+      json += wxT(",\n");
+    first = false;
+    json += wxString::Format(
+      wxT("{\"name\":\"%s\",\"cat\":\"wxMaxima\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%lld,\"dur\":%lld}"),
+      JSONEscape(GetName(event.probe)),
+      static_cast<unsigned long>(event.thread % 1000000),
+      static_cast<long long>(event.start),
+      static_cast<long long>(event.duration));
+  }
+  json += wxT("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  wxFFile output(file, wxT("w"));
+  if (!output.IsOpened())
+    return false;
+  return output.Write(json, wxConvUTF8) && output.Close();
+}
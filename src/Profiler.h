@@ -0,0 +1,201 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#ifndef WXMAXIMA_PROFILER_H
+#define WXMAXIMA_PROFILER_H
+
+/*! \file
+
+  This file declares the class Profiler that measures how long the
+  time-critical parts of wxMaxima take.
+ */
+
+#include <wx/string.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+class GroupCell;
+
+/*! Measures how long the time-critical parts of wxMaxima take
+
+  The probes are always compiled in. As long as recording is disabled a probe
+  costs nothing but reading an atomic flag; while it is enabled each probe
+  updates a counter, a histogram of its durations and a ring buffer of trace
+  events that can be exported in the format Chrome's about:tracing and
+  Perfetto understand. The time the GUI spends on parsing, laying out,
+  drawing and evaluating is additionally attributed to the GroupCell that
+  caused it, which allows to find the cells that make a worksheet slow.
+
+  Unless stated otherwise all functions may be called from any thread.
+ */
+class Profiler
+{
+public:
+  //! The things we measure
+  enum Probe
+  {
+    socketRead,    //!< Decoding the data read from maxima (reader thread)
+    interpretData, //!< Interpreting the data from maxima
+    parseLine,     //!< Converting maxima's XML to cells
+    recalculate,   //!< Laying out a GroupCell
+    paint,         //!< Drawing the worksheet
+    imageDecode,   //!< Decoding an image
+    save,          //!< Saving the worksheet
+    exportDocument, //!< Exporting the worksheet to HTML or LaTeX
+    probeCount     //!< Must be the last entry
+  };
+
+  /*! The number of histogram buckets.
+
+    Bucket i counts durations below 10^i µs that didn't fit into bucket i-1.
+    The last bucket counts everything that is slower.
+   */
+  static constexpr size_t histogramBuckets = 7;
+  //! The number of recent durations each probe remembers
+  static constexpr size_t recentDurations = 64;
+
+  //! What we know about one probe
+  struct Statistics
+  {
+    size_t count = 0;
+    //! The sum of all durations, in µs
+    std::int64_t total = 0;
+    //! The longest duration, in µs
+    std::int64_t max = 0;
+    //! How many durations fell into each power-of-10 bucket
+    std::array<size_t, histogramBuckets> histogram = {};
+    //! The newest durations in µs, oldest first
+    std::vector<std::int64_t> recent;
+  };
+
+  //! The kinds of work the profiler attributes to the GroupCell that caused them
+  enum CellCost
+  {
+    cellParse,      //!< Converting maxima's XML to the cell's output
+    cellLayout,     //!< Laying out the cell's input and output and breaking its lines
+    cellDraw,       //!< Drawing the cell
+    cellEvaluation, //!< The time between sending a command and maxima's next prompt
+    cellCostCount   //!< Must be the last entry
+  };
+
+  //! The time a GroupCell has cost while the profiler was recording, in µs
+  struct CellCosts
+  {
+    std::array<std::int64_t, cellCostCount> time = {};
+    std::int64_t Total() const;
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  //! Measures the time between its construction and its destruction
+  class Scope
+  {
+  public:
+    explicit Scope(Probe probe) :
+      m_probe(probe), m_active(IsEnabled())
+      {
+        if (m_active)
+          m_start = Clock::now();
+      }
+    ~Scope()
+      {
+        if (m_active)
+          Record(m_probe, m_start, Clock::now());
+      }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+  private:
+    Probe m_probe;
+    bool m_active;
+    Clock::time_point m_start;
+  };
+
+  /*! Adds the time between its construction and its destruction to a cell's costs
+
+    Only to be used in the GUI thread, as only this thread may access cells.
+   */
+  class CellScope
+  {
+  public:
+    CellScope(GroupCell *cell, CellCost cost) :
+      m_cell(cell), m_cost(cost), m_active(cell && IsEnabled())
+      {
+        if (m_active)
+          m_start = Clock::now();
+      }
+    ~CellScope()
+      {
+        if (m_active)
+          AddCellCost(m_cell, m_cost, Clock::now() - m_start);
+      }
+    CellScope(const CellScope &) = delete;
+    CellScope &operator=(const CellScope &) = delete;
+  private:
+    GroupCell *m_cell;
+    CellCost m_cost;
+    bool m_active;
+    Clock::time_point m_start;
+  };
+
+  //! Are we recording?
+  static bool IsEnabled() { return m_enabled.load(std::memory_order_relaxed); }
+  //! Starts or stops recording
+  static void Enable(bool enable);
+  //! Forgets everything that has been recorded so far
+  static void Reset();
+
+  //! The human-readable name of a probe
+  static wxString GetName(Probe probe);
+  static Statistics GetStatistics(Probe probe);
+
+  //! The human-readable name of a cell cost
+  static wxString GetName(CellCost cost);
+  /*! Adds a duration to a cell's costs, if we are recording
+
+    Only to be called from the GUI thread.
+   */
+  static void AddCellCost(GroupCell *cell, CellCost cost, Clock::duration duration);
+  //! The highest total cost of a cell since the last Reset(), in µs
+  static std::int64_t GetMaxCellCost() { return m_maxCellCost.load(std::memory_order_relaxed); }
+  /*! Re-determines GetMaxCellCost() from the cells that still exist
+
+    Needed after cells have been deleted. Only to be called from the GUI thread.
+   */
+  static void UpdateMaxCellCost(const GroupCell *tree);
+
+  /*! Writes the newest trace events to a file in Chrome's trace event format
+
+    \returns false, if the file could not be written.
+  */
+  static bool ExportChromeTrace(const wxString &file);
+
+private:
+  static void Record(Probe probe, Clock::time_point start, Clock::time_point end);
+
+  static std::atomic<bool> m_enabled;
+  static std::atomic<std::int64_t> m_maxCellCost;
+};
+
+#endif // WXMAXIMA_PROFILER_H
@@ -0,0 +1,90 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#ifndef WXMAXIMA_SPSCQUEUE_H
+#define WXMAXIMA_SPSCQUEUE_H
+
+/*! \file
+ *
+ * A lock-free queue that hands objects from one thread to another.
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/*! A bounded lock-free single-producer single-consumer queue
+
+  Exactly one thread may call Push() and exactly one (other) thread may call
+  Pop(). The queue can hold Capacity - 1 elements. Elements are moved in and
+  out, so a string that is handed over is never shared between the threads.
+ */
+template <typename T, std::size_t Capacity>
+class SPSCQueue
+{
+  static_assert(Capacity >= 2, "The queue needs room for at least one element");
+public:
+  /*! Moves an element into the queue
+
+    \returns false, if the queue is full. In this case value is left untouched.
+   */
+  bool Push(T &&value)
+    {
+      auto const head = m_head.load(std::memory_order_relaxed);
+      auto const next = Next(head);
+      if (next == m_tail.load(std::memory_order_acquire))
+        return false;
+      m_slots[head] = std::move(value);
+      m_head.store(next, std::memory_order_release);
+      return true;
+    }
+
+  /*! Moves the oldest element out of the queue
+
+    \returns false, if the queue was empty.
+   */
+  bool Pop(T &value)
+    {
+      auto const tail = m_tail.load(std::memory_order_relaxed);
+      if (tail == m_head.load(std::memory_order_acquire))
+        return false;
+      value = std::move(m_slots[tail]);
+      m_slots[tail] = T();
+      m_tail.store(Next(tail), std::memory_order_release);
+      return true;
+    }
+
+  //! True if there is nothing to Pop(). Only exact if called by one of the two threads.
+  bool IsEmpty() const
+    { return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire); }
+
+private:
+  static std::size_t Next(std::size_t index) { return (index + 1) % Capacity; }
+
+  std::array<T, Capacity> m_slots;
+  //! The slot the next element will be written to. Only written by the producer.
+  std::atomic<std::size_t> m_head{0};
+  //! The slot the next element will be read from. Only written by the consumer.
+  std::atomic<std::size_t> m_tail{0};
+};
+
+#endif
@@ -33,11 +33,30 @@
 #include <wx/rawbmp.h>
 #include "Image.h"
 #include "invalidImage.h"
+#include "Dirstructure.h"
+#include "Version.h"
+#include "ErrorRedirector.h"
+#include <wx/dir.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-SvgBitmap::SvgBitmap(const unsigned char *data, size_t len, int width, int height, int scaleFactor)
+//! The minimum height of the bands SvgBitmap::Rasterize() renders in parallel
+static constexpr int minBandHeight = 128;
+
+//! The first line of an icon cache file; ends in the version that has written the file
+static const char iconCacheMagic[] = "wxMaxima icon cache " GITVERSION "\n";
+
+//! Unzips an .svgz image and appends the NUL terminator nsvgParse() needs
+static std::vector<char> Unzip(const unsigned char *data, size_t len)
 {
-  m_scaleFactor = scaleFactor;
-  // Unzip the .svgz image
   wxMemoryInputStream istream(data, len);
   wxZlibInputStream zstream(istream);
   std::vector<char> svgContents;
@@ -52,6 +71,16 @@ SvgBitmap::SvgBitmap(const unsigned char *data, size_t len, int width, int heigh
       svgContents.resize(baseSize + zstream.LastRead());
   }
   svgContents.push_back('\0');
+  return svgContents;
+}
+
+//! The icons GetIcon() has already rendered or read, by their cache file name
+static std::unordered_map<wxString, std::vector<unsigned char>, wxStringHash> renderedIcons;
+
+SvgBitmap::SvgBitmap(const unsigned char *data, size_t len, int width, int height, int scaleFactor)
+{
+  m_scaleFactor = scaleFactor;
+  std::vector<char> svgContents = Unzip(data, len);
 
   // Render the .svgz image
   if (!m_svgRast)
@@ -81,30 +110,13 @@ const SvgBitmap &SvgBitmap::SetSize(int width, int height)
   std::vector<unsigned char> imgdata((long)width*height*4);
 
   // Actually render the bitmap
-  nsvgRasterize(m_svgRast, m_svgImage.get(), 0,0,
-                wxMin((double)width/(double)m_svgImage->width,
-                      (double)height/(double)m_svgImage->height),
-                imgdata.data(),
-                width, height, width*4);
+  Rasterize(m_svgRast, m_svgImage.get(),
+            wxMin((double)width/(double)m_svgImage->width,
+                  (double)height/(double)m_svgImage->height),
+            imgdata.data(), width, height);
 
   // Copy the bitmap to this object's bitmap storage
-  wxAlphaPixelData bmpdata(*this);
-  wxAlphaPixelData::Iterator dst(bmpdata);
-  const unsigned char* rgba = imgdata.data();
-  for( int y = 0; y < height; y++)
-  {
-    dst.MoveTo(bmpdata, 0, y);
-    for(int x = 0; x < width; x++)
-    {
-      unsigned char a = rgba[3];
-      dst.Red() = rgba[0] * a / 255;
-      dst.Green() = rgba[1] * a / 255;
-      dst.Blue() = rgba[2] * a / 255;
-      dst.Alpha() = a;
-      dst++;
-      rgba += 4;
-    }
-  }
+  CopyRGBA(imgdata.data(), *this, width, height);
   return *this;
 }
 
@@ -143,27 +155,254 @@ wxBitmap SvgBitmap::RGBA2wxBitmap(const unsigned char imgdata[],
   #else
   wxBitmap retval = wxBitmap(width, height, 32);
   #endif
-  const unsigned char* rgba = imgdata;
   if(!retval.Ok())
     return retval;
-  
-  wxAlphaPixelData bmpdata(retval);
+
+  CopyRGBA(imgdata, retval, width, height);
+  return retval;
+}
+
+void SvgBitmap::Rasterize(NSVGrasterizer *rasterizer, NSVGimage *image, double scale,
+                          unsigned char *rgba, int width, int height)
+{
+  int const stride = width * 4;
+  int const bands = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()),
+                                         height / minBandHeight));
+  if (bands < 2)
+  {
+    nsvgRasterize(rasterizer, image, 0, 0, scale, rgba, width, height, stride);
+    return;
+  }
+
+  // Each band renders the image moved up by the band's top, clipped to
+  // the band's height. nanoSVG doesn't modify the image while rendering it
+  // => all bands can share it.
+  int const bandHeight = (height + bands - 1) / bands;
+  auto const renderBand = [=](NSVGrasterizer *bandRasterizer, int top) {
+    int const rows = std::min(bandHeight, height - top);
+    if (rows > 0)
+      nsvgRasterize(bandRasterizer, image, 0, -top, scale, rgba + top * stride,
+                    width, rows, stride);
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(bands - 1);
+  for (int band = 1; band < bands; band++)
+    threads.emplace_back([=]() {
+      std::unique_ptr<NSVGrasterizer, decltype(&nsvgDeleteRasterizer)>
+        bandRasterizer(nsvgCreateRasterizer(), &nsvgDeleteRasterizer);
+      if (bandRasterizer)
+        renderBand(bandRasterizer.get(), band * bandHeight);
+    });
+  renderBand(rasterizer, 0);
+  for (auto &thread : threads)
+    thread.join();
+}
+
+//! Divides a product of two 8-bit values by 255, without a division
+static inline unsigned char DivideBy255(unsigned int value)
+{
+  return static_cast<unsigned char>((value + 1 + (value >> 8)) >> 8);
+}
+
+void SvgBitmap::CopyRGBA(const unsigned char *rgba, wxBitmap &bitmap, int width, int height)
+{
+  wxAlphaPixelData bmpdata(bitmap);
+  if (!bmpdata)
+    return;
   wxAlphaPixelData::Iterator dst(bmpdata);
   for( int y = 0; y < height; y++)
   {
     dst.MoveTo(bmpdata, 0, y);
+    // Neither branches nor divisions => the compiler can vectorize this loop.
     for(int x = 0; x < width; x++)
     {
-      unsigned char a = rgba[3];
-      dst.Red() = rgba[0] * a / 255;
-      dst.Green() = rgba[1] * a / 255;
-      dst.Blue() = rgba[2] * a / 255;
+      unsigned int const a = rgba[3];
+      dst.Red() = DivideBy255(rgba[0] * a);
+      dst.Green() = DivideBy255(rgba[1] * a);
+      dst.Blue() = DivideBy255(rgba[2] * a);
       dst.Alpha() = a;
-      dst++;
-          rgba += 4;
+      ++dst;
+      rgba += 4;
     }
   }
-  return retval;
+}
+
+std::vector<unsigned char> SvgBitmap::RenderIcon(const IconData &icon, wxSize size)
+{
+  std::vector<unsigned char> rgba;
+  std::vector<char> svgContents = Unzip(icon.data, icon.len);
+  if (svgContents.size() < 2)
+    return rgba;
+  std::unique_ptr<NSVGimage, decltype(&nsvgDelete)>
+    image(nsvgParse(svgContents.data(), "px", 96), &nsvgDelete);
+  std::unique_ptr<NSVGrasterizer, decltype(&nsvgDeleteRasterizer)>
+    rasterizer(nsvgCreateRasterizer(), &nsvgDeleteRasterizer);
+  if ((!image) || (!rasterizer) || (image->width <= 0) || (image->height <= 0))
+    return rgba;
+  rgba.resize(static_cast<size_t>(size.x) * size.y * 4);
+  nsvgRasterize(rasterizer.get(), image.get(), 0, 0,
+                wxMin((double)size.x / (double)image->width,
+                      (double)size.y / (double)image->height),
+                rgba.data(), size.x, size.y, size.x * 4);
+  return rgba;
+}
+
+wxString SvgBitmap::IconCacheName(const IconData &icon, wxSize size)
+{
+  // FNV-1a. Two icons with the same checksum would need to have the same
+  // length, too, in order to be confused.
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < icon.len; i++)
+    hash = (hash ^ icon.data[i]) * 16777619u;
+  return wxString::Format(wxT("%08x_%lu_%ix%i.rgba"), hash,
+                          static_cast<unsigned long>(icon.len), size.x, size.y);
+}
+
+bool SvgBitmap::ReadCachedIcon(const wxString &name, wxSize size, std::vector<unsigned char> &rgba)
+{
+  wxString const filename = Dirstructure::IconCacheDir() + wxT("/") + name;
+  if (!wxFileExists(filename))
+    return false;
+  wxFile file(filename);
+  if (!file.IsOpened())
+    return false;
+  size_t const headerLength = sizeof(iconCacheMagic) - 1;
+  size_t const dataLength = static_cast<size_t>(size.x) * size.y * 4;
+  if (file.Length() != static_cast<wxFileOffset>(headerLength + dataLength))
+    return false;
+  char header[sizeof(iconCacheMagic)];
+  if ((file.Read(header, headerLength) != static_cast<ssize_t>(headerLength)) ||
+      (std::memcmp(header, iconCacheMagic, headerLength) != 0))
+    return false;
+  rgba.resize(dataLength);
+  if (file.Read(rgba.data(), dataLength) != static_cast<ssize_t>(dataLength))
+  {
+    rgba.clear();
+    return false;
+  }
+  return true;
+}
+
+void SvgBitmap::WriteCachedIcon(const wxString &name, const std::vector<unsigned char> &rgba)
+{
+  wxString const dir = Dirstructure::IconCacheDir();
+  if ((!wxDirExists(dir)) && (!wxFileName::Mkdir(dir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)))
+    return;
+  // wxTempFile only replaces the old file once everything has been written
+  // => a second wxMaxima process never reads a half-written icon.
+  wxTempFile file(dir + wxT("/") + name);
+  if (!file.IsOpened())
+    return;
+  if (file.Write(iconCacheMagic, sizeof(iconCacheMagic) - 1) &&
+      file.Write(rgba.data(), rgba.size()))
+    file.Commit();
+  else
+    file.Discard();
+}
+
+void SvgBitmap::PurgeIconCache()
+{
+  wxString const dir = Dirstructure::IconCacheDir();
+  if (!wxDirExists(dir))
+    return;
+  SuppressErrorDialogs suppressor;
+  wxArrayString files;
+  wxDir::GetAllFiles(dir, &files, wxT("*.rgba"), wxDIR_FILES);
+  size_t const headerLength = sizeof(iconCacheMagic) - 1;
+  long purged = 0;
+  for (auto const &filename : files)
+  {
+    char header[sizeof(iconCacheMagic)];
+    bool current = false;
+    {
+      wxFile file(filename);
+      current = file.IsOpened() &&
+        (file.Read(header, headerLength) == static_cast<ssize_t>(headerLength)) &&
+        (std::memcmp(header, iconCacheMagic, headerLength) == 0);
+    }
+    if ((!current) && wxRemoveFile(filename))
+      purged++;
+  }
+  if (purged > 0)
+    wxLogMessage(wxString::Format(_("Deleted %li outdated icons from the icon cache"), purged));
+}
+
+wxBitmap SvgBitmap::GetIcon(const IconData &icon, wxSize size)
+{
+  wxString const name = IconCacheName(icon, size);
+  auto rendered = renderedIcons.find(name);
+  if (rendered == renderedIcons.end())
+  {
+    std::vector<unsigned char> rgba;
+    if (!ReadCachedIcon(name, size, rgba))
+    {
+      rgba = RenderIcon(icon, size);
+      if (rgba.empty())
+        return GetInvalidBitmap(size.x);
+      WriteCachedIcon(name, rgba);
+    }
+    rendered = renderedIcons.emplace(name, std::move(rgba)).first;
+  }
+  return RGBA2wxBitmap(rendered->second.data(), size.x, size.y);
+}
+
+void SvgBitmap::PrepareIcons(const std::vector<IconData> &icons, wxSize size)
+{
+  wxStopWatch stopwatch;
+  static bool cachePurged = false;
+  if (!cachePurged)
+  {
+    cachePurged = true;
+    PurgeIconCache();
+  }
+  // Read all icons the disk cache knows about, and collect the others.
+  std::vector<std::pair<wxString, const IconData *>> missing;
+  for (auto const &icon : icons)
+  {
+    wxString name = IconCacheName(icon, size);
+    if (renderedIcons.find(name) != renderedIcons.end())
+      continue;
+    std::vector<unsigned char> rgba;
+    if (ReadCachedIcon(name, size, rgba))
+      renderedIcons.emplace(name, std::move(rgba));
+    else
+      missing.emplace_back(std::move(name), &icon);
+  }
+  if (missing.empty())
+    return;
+
+  // Render the missing icons in parallel: Each thread picks the next icon
+  // no thread has taken yet, until no icon is left.
+  std::vector<std::vector<unsigned char>> results(missing.size());
+  std::atomic<size_t> next(0);
+  auto const renderIcons = [&]() {
+    size_t i;
+    while ((i = next++) < missing.size())
+      results[i] = RenderIcon(*missing[i].second, size);
+  };
+  size_t const threadCount =
+    std::min(static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency())),
+             missing.size());
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount - 1);
+  for (size_t i = 1; i < threadCount; i++)
+    threads.emplace_back(renderIcons);
+  renderIcons();
+  for (auto &thread : threads)
+    thread.join();
+
+  for (size_t i = 0; i < missing.size(); i++)
+  {
+    if (results[i].empty())
+      continue;
+    WriteCachedIcon(missing[i].first, results[i]);
+    renderedIcons.emplace(missing[i].first, std::move(results[i]));
+  }
+  wxLogMessage(wxString::Format(_("Rendered %li of %li icons at %ix%i pixels in %li ms"),
+                                static_cast<long>(missing.size()),
+                                static_cast<long>(icons.size()),
+                                size.x, size.y, stopwatch.Time()));
 }
 
 struct NSVGrasterizer* SvgBitmap::m_svgRast = NULL;
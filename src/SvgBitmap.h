@@ -32,6 +32,7 @@
 
 #include "precomp.h"
 #include <wx/bitmap.h>
+#include <vector>
 #define NANOSVG_ALL_COLOR_KEYWORDS
 #include "nanoSVG/nanosvg.h"
 #include "nanoSVG/nanosvgrast.h"
@@ -50,6 +51,35 @@ public:
 
   //! Converts rgba data to a wxBitmap
   static wxBitmap RGBA2wxBitmap(const unsigned char imgdata[],const int &width, const int &height, const int &scaleFactor = 1);
+  /*! Renders an svg image to rgba data
+
+    Big images are split into horizontal bands that are rendered in parallel,
+    each by a rasterizer of its own. The first band is rendered by the calling
+    thread using the rasterizer that is passed to this function.
+   */
+  static void Rasterize(NSVGrasterizer *rasterizer, NSVGimage *image, double scale,
+                        unsigned char *rgba, int width, int height);
+  //! An svgz image that is compiled into wxMaxima
+  struct IconData
+  {
+    const unsigned char *data;
+    size_t len;
+  };
+  /*! Returns an icon rendered at a given size
+
+    Rendered icons are kept in memory and in Dirstructure::IconCacheDir(),
+    keyed by a checksum of the svgz data and the size in pixels. The cache
+    files contain the version of wxMaxima they have been created by and are
+    overwritten by any other version. Must be called from the GUI thread.
+   */
+  static wxBitmap GetIcon(const IconData &icon, wxSize size);
+  /*! Makes sure that GetIcon() will find all of the icons at the given size
+
+    Icons that are neither in memory nor in the on-disk cache are rendered in
+    parallel. The first call also deletes the cache files older versions of
+    wxMaxima have left behind. Must be called from the GUI thread.
+   */
+  static void PrepareIcons(const std::vector<IconData> &icons, wxSize size);
   //! Sets the bitmap to a new size and renders the svg image at this size.
   const SvgBitmap& SetSize(int width, int height);
   //! Sets the bitmap to a new size and renders the svg image at this size.
@@ -67,6 +97,18 @@ public:
    */
   static wxBitmap GetInvalidBitmap(int targetSize);
 private:
+  //! Unzips, parses and renders an icon. Thread-safe; returns no data on failure.
+  static std::vector<unsigned char> RenderIcon(const IconData &icon, wxSize size);
+  //! The name of the file an icon is cached in, relative to the cache directory
+  static wxString IconCacheName(const IconData &icon, wxSize size);
+  //! Reads a cached icon, if there is one that was created by this version of wxMaxima
+  static bool ReadCachedIcon(const wxString &name, wxSize size, std::vector<unsigned char> &rgba);
+  //! Writes an icon to the cache
+  static void WriteCachedIcon(const wxString &name, const std::vector<unsigned char> &rgba);
+  //! Deletes all cached icons that weren't created by this version of wxMaxima
+  static void PurgeIconCache();
+  //! Copies rgba data to a bitmap, premultiplying the colors with the alpha channel
+  static void CopyRGBA(const unsigned char *rgba, wxBitmap &bitmap, int width, int height);
   //! The scale factor the bitmap is created with
   int m_scaleFactor;
   //! No idea what nanoSVG stores here. But can be shared between images.
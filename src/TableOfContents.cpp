@@ -30,6 +30,7 @@
 #include "TableOfContents.h"
 
 #include <wx/sizer.h>
+#include <algorithm>
 #include <list>
 
 TableOfContents::TableOfContents(wxWindow *parent, int id, Configuration **config, std::unique_ptr<GroupCell> *tree) :
@@ -233,107 +234,178 @@ TableOfContents::~TableOfContents()
   }
 }
 
+int TableOfContents::TocDepth(GroupType type)
+{
+  // Indentation further reduces the screen real-estate. So it is to be used
+  // sparingly. But we should perhaps add at least a little bit of it to make
+  // the list more readable.
+  switch (type)
+  {
+  case GC_TYPE_TITLE:
+    return 0;
+  case GC_TYPE_SECTION:
+    return 1;
+  case GC_TYPE_SUBSECTION:
+    return 2;
+  case GC_TYPE_SUBSUBSECTION:
+    return 3;
+  case GC_TYPE_HEADING5:
+    return 4;
+  case GC_TYPE_HEADING6:
+    return 5;
+  default:
+    return -1;
+  }
+}
+
+TableOfContents::TocEntry TableOfContents::CreateEntry(GroupCell *cell, const wxString &title,
+                                                      const wxString &number, bool showsNumber)
+{
+  TocEntry entry;
+  entry.cell = cell;
+  entry.type = cell->GetGroupType();
+  entry.title = title;
+  entry.number = number;
+  entry.showsNumber = showsNumber;
+  entry.text = TocEntryString(cell);
+  entry.matches = m_regex->Matches(entry.text);
+  return entry;
+}
+
 void TableOfContents::UpdateStruct()
 {
-  m_structure.clear();
+  if (!m_structureOutdated)
+  {
+    // If only titles have changed the headings don't need to be searched for
+    // and the worksheet's order stays the same.
+    for (auto const cell : m_changedHeadings)
+    {
+      auto const index = m_structureIndex.find(cell);
+      if ((index == m_structureIndex.end()) || (index->second >= m_structure.size()) ||
+          (m_structure[index->second].type != cell->GetGroupType()))
+      {
+        m_structureOutdated = true;
+        break;
+      }
+      TocEntry &entry = m_structure[index->second];
+      wxString title;
+      if (entry.cell->GetEditable())
+        title = entry.cell->GetEditable()->GetValue();
+      if (entry.title != title)
+        entry = CreateEntry(entry.cell, title, entry.number, entry.showsNumber);
+    }
+    m_changedHeadings.clear();
+    if (!m_structureOutdated)
+      return;
+  }
+  m_structureOutdated = false;
+  m_changedHeadings.clear();
+
+  std::vector<TocEntry> structure;
+  std::unordered_map<const GroupCell *, size_t> structureIndex;
+  m_cellOrder.clear();
+  m_structureOrder.clear();
+  bool const showsNumbers = (*m_configuration)->TocShowsSectionNumbers();
 
   // Get the current list of tokens that should be in the Table Of Contents.
+  size_t order = 0;
   for (auto &cell : OnList(m_tree->get()))
   {
-    int groupType = cell.GetGroupType();
-    if (
-      (groupType == GC_TYPE_TITLE) ||
-      (groupType == GC_TYPE_SECTION) ||
-      (groupType == GC_TYPE_SUBSECTION) ||
-      (groupType == GC_TYPE_SUBSUBSECTION) ||
-      (groupType == GC_TYPE_HEADING5) ||
-      (groupType == GC_TYPE_HEADING6)
-      )
-      m_structure.push_back(&cell);
+    m_cellOrder[&cell] = order;
+    if (TocDepth(cell.GetGroupType()) >= 0)
+    {
+      wxString title;
+      if (cell.GetEditable())
+        title = cell.GetEditable()->GetValue();
+      wxString number;
+      if (showsNumbers && cell.GetPrompt())
+        number = cell.GetPrompt()->ToString();
+
+      // Generating the text of an entry and matching it against the regex
+      // isn't for free => headings that haven't changed keep their entry.
+      TocEntry *old = NULL;
+      auto const oldIndex = m_structureIndex.find(&cell);
+      if ((oldIndex != m_structureIndex.end()) && (oldIndex->second < m_structure.size()))
+        old = &m_structure[oldIndex->second];
+      structureIndex[&cell] = structure.size();
+      m_structureOrder.push_back(order);
+      if (old && (old->cell == &cell) && (old->type == cell.GetGroupType()) &&
+          (old->showsNumber == showsNumbers) && (old->title == title) && (old->number == number))
+        structure.push_back(std::move(*old));
+      else
+        structure.push_back(CreateEntry(&cell, title, number, showsNumbers));
+    }
+    order++;
+  }
+  m_structure = std::move(structure);
+  m_structureIndex = std::move(structureIndex);
+}
 
+long TableOfContents::FindSection(GroupCell *pos) const
+{
+  // Cells that have been created since the last UpdateStruct() aren't known
+  // => we use the position of the first known cell above them.
+  auto order = m_cellOrder.end();
+  for (; pos != NULL; pos = pos->GetPrevious())
+  {
+    order = m_cellOrder.find(pos);
+    if (order != m_cellOrder.end())
+      break;
   }
+  if (pos == NULL)
+    return -1;
+
+  // The section pos is in is the last heading that isn't below pos
+  auto const next = std::upper_bound(m_structureOrder.begin(), m_structureOrder.end(), order->second);
+  return long(next - m_structureOrder.begin()) - 1;
 }
 
 void TableOfContents::UpdateTableOfContents(GroupCell *pos)
 {
-  long selection = m_lastSelection;
-  if (IsShown())
+  if (!IsShown())
+    return;
+
+  UpdateStruct();
+  UpdateDisplay();
+
+  // Select the entry of the section the cursor is in
+  long const section = FindSection(pos);
+  if (section < 0)
+    return;
+  auto const displayed = std::upper_bound(m_displayedIndices.begin(), m_displayedIndices.end(),
+                                          size_t(section));
+  if (displayed == m_displayedIndices.begin())
+    return;
+  long const selection = long(displayed - m_displayedIndices.begin()) - 1;
+  long const item = m_displayedItems->GetNextItem(-1,
+                                                  wxLIST_NEXT_ALL,
+                                                  wxLIST_STATE_SELECTED);
+  if ((item != selection) && (selection < m_displayedItems->GetItemCount()))
   {
-    long item = m_displayedItems->GetNextItem(-1,
-                                              wxLIST_NEXT_ALL,
-                                              wxLIST_STATE_SELECTED);
-    UpdateStruct();
-    // Select the cell with the cursor
-    for (auto &cell : OnList(m_tree->get()))
-    {
-      if (&cell == pos)
-      {
-        if (!m_structure.empty())
-          selection = m_structure.size() - 1;
-      }
-    }      
-    if ((selection >= 0) && (item != selection))
-    {
-      if ((long) m_displayedItems->GetItemCount() < selection)
-        selection = m_displayedItems->GetItemCount() - 1;
-      if ((selection >= 0) && (selection < m_displayedItems->GetItemCount()))
-      {
-        m_displayedItems->SetItemState(selection,
-                                       wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED,
-                                       wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
-        m_displayedItems->EnsureVisible(selection);
-      }
-      m_lastSelection = selection;
-    }
-    UpdateDisplay();
+    m_displayedItems->SetItemState(selection,
+                                   wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED,
+                                   wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
+    m_displayedItems->EnsureVisible(selection);
   }
+  m_lastSelection = selection;
 }
 
 void TableOfContents::UpdateDisplay()
 {
   m_displayedGroupCells.clear();
+  m_displayedIndices.clear();
 
-  // Create a wxArrayString containing all section/chapter/... titles we want
-  // to display
-  for (unsigned int i = 0; i < m_structure.size(); i++)
+  // Collect all section/chapter/... titles we want to display
+  for (size_t i = 0; i < m_structure.size(); i++)
   {
-    // Indentation further reduces the screen real-estate. So it is to be used
-    // sparingly. But we should perhaps add at least a little bit of it to make
-    // the list more readable.
-    int tocDepth = 0;
-    switch (m_structure[i]->GetGroupType())
-    {
-    case GC_TYPE_TITLE:
-      tocDepth = 0;
-      break;
-    case GC_TYPE_SECTION:
-      tocDepth = 1;
-      break;
-    case GC_TYPE_SUBSECTION:
-      tocDepth = 2;
-      break;
-    case GC_TYPE_SUBSUBSECTION:
-      tocDepth = 3;
-      break;
-    case GC_TYPE_HEADING5:
-      tocDepth = 4;
-      break;
-    case GC_TYPE_HEADING6:
-      tocDepth = 5;
-      break;
-    default:
-      break;
-    }
-
     // Limit the toc depth shown
-    if((*m_configuration)->TocDepth() <= tocDepth)
+    if((*m_configuration)->TocDepth() <= TocDepth(m_structure[i].type))
       continue;
-    
-    wxString curr = TocEntryString(m_structure[i]);
-    
-    if (m_regex->Matches(curr))
+
+    if (m_structure[i].matches)
     {
-      m_displayedGroupCells.push_back(m_structure[i]);
+      m_displayedGroupCells.push_back(m_structure[i].cell);
+      m_displayedIndices.push_back(i);
     }
   }
 
@@ -400,38 +472,42 @@ void TableOfContents::UpdateDisplay()
     displayedCells_dndOrder = m_displayedGroupCells;
 
   wxArrayString items;
+  std::vector<bool> hidden;
   for(auto i : displayedCells_dndOrder)
-    items.Add(TocEntryString(i));
-  // Work around a wxWidgets bug: items==m_items_old if items is empty and m_items_old isn't.
-  if ((items != m_items_old) || (items.GetCount() == 0))
   {
-    // Delete superfluous items
-    for (unsigned int i = m_displayedItems->GetItemCount();
-         i > displayedCells_dndOrder.size() ; i--)
-      m_displayedItems->DeleteItem(i - 1);
-
-    // Update the name of all existing items and add new items, if necessary.
-    // We don't just empty the item list and create a new one since on Windows this
-    // causes excessive flickering.
-    for (signed int i = 0; i < (signed)items.GetCount(); i++)
-    {
-      if ((i < m_displayedItems->GetItemCount()) && (m_displayedItems->GetItemCount() > 0))
-        m_displayedItems->SetItemText(i, TocEntryString(displayedCells_dndOrder[i]));
-      else
-        m_displayedItems->InsertItem(i, TocEntryString(displayedCells_dndOrder[i]));
-      
-      if (displayedCells_dndOrder[i]->GetHiddenTree())
-        m_displayedItems->SetItemTextColour(i, wxSystemSettings::GetColour(wxSYS_COLOUR_GRAYTEXT));
-      else
-        m_displayedItems->SetItemTextColour(i, wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOWTEXT));
-    }
-    m_items_old = items;
+    items.Add(m_structure[m_structureIndex.at(i)].text);
+    hidden.push_back(i->GetHiddenTree() != NULL);
+  }
+
+  // Delete superfluous items
+  for (long i = m_displayedItems->GetItemCount(); i > (long)items.GetCount(); i--)
+    m_displayedItems->DeleteItem(i - 1);
+
+  // Update the items that have changed and add new items, if necessary.
+  // We don't just empty the item list and create a new one since on Windows this
+  // causes excessive flickering.
+  for (long i = 0; i < (long)items.GetCount(); i++)
+  {
+    bool const known = (i < (long)m_items_old.GetCount()) && (i < m_displayedItems->GetItemCount());
+    if (i >= m_displayedItems->GetItemCount())
+      m_displayedItems->InsertItem(i, items[i]);
+    else if (!known || (items[i] != m_items_old[i]))
+      m_displayedItems->SetItemText(i, items[i]);
+    else if (hidden[i] == m_itemsHidden_old[i])
+      continue;
+
+    if (hidden[i])
+      m_displayedItems->SetItemTextColour(i, wxSystemSettings::GetColour(wxSYS_COLOUR_GRAYTEXT));
+    else
+      m_displayedItems->SetItemTextColour(i, wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOWTEXT));
   }
+  m_items_old = items;
+  m_itemsHidden_old = hidden;
 }
 
 GroupCell *TableOfContents::GetCell(long index)
 {
-  if((unsigned long) index > m_structure.size())
+  if((unsigned long) index >= m_displayedGroupCells.size())
     return NULL;
   if(index < 0)
     return NULL;
@@ -482,6 +558,8 @@ wxString TableOfContents::TocEntryString(GroupCell *cell)
 
 void TableOfContents::OnRegExEvent(wxCommandEvent& WXUNUSED(ev))
 {
+  for (auto &entry : m_structure)
+    entry.matches = m_regex->Matches(entry.text);
   UpdateDisplay();
 }
 
@@ -490,7 +568,7 @@ void TableOfContents::OnMouseRightDown(wxListEvent &event)
   if (event.GetIndex() < 0)
     return;
   std::unique_ptr<wxMenu> popupMenu(new wxMenu());
-  m_cellRightClickedOn = m_structure[event.GetIndex()];
+  m_cellRightClickedOn = GetCell(event.GetIndex());
 
   if (m_cellRightClickedOn != NULL)
   {
@@ -32,6 +32,8 @@
 #include <wx/timer.h>
 #include <wx/listctrl.h>
 #include <wx/dragimag.h>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "GroupCell.h"
 
@@ -83,11 +85,25 @@ public:
 
     Since this function traverses the tree and we don't want it 
     to impact the performance too much
-      - we call it only on creation of a cell and on leaving it again
+      - we traverse the tree only if StructureChanged() has been called since
+        the last traversal,
+      - only regenerate the entries whose headings have changed
       - and we only traverse the tree if the pane is actually shown.
+
+    \param pos The cell the cursor is in. The entry of the section it belongs to
+    is selected.
    */
   void UpdateTableOfContents(GroupCell *pos);
 
+  //! Tells the table of contents that headings might have been added, deleted or changed
+  void StructureChanged() { m_structureOutdated = true; }
+
+  /*! Tells the table of contents that the title of a heading has changed
+
+    Cheaper than StructureChanged(): Only this heading's entry is generated anew.
+   */
+  void HeadingChanged(const GroupCell *cell) { m_changedHeadings.insert(cell); }
+
   //! Get the nth Cell in the table of contents.
   GroupCell *GetCell(long index);
 
@@ -107,7 +123,35 @@ protected:
 
   wxString TocEntryString(GroupCell *cell);
 private:
+  //! A heading in the table of contents
+  struct TocEntry
+  {
+    GroupCell *cell;
+    GroupType type;
+    //! The title of the heading the entry has been generated for
+    wxString title;
+    //! The section number the entry has been generated for
+    wxString number;
+    //! Did the entry contain the section number?
+    bool showsNumber;
+    //! The text the table of contents displays for this heading
+    wxString text;
+    //! Does text match the regex?
+    bool matches;
+  };
+
+  //! Updates m_structure, if StructureChanged() or HeadingChanged() have been called since the last update
   void UpdateStruct();
+  //! Generates the entry for the heading cell
+  TocEntry CreateEntry(GroupCell *cell, const wxString &title, const wxString &number,
+                       bool showsNumber);
+  //! How far the table of contents indents a heading type. -1 = isn't a heading.
+  static int TocDepth(GroupType type);
+  /*! The index of the heading in m_structure the cell pos belongs to
+
+    -1, if pos is above the first heading.
+  */
+  long FindSection(GroupCell *pos) const;
   std::unique_ptr<GroupCell> *m_tree;
   GroupCell *m_dndStartCell;
   GroupCell *m_dndEndCell;
@@ -134,9 +178,24 @@ private:
   RegexCtrl *m_regex;
   //! The items we displayed the last time update() was called
   wxArrayString m_items_old;
+  //! The hidden state of the items we displayed the last time update() was called
+  std::vector<bool> m_itemsHidden_old;
   Configuration **m_configuration;
 
-  std::vector<GroupCell *> m_structure;
+  //! The headings of the worksheet, in the order they appear in
+  std::vector<TocEntry> m_structure;
+  //! The index in m_structure of each heading
+  std::unordered_map<const GroupCell *, size_t> m_structureIndex;
+  //! The position of each GroupCell in the worksheet, as of the last call to UpdateStruct()
+  std::unordered_map<const GroupCell *, size_t> m_cellOrder;
+  //! The position in the worksheet of each entry of m_structure
+  std::vector<size_t> m_structureOrder;
+  //! The indices in m_structure of the entries in m_displayedGroupCells
+  std::vector<size_t> m_displayedIndices;
+  //! Do headings need to be searched for again?
+  bool m_structureOutdated = true;
+  //! The headings whose title has changed since the last UpdateStruct()
+  std::unordered_set<const GroupCell *> m_changedHeadings;
 };
 
 #endif // TABLEOFCONTENTS_H
@@ -46,53 +46,92 @@
 #define TOOLBAR_ICON_SCALE (0.35)
 #endif
 
-wxBitmap ToolBar::GetBitmap(wxString name, unsigned char *data, size_t len, wxSize siz)
+wxSize ToolBar::GetIconSize()
 {
-  if(siz.x <= 0)
-  {
 #if wxCHECK_VERSION(3, 1, 1)
-    wxDisplay display;
-    int display_idx = wxDisplay::GetFromWindow(GetParent());
-    if (display_idx < 0)
-      m_ppi = wxSize(72,72);
-    else
-      m_ppi = wxDisplay(display_idx).GetPPI();
+  wxDisplay display;
+  int display_idx = wxDisplay::GetFromWindow(GetParent());
+  if (display_idx < 0)
+    m_ppi = wxSize(72,72);
+  else
+    m_ppi = wxDisplay(display_idx).GetPPI();
 #else
-    m_ppi = wxGetDisplayPPI();
+  m_ppi = wxGetDisplayPPI();
 #endif
-    if((m_ppi.x <= 10) || (m_ppi.y <= 10))
-      m_ppi = wxGetDisplayPPI();
+  if((m_ppi.x <= 10) || (m_ppi.y <= 10))
+    m_ppi = wxGetDisplayPPI();
 
-    if((m_ppi.x <= 10) || (m_ppi.y <= 10))
-      m_ppi = wxSize(72,72);
+  if((m_ppi.x <= 10) || (m_ppi.y <= 10))
+    m_ppi = wxSize(72,72);
 
-  #if defined __WXOSX__
-    int targetSize = wxMax(m_ppi.x,75) * TOOLBAR_ICON_SCALE * GetContentScaleFactor();
+#if defined __WXOSX__
+  int targetSize = wxMax(m_ppi.x,75) * TOOLBAR_ICON_SCALE * GetContentScaleFactor();
 #else
-    int targetSize = wxMax(m_ppi.x,75) * TOOLBAR_ICON_SCALE;
+  int targetSize = wxMax(m_ppi.x,75) * TOOLBAR_ICON_SCALE;
 #endif
-    int sizeA = 128 << 4;
-    while(sizeA * 3 / 2 > targetSize && sizeA >= 32) {
-      sizeA >>= 1;
-    };
-
-    int sizeB = 192 << 4;
-    while(sizeB * 4 / 3 > targetSize && sizeB >= 32) {
-      sizeB >>= 1;
-    }
-
-    if(std::abs(targetSize - sizeA) < std::abs(targetSize - sizeB))
-      targetSize = sizeA;
-    else
-      targetSize = sizeB;
-    siz = wxSize(targetSize, targetSize);
+  int sizeA = 128 << 4;
+  while(sizeA * 3 / 2 > targetSize && sizeA >= 32) {
+    sizeA >>= 1;
+  };
+
+  int sizeB = 192 << 4;
+  while(sizeB * 4 / 3 > targetSize && sizeB >= 32) {
+    sizeB >>= 1;
   }
+
+  if(std::abs(targetSize - sizeA) < std::abs(targetSize - sizeB))
+    targetSize = sizeA;
+  else
+    targetSize = sizeB;
+  return wxSize(targetSize, targetSize);
+}
+
+void ToolBar::PrepareIcons()
+{
+  wxSize const siz = GetIconSize();
+  // Only the icons of the tools we show need to be rendered, and only if the
+  // icon theme doesn't provide them.
+  std::vector<SvgBitmap::IconData> icons;
+  auto const addIcon = [&](bool shown, const wxString &name, unsigned char *data, size_t len) {
+    if(shown && !wxArtProvider::GetBitmap(name, wxART_TOOLBAR, siz).IsOk())
+      icons.push_back({data, len});
+  };
+  addIcon(ShowNew(), wxT("gtk-new"), GTK_NEW_SVG_GZ, GTK_NEW_SVG_GZ_SIZE);
+  addIcon(ShowOpenSave(), wxT("gtk-open"), GTK_OPEN_SVG_GZ, GTK_OPEN_SVG_GZ_SIZE);
+  addIcon(ShowOpenSave(), wxT("gtk-save"), GTK_SAVE_SVG_GZ, GTK_SAVE_SVG_GZ_SIZE);
+  addIcon(ShowPrint(), wxT("gtk-print"), GTK_PRINT_SVG_GZ, GTK_PRINT_SVG_GZ_SIZE);
+  addIcon(ShowOptions(), wxT("gtk-preferences"), GTK_PREFERENCES_SVG_GZ, GTK_PREFERENCES_SVG_GZ_SIZE);
+  addIcon(ShowCopyPaste(), wxT("gtk-cut"), GTK_CUT_SVG_GZ, GTK_CUT_SVG_GZ_SIZE);
+  addIcon(ShowCopyPaste(), wxT("gtk-copy"), GTK_COPY_SVG_GZ, GTK_COPY_SVG_GZ_SIZE);
+  addIcon(ShowCopyPaste(), wxT("gtk-paste"), GTK_PASTE_SVG_GZ, GTK_PASTE_SVG_GZ_SIZE);
+  addIcon(ShowSelectAll(), wxT("gtk-select-all"), GTK_SELECT_ALL_SVG_GZ, GTK_SELECT_ALL_SVG_GZ_SIZE);
+  addIcon(ShowSearch(), wxT("gtk-find"), GTK_FIND_SVG_GZ, GTK_FIND_SVG_GZ_SIZE);
+  addIcon(true, wxT("view-refresh"), VIEW_REFRESH1_SVG_GZ, VIEW_REFRESH1_SVG_GZ_SIZE);
+  addIcon(true, wxT("gtk-stop"), GTK_STOP_SVG_GZ, GTK_STOP_SVG_GZ_SIZE);
+  addIcon(true, wxT("arrow_up_square"), ARROW_UP_SQUARE_SVG_GZ, ARROW_UP_SQUARE_SVG_GZ_SIZE);
+  addIcon(true, wxT("software-update-urgent"),
+          SOFTWARE_UPDATE_URGENT_SVG_GZ, SOFTWARE_UPDATE_URGENT_SVG_GZ_SIZE);
+  addIcon(true, wxT("go-next"), GO_NEXT_SVG_GZ, GO_NEXT_SVG_GZ_SIZE);
+  addIcon(true, wxT("go-next"), GO_JUMP_SVG_GZ, GO_JUMP_SVG_GZ_SIZE);
+  addIcon(true, wxT("go-bottom"), GO_BOTTOM_SVG_GZ, GO_BOTTOM_SVG_GZ_SIZE);
+  addIcon(true, wxT("go-last"), GO_LAST_SVG_GZ, GO_LAST_SVG_GZ_SIZE);
+  addIcon(true, wxT("eye-slash"), EYE_SLASH_SVG_GZ, EYE_SLASH_SVG_GZ_SIZE);
+  addIcon(true, wxT("media-playback-start"), MEDIA_PLAYBACK_START_SVG_GZ, MEDIA_PLAYBACK_START_SVG_GZ_SIZE);
+  addIcon(true, wxT("media-playback-stop"), MEDIA_PLAYBACK_STOP_SVG_GZ, MEDIA_PLAYBACK_STOP_SVG_GZ_SIZE);
+  addIcon(ShowHelp(), wxT("gtk-help"), GTK_HELP_SVG_GZ, GTK_HELP_SVG_GZ_SIZE);
+  SvgBitmap::PrepareIcons(icons, siz);
+}
+
+wxBitmap ToolBar::GetBitmap(wxString name, unsigned char *data, size_t len, wxSize siz)
+{
+  if(siz.x <= 0)
+    siz = GetIconSize();
   wxBitmap bmp = wxArtProvider::GetBitmap(name, wxART_TOOLBAR, siz);
   wxImage img;
   if(bmp.IsOk())
     img = bmp.ConvertToImage();
   if(!img.IsOk())
-    return SvgBitmap(data, len, siz, GetContentScaleFactor());
+    return SvgBitmap::GetIcon({data, len}, siz);
 
   img.Rescale(siz.x, siz.y, wxIMAGE_QUALITY_HIGH);
 #if defined __WXOSX__
@@ -161,6 +200,7 @@ void ToolBar::AddTools()
 {
   Clear();
   m_ppi = wxSize(-1,-1);
+  PrepareIcons();
   if(ShowNew())
     AddTool(wxID_NEW, _("New"),GetNewBitmap(),_("New document"));
   if(ShowOpenSave())
@@ -354,18 +394,32 @@ void ToolBar::UpdateBitmaps()
 
   m_ppi = ppi;
 
+  PrepareIcons();
   SetToolBitmap(tb_eval,GetEvalBitmap());
   SetToolBitmap(tb_eval_all,GetEvalAllBitmap());
-  SetToolBitmap(wxID_NEW,GetNewBitmap());
-  SetToolBitmap(wxID_OPEN,GetOpenBitmap());
-  SetToolBitmap(wxID_SAVE,GetSaveBitmap());
-  SetToolBitmap(wxID_PRINT,GetPrintBitmap());
-  SetToolBitmap(wxID_PREFERENCES,GetPreferencesBitmap());
-  SetToolBitmap(wxID_CUT,GetCutBitmap());
-  SetToolBitmap(wxID_COPY,GetCopyBitmap());
-  SetToolBitmap(wxID_PASTE,GetPasteBitmap());
-  SetToolBitmap(wxID_SELECTALL,GetSelectAllBitmap());
-  SetToolBitmap(wxID_FIND,GetFindBitmap());
+  // The icons of hidden tools haven't been prepared and would be rendered one
+  // by one, just to be thrown away.
+  if(ShowNew())
+    SetToolBitmap(wxID_NEW,GetNewBitmap());
+  if(ShowOpenSave())
+  {
+    SetToolBitmap(wxID_OPEN,GetOpenBitmap());
+    SetToolBitmap(wxID_SAVE,GetSaveBitmap());
+  }
+  if(ShowPrint())
+    SetToolBitmap(wxID_PRINT,GetPrintBitmap());
+  if(ShowOptions())
+    SetToolBitmap(wxID_PREFERENCES,GetPreferencesBitmap());
+  if(ShowCopyPaste())
+  {
+    SetToolBitmap(wxID_CUT,GetCutBitmap());
+    SetToolBitmap(wxID_COPY,GetCopyBitmap());
+    SetToolBitmap(wxID_PASTE,GetPasteBitmap());
+  }
+  if(ShowSelectAll())
+    SetToolBitmap(wxID_SELECTALL,GetSelectAllBitmap());
+  if(ShowSearch())
+    SetToolBitmap(wxID_FIND,GetFindBitmap());
   SetToolBitmap(menu_restart_id,GetRestartBitmap());
   SetToolBitmap(tb_interrupt,GetInterruptBitmap());
   m_followIcon = GetBitmap(wxT("arrow_up_square"),
@@ -382,7 +436,8 @@ void ToolBar::UpdateBitmaps()
                            MEDIA_PLAYBACK_STOP_SVG_GZ, MEDIA_PLAYBACK_STOP_SVG_GZ_SIZE);
   SetToolBitmap(tb_animation_startStop,
                 m_PlayButton);
-  SetToolBitmap(wxID_HELP,GetHelpBitmap());
+  if(ShowHelp())
+    SetToolBitmap(wxID_HELP,GetHelpBitmap());
   Realize();
 }
 
@@ -258,6 +258,13 @@ protected:
   void OnMouseRightDown(wxMouseEvent &event);
   void OnMenu(wxMenuEvent &event);
 private:
+  //! Determines the ppi rate and the size our icons should have at this rate
+  wxSize GetIconSize();
+  /*! Renders the icons of our visible tools that aren't cached yet at once, and in parallel
+
+    Icons the icon theme provides are skipped.
+   */
+  void PrepareIcons();
   //! The ppi rate.
   wxSize m_ppi;
   //! The default style for new cells.
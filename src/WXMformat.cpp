@@ -213,7 +213,8 @@ wxString TreeToWXM(GroupCell *cell, bool wxm)
   return retval;
 }
 
-std::unique_ptr<GroupCell> TreeFromWXM(const wxArrayString &wxmLines, Configuration **config)
+//! Converts a wxm description into cells without showing a busy cursor
+static std::unique_ptr<GroupCell> TreeFromWXMLines(const wxArrayString &wxmLines, Configuration **config)
 {
   auto wxmLine = wxmLines.begin();
   auto const end = wxmLines.end();
@@ -246,8 +247,6 @@ std::unique_ptr<GroupCell> TreeFromWXM(const wxArrayString &wxmLines, Configurat
     }
   };
 
-  // Show a busy cursor while we read
-  wxBusyCursor crs;
   CellListBuilder<GroupCell> tree;
   wxString question;
 
@@ -332,7 +331,7 @@ std::unique_ptr<GroupCell> TreeFromWXM(const wxArrayString &wxmLines, Configurat
       while (wxmLine != end && *wxmLine != endHeader)
         hiddenTree.Add(*wxmLine ++);
 
-      last->HideTree(TreeFromWXM(hiddenTree, config));
+      last->HideTree(TreeFromWXMLines(hiddenTree, config));
     }
     break;
 
@@ -347,6 +346,116 @@ std::unique_ptr<GroupCell> TreeFromWXM(const wxArrayString &wxmLines, Configurat
   return std::move(tree);
 }
 
+std::unique_ptr<GroupCell> TreeFromWXM(const wxArrayString &wxmLines, Configuration **config)
+{
+  // Show a busy cursor while we read
+  wxBusyCursor crs;
+  return TreeFromWXMLines(wxmLines, config);
+}
+
+bool SplitWXM(const wxArrayString &wxmLines, const CellSourceSink &sink)
+{
+  auto wxmLine = wxmLines.begin();
+  auto const end = wxmLines.end();
+
+  //! Copies lines up to and including a closing tag
+  CellSource cell;
+  const auto copyLinesUntil = [&wxmLine, end, &cell](const wxString &tag)
+  {
+    while (wxmLine != end)
+    {
+      auto const thisLn = wxmLine++;
+      cell.wxmLines.Add(*thisLn);
+      if (*thisLn == tag)
+        break;
+    }
+  };
+
+  // Does cell already contain the start of a cell?
+  bool cellStarted = false;
+  while (wxmLine != end)
+  {
+    WXMHeaderId headerId = Headers.LookupStart(*wxmLine);
+
+    // Everything that starts a new cell (or hides the next one) ends the
+    // source of the current cell.
+    switch (headerId)
+    {
+    case WXM_HIDE:
+    case WXM_TITLE:
+    case WXM_SECTION:
+    case WXM_SUBSECTION:
+    case WXM_SUBSUBSECTION:
+    case WXM_HEADING5:
+    case WXM_HEADING6:
+    case WXM_COMMENT:
+    case WXM_INPUT:
+    case WXM_CAPTION:
+    case WXM_PAGEBREAK:
+      if (cellStarted)
+      {
+        if (!sink(std::move(cell)))
+          return false;
+        cell = {};
+      }
+      cellStarted = (headerId != WXM_HIDE);
+      break;
+    default:
+      break;
+    }
+
+    cell.wxmLines.Add(*wxmLine ++);
+    switch (headerId)
+    {
+    case WXM_TITLE:
+    case WXM_SECTION:
+    case WXM_SUBSECTION:
+    case WXM_SUBSUBSECTION:
+    case WXM_HEADING5:
+    case WXM_HEADING6:
+    case WXM_COMMENT:
+    case WXM_INPUT:
+    case WXM_CAPTION:
+    case WXM_ANSWER:
+    case WXM_QUESTION:
+      copyLinesUntil(Headers.GetEnd(headerId));
+      break;
+    case WXM_IMAGE:
+      if (wxmLine != end)
+      { // The image type
+        cell.wxmLines.Add(*wxmLine ++);
+        copyLinesUntil(Headers.GetEnd(headerId));
+      }
+      break;
+    case WXM_FOLD:
+    {
+      // TreeFromWXM() reads the folded tree up to (but not including) the end tag.
+      auto const &endHeader = Headers.GetEnd(headerId);
+      while (wxmLine != end && *wxmLine != endHeader)
+        cell.wxmLines.Add(*wxmLine ++);
+    }
+    break;
+    default:
+      break;
+    }
+  }
+
+  if (!cell.wxmLines.IsEmpty())
+    return sink(std::move(cell));
+  return true;
+}
+
+std::unique_ptr<GroupCell> CellsFromSource(CellSource &&source, Configuration **config)
+{
+  if (source.type != GC_TYPE_INVALID)
+    return std::make_unique<GroupCell>(config, source.type, source.text);
+
+  auto tree = TreeFromWXMLines(source.wxmLines, config);
+  if (!tree && !source.text.IsEmpty())
+    tree = std::make_unique<GroupCell>(config, GC_TYPE_TEXT, source.text);
+  return tree;
+}
+
 std::unique_ptr<GroupCell> ParseWXMFile(wxTextBuffer &text, Configuration **config)
 {
   wxArrayString wxmLines;
@@ -357,15 +466,43 @@ std::unique_ptr<GroupCell> ParseWXMFile(wxTextBuffer &text, Configuration **conf
       break;
   }
 
-  return Format::TreeFromWXM(wxmLines, config);
+  // Show a busy cursor while we read
+  wxBusyCursor crs;
+  CellListBuilder<GroupCell> tree;
+  SplitWXM(wxmLines, [&tree, config](CellSource &&cell){
+      tree.Append(CellsFromSource(std::move(cell), config));
+      return true;
+    });
+  return std::move(tree);
 }
 
-std::unique_ptr<GroupCell> ParseMACContents(const wxString &macContents, Configuration **config)
+bool SplitMACContents(const wxString &macContents, const CellSourceSink &sink)
 {
   wxString wxmLines;
-  CellListBuilder<GroupCell> tree;
   auto const end = macContents.end();
 
+  //! Hands the wxm comments that have been collected so far to the sink
+  const auto flushWXMLines = [&wxmLines, &sink]
+  {
+    if (wxmLines.IsEmpty())
+      return true;
+    CellSource cell;
+    // Convert the comment block to an array of lines
+    wxStringTokenizer tokenizer(wxmLines, "\n");
+    while (tokenizer.HasMoreTokens())
+      cell.wxmLines.Add(tokenizer.GetNextToken());
+    // If the block doesn't contain any cells we display it as a comment
+    cell.text.swap(wxmLines);
+    return sink(std::move(cell));
+  };
+  const auto plainCell = [&sink](GroupType type, const wxString &text)
+  {
+    CellSource cell;
+    cell.type = type;
+    cell.text = text;
+    return sink(std::move(cell));
+  };
+
   struct State { wxChar lastChar; wxString::const_iterator ch; };
   auto const readUntil = [end](wxString &line, State s, wxChar until)
   {
@@ -446,20 +583,8 @@ std::unique_ptr<GroupCell> ParseMACContents(const wxString &macContents, Configu
         }
         else
         {
-          if(!wxmLines.IsEmpty())
-          {
-            // Convert the comment block to an array of lines
-            wxStringTokenizer tokenizer(wxmLines, "\n");
-            wxArrayString commentLines;
-            while (tokenizer.HasMoreTokens())
-              commentLines.Add(tokenizer.GetNextToken());
-
-            // Interpret the comment block 
-            bool ok = tree.Append(TreeFromWXM(commentLines, config));
-            if (!ok)
-              tree.Append(std::make_unique<GroupCell>(config, GC_TYPE_TEXT, wxmLines));
-            wxmLines = wxEmptyString;
-          }
+          if (!flushWXMLines())
+            return false;
           if ((line.EndsWith(" */")) || (line.EndsWith("\n*/")))
             line.Truncate(line.length() - 3);
           else
@@ -470,7 +595,8 @@ std::unique_ptr<GroupCell> ParseMACContents(const wxString &macContents, Configu
           else
             line.erase(0, 2);
 
-          tree.Append(std::make_unique<GroupCell>(config, GC_TYPE_TEXT, line));
+          if (!plainCell(GC_TYPE_TEXT, line))
+            return false;
         }
         line.clear();
       }
@@ -497,37 +623,37 @@ std::unique_ptr<GroupCell> ParseMACContents(const wxString &macContents, Configu
       {
         line.Trim(true);
         line.Trim(false);
-        tree.Append(std::make_unique<GroupCell>(config, GC_TYPE_CODE, line));
+        if (!plainCell(GC_TYPE_CODE, line))
+          return false;
         line.clear();
       }
       s.lastChar = c;
       ++s.ch;
     }
   }
-  if(!wxmLines.IsEmpty())
-  {
-    // Convert the comment block to an array of lines
-    wxStringTokenizer tokenizer(wxmLines, "\n");
-    wxArrayString commentLines;
-    while (tokenizer.HasMoreTokens())
-      commentLines.Add(tokenizer.GetNextToken());
-    
-    // Interpret the comment block 
-    bool ok = tree.Append(TreeFromWXM(commentLines, config));
-    if (!ok)
-      tree.Append(std::make_unique<GroupCell>(config, GC_TYPE_TEXT, wxmLines));
-    wxmLines = wxEmptyString;
-  }
-  
+  if (!flushWXMLines())
+    return false;
+
   line.Trim(true);
   line.Trim(false);
   if (!line.empty())
-    tree.Append(std::make_unique<GroupCell>(config, GC_TYPE_CODE, line));
+    return plainCell(GC_TYPE_CODE, line);
+  return true;
+}
 
+std::unique_ptr<GroupCell> ParseMACContents(const wxString &macContents, Configuration **config)
+{
+  // Show a busy cursor while we read
+  wxBusyCursor crs;
+  CellListBuilder<GroupCell> tree;
+  SplitMACContents(macContents, [&tree, config](CellSource &&cell){
+      tree.Append(CellsFromSource(std::move(cell), config));
+      return true;
+    });
   return std::move(tree);
 }
 
-std::unique_ptr<GroupCell> ParseMACFile(wxTextBuffer &text, bool xMaximaFile, Configuration **config)
+wxString MACContentsFromFile(wxTextBuffer &text, bool xMaximaFile)
 {
   bool input = true;
   wxString macContents;
@@ -557,8 +683,12 @@ std::unique_ptr<GroupCell> ParseMACFile(wxTextBuffer &text, bool xMaximaFile, Co
     if (text.Eof())
       break;
   }
+  return macContents;
+}
 
-  return Format::ParseMACContents(macContents, config);
+std::unique_ptr<GroupCell> ParseMACFile(wxTextBuffer &text, bool xMaximaFile, Configuration **config)
+{
+  return ParseMACContents(MACContentsFromFile(text, xMaximaFile), config);
 }
 
 } // namespace Format
@@ -27,6 +27,7 @@
 #define WXMFORMAT_H
 
 #include "GroupCell.h"
+#include <functional>
 
 class wxTextBuffer;
 
@@ -68,6 +69,50 @@ wxString TreeToWXM(GroupCell *cell, bool wxm = true);
 //! Converts a wxm description into individual cells
 std::unique_ptr<GroupCell> TreeFromWXM(const wxArrayString &wxmLines, Configuration **config);
 
+/*! The source text of one or more cells of a .wxm or .mac file
+
+  Splitting a file into CellSources doesn't create any cells and therefore can
+  be done in a background thread. Only CellsFromSource() needs the GUI thread.
+ */
+struct CellSource
+{
+  //! The type of a cell that consists of nothing but text, or GC_TYPE_INVALID
+  GroupType type = GC_TYPE_INVALID;
+  /*! The text of the cell
+
+    If type is GC_TYPE_INVALID this is the text of the comment cell we create
+    if wxmLines doesn't describe any cells.
+  */
+  wxString text;
+  //! The wxm description of the cells, if type is GC_TYPE_INVALID
+  wxArrayString wxmLines;
+};
+
+//! Receives the CellSources of a file. Returns false if splitting shall stop.
+using CellSourceSink = std::function<bool (CellSource &&source)>;
+
+/*! Splits a wxm description into the descriptions of individual top-level cells
+
+  Everything that belongs to a cell (hide tags, images, answers and folded
+  trees) ends up in the same CellSource as the cell.
+  \returns false, if the sink has stopped the splitting.
+ */
+bool SplitWXM(const wxArrayString &wxmLines, const CellSourceSink &sink);
+
+/*! Splits the contents of a preloaded .mac file into the sources of its cells
+  \returns false, if the sink has stopped the splitting.
+ */
+bool SplitMACContents(const wxString &macContents, const CellSourceSink &sink);
+
+/*! Reads a .mac or a .out file into a string
+
+  For .out files (xMaximaFile = true) the output and the input prompts are dropped.
+ */
+wxString MACContentsFromFile(wxTextBuffer &buf, bool xMaximaFile);
+
+//! Creates the cells a CellSource describes. GUI thread only.
+std::unique_ptr<GroupCell> CellsFromSource(CellSource &&source, Configuration **config);
+
 /*! Parses the contents of a .wxm file into individual cells.
  * Invokes TreeFromWXM on pre-processed data,
  * concatenates the results.
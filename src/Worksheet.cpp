@@ -53,6 +53,8 @@
 #include "BitmapOut.h"
 #include "AnimationCell.h"
 #include "ImgCell.h"
+#include "OutputPreviewCell.h"
+#include "Profiler.h"
 #include "MarkDown.h"
 #include "wxm_manual_anchors_xml.h"
 #include <wx/clipbrd.h>
@@ -73,6 +75,8 @@
 #include <wx/fs_mem.h>
 #include <wx/filefn.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <functional>
 #include <memory>
 
 //! This class represents the worksheet shown in the middle of the wxMaxima window.
@@ -162,6 +166,7 @@ Worksheet::Worksheet(wxWindow *parent, int id, Worksheet* &observer, wxPoint pos
   m_blinkDisplayCaret = true;
   m_timer.SetOwner(this, TIMER_ID);
   m_caretTimer.SetOwner(this, CARET_TIMER_ID);
+  m_cellPointers.SetAnimationTimerOwner(this, ANIMATION_TIMER_ID);
   SetSaved(false);
   AdjustSize();
   m_autocompleteTemplates = false;
@@ -354,7 +359,27 @@ bool Worksheet::RedrawIfRequested()
   }
   if (m_redrawRequested)
   {
-    Refresh();
+    if (m_redrawStart && (m_redrawStart != GetTree()) && (m_redrawStart->GetCurrentPoint().y >= 0))
+    {
+      // Only the cells from m_redrawStart downwards have changed. This
+      // includes the gap above m_redrawStart that the horizontal cursor is
+      // drawn in, and the area cells that follow may have vacated.
+      int visibleBottom;
+      CalcUnscrolledPosition(0, GetClientSize().y, NULL, &visibleBottom);
+      wxRect changed;
+      changed.SetLeft(0);
+      changed.SetRight(wxMax(GetVirtualSize().x, GetClientSize().x));
+      changed.SetTop(m_redrawStart->GetRect().GetTop() - ((int) m_configuration->GetGroupSkip()));
+      changed.SetBottom(wxMax(GetVirtualSize().y, visibleBottom));
+      // Tiles that aren't on the screen are outdated, too.
+      m_tileCache.Invalidate(changed);
+      CalcScrolledPosition(changed.x, changed.y, &changed.x, &changed.y);
+      changed.Intersect(wxRect(wxPoint(0, 0), GetClientSize()));
+      if (!changed.IsEmpty())
+        RefreshRect(changed);
+    }
+    else
+      Refresh();
     m_redrawRequested = false;
     m_redrawStart = NULL;
     redrawIssued = true;
@@ -428,6 +453,14 @@ Worksheet::~Worksheet()
 
   m_mainToolBar = NULL;
 
+  // The clipboard might still offer formats that are generated from a copy
+  // of our cells: Generating them requires our configuration.
+  if (auto snapshot = m_clipboardSnapshot.lock())
+  {
+    snapshot->cellsAsData.reset();
+    snapshot->cells.reset();
+  }
+
   ClearDocument();
   m_configuration = NULL;
   m_observer = nullptr;
@@ -458,6 +491,7 @@ Worksheet::~Worksheet()
 
 void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event))
 {
+  Profiler::Scope timer(Profiler::paint);
   m_configuration->ClearAndEnableRedrawTracing();
   m_configuration->SetBackgroundBrush(
     *(wxTheBrushList->FindOrCreateBrush(m_configuration->DefaultBackgroundColor(),
@@ -491,6 +525,8 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event))
   // It is possible that the redraw starts before the idle task attempts
   // to recalculate the worksheet.
   RecalculateIfNeeded();
+  if (ScheduleRecalculationOfEstimatedCells())
+    RecalculateIfNeeded();
 
   // Create a working drawing context that is valid for the time of this redraw
 #ifdef WORKING_AUTO_BUFFER
@@ -545,16 +581,13 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event))
 
     // Don't draw rectangles with zero size or height
     if ((rect.GetWidth() < 1) || (rect.GetHeight() < 1))
+    {
+      region++;
       continue;
+    }
+
+    SetBackgroundColour(m_configuration->DefaultBackgroundColor());
 
-    // Set line pen and fill brushes
-    SetBackgroundColour(m_configuration->DefaultBackgroundColor());    
-    m_configuration->GetDC()->SetBackgroundMode(wxTRANSPARENT);
-    m_configuration->GetDC()->SetBackground(m_configuration->GetBackgroundBrush());
-    m_configuration->GetDC()->SetBrush(m_configuration->GetBackgroundBrush());
-    m_configuration->GetDC()->SetPen(*wxTRANSPARENT_PEN);
-    m_configuration->GetDC()->SetLogicalFunction(wxCOPY);
-        
     // Tell the configuration where to crop in this redraw
     int xstart, xend, top, bottom;
     CalcUnscrolledPosition(rect.GetLeft(), rect.GetTop(), &xstart, &top);
@@ -564,68 +597,37 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event))
     unscrolledRect.SetRight(xend);
     unscrolledRect.SetTop(top);
     unscrolledRect.SetBottom(bottom);
-    m_configuration->SetUpdateRegion(unscrolledRect);
 
-    // Clear the drawing area
-    m_configuration->GetDC()->DrawRectangle(unscrolledRect);
+    // Copy the parts of the worksheet that haven't changed since the last redraw
+    // from the tile cache. Its tiles have the screen's resolution.
+    bool drawn = false;
+    m_tileCache.SetScaleFactor(GetContentScaleFactor());
+    {
+      wxDC *paintDC = m_configuration->GetDC();
+      drawn = m_tileCache.Paint(*paintDC, unscrolledRect,
+                                [this](wxMemoryDC &tileDC, const wxRect &tileRect) {
+                                  m_configuration->SetContext(tileDC);
+                                  tileDC.SetMapMode(wxMM_TEXT);
+                                  wxGCDC tileAntiAliassingDC(tileDC);
+                                  if (tileAntiAliassingDC.IsOk())
+                                  {
+                                    tileAntiAliassingDC.SetClippingRegion(tileRect);
+                                    m_configuration->SetAntialiassingDC(tileAntiAliassingDC);
+                                  }
+                                  DrawWorksheetRegion(tileRect);
+                                  m_configuration->UnsetAntialiassingDC();
+                                  // A cell that spans two tiles is drawn once for each of them.
+                                  m_configuration->ReportMultipleRedraws();
+                                  m_configuration->ClearAndEnableRedrawTracing();
+                                });
+      m_configuration->SetContext(*paintDC);
+      if(antiAliassingDC.IsOk())
+        m_configuration->SetAntialiassingDC(antiAliassingDC);
+      m_configuration->SetUpdateRegion(unscrolledRect);
+    }
+    if (!drawn)
+      DrawWorksheetRegion(unscrolledRect);
 
-    //
-    // Draw the cell contents
-    //
-    if(GetTree())
-    {
-      wxPoint point;
-      point.x = m_configuration->GetIndent();
-      point.y = m_configuration->GetBaseIndent() + GetTree()->GetCenterList();
-      
-      // Draw tree
-      m_configuration->GetDC()->SetPen(*(wxThePenList->FindOrCreatePen(m_configuration->GetColor(TS_DEFAULT), 1, wxPENSTYLE_SOLID)));
-      m_configuration->GetDC()->SetBrush(*(wxTheBrushList->FindOrCreateBrush(m_configuration->GetColor(TS_DEFAULT))));
-      
-      bool atStart = true;
-      for (auto &tmp : OnList(GetTree()))
-      {
-        if (!atStart)
-        {
-          tmp.UpdateYPosition();
-          point = tmp.GetCurrentPoint();
-        }
-        atStart = false;
-        
-        wxRect cellRect = tmp.GetRect();
-        
-        int width;
-        int height;
-        GetClientSize(&width, &height);
-        
-        wxPoint upperLeftScreenCorner;
-        CalcScrolledPosition(0, 0,
-                             &upperLeftScreenCorner.x, &upperLeftScreenCorner.y);
-        m_configuration->SetVisibleRegion(wxRect(upperLeftScreenCorner,
-                                                 upperLeftScreenCorner + wxPoint(width,height)));
-        m_configuration->SetWorksheetPosition(GetPosition());
-        // Clear the image cache of all cells above or below the viewport.
-        if (cellRect.GetTop() >= bottom || cellRect.GetBottom() <= top)
-        {
-          // Only actually clear the image cache if there is a screen's height between
-          // us and the image's position: Else the chance is too high that we will
-          // very soon have to generated a scaled image again.
-          if ((cellRect.GetBottom() <= m_lastBottom - 2 * height) || (cellRect.GetTop() >= m_lastTop + 2 * height))
-          {
-            if (tmp.GetOutput())
-              tmp.GetOutput()->ClearCacheList();
-          }
-        }
-        
-        tmp.SetCurrentPoint(point);
-        if (tmp.DrawThisCell(point))
-        {
-          tmp.InEvaluationQueue(m_evaluationQueue.IsInQueue(&tmp));
-          tmp.LastInEvaluationQueue(m_evaluationQueue.GetCell() == &tmp);
-        }
-        tmp.Draw(point);
-      }
-    }
 #ifndef WORKING_AUTO_BUFFER
     // Blit the memory image to the window
     dcm.SetDeviceOrigin(0, 0);
@@ -645,11 +647,7 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event))
       m_configuration->GetDC()->SetPen(*(wxThePenList->FindOrCreatePen(m_configuration->GetColor(TS_CURSOR), 1, wxPENSTYLE_SOLID)));
       m_configuration->GetDC()->SetBrush(*(wxTheBrushList->FindOrCreateBrush(m_configuration->GetColor(TS_CURSOR), wxBRUSHSTYLE_SOLID)));
 
-      wxRect currentGCRect = m_hCaretPosition->GetRect();
-      int caretY = ((int) m_configuration->GetGroupSkip()) / 2 + currentGCRect.GetBottom() + 1;
-      m_configuration->GetDC()->DrawRectangle(xstart + m_configuration->GetBaseIndent(),
-                                              caretY - m_configuration->GetCursorWidth() / 2,
-                                              MC_HCARET_WIDTH, m_configuration->GetCursorWidth());
+      m_configuration->GetDC()->DrawRectangle(GetHCaretRect());
     }
 
     if ((m_hCaretActive) && (m_hCaretPositionStart == NULL) && (m_hasFocus) && (m_hCaretPosition == NULL))
@@ -665,15 +663,13 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event))
         m_configuration->GetDC()->SetBrush(*(wxTheBrushList->FindOrCreateBrush(m_configuration->GetColor(TS_CURSOR), wxBRUSHSTYLE_SOLID)));
       }
 
-      wxRect cursor = wxRect(xstart + m_configuration->GetCellBracketWidth(),
-                             (m_configuration->GetBaseIndent() - m_configuration->GetCursorWidth()) / 2,
-                             MC_HCARET_WIDTH, m_configuration->GetCursorWidth());
-      m_configuration->GetDC()->DrawRectangle(cursor);
+      m_configuration->GetDC()->DrawRectangle(GetHCaretRect());
     }
 
     if (GetTree() == NULL)
     {
       m_configuration->SetContext(m_dc);
+      m_configuration->UnsetAntialiassingDC();
       return;
     }
 
@@ -696,18 +692,91 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event))
       }
     }
 
-    
-    m_configuration->SetContext(m_dc);
-    m_configuration->UnsetAntialiassingDC();
     m_lastTop = top;
     m_lastBottom = bottom;
 
     region++;
   }
-  
+  m_configuration->SetContext(m_dc);
+  m_configuration->UnsetAntialiassingDC();
+
   m_configuration->ReportMultipleRedraws();
 }
 
+void Worksheet::DrawWorksheetRegion(const wxRect &rect)
+{
+  // Set line pen and fill brushes
+  m_configuration->GetDC()->SetBackgroundMode(wxTRANSPARENT);
+  m_configuration->GetDC()->SetBackground(m_configuration->GetBackgroundBrush());
+  m_configuration->GetDC()->SetBrush(m_configuration->GetBackgroundBrush());
+  m_configuration->GetDC()->SetPen(*wxTRANSPARENT_PEN);
+  m_configuration->GetDC()->SetLogicalFunction(wxCOPY);
+      
+  // Tell the configuration where to crop in this redraw
+  m_configuration->SetUpdateRegion(rect);
+
+  // Clear the drawing area
+  m_configuration->GetDC()->DrawRectangle(rect);
+
+  //
+  // Draw the cell contents
+  //
+  if(GetTree())
+  {
+    wxPoint point;
+    point.x = m_configuration->GetIndent();
+    point.y = m_configuration->GetBaseIndent() + GetTree()->GetCenterList();
+    
+    // Draw tree
+    m_configuration->GetDC()->SetPen(*(wxThePenList->FindOrCreatePen(m_configuration->GetColor(TS_DEFAULT), 1, wxPENSTYLE_SOLID)));
+    m_configuration->GetDC()->SetBrush(*(wxTheBrushList->FindOrCreateBrush(m_configuration->GetColor(TS_DEFAULT))));
+    
+    bool atStart = true;
+    for (auto &tmp : OnList(GetTree()))
+    {
+      if (!atStart)
+      {
+        tmp.UpdateYPosition();
+        point = tmp.GetCurrentPoint();
+      }
+      atStart = false;
+      
+      wxRect cellRect = tmp.GetRect();
+      
+      int width;
+      int height;
+      GetClientSize(&width, &height);
+      
+      wxPoint upperLeftScreenCorner;
+      CalcScrolledPosition(0, 0,
+                           &upperLeftScreenCorner.x, &upperLeftScreenCorner.y);
+      m_configuration->SetVisibleRegion(wxRect(upperLeftScreenCorner,
+                                               upperLeftScreenCorner + wxPoint(width,height)));
+      m_configuration->SetWorksheetPosition(GetPosition());
+      // Clear the image cache of all cells above or below the viewport.
+      if (cellRect.GetTop() >= rect.GetBottom() || cellRect.GetBottom() <= rect.GetTop())
+      {
+        // Only actually clear the image cache if there is a screen's height between
+        // us and the image's position: Else the chance is too high that we will
+        // very soon have to generated a scaled image again.
+        if ((cellRect.GetBottom() <= m_lastBottom - 2 * height) || (cellRect.GetTop() >= m_lastTop + 2 * height))
+        {
+          if (tmp.GetOutput())
+            tmp.GetOutput()->ClearCacheList();
+        }
+      }
+      
+      tmp.SetCurrentPoint(point);
+      if (tmp.DrawThisCell(point))
+      {
+        tmp.InEvaluationQueue(m_evaluationQueue.IsInQueue(&tmp));
+        tmp.LastInEvaluationQueue(m_evaluationQueue.GetCell() == &tmp);
+      }
+      tmp.Draw(point);
+    }
+  }
+}
+
 GroupCell *Worksheet::InsertGroupCells(std::unique_ptr<GroupCell> &&cells, GroupCell *where)
 {
   return InsertGroupCells(std::move(cells), where, &treeUndoActions);
@@ -718,7 +787,7 @@ GroupCell *Worksheet::InsertGroupCells(std::unique_ptr<GroupCell> &&cells, Group
 // Multiple groupcells can be inserted when cells->m_next != NULL
 // Returns the pointer to the last inserted group cell to have fun with
 GroupCell *Worksheet::InsertGroupCells(std::unique_ptr<GroupCell> &&cells, GroupCell *where,
-                                       UndoActions *undoBuffer)
+                                       UndoActions *undoBuffer, bool updateStructure)
 {
   if (!cells)
     return NULL; // nothing to insert
@@ -767,8 +836,14 @@ GroupCell *Worksheet::InsertGroupCells(std::unique_ptr<GroupCell> &&cells, Group
       wxASSERT_MSG(m_last, "The pointer to last cell in the document is invalid");
   }
 
-  if (renumbersections)
-    NumberSections();
+  if (updateStructure)
+  {
+    if (renumbersections)
+      NumberSections();
+    // Every insertion of cells ends up here => this is the place to tell the
+    // table of contents that the structure of the document has changed.
+    UpdateTableOfContents();
+  }
 
   GroupCell *recalcStart = NULL;
   if(where)
@@ -893,7 +968,8 @@ void Worksheet::InsertLine(std::unique_ptr<Cell> &&newCell, bool forceNewLine)
     else
       ScrollToCaret();
   }
-  Recalculate(tmp);
+  // AppendOutput() has decided if the output needs to be laid out anew.
+  ScheduleRecalculation(tmp);
   RequestRedraw(tmp);
 }
 
@@ -988,6 +1064,91 @@ bool Worksheet::RecalculateIfNeeded()
   return true;
 }
 
+bool Worksheet::ScheduleRecalculationOfEstimatedCells()
+{
+  if (!GetTree())
+    return false;
+
+  wxRect const visible(CalcUnscrolledPosition(wxPoint(0, 0)), GetClientSize());
+  bool found = false;
+  for (auto &group : OnList(GetTree()))
+  {
+    wxRect const rect = group.GetRect();
+    if (rect.GetTop() > visible.GetBottom())
+      break;
+    if (rect.GetBottom() < visible.GetTop())
+      continue;
+    if (group.HasEstimatedSizeIn(visible))
+    {
+      Recalculate(&group);
+      found = true;
+    }
+  }
+  return found;
+}
+
+void Worksheet::OutputPreviewsLoaded()
+{
+  m_pendingOutputPreviews.clear();
+  for (auto &group : OnList(GetTree()))
+    if (dynamic_cast<OutputPreviewCell *>(group.GetLabel()))
+      m_pendingOutputPreviews.emplace_back(&group);
+}
+
+bool Worksheet::ReplaceOutputPreview()
+{
+  // Forget about groups that have been deleted or whose output has changed
+  // in the meantime.
+  auto const isDone = [](const CellPtr<GroupCell> &group) {
+    return !group || !dynamic_cast<OutputPreviewCell *>(group->GetLabel());
+  };
+  while (!m_pendingOutputPreviews.empty() && isDone(m_pendingOutputPreviews.front()))
+    m_pendingOutputPreviews.pop_front();
+  // The bisection below needs every group to have a position
+  m_pendingOutputPreviews.erase(
+    std::remove_if(m_pendingOutputPreviews.begin(), m_pendingOutputPreviews.end(),
+                   [](const CellPtr<GroupCell> &group) { return !group; }),
+    m_pendingOutputPreviews.end());
+  if (m_pendingOutputPreviews.empty())
+    return false;
+
+  // The cells that are visible on the screen come first. The groups are in
+  // document order => the first one that might be visible can be found by
+  // bisection.
+  wxRect const visible(CalcUnscrolledPosition(wxPoint(0, 0)), GetClientSize());
+  auto candidate = std::lower_bound(
+    m_pendingOutputPreviews.begin(), m_pendingOutputPreviews.end(), visible.GetTop(),
+    [](const CellPtr<GroupCell> &group, int top) {
+      return group->GetRect().GetBottom() < top;
+    });
+  if ((candidate == m_pendingOutputPreviews.end()) || isDone(*candidate) ||
+      !(*candidate)->GetRect().Intersects(visible))
+    candidate = m_pendingOutputPreviews.begin();
+
+  GroupCell &group = **candidate;
+  m_pendingOutputPreviews.erase(candidate);
+  ReplaceOutputPreview(group);
+  return !m_pendingOutputPreviews.empty();
+}
+
+void Worksheet::ReplaceAllOutputPreviews()
+{
+  for (auto &group : m_pendingOutputPreviews)
+    if (group && dynamic_cast<OutputPreviewCell *>(group->GetLabel()))
+      ReplaceOutputPreview(*group);
+  m_pendingOutputPreviews.clear();
+}
+
+void Worksheet::ReplaceOutputPreview(GroupCell &group)
+{
+  auto output = dynamic_cast<OutputPreviewCell *>(group.GetLabel())->ParseOutput(&group);
+  group.RemoveOutput();
+  if (output)
+    group.AppendOutput(std::move(output));
+  Recalculate(&group);
+  RequestRedraw(&group);
+}
+
 void Worksheet::Recalculate(Cell *start)
 {
   if(!GetTree())
@@ -997,11 +1158,17 @@ void Worksheet::Recalculate(Cell *start)
     return;
 
   GroupCell  *group = start->GetGroup();
+  group->MarkNeedsRecalculate();
+  ScheduleRecalculation(group);
+}
 
-  if(m_recalculateStart == group)
+void Worksheet::ScheduleRecalculation(GroupCell *group)
+{
+  if(!GetTree() || !group)
     return;
 
-  group->MarkNeedsRecalculate();
+  if(m_recalculateStart == group)
+    return;
 
   if (!m_recalculateStart)
     m_recalculateStart = group;
@@ -1105,8 +1272,11 @@ void Worksheet::ClearDocument()
   m_hCaretPositionStart = m_hCaretPositionEnd = NULL;
   m_recalculateStart = NULL;
   m_evaluationQueue.Clear();
+  m_pendingOutputPreviews.clear();
   TreeUndo_ClearBuffers();
   DestroyTree();
+  Profiler::UpdateMaxCellCost(GetTree());
+  m_tileCache.Clear();
 
   m_blinkDisplayCaret = true;
   SetSaved(false);
@@ -1193,6 +1363,8 @@ void Worksheet::FoldOccurred()
 {
   OutputChanged();
   UpdateMLast();
+  // Folded headings vanish from the worksheet's list of cells
+  UpdateTableOfContents();
 }
 
 /**
@@ -1382,12 +1554,7 @@ void Worksheet::OnMouseRightDown(wxMouseEvent &event)
       if (IsSelected(MC_TYPE_DEFAULT))
       {
         wxString wordUnderCursor = GetSelectionStart()->ToString();
-        if(m_helpfileanchorsThread)
-        {
-          if(m_helpfileanchorsThread->joinable())
-            m_helpfileanchorsThread->join();
-          m_helpfileanchorsThread.reset();
-        }
+        UseCompiledHelpFileAnchors();
         if(m_helpFileAnchors.find(wordUnderCursor) != m_helpFileAnchors.end())
         {
           popupMenu.Append(wxID_HELP, wxString::Format(_("Help on \"%s\""), wordUnderCursor));
@@ -1733,12 +1900,7 @@ void Worksheet::OnMouseRightDown(wxMouseEvent &event)
             wxString wordUnderCursor = group->GetEditable()->GetWordUnderCaret();
             wxArrayString dst[4];
             wxArrayString sameBeginning;
-            if(m_helpfileanchorsThread)
-            {
-              if(m_helpfileanchorsThread->joinable())
-                m_helpfileanchorsThread->join();
-              m_helpfileanchorsThread.reset();
-            }
+            UseCompiledHelpFileAnchors();
 
             if((m_helpFileAnchors.find(wordUnderCursor) != m_helpFileAnchors.end()))
               popupMenu.Append(wxID_HELP, wxString::Format(_("Help on \"%s\""),
@@ -2156,7 +2318,7 @@ void Worksheet::OnMouseLeftDown(wxMouseEvent &event)
   m_clickType_selectionStart = m_clickType;
   RequestRedraw();
   // Re-calculate the table of contents
-  UpdateTableOfContents();
+  UpdateTocSelection();
 }
 
 
@@ -2452,6 +2614,21 @@ wxString Worksheet::GetString(bool lb)
   return s;
 }
 
+//! Returns a function that calls generate on its first call and afterwards returns the cached result
+static std::function<wxString()> GenerateOnce(std::function<wxString()> &&generate)
+{
+  auto result = std::make_shared<wxString>();
+  auto generated = std::make_shared<bool>(false);
+  return [generate, result, generated]{
+      if (!*generated)
+      {
+        *result = generate();
+        *generated = true;
+      }
+      return *result;
+    };
+}
+
 /***
  * Copy selection to clipboard.
  */
@@ -2479,35 +2656,46 @@ bool Worksheet::Copy(bool astext)
   wxASSERT_MSG(!wxTheClipboard->IsOpened(),_("Bug: The clipboard is already opened"));
   if (wxTheClipboard->Open())
   {
-    wxDataObjectComposite *data = new wxDataObjectComposite;
+    auto *data = new CompositeDataObject;
 
     // Add the wxm code corresponding to the selected output to the clipboard
-    wxString s = GetString(true);
-    data->Add(new wxmDataObject(s));
+    data->Add(new wxmDataObject(GetString(true)));
 
-    std::unique_ptr<Cell> tmp(CopySelection());
+    // All other formats are only generated if an application asks for them.
+    auto const snapshot = SnapshotSelection();
 
     if(m_configuration->CopyMathML())
     {
       // Add a mathML representation of the data to the clipboard
-      s = ConvertSelectionToMathML();
-      if (s != wxEmptyString)
-      {
-        // We mark the MathML version of the data on the clipboard as "preferred"
-        // as if an application supports MathML neither bitmaps nor plain text
-        // makes much sense.
-        data->Add(new MathMLDataObject(s), true);
-        data->Add(new MathMLDataObject2(s), true);
-        if(m_configuration->CopyMathMLHTML())
-          data->Add(new wxHTMLDataObject(s), true);
-        // wxMathML is a HTML5 flavour, as well.
-        // See https://github.com/fred-wang/Mathzilla/blob/master/mathml-copy/lib/copy-mathml.js#L21
-        //
-        // Unfortunately MS Word and Libreoffice Writer don't like this idea so I have
-        // disabled the following line of code again:
-        //
-        // data->Add(new wxHTMLDataObject(s));
-      }
+      auto const mathML = GenerateOnce([snapshot]{
+          return CellsToMathML(snapshot->cellsAsData.get());
+        });
+      // We mark the MathML version of the data on the clipboard as "preferred"
+      // as if an application supports MathML neither bitmaps nor plain text
+      // makes much sense.
+      data->AddDeferred(std::make_unique<MathMLDataObject>(),
+                        [mathML]() -> wxDataObject * {
+                          wxString const s = mathML();
+                          return s.empty() ? nullptr : new MathMLDataObject(s);
+                        }, true);
+      data->AddDeferred(std::make_unique<MathMLDataObject2>(),
+                        [mathML]() -> wxDataObject * {
+                          wxString const s = mathML();
+                          return s.empty() ? nullptr : new MathMLDataObject2(s);
+                        }, true);
+      if(m_configuration->CopyMathMLHTML())
+        data->AddDeferred(std::make_unique<wxHTMLDataObject>(),
+                          [mathML]() -> wxDataObject * {
+                            wxString const s = mathML();
+                            return s.empty() ? nullptr : new wxHTMLDataObject(s);
+                          }, true);
+      // wxMathML is a HTML5 flavour, as well.
+      // See https://github.com/fred-wang/Mathzilla/blob/master/mathml-copy/lib/copy-mathml.js#L21
+      //
+      // Unfortunately MS Word and Libreoffice Writer don't like this idea so I have
+      // disabled the following line of code again:
+      //
+      // data->Add(new wxHTMLDataObject(s));
     }
 
     if(m_configuration->CopyRTF())
@@ -2515,24 +2703,42 @@ bool Worksheet::Copy(bool astext)
       // Add a RTF representation of the currently selected text
       // to the clipboard: For some reason Libreoffice likes RTF more than
       // it likes the MathML - which is standardized.
-      wxString rtf;
-      rtf = RTFStart() + tmp->ListToRTF() + wxT("\\par\n") + RTFEnd();
-      data->Add(new RtfDataObject(rtf));
-      data->Add(new RtfDataObject2(rtf), true);
+      auto const rtf = GenerateOnce([snapshot, start = RTFStart(), end = RTFEnd()]{
+          if (!snapshot->cells)
+            return wxString();
+          wxString rtf = start;
+          snapshot->cells->ListAppendRTF(rtf);
+          rtf += wxT("\\par\n");
+          rtf += end;
+          return rtf;
+        });
+      data->AddDeferred(std::make_unique<RtfDataObject>(),
+                        [rtf]{ return new RtfDataObject(rtf()); });
+      data->AddDeferred(std::make_unique<RtfDataObject2>(),
+                        [rtf]{ return new RtfDataObject2(rtf()); }, true);
     }
 
     // Add a string representation of the selected output to the clipboard
-    s = tmp->ListToString();
-    data->Add(new wxTextDataObject(s));
+    data->AddDeferred(std::make_unique<wxTextDataObject>(),
+                      [snapshot]() -> wxDataObject * {
+                        if (!snapshot->cells)
+                          return nullptr;
+                        return new wxTextDataObject(snapshot->cells->ListToString());
+                      });
 
     if(m_configuration->CopyBitmap())
     {
       // Try to fill bmp with a high-res version of the cells
-      BitmapOut output(&m_configuration, std::move(tmp),
-                       m_configuration->BitmapScale(),
-                       1000000*m_configuration->MaxClipbrdBitmapMegabytes());
-      if (output.IsOk())
-        data->Add(output.GetDataObject().release());
+      Configuration **const configuration = &m_configuration;
+      double const scale = m_configuration->BitmapScale();
+      long const maxSize = 1000000*m_configuration->MaxClipbrdBitmapMegabytes();
+      data->AddDeferred(std::make_unique<wxBitmapDataObject>(),
+                        [snapshot, configuration, scale, maxSize]() -> wxDataObject * {
+                          if (!snapshot->cells)
+                            return nullptr;
+                          BitmapOut output(configuration, snapshot->Copy(), scale, maxSize);
+                          return output.IsOk() ? output.GetDataObject().release() : nullptr;
+                        });
     }
     wxTheClipboard->SetData(data);
     wxTheClipboard->Close();
@@ -2543,6 +2749,55 @@ bool Worksheet::Copy(bool astext)
   return false;
 }
 
+std::shared_ptr<Worksheet::ClipboardSnapshot> Worksheet::SnapshotSelection()
+{
+  auto snapshot = std::make_shared<ClipboardSnapshot>();
+  Cell *const start = m_cellPointers.m_selectionStart.get();
+  Cell *const end = m_cellPointers.m_selectionEnd.get();
+
+  if (start->GetType() == MC_TYPE_GROUP)
+  {
+    // Copies of GroupCells don't point back to the worksheet.
+    GroupCell *const endGroup = end->GetGroup();
+    CellListBuilder<> copy;
+    for (auto &tmp : OnList(start->GetGroup()))
+    {
+      copy.Append(tmp.Copy(nullptr));
+      if (&tmp == endGroup)
+        break;
+    }
+    snapshot->cells = std::move(copy);
+  }
+  else
+  {
+    // Copies of output cells need a group that isn't part of the worksheet.
+    snapshot->group = std::make_unique<GroupCell>(&m_configuration, GC_TYPE_CODE);
+    CellListBuilder<> copy;
+    for (const Cell &tmp : OnDrawList(start))
+    {
+      copy.Append(tmp.Copy(snapshot->group.get()));
+      if (&tmp == end)
+        break;
+    }
+    snapshot->cells = std::move(copy);
+
+    if (m_configuration->CopyMathML())
+    {
+      CellListBuilder<> asData;
+      for (const Cell &tmp : OnList(start))
+      {
+        asData.Append(tmp.Copy(snapshot->group.get()));
+        if (&tmp == end)
+          break;
+      }
+      snapshot->cellsAsData = std::move(asData);
+    }
+  }
+
+  m_clipboardSnapshot = snapshot;
+  return snapshot;
+}
+
 wxString Worksheet::ConvertSelectionToMathML()
 {
   if (GetActiveCell())
@@ -2551,18 +2806,23 @@ wxString Worksheet::ConvertSelectionToMathML()
   if (!m_cellPointers.m_selectionStart || !m_cellPointers.m_selectionEnd)
     return {};
 
-  wxString s;
   std::unique_ptr<Cell> tmp(
     CopySelection(m_cellPointers.m_selectionStart, m_cellPointers.m_selectionEnd, true));
+  wxString s = CellsToMathML(tmp.get());
+  Recalculate();
+  return s;
+}
+
+wxString Worksheet::CellsToMathML(const Cell *cells)
+{
+  if (!cells)
+    return {};
 
-  s = wxString(wxT("<math xmlns=\"http://www.w3.org/1998/Math/MathML\">\n")) +
-      wxT("<semantics>") +
-      tmp->ListToMathML(true) +
-      wxT("<annotation encoding=\"application/x-maxima\">") +
-      Cell::XMLescape(tmp->ListToString()) +
-      wxT("</annotation>") +
-      wxT("</semantics>") +
-      wxT("</math>");
+  wxString s = wxT("<math xmlns=\"http://www.w3.org/1998/Math/MathML\">\n<semantics>");
+  cells->ListAppendMathML(s, true);
+  s += wxT("<annotation encoding=\"application/x-maxima\">");
+  s += Cell::XMLescape(cells->ListToString());
+  s += wxT("</annotation></semantics></math>");
 
   // We might add indentation as additional eye candy to all but extremely long
   // xml data chunks.
@@ -2593,7 +2853,6 @@ wxString Worksheet::ConvertSelectionToMathML()
 
     }
   }
-  Recalculate();
   return s;
 }
 
@@ -2675,7 +2934,7 @@ bool Worksheet::CopyTeX()
   }
   for (const Cell &tmp : OnList(start))
   {
-    s += tmp.ToTeX();
+    tmp.AppendTeX(s);
     if (&tmp == m_cellPointers.m_selectionEnd)
       break;
   }
@@ -2732,65 +2991,78 @@ bool Worksheet::CopyCells()
 
   if (wxTheClipboard->Open())
   {
-#if wxUSE_ENH_METAFILE
     auto *data = new CompositeDataObject;
-#else
-    wxDataObjectComposite *data = new wxDataObjectComposite;
-#endif
-    wxString wxm;
-    wxString str;
-    wxString rtf = RTFStart();
 
-    GroupCell *const end = m_cellPointers.m_selectionEnd->GetGroup();
-    bool firstcell = true;
-    for (auto &tmp : OnList(m_cellPointers.m_selectionStart->GetGroup()))
-    {
-      if (!firstcell)
-        str += wxT("\n");
-      str += tmp.ToString();
-      firstcell = false;
-
-      if (m_configuration->CopyRTF())
-        rtf += tmp.ToRTF();
-      wxm += Format::TreeToWXM(&tmp);
-
-      if (&tmp == end)
-      	break;
-    }
-
-    rtf += wxT("\\par") + RTFEnd();
+    // The formats are only generated if an application asks for them.
+    auto const snapshot = SnapshotSelection();
+    Configuration **const configuration = &m_configuration;
 
     if (m_configuration->CopyRTF())
     {
-      data->Add(new RtfDataObject(rtf), true);
-      data->Add(new RtfDataObject2(rtf));
-    }
-    data->Add(new wxTextDataObject(str));
-    data->Add(new wxmDataObject(wxm));
+      auto const rtf = GenerateOnce([snapshot, start = RTFStart(), end = RTFEnd()]{
+          wxString rtf = start;
+          for (auto &tmp : OnList(snapshot->cells.get()))
+            rtf += tmp.ToRTF();
+          rtf += wxT("\\par") + end;
+          return rtf;
+        });
+      data->AddDeferred(std::make_unique<RtfDataObject>(),
+                        [rtf]{ return new RtfDataObject(rtf()); }, true);
+      data->AddDeferred(std::make_unique<RtfDataObject2>(),
+                        [rtf]{ return new RtfDataObject2(rtf()); });
+    }
+    data->AddDeferred(std::make_unique<wxTextDataObject>(),
+                      [snapshot]{
+                        wxString str;
+                        bool firstcell = true;
+                        for (auto &tmp : OnList(snapshot->cells.get()))
+                        {
+                          if (!firstcell)
+                            str += wxT("\n");
+                          str += tmp.ToString();
+                          firstcell = false;
+                        }
+                        return new wxTextDataObject(str);
+                      });
+    data->AddDeferred(std::make_unique<wxmDataObject>(),
+                      [snapshot]{
+                        wxString wxm;
+                        for (auto &tmp : OnList(dynamic_cast<GroupCell *>(snapshot->cells.get())))
+                          wxm += Format::TreeToWXM(&tmp);
+                        return new wxmDataObject(wxm);
+                      });
 
     if (m_configuration->CopyBitmap())
     {
-      BitmapOut output(&m_configuration, CopySelection(),
-                       m_configuration->BitmapScale(),
-                       1000000*m_configuration->MaxClipbrdBitmapMegabytes());
-      if (output.IsOk())
-        data->Add(output.GetDataObject().release());
+      double const scale = m_configuration->BitmapScale();
+      long const maxSize = 1000000*m_configuration->MaxClipbrdBitmapMegabytes();
+      data->AddDeferred(std::make_unique<wxBitmapDataObject>(),
+                        [snapshot, configuration, scale, maxSize]() -> wxDataObject * {
+                          if (!snapshot->cells)
+                            return nullptr;
+                          BitmapOut output(configuration, snapshot->Copy(), scale, maxSize);
+                          return output.IsOk() ? output.GetDataObject().release() : nullptr;
+                        });
     }
 
 #if wxUSE_ENH_METAFILE
     if (m_configuration->CopyEMF())
-    {
-      Emfout emf(&m_configuration, CopySelection());
-      if (emf.IsOk())
-        data->Add(emf.GetDataObject().release());
-    }
+      data->AddDeferred(std::make_unique<wxEnhMetaFileDataObject>(),
+                        [snapshot, configuration]() -> wxDataObject * {
+                          if (!snapshot->cells)
+                            return nullptr;
+                          Emfout emf(configuration, snapshot->Copy());
+                          return emf.IsOk() ? emf.GetDataObject().release() : nullptr;
+                        });
 #endif
     if (m_configuration->CopySVG())
-    {
-      Svgout svg(&m_configuration, CopySelection());
-      if (svg.IsOk())
-        data->Add(svg.GetDataObject().release());
-    }
+      data->AddDeferred(std::make_unique<wxCustomDataObject>(Svgout::GetDataFormat()),
+                        [snapshot, configuration]() -> wxDataObject * {
+                          if (!snapshot->cells)
+                            return nullptr;
+                          Svgout svg(configuration, snapshot->Copy());
+                          return svg.IsOk() ? svg.GetDataObject().release() : nullptr;
+                        });
 
     wxTheClipboard->SetData(data);
     wxTheClipboard->Close();
@@ -3031,6 +3303,9 @@ void Worksheet::DeleteRegion(GroupCell *start, GroupCell *end, UndoActions *undo
   if (renumber)
     NumberSections();
   UpdateTableOfContents();
+  // The most expensive cell might have been deleted
+  if (Profiler::GetMaxCellCost() > 0)
+    Profiler::UpdateMaxCellCost(GetTree());
   Recalculate();
   RequestRedraw();
   SetSaved(false);
@@ -3440,7 +3715,7 @@ void Worksheet::OnCharInActive(wxKeyEvent &event)
 
     // Re-calculate the table of contents as we possibly leave a cell that is
     // to be found here.
-    UpdateTableOfContents();
+    UpdateTocSelection();
 
     // If we scrolled away from the cell that is currently being evaluated
     // we need to enable the button that brings us back
@@ -3495,7 +3770,7 @@ void Worksheet::OnCharInActive(wxKeyEvent &event)
     }
     // Re-calculate the table of contents as we possibly leave a cell that is
     // to be found here.
-    UpdateTableOfContents();
+    UpdateTocSelection();
     ScrolledAwayFromEvaluation();
 
     return;
@@ -3628,7 +3903,7 @@ void Worksheet::OnCharInActive(wxKeyEvent &event)
   if (GetActiveCell())
   {
     if (IsLesserGCType(GC_TYPE_TEXT, GetActiveCell()->GetGroup()->GetGroupType()))
-      UpdateTableOfContents();
+      UpdateTableOfContents(GetActiveCell()->GetGroup());
   }
 }
 
@@ -4416,37 +4691,24 @@ void Worksheet::OnTimer(wxTimerEvent &event)
     break;
   case CARET_TIMER_ID:
     {
-      int virtualsize_x;
-      int virtualsize_y;
-      GetVirtualSize(&virtualsize_x, &virtualsize_y);
-
       if (m_blinkDisplayCaret)
       {
+        // Only the few pixels the caret occupies need to be redrawn: Redrawing
+        // the whole active cell means re-drawing all of its text twice a second.
         wxRect rect;
 
         if (GetActiveCell())
         {
-          rect = GetActiveCell()->GetRect();
+          rect = GetActiveCell()->GetCaretRect();
           GetActiveCell()->SwitchCaretDisplay();
         }
         else
         {
           m_hCaretBlinkVisible = !m_hCaretBlinkVisible;
-          if (!m_hCaretPosition)
-          {
-            rect.SetTop(0);
-            rect.SetBottom(m_configuration->GetGroupSkip());
-          }
-          else
-          {
-            rect = m_hCaretPosition->GetRect();
-            int caretY = ((int) m_configuration->GetGroupSkip()) / 2 + rect.GetBottom() + 1;
-            rect.SetTop(caretY - m_configuration->GetCursorWidth() / 2);
-            rect.SetBottom(caretY + (m_configuration->GetCursorWidth() + 1) / 2);
-          }
+          rect = GetHCaretRect();
         }
-        rect.SetLeft(0);
-        rect.SetRight(virtualsize_x + m_configuration->Scale_Px(10));
+        // Leave room for antialiasing
+        rect.Inflate(m_configuration->Scale_Px(1) + 1);
         RequestRedraw(rect);
       }
 
@@ -4461,27 +4723,28 @@ void Worksheet::OnTimer(wxTimerEvent &event)
       }
     }
     break;
-  default:
-  {
-      // Determine if the timer that has expired belongs to a slide show cell.
-      Cell *const cell = m_cellPointers.GetCellForTimerId(event.GetId());
-      AnimationCell *const animation = dynamic_cast<AnimationCell*>(cell);
-      if (animation)
+  case ANIMATION_TIMER_ID:
+    {
+      // Step all animations that are due now. Their rectangles are merged
+      // into one region that is redrawn in a single go in the idle loop.
+      for (Cell *const cell : m_cellPointers.TakeDueAnimations())
       {
+        AnimationCell *const animation = dynamic_cast<AnimationCell*>(cell);
+        if (!animation)
+          continue;
         int pos = animation->GetDisplayedIndex() + 1;
 
         if (pos >= animation->Length())
           pos = 0;
         animation->SetDisplayedIndex(pos);
 
-        // Refresh the displayed bitmap
+        // Refresh the displayed bitmap. Animations that aren't visible aren't
+        // drawn and therefore don't ask for their next frame until they are
+        // scrolled into view again.
         if (!m_configuration->ClipToDrawRegion())
           animation->ReloadTimer();
         else
-        {
-          wxRect rect = animation->GetRect();
-          RequestRedraw(rect);
-        }
+          RequestRedraw(animation->GetRect());
 
         if (m_mainToolBar && GetSelectionStart() == animation)
         {
@@ -4489,11 +4752,45 @@ void Worksheet::OnTimer(wxTimerEvent &event)
             m_mainToolBar->UpdateSlider(animation);
         }
       }
-      break;
     }
+    break;
+  default:
+    break;
   }
 }
 
+void Worksheet::Refresh(bool eraseBackground, const wxRect *rect)
+{
+  // Everything that is redrawn has changed => the tile cache has to forget it.
+  if (rect)
+  {
+    wxRect unscrolledRect = *rect;
+    CalcUnscrolledPosition(rect->x, rect->y, &unscrolledRect.x, &unscrolledRect.y);
+    m_tileCache.Invalidate(unscrolledRect);
+  }
+  else
+    m_tileCache.InvalidateAll();
+  wxScrolled<wxWindow>::Refresh(eraseBackground, rect);
+}
+
+wxRect Worksheet::GetHCaretRect() const
+{
+  // The horizontal caret is drawn at the left of the visible part of the worksheet
+  int visibleLeft;
+  int visibleTop;
+  CalcUnscrolledPosition(0, 0, &visibleLeft, &visibleTop);
+
+  if (!m_hCaretPosition)
+    return wxRect(visibleLeft + m_configuration->GetCellBracketWidth(),
+                  (m_configuration->GetBaseIndent() - m_configuration->GetCursorWidth()) / 2,
+                  MC_HCARET_WIDTH, m_configuration->GetCursorWidth());
+
+  int caretY = ((int) m_configuration->GetGroupSkip()) / 2 + m_hCaretPosition->GetRect().GetBottom() + 1;
+  return wxRect(visibleLeft + m_configuration->GetBaseIndent(),
+                caretY - m_configuration->GetCursorWidth() / 2,
+                MC_HCARET_WIDTH, m_configuration->GetCursorWidth());
+}
+
 void Worksheet::RequestRedraw(wxRect rect)
 {
   if(!m_rectToRefresh.Union(rect))
@@ -4799,6 +5096,7 @@ void Worksheet::CalculateReorderedCellIndices(GroupCell *tree, int &cellIndex, s
  */
 bool Worksheet::ExportToHTML(const wxString &file)
 {
+  Profiler::Scope timer(Profiler::exportDocument);
   // Show a busy cursor as long as we export.
   wxBusyCursor crs;
 
@@ -5481,7 +5779,7 @@ bool Worksheet::ExportToHTML(const wxString &file)
                 alttext +
                 wxT("\" /><br/>\n");
 
-              output << line + "\n";
+              output << line << "\n";
               break;
             }
 
@@ -5502,15 +5800,16 @@ bool Worksheet::ExportToHTML(const wxString &file)
                 alttext +
                 wxT("\" /><br/>\n");
 
-              output << line + "\n";
+              output << line << "\n";
               break;
             }
 
             default:
             {
-              wxString line = chunk->ListToMathML();
-              output << wxT("<math xmlns=\"http://www.w3.org/1998/Math/MathML\" display=\"block\">") << line
-                     << wxT("</math>\n");
+              wxString line = wxT("<math xmlns=\"http://www.w3.org/1998/Math/MathML\" display=\"block\">");
+              chunk->ListAppendMathML(line);
+              line += wxT("</math>\n");
+              output << line;
             }
             }
           }
@@ -5531,7 +5830,7 @@ bool Worksheet::ExportToHTML(const wxString &file)
               alttext +
               wxT("\" /><br/>\n");
 
-            output << line + "\n";
+            output << line << "\n";
           }
           count++;
 
@@ -5548,14 +5847,14 @@ bool Worksheet::ExportToHTML(const wxString &file)
           output << wxT("<div class=\"comment\">\n");
           // A text cell can include block-level HTML elements, e.g. <ul> ... </ul> (converted from Markdown)
           // Therefore do not output <p> ... </p> elements, that would result in invalid HTML.
-          output << MarkDown.MarkDown(EditorCell::EscapeHTMLChars(tmp.GetEditable()->ToString())) + "\n";
+          output << MarkDown.MarkDown(EditorCell::EscapeHTMLChars(tmp.GetEditable()->ToString())) << "\n";
           output << wxT("</div>\n");
           break;
         case GC_TYPE_SECTION:
           output << wxT("\n\n<!-- Section cell -->\n\n\n");
           output << wxT("<div class=\"section\">\n");
           output << wxT("<p>\n");
-          output << EditorCell::EscapeHTMLChars(tmp.GetPrompt()->ToString() + tmp.GetEditable()->ToString()) + "\n";
+          output << EditorCell::EscapeHTMLChars(tmp.GetPrompt()->ToString() + tmp.GetEditable()->ToString()) << "\n";
           output << wxT("</p>\n");
           output << wxT("</div>\n");
           break;
@@ -5564,7 +5863,7 @@ bool Worksheet::ExportToHTML(const wxString &file)
           output << wxT("<div class=\"subsect\">\n");
           output << wxT("<p>\n");
           output <<
-                  EditorCell::EscapeHTMLChars(tmp.GetPrompt()->ToString() + tmp.GetEditable()->ToString()) + "\n";
+                  EditorCell::EscapeHTMLChars(tmp.GetPrompt()->ToString() + tmp.GetEditable()->ToString()) << "\n";
           output << wxT("</p>\n");
           output << wxT("</div>\n");
           break;
@@ -5572,7 +5871,7 @@ bool Worksheet::ExportToHTML(const wxString &file)
           output << wxT("\n\n<!-- Subsubsection cell -->\n\n\n");
           output << wxT("<div class=\"subsubsect\">\n");
           output << wxT("<p>\n");
-          output << EditorCell::EscapeHTMLChars(tmp.GetPrompt()->ToString() + tmp.GetEditable()->ToString()) + "\n";
+          output << EditorCell::EscapeHTMLChars(tmp.GetPrompt()->ToString() + tmp.GetEditable()->ToString()) << "\n";
           output << wxT("</p>\n");
           output << wxT("</div>\n");
           break;
@@ -5580,7 +5879,7 @@ bool Worksheet::ExportToHTML(const wxString &file)
           output << wxT("\n\n<!-- Heading5 cell -->\n\n\n");
           output << wxT("<div class=\"heading5\">\n");
           output << wxT("<p>\n");
-          output << EditorCell::EscapeHTMLChars(tmp.GetPrompt()->ToString() + tmp.GetEditable()->ToString()) + "\n";
+          output << EditorCell::EscapeHTMLChars(tmp.GetPrompt()->ToString() + tmp.GetEditable()->ToString()) << "\n";
           output << wxT("</p>\n");
           output << wxT("</div>\n");
           break;
@@ -5588,7 +5887,7 @@ bool Worksheet::ExportToHTML(const wxString &file)
           output << wxT("\n\n<!-- Heading6 cell -->\n\n\n");
           output << wxT("<div class=\"heading6\">\n");
           output << wxT("<p>\n");
-          output << EditorCell::EscapeHTMLChars(tmp.GetPrompt()->ToString() + tmp.GetEditable()->ToString()) + "\n";
+          output << EditorCell::EscapeHTMLChars(tmp.GetPrompt()->ToString() + tmp.GetEditable()->ToString()) << "\n";
           output << wxT("</p>\n");
           output << wxT("</div>\n");
           break;
@@ -5733,6 +6032,7 @@ void Worksheet::CodeCellVisibilityChanged()
  */
 bool Worksheet::ExportToTeX(const wxString &file)
 {
+  Profiler::Scope timer(Profiler::exportDocument);
   // Show a busy cursor as long as we export.
   wxBusyCursor crs;
 
@@ -5853,31 +6153,52 @@ void Worksheet::LoadSymbols()
   if(m_helpfileanchorsThread)
   {
     m_helpfileanchorsThread->join();
-    m_helpfileanchorsThread.reset();
+    UseCompiledHelpFileAnchors();
   }
   if(m_helpFileAnchors.empty())
   {
     if(!LoadManualAnchorsFromCache())
     {
-      if(wxFileExists(GetMaximaHelpFile()))
+      // Until the background task has scanned the manual help requests are
+      // answered from the built-in list.
+      LoadBuiltInManualAnchors();
+      wxString maximaHelpFile = GetMaximaHelpFile();
+      if(wxFileExists(maximaHelpFile))
       {
-        if(m_helpfileanchorsThread)
-        {
-          // Show a busy cursor as long as we finish the old background task
-          wxBusyCursor crs;
-          m_helpfileanchorsThread->join();
-        }
+        m_helpFileAnchorsCompiled = false;
         m_helpfileanchorsThread =
           std::unique_ptr<std::thread>(
-            new std::thread(&Worksheet::CompileHelpFileAnchors, this));
+            new std::thread(&Worksheet::CompileHelpFileAnchors_Backgroundtask, this,
+                            maximaHelpFile, m_maximaVersion));
       }
-      else
-        LoadBuiltInManualAnchors();
     }
   }
   m_autocomplete.LoadSymbols();
 }
 
+wxString Worksheet::GetHelpFileAnchor(const wxString &keyword)
+{
+  UseCompiledHelpFileAnchors();
+  auto anchor = m_helpFileAnchors.find(keyword);
+  if(anchor == m_helpFileAnchors.end())
+    return wxEmptyString;
+  return anchor->second;
+}
+
+void Worksheet::UseCompiledHelpFileAnchors()
+{
+  if((!m_helpfileanchorsThread) || (!m_helpFileAnchorsCompiled))
+    return;
+  if(m_helpfileanchorsThread->joinable())
+    m_helpfileanchorsThread->join();
+  m_helpfileanchorsThread.reset();
+  if(!m_compiledHelpFileAnchors.empty())
+  {
+    m_helpFileAnchors.clear();
+    m_helpFileAnchors.swap(m_compiledHelpFileAnchors);
+  }
+}
+
 bool Worksheet::LoadBuiltInManualAnchors()
 {
   wxLogMessage(_("Using the built-in list of manual anchors."));
@@ -5899,111 +6220,59 @@ bool Worksheet::LoadManualAnchorsFromCache()
     wxLogMessage(_("No file with the subjects the manual contained in the last wxMaxima run."));
     return false;
   }
-  wxXmlDocument xmlDocument(anchorsFile);
-  if(!xmlDocument.IsOk())
+  if(!ManualAnchors::ReadCache(anchorsFile, m_maximaVersion, m_helpFileAnchors))
   {
-    wxLogMessage(_("The cache for the subjects the manual contains cannot be read."));
-    wxRemoveFile(anchorsFile);
+    wxLogMessage(_("The cache for the subjects the manual contains cannot be read or is from a different Maxima version."));
     return false;
   }
-
-  if(LoadManualAnchorsFromXML(xmlDocument))
-  {
-    wxLogMessage(wxString::Format(_("Read the entries the maxima manual offers from %s"), Dirstructure::Get()->AnchorsCacheFile().utf8_str()));
-    return true;
-  }
-  return !m_helpFileAnchors.empty();
+  wxLogMessage(wxString::Format(_("Read the entries the maxima manual offers from %s"), anchorsFile.utf8_str()));
+  return true;
 }
 
-
-void Worksheet::CompileHelpFileAnchors()
+void Worksheet::CompileHelpFileAnchors_Backgroundtask(wxString maximaHelpFile, wxString maximaVersion)
 {
   SuppressErrorDialogs suppressor;
-
-  wxString MaximaHelpFile = GetMaximaHelpFile();
-
-  if(m_helpFileAnchors.empty() && (!(MaximaHelpFile.IsEmpty())))
-  {
-    m_helpFileAnchors["wxbarsplot"] = "barsplot";
-    m_helpFileAnchors["wxboxplot"] = "boxplot";
-    m_helpFileAnchors["wxhistogram"] = "histogram";
-    m_helpFileAnchors["wxpiechart"] = "piechart";
-    m_helpFileAnchors["wxscatterplot"] = "scatterplot";
-    m_helpFileAnchors["wxstarplot"] = "starplot";
-    m_helpFileAnchors["wxdrawdf"] = "drawdf";
-    m_helpFileAnchors["wxdraw"] = "draw";
-    m_helpFileAnchors["wxdraw2d"] = "draw2d";
-    m_helpFileAnchors["wxdraw3d"] = "draw3d";
-    m_helpFileAnchors["with_slider_draw"] = "draw";
-    m_helpFileAnchors["with_slider_draw2d"] = "draw2d";
-    m_helpFileAnchors["with_slider_draw3d"] = "draw3d";
-
-    int foundAnchors = 0;
-    wxLogMessage(_("Compiling the list of anchors the maxima manual provides"));
-    wxRegEx idExtractor(".*<span id=\\\"([a-zAZ0-9_-]*)\\\"");
-    wxRegEx idExtractor_oldManual(".*<a name=\\\"([a-zAZ0-9_-]*)\\\"");
-    wxString escapeChars = "<=>[]`%?;\\$%&+-*/.!\'@#:^_";
-    if(wxFileExists(MaximaHelpFile))
-    {
-      wxFileInputStream input(MaximaHelpFile);
-      if(input.IsOk())
-      {
-        wxTextInputStream text(input, wxT('\t'), wxConvAuto(wxFONTENCODING_UTF8));
-        while(input.IsOk() && !input.Eof())
-        {
-          wxString line = text.ReadLine();
-          wxStringTokenizer tokens(line, wxT(">"));
-          while(tokens.HasMoreTokens())
-          {
-            wxString token = tokens.GetNextToken();
-            wxString oldToken(token);
-            wxString id;
-            if(idExtractor.Replace(&token, "\\1")>0)
-              id = token;
-            else
-            {
-              if(idExtractor_oldManual.Replace(&token, "\\1")>0)
-                id = token;
-            }
-            if(!id.IsEmpty())
-            {
-              // In anchors a space is represented by a hyphen
-              token.Replace("-", " ");
-              // Some other chars including the minus are represented by "_00xx"
-              // where xx is being the ascii code of the char.
-              for(wxString::const_iterator it = escapeChars.begin(); it != escapeChars.end(); ++it)
-                token.Replace(wxString::Format("_00%x",(char)*it), *it);
-              // What the g_t means I don't know. But we don't need it
-              if(token.StartsWith("g_t"))
-                token = token.Right(token.Length()-3);
-              //! Tokens that end with "-1" aren't too useful, normally.
-              if((!token.EndsWith("-1")) && (!token.Contains(" ")))              {
-                m_helpFileAnchors[token] = id;
-                foundAnchors++;
-              }
-            }
-          }
-        }
-      }
-    }
-    if(m_helpFileAnchors["%solve"].IsEmpty())
-      m_helpFileAnchors["%solve"] = m_helpFileAnchors["to_poly_solve"];
-
-    if((m_helpFileAnchors.find("find_root_error") == m_helpFileAnchors.end()) &&
-       (m_helpFileAnchors.find("find_root") != m_helpFileAnchors.end()))
-      m_helpFileAnchors["find_root_error"] = m_helpFileAnchors["find_root"];
-
-    wxLogMessage(wxString::Format(_("Found %i anchors."), foundAnchors));
-    if(foundAnchors > 50)
-      SaveManualAnchorsToCache();
-    else
-      LoadBuiltInManualAnchors();
-  }
+  HelpFileAnchors &anchors = m_compiledHelpFileAnchors;
+  anchors.clear();
+
+  anchors["wxbarsplot"] = "barsplot";
+  anchors["wxboxplot"] = "boxplot";
+  anchors["wxhistogram"] = "histogram";
+  anchors["wxpiechart"] = "piechart";
+  anchors["wxscatterplot"] = "scatterplot";
+  anchors["wxstarplot"] = "starplot";
+  anchors["wxdrawdf"] = "drawdf";
+  anchors["wxdraw"] = "draw";
+  anchors["wxdraw2d"] = "draw2d";
+  anchors["wxdraw3d"] = "draw3d";
+  anchors["with_slider_draw"] = "draw";
+  anchors["with_slider_draw2d"] = "draw2d";
+  anchors["with_slider_draw3d"] = "draw3d";
+  auto const builtInAnchors = anchors.size();
+
+  wxLogMessage(_("Compiling the list of anchors the maxima manual provides"));
+  ManualAnchors::ScanFile(maximaHelpFile, anchors);
+  auto const foundAnchors = anchors.size() - builtInAnchors;
+
+  if(anchors["%solve"].IsEmpty())
+    anchors["%solve"] = anchors["to_poly_solve"];
+
+  if((anchors.find("find_root_error") == anchors.end()) &&
+     (anchors.find("find_root") != anchors.end()))
+    anchors["find_root_error"] = anchors["find_root"];
+
+  wxLogMessage(wxString::Format(_("Found %li anchors."), static_cast<long>(foundAnchors)));
+  if(foundAnchors > 50)
+    SaveManualAnchorsToCache(anchors, maximaVersion);
+  else
+    // Keep the built-in list of anchors
+    anchors.clear();
+  m_helpFileAnchorsCompiled = true;
 }
 
-void Worksheet::SaveManualAnchorsToCache()
+void Worksheet::SaveManualAnchorsToCache(const HelpFileAnchors &anchors, const wxString &maximaVersion)
 {
-  long num = m_helpFileAnchors.size();
+  long num = anchors.size();
   if(num <= 50)
   {
     wxLogMessage(
@@ -6012,66 +6281,18 @@ void Worksheet::SaveManualAnchorsToCache()
         num));
     return;
   }
-  wxXmlAttribute *maximaVersion = new wxXmlAttribute(
-    wxT("maxima_version"),
-    m_maximaVersion);
-  wxXmlNode *topNode = new wxXmlNode(
-    NULL,
-    wxXML_DOCUMENT_NODE, wxEmptyString,
-    wxEmptyString
-    );
-  wxXmlNode *headNode = new wxXmlNode(
-    topNode,
-    wxXML_ELEMENT_NODE, wxT("maxima_toc"),
-    wxEmptyString,
-    maximaVersion
-    );
-
-  Worksheet::HelpFileAnchors::const_iterator it;
-  for (it = m_helpFileAnchors.begin();
-       it != m_helpFileAnchors.end();
-       ++it)
-  {
-    wxXmlNode *manualEntry =
-      new wxXmlNode(
-        headNode,
-          wxXML_ELEMENT_NODE,
-        "entry");
-    wxXmlNode *anchorNode = new wxXmlNode(
-      manualEntry,
-      wxXML_ELEMENT_NODE,
-      "anchor");
-    new wxXmlNode(
-      anchorNode,
-      wxXML_TEXT_NODE,
-      wxEmptyString,
-      it->second);
-    wxXmlNode *keyNode = new wxXmlNode(
-      manualEntry,
-      wxXML_ELEMENT_NODE,
-        "key");
-    new wxXmlNode(
-        keyNode,
-        wxXML_TEXT_NODE,
-        wxEmptyString,
-        it->first);
-  }
-  wxXmlDocument xmlDoc;
-  xmlDoc.SetDocumentNode(topNode);
-  wxXmlNode *commentNode = new wxXmlNode(
-    NULL,
-    wxXML_COMMENT_NODE,
-    wxEmptyString,
-    _("This file is generated by wxMaxima\n"
-      "It caches the list of subjects maxima's manual offers and is automatically\n"
-      "overwritten if maxima's version changes or the file cannot be read"));
-
-  xmlDoc.AppendToProlog(commentNode);
-
   wxString saveName = Dirstructure::AnchorsCacheFile();
   wxLogMessage(wxString::Format(_("Trying to cache the list of subjects the manual contains in the file %s."),
                                 saveName.utf8_str()));
-  xmlDoc.Save(saveName);
+  if(!ManualAnchors::WriteCache(saveName, maximaVersion, anchors))
+  {
+    wxLogMessage(_("Could not write the cache for the subjects the manual contains."));
+    return;
+  }
+  // The cache older wxMaxima versions wrote is no more read.
+  wxString oldCache = Dirstructure::OldAnchorsCacheFile();
+  if(wxFileExists(oldCache) && !wxRemoveFile(oldCache))
+    wxLogMessage(wxString::Format(_("Cannot remove the file %s"), oldCache.utf8_str()));
 }
 
 bool Worksheet::LoadManualAnchorsFromXML(wxXmlDocument xmlDocument, bool checkManualVersion)
@@ -6161,66 +6382,6 @@ wxString Worksheet::GetMaximaHelpFile()
   }
 }
 
-wxString Worksheet::UnicodeToMaxima(wxString s)
-{
-  s.Replace(wxT("\u2052"), "-"); // commercial minus sign
-  s.Replace(wxT("\uFE63"), "-"); // unicode small minus sign
-  s.Replace(wxT("\uFF0D"), "-"); // unicode big minus sign
-  s.Replace(wxT("\uFF0B"), "+"); // unicode big plus
-  s.Replace(wxT("\uFB29"), "+"); // hebrew alternate plus
-
-  wxString retval;
-
-  for (auto const &tok : MaximaTokenizer(s, m_configuration).PopTokens())
-  {
-    auto &tokenString = tok.GetText();
-    switch(tok.GetStyle())
-    {
-    case TS_DEFAULT:
-    case TS_CODE_OPERATOR:
-    case TS_CODE_VARIABLE:
-    case TS_CODE_FUNCTION:
-      if(tokenString == wxT("\u221A")) {retval += wxT(" sqrt ");continue;}
-      if(tokenString == wxT("\u222B")) {retval += wxT(" integrate ");continue;}
-      if(tokenString == wxT("\u2211")) {retval += wxT(" sum ");continue;}
-      if(tokenString == wxT("\u220F")) {retval += wxT(" product ");continue;}
-      if(tokenString == wxT("\u2148")) {retval += wxT(" %i ");continue;}
-      if(tokenString == wxT("\u2147")) {retval += wxT(" %e ");continue;}
-      if(tokenString == wxT("\u22C0")) {retval += wxT(" and ");continue;}
-      if(tokenString == wxT("\u22C1")) {retval += wxT(" or ");continue;}
-      if(tokenString == wxT("\u22BB")) {retval += wxT(" xor ");continue;}
-      if(tokenString == wxT("\u22BC")) {retval += wxT(" nand ");continue;}
-      if(tokenString == wxT("\u22BD")) {retval += wxT(" nor ");continue;}
-      if(tokenString == wxT("\u21D2")) {retval += wxT(" implies ");continue;}
-      if(tokenString == wxT("\u21D4")) {retval += wxT(" equiv ");continue;}
-      if(tokenString == wxT("\u00AC")) {retval += wxT(" not ");continue;}
-      if(tokenString == wxT("\u03C0")) {retval += wxT(" %pi ");continue;}
-      // Only executed if none of the conditions that can be found above fires
-      retval += tokenString;
-      break;
-    default:
-      if(tokenString == wxT("\u221E")) {retval += wxT(" inf ");continue;}
-      retval += tokenString;
-    }
-  }
-
-  retval.Replace(wxT("\u00B2"), "^2");
-  retval.Replace(wxT("\u00B3"), "^3");
-  retval.Replace(wxT("\u00BD"), "(1/2)");
-  retval.Replace(wxT("\u2205"), "[]"); // An empty list
-  retval.Replace(wxT("\u2212"), "-");
-  retval.Replace(wxT("\u2260"), "#");  // The "not equal" sign
-  retval.Replace(wxT("\u2264"), "<=");
-  retval.Replace(wxT("\u2265"), ">=");
-  retval.Replace(wxT("\u00B7"), "*");  // An unicode multiplication sign
-  retval.Replace(wxT("\u2052"), "-");  // commercial minus sign
-  retval.Replace(wxT("\uFE63"), "-");  // unicode small minus sign
-  retval.Replace(wxT("\uFF0D"), "-");  // unicode big minus sign
-  retval.Replace(wxT("\uFF0B"), "+");  // unicode big plus
-  retval.Replace(wxT("\uFB29"), "+");  // hebrew alternate plus
-  return retval;
-}
-
 void Worksheet::ExportToMAC(wxTextFile &output, GroupCell *tree, bool wxm, const std::vector<int> &cellMap,
                            bool fixReorderedIndices)
 {
@@ -6269,6 +6430,7 @@ void Worksheet::ExportToMAC(wxTextFile &output, GroupCell *tree, bool wxm, const
 
 bool Worksheet::ExportToMAC(const wxString &file)
 {
+  Profiler::Scope timer(Profiler::save);
   bool wasSaved = m_saved;
 
   // Show a busy cursor as long as we export or save.
@@ -6357,13 +6519,68 @@ bool Worksheet::ExportToMAC(const wxString &file)
   since the last save. Then the original .wxmx file is replaced in a
   (hopefully) atomic operation.
 */
+void Worksheet::WriteOutputPreviews(wxZipOutputStream &zip)
+{
+  if (!GetTree())
+    return;
+
+  // The pictures are rendered for the current zoom factor
+  double const zoom = m_configuration->GetZoomFactor();
+  wxString index = wxT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  index << wxString::Format(wxT("<previews zoom=\"%i\">\n"), int(100.0 * zoom));
+
+  // Like the images in the worksheet the pictures are stored uncompressed
+  zip.CloseEntry();
+  zip.SetLevel(0);
+  {
+    BitmapOut bitmap(&m_configuration, zoom);
+    // The number of the cell, as counted by wxMaxima::CreateTreeFromXMLNode()
+    long cellNumber = 0;
+    GroupCell *firstRendered = {};
+    for (auto &group : OnList(GetTree()))
+    {
+      Cell *const output = group.GetLabel();
+      // Outputs with more than 4 megapixels would make the file too big for
+      // the preview to load faster than the output itself.
+      if ((group.GetGroupType() == GC_TYPE_CODE) && output &&
+          bitmap.Render(output->CopyList(&group), 4000000))
+      {
+        group.MarkNeedsRecalculate();
+        if (!firstRendered)
+          firstRendered = &group;
+        wxImage image = bitmap.GetBitmap().ConvertToImage();
+        zip.PutNextEntry(wxString::Format(wxT("previews/%li.png"), cellNumber));
+        if (image.SaveFile(zip, wxBITMAP_TYPE_PNG))
+          index << wxString::Format(wxT("<preview cell=\"%li\" width=\"%i\" height=\"%i\"/>\n"),
+                                    cellNumber, image.GetWidth(), image.GetHeight());
+        zip.CloseEntry();
+      }
+      cellNumber++;
+    }
+  }
+  index << wxT("</previews>\n");
+
+  zip.PutNextEntry(wxT("previews/index.xml"));
+  wxTextOutputStream output(zip);
+  output << index;
+  zip.CloseEntry();
+
+  // The copies of the outputs have been laid out with the configuration of the
+  // bitmap => only the groups that have been rendered need to be laid out anew.
+  ScheduleRecalculation(firstRendered);
+}
+
 bool Worksheet::ExportToWXMX(const wxString &file, bool markAsSaved)
 {
+  Profiler::Scope timer(Profiler::save);
   // Show a busy cursor as long as we export a file.
   wxBusyCursor crs;
   // Don't update the worksheet whilst exporting
   wxWindowUpdateLocker noUpdates(this);
   wxLogMessage(_("Starting to save the worksheet as .wxmx"));
+  // The images in outputs that are still displayed as pictures would be read
+  // from the file we are about to replace.
+  ReplaceAllOutputPreviews();
   // delete temp file if it already exists
   wxString backupfile = file + wxT("~");
   if (wxFileExists(backupfile))
@@ -6520,7 +6737,7 @@ bool Worksheet::ExportToWXMX(const wxString &file, bool markAsSaved)
         m_cellPointers.WXMXResetCounter();
 
         if (GetTree())
-          xmlText += GetTree()->ListToXML();
+          GetTree()->ListAppendXML(xmlText);
 
         // Delete all but one control character from the string: there should be
         // no way for them to enter this string, anyway. But sometimes they still
@@ -6627,6 +6844,8 @@ bool Worksheet::ExportToWXMX(const wxString &file, bool markAsSaved)
             memFsName = fsystem->FindNext();
           }
         }
+        if (m_configuration->EmbedOutputPreviews())
+          WriteOutputPreviews(zip);
       }
       if(!zip.Close())
         return false;
@@ -6746,7 +6965,7 @@ void Worksheet::OnDoubleClick(wxMouseEvent &WXUNUSED(event))
 
   RequestRedraw();
 // Re-calculate the table of contents
-  UpdateTableOfContents();
+  UpdateTocSelection();
 }
 
 bool Worksheet::ActivateInput(int direction)
@@ -7834,6 +8053,8 @@ void Worksheet::UndoInsideCell()
     GetActiveCell()->Undo();
     GetActiveCell()->GetGroup()->ResetSize();
     GetActiveCell()->ResetSize();
+    if (IsLesserGCType(GC_TYPE_TEXT, GetActiveCell()->GetGroup()->GetGroupType()))
+      UpdateTableOfContents(GetActiveCell()->GetGroup());
     Recalculate();
     RequestRedraw();
   }
@@ -7850,6 +8071,8 @@ void Worksheet::RedoInsideCell()
   {
     GetActiveCell()->Redo();
     GetActiveCell()->GetGroup()->ResetSize();
+    if (IsLesserGCType(GC_TYPE_TEXT, GetActiveCell()->GetGroup()->GetGroupType()))
+      UpdateTableOfContents(GetActiveCell()->GetGroup());
     Recalculate();
     RequestRedraw();
   }
@@ -8088,7 +8311,7 @@ bool Worksheet::FindNext(const wxString &str, bool down, bool ignoreCase, bool w
         SetActiveCell(editor);
         editor->SetSelection(strt, end);
         ScrollToCaret();
-        UpdateTableOfContents();
+        UpdateTocSelection();
         RequestRedraw();
         if ((wrappedSearch) && warn)
         {
@@ -38,9 +38,13 @@
 #include <wx/textfile.h>
 #include <wx/fdrepdlg.h>
 #include <wx/dc.h>
+#include <wx/zipstrm.h>
+#include <atomic>
+#include <deque>
 #include <thread>
 #include <list>
 #include "CellPointers.h"
+#include "CompositeDataObject.h"
 #include "VariablesPane.h"
 #include "Notification.h"
 #include "Cell.h"
@@ -50,10 +54,12 @@
 #include "EvaluationQueue.h"
 #include "FindReplaceDialog.h"
 #include "Autocomplete.h"
+#include "ManualAnchors.h"
 #include "AutocompletePopup.h"
 #include "TableOfContents.h"
 #include "UnicodeSidebar.h"
 #include "ToolBar.h"
+#include "WorksheetTileCache.h"
 
 /*! The canvas that contains the spreadsheet the whole program is about.
 
@@ -86,7 +92,7 @@ wxMaxima can display it.
 class Worksheet : public wxScrolled<wxWindow>
 {
 public:
-  WX_DECLARE_STRING_HASH_MAP(wxString, HelpFileAnchors);
+  typedef ManualAnchors::Map HelpFileAnchors;
   //! Is an update of the worksheet controls needed?
   bool UpdateControlsNeeded(){bool result = m_updateControls; m_updateControls = false; return result;}
 private:
@@ -115,6 +121,10 @@ private:
   Configuration m_configurationTopInstance;
   //! The rectangle we need to refresh.
   wxRegion m_rectToRefresh;
+  //! The parts of the worksheet that have already been drawn
+  WorksheetTileCache m_tileCache;
+  //! The groups whose outputs still are displayed as OutputPreviewCells, in document order
+  std::deque<CellPtr<GroupCell>> m_pendingOutputPreviews;
   /*! The size of a scroll step
 
     Defines the size of a
@@ -419,7 +429,8 @@ private:
   enum TimerIDs
   {
     TIMER_ID,
-    CARET_TIMER_ID
+    CARET_TIMER_ID,
+    ANIMATION_TIMER_ID
   };
 
   //! Add a line to a file.
@@ -438,6 +449,32 @@ private:
   */
   std::unique_ptr<Cell> CopySelection(Cell *start, Cell *end, bool asData = false) const;
 
+  /*! A copy of the selection the clipboard formats are generated from
+
+    The formats on the clipboard are only generated when an application asks
+    for them. By then the worksheet might have been changed: The cells they
+    are generated from therefore have to be a copy that doesn't point back to
+    the worksheet.
+  */
+  struct ClipboardSnapshot
+  {
+    //! The group the copied output cells belong to. nullptr if whole groups were copied.
+    std::unique_ptr<GroupCell> group;
+    //! The copied cells in draw list order. nullptr if the worksheet has been closed.
+    std::unique_ptr<Cell> cells;
+    //! The copied output cells in cell list order, if they are needed for MathML.
+    std::unique_ptr<Cell> cellsAsData;
+    //! Returns a new copy of the copied cells
+    std::unique_ptr<Cell> Copy() const
+      { return cells ? cells->CopyList(group.get()) : nullptr; }
+  };
+  //! Copies the selection into a snapshot the clipboard formats can be generated from
+  std::shared_ptr<ClipboardSnapshot> SnapshotSelection();
+  //! The snapshot of the data on the clipboard, if it was copied from this worksheet
+  std::weak_ptr<ClipboardSnapshot> m_clipboardSnapshot;
+  //! Converts a list of cells to MathML
+  static wxString CellsToMathML(const Cell *cells);
+
   //! Get the coordinates of the bottom right point of the worksheet.
   void GetMaxPoint(int *width, int *height);
 
@@ -466,6 +503,9 @@ private:
    */
   void OnPaint(wxPaintEvent &event);
 
+  //! Clears and draws a part of the worksheet (in unscrolled coordinates) into the configuration's DC
+  void DrawWorksheetRegion(const wxRect &rect);
+
   void OnSize(wxSizeEvent &event);
 
   void OnMouseRightDown(wxMouseEvent &event);
@@ -695,7 +735,30 @@ public:
     This function actually only schedules the update of the table-of-contents-tab.
     The actual update is done when wxMaxima is idle.
    */
-  void UpdateTableOfContents() { m_scheduleUpdateToc = true; }
+  void UpdateTableOfContents()
+    {
+      m_scheduleUpdateToc = true;
+      if (m_tableOfContents)
+        m_tableOfContents->StructureChanged();
+    }
+
+  /*! Update the table of contents after the title of a heading has changed
+
+    Only generates the entry of this heading anew.
+   */
+  void UpdateTableOfContents(GroupCell *heading)
+    {
+      m_scheduleUpdateToc = true;
+      if (m_tableOfContents)
+        m_tableOfContents->HeadingChanged(heading);
+    }
+
+  /*! Update the table of contents after the cursor has moved
+
+    Only changes which item the table of contents highlights, which means that
+    the headings don't need to be searched for again.
+   */
+  void UpdateTocSelection() { m_scheduleUpdateToc = true; }
 
   /*! Handle redrawing the worksheet or of parts of it
 
@@ -748,6 +811,10 @@ public:
     real time.
    */
   void RequestRedraw(wxRect rect);
+  //! Schedules a redraw, telling the tile cache which parts of the worksheet have changed
+  void Refresh(bool eraseBackground = true, const wxRect *rect = NULL) override;
+  //! The rectangle the horizontal caret occupies, in unscrolled coordinates
+  wxRect GetHCaretRect() const;
 
   //! Redraw the window now and mark any pending redraw request as "handled".
   void ForceRedraw()
@@ -768,16 +835,14 @@ public:
 
   //! The thread the help file anchors are compiled in
   std::unique_ptr<std::thread> m_helpfileanchorsThread;
+  //! The anchors m_helpfileanchorsThread has found. Only valid once m_helpFileAnchorsCompiled is true.
+  HelpFileAnchors m_compiledHelpFileAnchors;
+  //! Has m_helpfileanchorsThread finished its work?
+  std::atomic<bool> m_helpFileAnchorsCompiled{false};
 
   //! The name of the currently-opened file
   wxString m_currentFile;
 
-  /*! Make a few unicode characters interpretable by maxima.
-
-    Does convert the not equal sign to a '#' and similar.
-   */
-  wxString UnicodeToMaxima(wxString s);
-
   //! Scroll to the start of the worksheet.
   void ScrollToStart() { Scroll(0, 0); }
 
@@ -938,9 +1003,12 @@ public:
             - treeUndoActions for normal deletes,
             - treeRedoActions for deletions while executing an undo or
             - NULL for: Don't keep any copy of the cells.
+    \param updateStructure false means: Don't renumber the sections and don't
+           update the table of contents. Whoever inserts many lists of cells
+           in a row can do this once after the last one.
    */
   GroupCell *InsertGroupCells(std::unique_ptr<GroupCell> &&cells, GroupCell *where,
-                              UndoActions *undoBuffer);
+                              UndoActions *undoBuffer, bool updateStructure = true);
 
   /*! Insert group cells into the worksheet
 
@@ -962,9 +1030,42 @@ public:
   // Actually recalculate the worksheet.
   bool RecalculateIfNeeded();
 
+  /*! Schedules the recalculation of the visible cells whose size is an estimate
+
+    Editor cells that were far away from the screen when they were laid out
+    haven't been tokenized yet, and paged outputs only measure the pages near
+    the screen. Returns true if any of these parts have been scrolled into view
+    since.
+   */
+  bool ScheduleRecalculationOfEstimatedCells();
+
+  //! Tells the worksheet that a .wxmx file with pictures of its outputs has been loaded
+  void OutputPreviewsLoaded();
+
+  /*! Converts the output of one cell that is displayed as a picture to cells
+
+    Prefers cells that are visible on the screen. Meant to be called from the
+    idle task: It only looks at the outputs OutputPreviewsLoaded() has found.
+    \return true, if there are more outputs that need to be converted.
+  */
+  bool ReplaceOutputPreview();
+
+  //! Converts all outputs that are displayed as pictures to cells
+  void ReplaceAllOutputPreviews();
+
+  //! Converts the output of group, which is displayed as a picture, to cells
+  void ReplaceOutputPreview(GroupCell &group);
+
   //! Schedule a recalculation of the worksheet starting with the cell start.
   void Recalculate(Cell *start);
 
+  /*! Schedule a recalculation of the worksheet starting with the GroupCell group
+
+    Unlike Recalculate(Cell *) this doesn't mark group as needing a full recalculation
+    => if group only got output appended only the new output will be laid out.
+  */
+  void ScheduleRecalculation(GroupCell *group);
+
   void Recalculate() { Recalculate(GetTree()); }
 
   //! Schedule a full recalculation of the worksheet
@@ -1150,6 +1251,12 @@ public:
   */
   bool ExportToWXMX(const wxString &file, bool markAsSaved = true);
 
+  /*! Adds pictures of the outputs of the code cells to a .wxmx file
+
+    The pictures are read by wxMaxima::ReadOutputPreviews().
+  */
+  void WriteOutputPreviews(wxZipOutputStream &zip);
+
   //! The start of a RTF document
   wxString RTFStart() const;
 
@@ -1169,6 +1276,10 @@ public:
   GroupCell *GetTree() const { return m_tree.get(); }
   std::unique_ptr<GroupCell> *GetTreeAddress() { return &m_tree; }
 
+  //! How well the cache of already drawn parts of the worksheet performs
+  const WorksheetTileCache::Stats &GetTileCacheStats() const { return m_tileCache.GetStats(); }
+  void ResetTileCacheStats() { m_tileCache.ResetStats(); }
+
   /*! Return the first of the currently selected cells.
 
     NULL means: No cell is selected.
@@ -1506,16 +1617,24 @@ public:
   wxString GetOutputAboveCaret();
 
   void LoadSymbols();
-  //! Collect all keyword anchors in the help file
-  void CompileHelpFileAnchors();
-  //! Load the result from the last CompileHelpFileAnchors from the disk cache
+  /*! The anchor of the manual entry for a keyword
+
+    Doesn't wait for the help file anchors to be compiled: Until they are the
+    anchors are looked up in the built-in list.
+   */
+  wxString GetHelpFileAnchor(const wxString &keyword);
+  //! Collect all keyword anchors in the help file into m_compiledHelpFileAnchors
+  void CompileHelpFileAnchors_Backgroundtask(wxString maximaHelpFile, wxString maximaVersion);
+  //! Use the anchors m_helpfileanchorsThread has compiled, if it has finished
+  void UseCompiledHelpFileAnchors();
+  //! Load the result from the last CompileHelpFileAnchors_Backgroundtask() from the disk cache
   bool LoadManualAnchorsFromCache();
   //! Load the help file anchors from an wxXmlDocument
   bool LoadManualAnchorsFromXML(wxXmlDocument xmlDocument, bool checkManualVersion = true);
   //! Load the help file anchors from the built-in list
   bool LoadBuiltInManualAnchors();
-  //! Save the list of help file anchors to the cache.
-  void SaveManualAnchorsToCache();
+  //! Save a list of help file anchors to the cache.
+  static void SaveManualAnchorsToCache(const HelpFileAnchors &anchors, const wxString &maximaVersion);
 
   bool Autocomplete(AutoComplete::autoCompletionType type = AutoComplete::command);
 
@@ -1534,7 +1653,7 @@ public:
   void OpenNextOrCreateCell();
 
   //! The table of contents pane
-  TableOfContents *m_tableOfContents;
+  TableOfContents *m_tableOfContents = NULL;
 
   //! Called when the "Scroll to currently evaluated" button is pressed.
   void OnFollow();
@@ -0,0 +1,168 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+/*! \file
+  This file defines the class WorksheetTileCache
+ */
+
+#include "WorksheetTileCache.h"
+#include <wx/math.h>
+
+WorksheetTileCache::WorksheetTileCache(size_t maxBytes) : m_maxBytes(maxBytes)
+{
+}
+
+size_t WorksheetTileCache::TileBytes() const
+{
+  size_t const deviceSize = wxRound(TILE_SIZE * m_scaleFactor);
+  return deviceSize * deviceSize * 4;
+}
+
+void WorksheetTileCache::SetScaleFactor(double scaleFactor)
+{
+  if (scaleFactor == m_scaleFactor)
+    return;
+  // The tiles that exist have the wrong resolution
+  Clear();
+  m_scaleFactor = scaleFactor;
+}
+
+int WorksheetTileCache::TileIndex(int coordinate)
+{
+  // Round towards minus infinity, not towards zero
+  if (coordinate < 0)
+    return -((-coordinate + TILE_SIZE - 1) / TILE_SIZE);
+  return coordinate / TILE_SIZE;
+}
+
+wxRect WorksheetTileCache::TileRect(const std::pair<int, int> &key)
+{
+  return wxRect(key.first * TILE_SIZE, key.second * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+}
+
+bool WorksheetTileCache::Paint(wxDC &dc, const wxRect &rect, const Renderer &render)
+{
+  if ((rect.GetWidth() < 1) || (rect.GetHeight() < 1))
+    return true;
+
+  m_paintCount++;
+  for (int row = TileIndex(rect.GetTop()); row <= TileIndex(rect.GetBottom()); row++)
+    for (int column = TileIndex(rect.GetLeft()); column <= TileIndex(rect.GetRight()); column++)
+    {
+      std::pair<int, int> const key(column, row);
+      wxRect const tileRect = TileRect(key);
+      auto tileIt = m_tiles.find(key);
+      if (tileIt == m_tiles.end())
+      {
+        Tile tile;
+        if (!tile.bitmap.CreateScaled(TILE_SIZE, TILE_SIZE, wxBITMAP_SCREEN_DEPTH, m_scaleFactor) ||
+            !tile.bitmap.IsOk())
+          return false;
+        tile.dirty = wxRegion(tileRect);
+        tileIt = m_tiles.emplace(key, std::move(tile)).first;
+        m_stats.tiles++;
+        m_stats.bytes += TileBytes();
+      }
+      Tile &tile = tileIt->second;
+      tile.lastUsed = m_paintCount;
+
+      wxMemoryDC tileDC(tile.bitmap);
+      if (!tileDC.IsOk())
+        return false;
+      // Let the tile use the same coordinates as the worksheet
+      tileDC.SetDeviceOrigin(-tileRect.GetLeft(), -tileRect.GetTop());
+      if (tile.dirty.IsEmpty())
+        m_stats.hits++;
+      else
+      {
+        for (wxRegionIterator dirty(tile.dirty); dirty; ++dirty)
+        {
+          wxRect const dirtyRect = dirty.GetRect();
+          tileDC.SetClippingRegion(dirtyRect);
+          render(tileDC, dirtyRect);
+          tileDC.DestroyClippingRegion();
+        }
+        tile.dirty.Clear();
+        m_stats.renders++;
+      }
+
+      wxRect const area = tileRect.Intersect(rect);
+      dc.Blit(area.GetLeft(), area.GetTop(), area.GetWidth(), area.GetHeight(),
+              &tileDC, area.GetLeft(), area.GetTop());
+    }
+  Evict();
+  return true;
+}
+
+void WorksheetTileCache::Invalidate(const wxRect &rect)
+{
+  if ((rect.GetWidth() < 1) || (rect.GetHeight() < 1))
+    return;
+  for (auto &tile : m_tiles)
+  {
+    wxRect const tileRect = TileRect(tile.first);
+    if (!tileRect.Intersects(rect))
+      continue;
+    wxRect const outdated = tileRect.Intersect(rect);
+    if (!tile.second.dirty.Union(outdated))
+      tile.second.dirty = wxRegion(outdated);
+  }
+}
+
+void WorksheetTileCache::InvalidateAll()
+{
+  for (auto &tile : m_tiles)
+    tile.second.dirty = wxRegion(TileRect(tile.first));
+}
+
+void WorksheetTileCache::Clear()
+{
+  m_tiles.clear();
+  m_stats.tiles = 0;
+  m_stats.bytes = 0;
+}
+
+void WorksheetTileCache::ResetStats()
+{
+  m_stats.hits = 0;
+  m_stats.renders = 0;
+  m_stats.evictions = 0;
+}
+
+void WorksheetTileCache::Evict()
+{
+  while (m_stats.bytes > m_maxBytes)
+  {
+    // Tiles that have been used in the current Paint() are needed on the screen.
+    auto oldest = m_tiles.end();
+    for (auto tile = m_tiles.begin(); tile != m_tiles.end(); ++tile)
+      if ((tile->second.lastUsed != m_paintCount) &&
+          ((oldest == m_tiles.end()) || (tile->second.lastUsed < oldest->second.lastUsed)))
+        oldest = tile;
+    if (oldest == m_tiles.end())
+      return;
+    m_tiles.erase(oldest);
+    m_stats.tiles--;
+    m_stats.bytes -= TileBytes();
+    m_stats.evictions++;
+  }
+}
@@ -0,0 +1,134 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#ifndef WORKSHEETTILECACHE_H
+#define WORKSHEETTILECACHE_H
+
+/*! \file
+
+  This file declares the class WorksheetTileCache.
+ */
+
+#include <wx/bitmap.h>
+#include <wx/dc.h>
+#include <wx/dcmemory.h>
+#include <wx/region.h>
+#include <functional>
+#include <map>
+#include <utility>
+
+/*! A cache of rendered parts of the worksheet
+
+  Drawing the worksheet means walking the list of GroupCells and re-issuing
+  every single text draw. This cache retains the drawn worksheet as square
+  tiles in unscrolled coordinates so that scrolling or uncovering parts of the
+  window only needs to copy bitmaps: Only the parts of the worksheet that have
+  changed or that haven't been drawn before need to actually be drawn.
+
+  On high-DPI screens the tiles have one pixel per device pixel: Their size
+  and coordinates are logical pixels, though, like the worksheet's.
+
+  Every request to redraw a part of the worksheet has to be reported to
+  Invalidate() as the cache otherwise would continue showing the outdated
+  contents.
+ */
+class WorksheetTileCache
+{
+public:
+  //! The width and height of a tile, in logical pixels
+  static constexpr int TILE_SIZE = 512;
+  //! Draws the part of the worksheet described by the wxRect into the DC
+  using Renderer = std::function<void(wxMemoryDC &, const wxRect &)>;
+
+  //! How well the cache performs
+  struct Stats
+  {
+    //! How many times a tile could be copied to the screen without drawing it
+    unsigned long hits = 0;
+    //! How many times (parts of) a tile had to be drawn
+    unsigned long renders = 0;
+    //! How many tiles were dropped in order to stay within the memory limit
+    unsigned long evictions = 0;
+    //! How many tiles are currently cached
+    size_t tiles = 0;
+    //! How much memory the cached tiles use, in bytes
+    size_t bytes = 0;
+  };
+
+  //! \param maxBytes How much memory the tiles may use
+  explicit WorksheetTileCache(size_t maxBytes = 64 * 1024 * 1024);
+
+  /*! Draws a part of the worksheet, drawing the outdated parts of the tiles it covers first
+
+    \param dc The DC to draw to. Its logical coordinates must be unscrolled
+    worksheet coordinates.
+    \param rect The part of the worksheet to draw, in unscrolled coordinates
+    \param render Draws a part of the worksheet into a tile.
+    \returns false, if no tile could be created. In this case the caller
+    has to draw rect directly.
+   */
+  bool Paint(wxDC &dc, const wxRect &rect, const Renderer &render);
+  //! Marks a part of the worksheet (in unscrolled coordinates) as outdated
+  void Invalidate(const wxRect &rect);
+  //! Marks the whole worksheet as outdated
+  void InvalidateAll();
+  //! Drops all tiles, freeing their memory
+  void Clear();
+  /*! Sets how many device pixels a logical pixel has
+
+    Drops all tiles, if the scale factor changes.
+   */
+  void SetScaleFactor(double scaleFactor);
+  const Stats &GetStats() const { return m_stats; }
+  //! Restarts counting hits, renders and evictions
+  void ResetStats();
+
+private:
+  struct Tile
+  {
+    wxBitmap bitmap;
+    //! The outdated parts of the tile, in unscrolled coordinates
+    wxRegion dirty;
+    //! The number of the Paint() call this tile has last been used in
+    unsigned long lastUsed = 0;
+  };
+
+  //! The column or row of the tile a coordinate belongs to
+  static int TileIndex(int coordinate);
+  //! The rectangle a tile covers, in unscrolled coordinates
+  static wxRect TileRect(const std::pair<int, int> &key);
+  //! Drops the least recently used tiles until the cache fits into m_maxBytes
+  void Evict();
+  //! The memory one tile occupies, assuming 32 bits per pixel
+  size_t TileBytes() const;
+
+  //! The tiles, indexed by column and row
+  std::map<std::pair<int, int>, Tile> m_tiles;
+  size_t m_maxBytes;
+  //! How many times Paint() has been called
+  unsigned long m_paintCount = 0;
+  //! How many device pixels a logical pixel has
+  double m_scaleFactor = 1.0;
+  Stats m_stats;
+};
+
+#endif // WORKSHEETTILECACHE_H
@@ -30,34 +30,88 @@
 #include "XmlInspector.h"
 
 #include <wx/sizer.h>
-#include <wx/regex.h>
-
-XmlInspector::XmlInspector(wxWindow *parent, int id) : wxRichTextCtrl(parent, id,
-                                                                      wxEmptyString,
-                                                                      wxDefaultPosition,
-                                                                      wxSize(wxSystemSettings::GetMetric ( wxSYS_SCREEN_X )/10,
-                    wxSystemSettings::GetMetric ( wxSYS_SCREEN_Y )/10),
-                                                                      wxTE_READONLY |
-                                                                      wxTE_RICH |
-                                                                      wxHSCROLL |
-                                                                      wxTE_MULTILINE)
+#include <wx/config.h>
+#include <wx/clipbrd.h>
+#include <wx/menu.h>
+#include <wx/wupdlock.h>
+#include <algorithm>
+
+XmlInspector::XmlInspector(wxWindow *parent, int id) : wxPanel(parent, id)
 {
-  m_state = clear;
-  m_indentLevel = 0;
-  BeginSuppressUndo();
-  XmlInspector::Clear();
-  wxRichTextCtrl::Clear();
+  wxConfig::Get()->Read(m_maxBytesKey, &m_maxBytes);
+  m_attributes[toMaxima].SetTextColour(wxColour(128,0,0));
+  m_attributes[fromMaxima].SetTextColour(wxColour(0,128,0));
+
+  m_list = new LineList(this, XmlInspector_ctrl_id);
+  m_list->SetInitialSize(wxSize(wxSystemSettings::GetMetric ( wxSYS_SCREEN_X )/10,
+                                wxSystemSettings::GetMetric ( wxSYS_SCREEN_Y )/10));
+  wxArrayString directions;
+  directions.Add(_("All"));
+  directions.Add(_("Maxima response"));
+  directions.Add(_("Sent to maxima"));
+  m_direction = new wxChoice(this, XmlInspector_direction_id, wxDefaultPosition, wxDefaultSize, directions);
+  m_direction->SetSelection(0);
+  m_tags = new wxTextCtrl(this, XmlInspector_tags_id);
+  m_tags->SetHint(_("Tags to show, for example: mth lbl"));
+
+  wxBoxSizer *filterBox = new wxBoxSizer(wxHORIZONTAL);
+  filterBox->Add(m_direction, wxSizerFlags());
+  filterBox->Add(m_tags, wxSizerFlags(1).Expand());
+  wxBoxSizer *box = new wxBoxSizer(wxVERTICAL);
+  box->Add(m_list, wxSizerFlags(1).Expand());
+  box->Add(filterBox, wxSizerFlags().Expand());
+  SetSizer(box);
+  FitInside();
+
+  m_direction->Connect(wxEVT_CHOICE, wxCommandEventHandler(XmlInspector::OnFilterChange), NULL, this);
+  m_tags->Connect(wxEVT_TEXT, wxCommandEventHandler(XmlInspector::OnFilterChange), NULL, this);
+  m_list->Connect(wxEVT_KEY_DOWN, wxKeyEventHandler(XmlInspector::OnKeyDown), NULL, this);
+  m_list->Connect(wxEVT_RIGHT_DOWN, wxMouseEventHandler(XmlInspector::OnMouseRightDown), NULL, this);
+  Connect(wxEVT_MENU, wxCommandEventHandler(XmlInspector::OnMenu), NULL, this);
 }
 
 XmlInspector::~XmlInspector()
 {
 }
 
+XmlInspector::LineList::LineList(XmlInspector *inspector, wxWindowID id) :
+  wxListCtrl(inspector, id, wxDefaultPosition, wxDefaultSize,
+             wxLC_REPORT | wxLC_VIRTUAL | wxLC_NO_HEADER),
+  m_inspector(inspector)
+{
+  InsertColumn(0, wxEmptyString);
+}
+
+wxString XmlInspector::LineList::OnGetItemText(long item, long WXUNUSED(column)) const
+{
+  if ((item < 0) || (item >= m_inspector->ShownLineCount()))
+    return {};
+  const Line &line = m_inspector->GetShownLine(item);
+  if (line.state != fromMaxima)
+    return line.text;
+  return wxString(wxT(' '), std::max(line.indentLevel + 1, 0)) + line.text;
+}
+
+wxListItemAttr *XmlInspector::LineList::OnGetItemAttr(long item) const
+{
+  if ((item < 0) || (item >= m_inspector->ShownLineCount()))
+    return NULL;
+  const Line &line = m_inspector->GetShownLine(item);
+  if (line.state == clear)
+    return NULL;
+  return &m_inspector->m_attributes[line.state];
+}
+
 void XmlInspector::Clear()
 {
-  m_clear = true;
-  m_fromMaxima = wxEmptyString;
-  m_toMaxima = wxEmptyString;
+  m_lines.clear();
+  m_shownLines.clear();
+  m_currentLine = Line();
+  m_bytes = 0;
+  m_longestLine = 0;
+  m_lastChar = wxT('\0');
+  m_indentLevel = 0;
+  m_state = clear;
   m_updateNeeded = true;
 }
 
@@ -66,123 +120,259 @@ void XmlInspector::UpdateContents()
   if(!m_updateNeeded)
     return;
   m_updateNeeded = false;
-  
-  if(m_clear)
+
+  // Follow the new lines, unless the user has scrolled away from the end.
+  long const oldCount = m_list->GetItemCount();
+  bool const atEnd = (oldCount == 0) ||
+    (m_list->GetTopItem() + m_list->GetCountPerPage() >= oldCount);
+
+  long const count = ShownLineCount();
+  m_list->SetItemCount(count);
+  m_list->SetColumnWidth(0, std::max(m_list->GetClientSize().x,
+                                     int(m_longestLine + 1) * m_list->GetCharWidth()));
+  if (atEnd && (count > 0))
+    m_list->EnsureVisible(count - 1);
+  m_list->Refresh();
+}
+
+void XmlInspector::StartSection(monitorState state)
+{
+  if(m_state == state)
+    return;
+  FinishLine();
+  Line line;
+  if(!m_lines.empty())
   {
-    wxRichTextCtrl::Clear();
-    m_lastChar = wxChar(0);
-    m_indentLevel = 0;
-    m_state = clear;
-    m_clear = false;
+    m_currentLine = line;
+    FinishLine();
   }
-  
-  // Display all data we have sent to Maxima
-  if(m_toMaxima != wxEmptyString)
+  if(state == toMaxima)
+    line.text = _("SENT TO MAXIMA:");
+  else
+    line.text = _("MAXIMA RESPONSE:");
+  m_currentLine = line;
+  FinishLine();
+  m_currentLine.state = state;
+  m_currentLine.indentLevel = m_indentLevel;
+  m_state = state;
+}
+
+void XmlInspector::FinishLine()
+{
+  Line line;
+  line.state = m_currentLine.state;
+  line.indentLevel = m_indentLevel;
+  std::swap(line, m_currentLine);
+  // Empty lines only make sense as separators between sections
+  if(line.text.IsEmpty() && ((line.state != clear) || m_lines.empty()))
+    return;
+
+  m_longestLine = std::max(m_longestLine, line.text.Length() + std::max(line.indentLevel + 1, 0));
+  m_bytes += LineBytes(line);
+  if(Matches(line))
+    m_shownLines.push_back(m_firstLine + m_lines.size());
+  m_lines.push_back(std::move(line));
+  DropOldLines();
+  m_updateNeeded = true;
+}
+
+void XmlInspector::DropOldLines()
+{
+  while((m_bytes > size_t(m_maxBytes)) && (m_lines.size() > 1))
   {
-    if(m_state != toMaxima)
-    {
-      if(GetValue() != wxEmptyString)
-      {
-        Newline();Newline();
-      }
-      SetInsertionPointEnd();
-      BeginTextColour(wxColour(0,0,0));
-      WriteText(_("SENT TO MAXIMA:"));
-      Newline();Newline();
-      EndTextColour();
-      m_state = toMaxima;
-    }
-    else
-    {
-      SetInsertionPointEnd();
-      WriteText("\n");
-    }
-    
-    SetInsertionPointEnd();
-    BeginTextColour(wxColour(128,0,0));
-    WriteText(m_toMaxima);
-    EndTextColour();
-    m_toMaxima = wxEmptyString;
+    m_bytes -= LineBytes(m_lines.front());
+    m_lines.pop_front();
+    m_firstLine++;
+    while(!m_shownLines.empty() && (m_shownLines.front() < m_firstLine))
+      m_shownLines.pop_front();
   }
+}
+
+size_t XmlInspector::LineBytes(const Line &line)
+{
+  return sizeof(Line) + line.text.Length() * sizeof(wxChar);
+}
+
+wxString XmlInspector::TagName(const wxString &text)
+{
+  if(!text.StartsWith(wxT("<")))
+    return {};
+  auto it = text.begin() + 1;
+  if((it != text.end()) && (*it == wxT('/')))
+    ++it;
+  auto const start = it;
+  while((it != text.end()) && (*it != wxT(' ')) && (*it != wxT('>')) && (*it != wxT('/')))
+    ++it;
+  return wxString(start, it);
+}
+
+bool XmlInspector::Matches(const Line &line) const
+{
+  // Headlines only make sense if the whole communication is shown
+  if(line.state == clear)
+    return (m_stateFilter == clear) && m_tagFilter.empty();
+  if((m_stateFilter != clear) && (line.state != m_stateFilter))
+    return false;
+  if(m_tagFilter.empty())
+    return true;
+  return std::find(m_tagFilter.begin(), m_tagFilter.end(), TagName(line.text)) != m_tagFilter.end();
+}
 
-  // Display all data from Maxima
-  if(m_fromMaxima != wxEmptyString)
+void XmlInspector::OnFilterChange(wxCommandEvent &WXUNUSED(event))
+{
+  switch(m_direction->GetSelection())
   {
-    if(m_state != fromMaxima)
-    {
-      if(GetValue() != wxEmptyString)
-      {
-        Newline();Newline();
-      }
-      SetInsertionPointEnd();
-      BeginTextColour(wxColour(0,0,0));
-      WriteText(_("MAXIMA RESPONSE:"));
-      Newline();Newline();    
-      EndTextColour();
-      m_state = fromMaxima;
-    }
-    m_fromMaxima.Replace(wxT("$FUNCTION:"), wxT("\n$FUNCTION:"));
+  case 1:
+    m_stateFilter = fromMaxima;
+    break;
+  case 2:
+    m_stateFilter = toMaxima;
+    break;
+  default:
+    m_stateFilter = clear;
+  }
+  m_tagFilter.clear();
+  for(auto tag : wxSplit(m_tags->GetValue(), wxT(' ')))
+  {
+    tag.Replace(wxT("<"), wxEmptyString);
+    tag.Replace(wxT("/"), wxEmptyString);
+    tag.Replace(wxT(">"), wxEmptyString);
+    if(!tag.IsEmpty())
+      m_tagFilter.push_back(tag);
+  }
 
-    // Indent the XML
-    wxString textWithIndention;
-    long length = 0;
-    for (wxString::const_iterator it = m_fromMaxima.begin(); it!=m_fromMaxima.end(); ++it)
-    {
-      length++;
-      // Assume that all tags add indentation
-      if (*it == wxT('>'))
-        m_indentLevel++;
-      
-      // A closing tag needs to remove the indentation of the opening tag 
-      // plus the indentation of the closing tag
-      if ((m_lastChar == wxT('<')) && (*it == wxT('/')))
-        m_indentLevel -= 2;
-    
-      // Self-closing Tags remove their own indentation
-      if ((m_lastChar == wxT('/')) && (*it == wxT('>')))
-        m_indentLevel -= 1;
-    
-      // Add a linebreak and indent if we are at the space between 2 tags
-      if ((m_lastChar == wxT('>')) && (*it == wxT('<')))
-        textWithIndention += wxT ("\n") + IndentString(m_indentLevel);
-
-      textWithIndention += *it;
-      m_lastChar = *it;
-    }
-    SetInsertionPointEnd();
-    BeginTextColour(wxColour(0,128,0));
-    WriteText(textWithIndention);
-    EndTextColour();
-    m_fromMaxima = wxEmptyString;
-
-    // Adding many chars to the XML inspector is slow => Warn our users if we do so.
-    if(length > 100000)
-      wxLogMessage(wxString::Format(_("Added much text (%li chars) to the XML inspector."), length));
+  m_shownLines.clear();
+  for(size_t i = 0; i < m_lines.size(); i++)
+    if(Matches(m_lines[i]))
+      m_shownLines.push_back(m_firstLine + i);
+
+  wxWindowUpdateLocker speedUp(m_list);
+  m_updateNeeded = true;
+  UpdateContents();
+}
+
+void XmlInspector::OnKeyDown(wxKeyEvent &event)
+{
+  if((event.GetKeyCode() == 'C') && (event.GetModifiers() == wxMOD_CMD))
+    CopySelection();
+  else
+    event.Skip();
+}
+
+void XmlInspector::OnMouseRightDown(wxMouseEvent &WXUNUSED(event))
+{
+  wxMenu popupMenu;
+  popupMenu.Append(wxID_COPY, _("Copy"));
+  popupMenu.Enable(wxID_COPY, m_list->GetSelectedItemCount() > 0);
+  PopupMenu(&popupMenu);
+}
+
+void XmlInspector::OnMenu(wxCommandEvent &event)
+{
+  if(event.GetId() == wxID_COPY)
+    CopySelection();
+}
+
+void XmlInspector::CopySelection() const
+{
+  wxString text;
+  long item = -1;
+  while((item = m_list->GetNextItem(item, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)) >= 0)
+  {
+    if(item >= ShownLineCount())
+      break;
+    text << GetShownLine(item).text << wxT("\n");
+  }
+  if(text.IsEmpty())
+    return;
+  if(wxTheClipboard->Open())
+  {
+    wxTheClipboard->SetData(new wxTextDataObject(text));
+    wxTheClipboard->Close();
   }
 }
 
-wxString XmlInspector::IndentString(int level)
+long XmlInspector::ShownLineCount() const
+{
+  long count = m_shownLines.size();
+  // The line that is still being received is shown, too.
+  if(!m_currentLine.text.IsEmpty() && Matches(m_currentLine))
+    count++;
+  return count;
+}
+
+const XmlInspector::Line &XmlInspector::GetShownLine(long item) const
 {
-  wxString result;
-  for (int i = 0; i <= level; i++)
-    result += wxT(" ");
-  return result;
+  if(size_t(item) < m_shownLines.size())
+    return m_lines[m_shownLines[item] - m_firstLine];
+  return m_currentLine;
 }
 
-void XmlInspector::Add_ToMaxima(wxString text)
+void XmlInspector::Add_ToMaxima(const wxString &text)
 {
-  if(m_toMaxima != wxEmptyString)
+  if(text.IsEmpty())
+    return;
+  if(m_state == toMaxima)
+  {
+    FinishLine();
+    m_currentLine.text = wxT("\u2015");
+    FinishLine();
+  }
+  StartSection(toMaxima);
+  for (auto const &ch : text)
   {
-    m_toMaxima += wxT("\n\u2015\n");
-    if(m_fromMaxima != wxEmptyString)
-      m_fromMaxima += wxT("\n\u2015\n");
+    if(ch == wxT('\n'))
+      FinishLine();
+    else
+      m_currentLine.text += ch;
   }
-  m_toMaxima += text;
   m_updateNeeded = true;
 }
 
-void XmlInspector::Add_FromMaxima(wxString text)
+void XmlInspector::Add_FromMaxima(const wxString &text)
 {
-  m_fromMaxima += text;
+  if(text.IsEmpty())
+    return;
+  StartSection(fromMaxima);
+  for (auto const &ch : text)
+  {
+    // Assume that all tags add indentation
+    if (ch == wxT('>'))
+      m_indentLevel++;
+
+    // A closing tag needs to remove the indentation of the opening tag
+    // plus the indentation of the closing tag
+    if ((m_lastChar == wxT('<')) && (ch == wxT('/')))
+      m_indentLevel -= 2;
+
+    // Self-closing Tags remove their own indentation
+    if ((m_lastChar == wxT('/')) && (ch == wxT('>')))
+      m_indentLevel -= 1;
+
+    m_lastChar = ch;
+
+    // Start a new line at the space between 2 tags and at line breaks
+    if ((ch == wxT('\n')) ||
+        ((ch == wxT('<')) && m_currentLine.text.EndsWith(wxT(">"))))
+      FinishLine();
+    if (ch == wxT('\n'))
+      continue;
+
+    m_currentLine.text += ch;
+    // Lisp functions maxima has sent each start a line, too
+    if ((ch == wxT(':')) && m_currentLine.text.EndsWith(wxT("$FUNCTION:")) &&
+        (m_currentLine.text.Length() > 10))
+    {
+      m_currentLine.text.Truncate(m_currentLine.text.Length() - 10);
+      FinishLine();
+      m_currentLine.text = wxT("$FUNCTION:");
+    }
+
+    // Even a line that doesn't end must not exceed the memory we may use
+    if (LineBytes(m_currentLine) > size_t(m_maxBytes))
+      FinishLine();
+  }
   m_updateNeeded = true;
 }
+
+wxString XmlInspector::m_maxBytesKey(wxT("xmlInspector/maxBytes"));
@@ -21,22 +21,30 @@
 
 /*! \file
 
-  This file contains the definition of the class XmlInspector that handles the 
-  table of contents pane.
+  This file contains the definition of the class XmlInspector that displays
+  the communication between maxima and wxMaxima.
  */
 #include "precomp.h"
 #include <wx/wx.h>
-#include <wx/richtext/richtextctrl.h>
+#include <wx/listctrl.h>
+#include <cstdint>
+#include <deque>
 #include <vector>
 
 #ifndef XMLINSPECTOR_H
 #define XMLINSPECTOR_H
 
 /*! This class generates a pane displaying the communication between maxima and wxMaxima.
-  
-  The display of this data is only actually updated on calling XmlInspector::Update().
+
+  The communication is split into lines as soon as it arrives. The lines are
+  kept in a ring buffer that forgets the oldest lines once they use more than
+  a configurable number of bytes, which allows to keep the inspector open
+  during long sessions. A virtual list control indents and colours only the
+  lines that actually are on the screen.
+
+  The display of this data is only actually updated on calling XmlInspector::UpdateContents().
  */
-class XmlInspector : public wxRichTextCtrl
+class XmlInspector : public wxPanel
 {
 public:
   XmlInspector(wxWindow *parent, int id);
@@ -46,38 +54,107 @@ public:
   ~XmlInspector();
 
   //! Remove all text from the editor.
-  virtual void Clear();
+  void Clear();
 
   //! Add some text we sent to maxima.
-  void Add_ToMaxima(wxString text);
+  void Add_ToMaxima(const wxString &text);
   //! Add some text we have received from maxima.
-  void Add_FromMaxima(wxString text);
+  void Add_FromMaxima(const wxString &text);
   //! Actually draw the updates
   void UpdateContents();
   //! Do we need to update the XmlInspector's display?
   bool UpdateNeeded(){return m_updateNeeded;}
 private:
-  bool m_updateNeeded;
-  wxString m_fromMaxima;
-  wxString m_toMaxima;
-  bool m_clear;
   enum xmlInspectorIDs
   {
     XmlInspector_ctrl_id = 4,
-    XmlInspector_regex_id
+    XmlInspector_direction_id,
+    XmlInspector_tags_id
   };
-  enum monitorState
+  //! Which part of the communication a line belongs to
+  enum monitorState : int8_t
   {
     clear,
     fromMaxima,
     toMaxima
   };
-  monitorState m_state;
+  //! One line of the communication. Lines in the "clear" state are headlines.
+  struct Line
+  {
+    wxString text;
+    int indentLevel = 0;
+    monitorState state = clear;
+  };
+
+  //! A list control that only asks for the lines that are on the screen
+  class LineList : public wxListCtrl
+  {
+  public:
+    LineList(XmlInspector *inspector, wxWindowID id);
+  protected:
+    wxString OnGetItemText(long item, long column) const override;
+    wxListItemAttr *OnGetItemAttr(long item) const override;
+  private:
+    XmlInspector *const m_inspector;
+  };
+
+  //! Starts a new section with a headline, if the last line belonged to a different state
+  void StartSection(monitorState state);
+  //! Moves the line that currently is being received to the list of lines
+  void FinishLine();
+  //! Forgets the oldest lines until the lines use no more than m_maxBytes
+  void DropOldLines();
+  //! Does a line pass the filter the user has chosen?
+  bool Matches(const Line &line) const;
+  //! Re-reads the filter the user has chosen and re-determines which lines to show
+  void OnFilterChange(wxCommandEvent &event);
+  //! Copies the lines on Ctrl+C
+  void OnKeyDown(wxKeyEvent &event);
+  //! Offers to copy the selected lines
+  void OnMouseRightDown(wxMouseEvent &event);
+  void OnMenu(wxCommandEvent &event);
+  //! Puts the lines the user has selected on the clipboard
+  void CopySelection() const;
+  //! The number of lines that pass the filter
+  long ShownLineCount() const;
+  //! A line that passes the filter
+  const Line &GetShownLine(long item) const;
+  //! The name of the first tag of a line; empty if the line doesn't start with a tag.
+  static wxString TagName(const wxString &text);
+  //! The number of bytes a line occupies
+  static size_t LineBytes(const Line &line);
+
+  //! The lines that have been received, the oldest first.
+  std::deque<Line> m_lines;
+  //! The numbers of the lines that pass the filter. Line n is m_lines[n - m_firstLine].
+  std::deque<uint64_t> m_shownLines;
+  //! The number of the first line in m_lines
+  uint64_t m_firstLine = 0;
+  //! The line that currently is being received
+  Line m_currentLine;
+  //! The number of bytes m_lines use
+  size_t m_bytes = 0;
+  //! How many bytes of lines we keep
+  long m_maxBytes = 16 * 1024 * 1024;
+  //! The length of the longest line we have seen, including its indentation
+  size_t m_longestLine = 0;
+  //! The tags the user wants to see. Empty = all.
+  std::vector<wxString> m_tagFilter;
+  //! Which part of the communication the user wants to see. clear = all.
+  monitorState m_stateFilter = clear;
 
-  wxChar m_lastChar;
-  int m_indentLevel;
+  LineList *m_list;
+  wxChoice *m_direction;
+  wxTextCtrl *m_tags;
+  //! The colours of the lines, for each monitorState
+  wxListItemAttr m_attributes[3];
 
-  wxString IndentString(int level);
+  bool m_updateNeeded = true;
+  monitorState m_state = clear;
+  wxChar m_lastChar = wxT('\0');
+  int m_indentLevel = 0;
+  //! The config key telling how many bytes of communication to keep
+  static wxString m_maxBytesKey;
 };
 
 #endif // XMLINSPECTOR_H
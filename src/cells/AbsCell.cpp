@@ -107,13 +107,20 @@ void AbsCell::Draw(wxPoint point)
 
 wxString AbsCell::ToString() const
 {
-  if (IsBrokenIntoLines())
-    return wxEmptyString;
   wxString s;
-  s = wxT("abs(") + m_innerCell->ListToString() + wxT(")");
+  AppendString(s);
   return s;
 }
 
+void AbsCell::AppendString(wxString &out) const
+{
+  if (IsBrokenIntoLines())
+    return;
+  out += wxT("abs(");
+  m_innerCell->ListAppendString(out);
+  out += wxT(")");
+}
+
 wxString AbsCell::ToMatlab() const
 {
   if (IsBrokenIntoLines())
@@ -124,33 +131,64 @@ wxString AbsCell::ToMatlab() const
 }
 
 wxString AbsCell::ToTeX() const
+{
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void AbsCell::AppendTeX(wxString &out) const
 {
   if (IsBrokenIntoLines())
-    return wxEmptyString;
-  return wxT("\\left| ") + m_innerCell->ListToTeX() + wxT("\\right| ");
+    return;
+  out += wxT("\\left| ");
+  m_innerCell->ListAppendTeX(out);
+  out += wxT("\\right| ");
 }
 
 wxString AbsCell::ToMathML() const
 {
-  return wxT("<row><mo>|</mo>") +
-         m_innerCell->ListToMathML() +
-         wxT("<mo>|</mo></row>\n");
-//  return wxT("<apply><abs/><ci>") + m_innerCell->ListToMathML() + wxT("</ci></apply>");
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void AbsCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<row><mo>|</mo>");
+  m_innerCell->ListAppendMathML(out);
+  out += wxT("<mo>|</mo></row>\n");
 }
 
 wxString AbsCell::ToOMML() const
 {
-  return wxT("<m:d><m:dPr m:begChr=\"|\" m:endChr=\"|\"></m:dPr><m:e>") +
-         m_innerCell->ListToOMML() + wxT("</m:e></m:d>");
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void AbsCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:d><m:dPr m:begChr=\"|\" m:endChr=\"|\"></m:dPr><m:e>");
+  m_innerCell->ListAppendOMML(out);
+  out += wxT("</m:e></m:d>");
 }
 
 wxString AbsCell::ToXML() const
 {
-  wxString flags;
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void AbsCell::AppendXML(wxString &out) const
+{
+  out += wxT("<a");
   if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
-  
-  return wxT("<a") +flags + wxT(">") + m_innerCell->ListToXML() + wxT("</a>");
+    out += wxT(" breakline=\"true\"");
+  out += wxT(">");
+  m_innerCell->ListAppendXML(out);
+  out += wxT("</a>");
 }
 
 bool AbsCell::BreakUp()
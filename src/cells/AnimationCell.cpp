@@ -48,13 +48,13 @@
 #include <wx/mstream.h>
 #include <wx/wfstream.h>
 #include <wx/anidecod.h>
+#include <wx/gifdecod.h>
 
 // filesystem cannot be passed by const reference as we want to keep the
 // pointer to the file system alive in a background task
 // cppcheck-suppress performance symbolName=filesystem
 AnimationCell::AnimationCell(GroupCell *group, Configuration **config, std::shared_ptr <wxFileSystem> filesystem, int framerate) :
     ImgCellBase(group, config),
-    m_timer(m_cellPointers->GetWorksheet(), wxNewId()),
     m_fileSystem(filesystem),
     m_framerate(framerate),
     m_displayed(0),
@@ -67,7 +67,6 @@ AnimationCell::AnimationCell(GroupCell *group, Configuration **config, std::shar
 
 AnimationCell::AnimationCell(GroupCell *group, Configuration **config, int framerate) :
     ImgCellBase(group, config),
-    m_timer(m_cellPointers->GetWorksheet(), wxNewId()),
     m_framerate(framerate),
     m_displayed(0),
     m_imageBorderWidth(Scale_Px(1))
@@ -145,18 +144,12 @@ int AnimationCell::GetFrameRate() const
 
 void AnimationCell::ReloadTimer()
 {
-  if (!m_timer.IsRunning())
-  {
-    // Tell MathCtrl about our timer.
-    m_cellPointers->SetTimerIdForCell(this, m_timer.GetId());
-    m_timer.StartOnce(1000 / GetFrameRate());
-  }
+  m_cellPointers->ScheduleAnimation(this, 1000 / GetFrameRate());
 }
 
 void AnimationCell::StopTimer()
 {
-  m_timer.Stop();
-  m_cellPointers->RemoveTimerIdForCell(this);
+  m_cellPointers->UnscheduleAnimation(this);
 }
 
 void AnimationCell::AnimationRunning(bool run)
@@ -188,7 +181,24 @@ int AnimationCell::SetFrameRate(int Freq)
 
 void AnimationCell::LoadImages(wxMemoryBuffer imageData)
 {
-  wxImage images;
+#if wxUSE_GIF
+  // Loading frame i of a GIF decodes the frames before it, as well
+  // => decode the animation only once and convert its frames one by one.
+  {
+    wxMemoryInputStream istream(imageData.GetData(), imageData.GetDataLen());
+    wxGIFDecoder decoder;
+    if (decoder.CanRead(istream) && (decoder.LoadGIF(istream) == wxGIF_OK))
+    {
+      for (unsigned int i = 0; i < decoder.GetFrameCount(); i++)
+      {
+        wxImage image;
+        if (decoder.ConvertToImage(i, &image))
+          m_images.push_back(std::make_shared<Image>(m_configuration, wxBitmap(image)));
+      }
+      return;
+    }
+  }
+#endif
   wxMemoryInputStream istream(imageData.GetData(), imageData.GetDataLen());
   size_t count = wxImage::GetImageCount(istream);
 
@@ -203,15 +213,8 @@ void AnimationCell::LoadImages(wxMemoryBuffer imageData)
 
 void AnimationCell::LoadImages(wxString imageFile)
 {
-  wxImage images;
-  size_t count = wxImage::GetImageCount(imageFile);
-
-  for (size_t i = 0; i < count; i++)
-  {
-    wxImage image;
-    image.LoadFile(imageFile, wxBITMAP_TYPE_ANY, i);
-    m_images.push_back(std::make_shared<Image>(m_configuration, wxBitmap(image)));
-  }
+  // Read the file only once instead of once per frame
+  LoadImages(Image::ReadFile(*m_configuration, imageFile, false).data);
 }
 
 void AnimationCell::LoadImages(wxArrayString images, bool deleteRead)
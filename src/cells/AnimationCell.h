@@ -136,15 +136,16 @@ public:
    */
   int GetFrameRate() const;
 
-  /*! Reload the animation timer starting and instantiating and registering it if necessary.
+  /*! Asks the worksheet's animation timer for our next frame
 
-    If the timer is already running, the request to reload it is ignored.
+    If we already wait for our next frame, the request is ignored.
    */
   void ReloadTimer();
 
-  /*! Stops the timer
-    
-    Also deletes the timer as on MSW there aren't many timers available.
+  /*! Stops waiting for the next frame
+
+    All animations share the worksheet's animation timer, so no timer needs to
+    be deleted here.
    */
   void StopTimer();
 
@@ -172,8 +173,7 @@ public:
   }
 
 private:
-  CellPointers *const m_cellPointers = GetCellPointers(); // must come before m_timer (!)
-  wxTimer m_timer;
+  CellPointers *const m_cellPointers = GetCellPointers();
   std::vector<std::shared_ptr<Image>> m_images;
   std::shared_ptr<wxFileSystem> m_fileSystem;
 
@@ -89,12 +89,20 @@ void AtCell::Draw(wxPoint point)
 
 wxString AtCell::ToString() const
 {
-  wxString s = wxT("at(");
-  s += m_baseCell->ListToString();
-  s += wxT(",") + m_indexCell->ListToString() + wxT(")");
+  wxString s;
+  AppendString(s);
   return s;
 }
 
+void AtCell::AppendString(wxString &out) const
+{
+  out += wxT("at(");
+  m_baseCell->ListAppendString(out);
+  out += wxT(",");
+  m_indexCell->ListAppendString(out);
+  out += wxT(")");
+}
+
 wxString AtCell::ToMatlab() const
 {
   wxString s = wxT("at(");
@@ -105,31 +113,67 @@ wxString AtCell::ToMatlab() const
 
 wxString AtCell::ToTeX() const
 {
-  wxString s = wxT("\\left. ");
-  s += m_baseCell->ListToTeX();
-  s += wxT("\\right|_{") + m_indexCell->ListToTeX() + wxT("}");
-  return s;
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void AtCell::AppendTeX(wxString &out) const
+{
+  out += wxT("\\left. ");
+  m_baseCell->ListAppendTeX(out);
+  out += wxT("\\right|_{");
+  m_indexCell->ListAppendTeX(out);
+  out += wxT("}");
 }
 
 wxString AtCell::ToMathML() const
 {
-  return wxT("<msub>") + m_baseCell->ListToMathML() +
-         m_indexCell->ListToMathML() + wxT("</msub>\n");
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void AtCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<msub>");
+  m_baseCell->ListAppendMathML(out);
+  m_indexCell->ListAppendMathML(out);
+  out += wxT("</msub>\n");
 }
 
 wxString AtCell::ToOMML() const
 {
-  return wxT("<m:sSub><m:e>") + m_baseCell->ListToOMML() + wxT("</m:e><m:sub>") +
-         m_indexCell->ListToOMML() + wxT("</m:sub></m:sSub>\n");
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void AtCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:sSub><m:e>");
+  m_baseCell->ListAppendOMML(out);
+  out += wxT("</m:e><m:sub>");
+  m_indexCell->ListAppendOMML(out);
+  out += wxT("</m:sub></m:sSub>\n");
 }
 
 
 wxString AtCell::ToXML() const
 {
-  wxString flags;
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void AtCell::AppendXML(wxString &out) const
+{
+  out += wxT("<at");
   if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
-  
-  return wxT("<at") + flags + wxT("><r>") + m_baseCell->ListToXML() + wxT("</r><r>") +
-         m_indexCell->ListToXML() + wxT("</r></at>");
+    out += wxT(" breakline=\"true\"");
+  out += wxT("><r>");
+  m_baseCell->ListAppendXML(out);
+  out += wxT("</r><r>");
+  m_indexCell->ListAppendXML(out);
+  out += wxT("</r></at>");
 }
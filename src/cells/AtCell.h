@@ -43,11 +43,16 @@ public:
   void Draw(wxPoint point) override;
 
   wxString ToMathML() const override;
+  void AppendMathML(wxString &out) const override;
   wxString ToMatlab() const override;
   wxString ToOMML() const override;
+  void AppendOMML(wxString &out) const override;
   wxString ToString() const override;
+  void AppendString(wxString &out) const override;
   wxString ToTeX() const override;
+  void AppendTeX(wxString &out) const override;
   wxString ToXML() const override;
+  void AppendXML(wxString &out) const override;
 
 private:
   // The pointers below point to inner cells and must be kept contiguous.
@@ -134,7 +134,9 @@ void Cell::SetType(CellType type)
       break;
   }
   ResetSize();
-  if ((m_group) && (m_group != this))
+  // A cell that isn't part of a list yet (which is the case for most cells
+  // whose type is set) cannot have changed the size of its GroupCell.
+  if ((m_group) && (m_group != this) && (m_previous || m_next))
     GetGroup()->ResetSize();
 }
 
@@ -219,6 +221,9 @@ GroupCell *Cell::GetGroup() const
 
 bool Cell::NeedsRecalculation(AFontSize fontSize) const
 {
+  // Only asked if a setting the cell depends on has changed?
+  if (fontSize.IsNull())
+    return false;
   if (!HasValidSize())
     return true;
   if (GetType() == MC_TYPE_GROUP)
@@ -226,6 +231,19 @@ bool Cell::NeedsRecalculation(AFontSize fontSize) const
   return !EqualToWithin(Scale_Px(fontSize), m_fontSize_Scaled, 0.1f);
 }
 
+bool Cell::ListNeedsRecalculationDeep(AFontSize fontSize) const
+{
+  for (const Cell &tmp : OnList(this))
+  {
+    if (tmp.NeedsRecalculation(fontSize))
+      return true;
+    for (const Cell &cell : OnInner(&tmp))
+      if (cell.ListNeedsRecalculationDeep(AFontSize()))
+        return true;
+  }
+  return false;
+}
+
 int Cell::GetCenterList() const
 {
   if (m_maxCenter.IsInvalid())
@@ -545,34 +563,26 @@ wxString Cell::VariablesAndFunctionsList() const
 wxString Cell::ListToString() const
 {
   wxString retval;
+  ListAppendString(retval);
+  return retval;
+}
+
+void Cell::ListAppendString(wxString &out) const
+{
+  size_t const start = out.Length();
   bool firstline = true;
 
   for (const Cell &tmp : OnList(this))
   {
     if ((!firstline) && (tmp.m_forceBreakLine))
     {
-      if(!retval.EndsWith(wxT('\n')))
-        retval += wxT("\n");
-      // if(
-      //    (tmp.GetStyle() != TS_LABEL) &&
-      //    (tmp.GetStyle() != TS_USERLABEL) &&
-      //    (tmp.GetStyle() != TS_MAIN_PROMPT) &&
-      //    (tmp.GetStyle() != TS_OTHER_PROMPT))
-      //   retval += wxT("\t");
+      if((out.Length() == start) || (!out.EndsWith(wxT('\n'))))
+        out += wxT("\n");
     }
-    // if(firstline)
-    // {
-    //   if((tmp.GetStyle() != TS_LABEL) &&
-    //      (tmp.GetStyle() != TS_USERLABEL) &&
-    //      (tmp.GetStyle() != TS_MAIN_PROMPT) &&
-    //      (tmp.GetStyle() != TS_OTHER_PROMPT))
-    //     retval += wxT("\t");
-    // }
-    retval += tmp.ToString();
+    tmp.AppendString(out);
 
     firstline = false;
   }
-  return retval;
 }
 
 wxString Cell::ToMatlab() const
@@ -621,14 +631,57 @@ wxString Cell::ToTeX() const
 wxString Cell::ListToTeX() const
 {
   wxString retval;
+  ListAppendTeX(retval);
+  return retval;
+}
+
+void Cell::ListAppendTeX(wxString &out) const
+{
+  size_t const start = out.Length();
   for (const Cell &tmp : OnList(this))
   {
-    if (((!retval.IsEmpty()) && (tmp.m_textStyle == TS_LABEL)) ||
+    if (((out.Length() > start) && (tmp.m_textStyle == TS_LABEL)) ||
         (tmp.BreakLineHere()))
-      retval += wxT("\\]\\[");
-    retval += tmp.ToTeX();
+      out += wxT("\\]\\[");
+    tmp.AppendTeX(out);
+  }
+}
+
+void Cell::AppendTeXInDelimiters(wxString &out, const Cell *list,
+                                 const wxString &open, const wxString &close)
+{
+  // We only know if we need \left after we have seen the contents => we
+  // write it in front of them and replace it by the plain delimiter if it
+  // isn't needed. That only happens if the contents are plain letters and
+  // digits, which are cheap to move, unlike inserting in front of nested
+  // contents.
+  size_t const openStart = out.Length();
+  out += wxT("\\left");
+  out += open;
+  out += wxT(" ");
+  size_t const innerStart = out.Length();
+  if (list)
+    list->ListAppendTeX(out);
+
+  bool needsLeftRight = false;
+  for (size_t i = innerStart; i < out.Length(); i++)
+    if (!wxIsalnum(out[i]))
+    {
+      needsLeftRight = true;
+      break;
+    }
+
+  if (needsLeftRight)
+  {
+    out += wxT("\\right");
+    out += close;
+    out += wxT(" ");
+  }
+  else
+  {
+    out.replace(openStart, innerStart - openStart, open);
+    out += close;
   }
-  return retval;
 }
 
 wxString Cell::ToXML() const
@@ -643,8 +696,14 @@ wxString Cell::ToMathML() const
 
 wxString Cell::ListToMathML(bool startofline) const
 {
-  bool highlight = false;
   wxString retval;
+  ListAppendMathML(retval, startofline);
+  return retval;
+}
+
+void Cell::ListAppendMathML(wxString &out, bool startofline) const
+{
+  bool highlight = false;
 
   // If the region to export contains linebreaks or labels we put it into a table.
   bool needsTable = false;
@@ -661,43 +720,45 @@ wxString Cell::ListToMathML(bool startofline) const
   // group them into a single object.
   bool const multiCell = m_next.get();
 
+  if (needsTable)
+    out += wxT("<mtable>\n<mlabeledtr columnalign=\"left\"><mtd>");
+  else if (multiCell)
+    out += wxT("<mrow>");
+
   // Export all cells
   for (const Cell &tmp : OnList(this))
   {
     // Do we need to end a highlighting region?
     if ((!tmp.m_highlight) && (highlight))
-      retval += wxT("</mrow>");
+      out += wxT("</mrow>");
 
     // Handle linebreaks
     if ((&tmp != this) && (tmp.HasHardLineBreak()))
-      retval += wxT("</mtd></mlabeledtr>\n<mlabeledtr columnalign=\"left\"><mtd>");
+      out += wxT("</mtd></mlabeledtr>\n<mlabeledtr columnalign=\"left\"><mtd>");
 
     // If a linebreak isn't followed by a label we need to introduce an empty one.
     if ((((tmp.HasHardLineBreak()) || (startofline && (this == &tmp))) &&
          ((tmp.GetStyle() != TS_LABEL) && (tmp.GetStyle() != TS_USERLABEL))) && (needsTable))
-      retval += wxT("<mtext></mtext></mtd><mtd>");
+      out += wxT("<mtext></mtext></mtd><mtd>");
 
     // Do we need to start a highlighting region?
     if ((tmp.m_highlight) && (!highlight))
-      retval += wxT("<mrow mathcolor=\"red\">");
+      out += wxT("<mrow mathcolor=\"red\">");
     highlight = tmp.m_highlight;
 
-    retval += tmp.ToMathML();
+    tmp.AppendMathML(out);
   }
 
   // If the region we converted to MathML ended within a highlighted region
   // we need to close this region now.
   if (highlight)
-    retval += wxT("</mrow>");
-
-  // If we grouped multiple cells as a single object we need to cose this group now
-  if ((multiCell) && (!needsTable))
-    retval = wxT("<mrow>") + retval + wxT("</mrow>\n");
+    out += wxT("</mrow>");
 
-  // If we put the region we exported into a table we need to end this table now
+  // Close the table or the group we have put the region into
   if (needsTable)
-    retval = wxT("<mtable>\n<mlabeledtr columnalign=\"left\"><mtd>") + retval + wxT("</mtd></mlabeledtr>\n</mtable>");
-  return retval;
+    out += wxT("</mtd></mlabeledtr>\n</mtable>");
+  else if (multiCell)
+    out += wxT("</mrow>\n");
 }
 
 wxString Cell::OMML2RTF(wxXmlNode *node)
@@ -818,67 +879,95 @@ wxString Cell::ToOMML() const { return {}; }
 
 wxString Cell::ListToOMML(bool WXUNUSED(startofline)) const
 {
-  bool multiCell = (m_next != NULL);
-
   wxString retval;
+  ListAppendOMML(retval);
+  return retval;
+}
 
-  // If the region to export contains linebreaks or labels we put it into a table.
-  // Export all cells
+void Cell::ListAppendOMML(wxString &out) const
+{
+  bool const multiCell = (m_next != NULL);
+  size_t const start = out.Length();
 
+  if (multiCell)
+    out += wxT("<m:r>");
+  size_t const contentsStart = out.Length();
+
+  // Export all cells
   for (const Cell &tmp : OnList(this))
   {
-    wxString token = tmp.ToOMML();
+    size_t const tokenStart = out.Length();
+    tmp.AppendOMML(out);
 
     // End exporting the equation if we reached the end of the equation.
-    if (token.empty())
+    if (out.Length() == tokenStart)
       break;
 
-    retval += token;
-
     // Hard linebreaks aren't supported by OMML and therefore need a new equation object
     if (tmp.HasHardLineBreak())
       break;
   }
 
-  if (multiCell && !retval.empty())
-    return wxT("<m:r>") + retval + wxT("</m:r>");
-  else
-    return retval;
+  if (multiCell)
+  {
+    if (out.Length() == contentsStart)
+      out.Truncate(start);
+    else
+      out += wxT("</m:r>");
+  }
 }
 
 wxString Cell::ListToRTF(bool startofline) const
 {
   wxString retval;
+  ListAppendRTF(retval, startofline);
+  return retval;
+}
 
+void Cell::ListAppendRTF(wxString &out, bool startofline) const
+{
+  bool const label = (GetStyle() == TS_LABEL) || ((GetStyle() == TS_USERLABEL));
   for (const Cell *tmp = this; tmp != NULL; )
   {
-    wxString rtf = tmp->ToRTF();
-    if (!rtf.empty())
+    // Write the paragraph start up front and remove it again if the cell
+    // turns out to have no RTF representation.
+    size_t const itemStart = out.Length();
+    if (label)
+      out += wxT("\\par}\n{\\pard\\s22\\li1105\\lin1105\\fi-1105\\f0\\fs24 ");
+    else if (startofline)
+      out += wxT("\\par}\n{\\pard\\s21\\li1105\\lin1105\\f0\\fs24 ");
+    size_t const rtfStart = out.Length();
+    tmp->AppendRTF(out);
+    if (out.Length() > rtfStart)
     {
-      if ((GetStyle() == TS_LABEL) || ((GetStyle() == TS_USERLABEL)))
+      if (label)
       {
-        retval += wxT("\\par}\n{\\pard\\s22\\li1105\\lin1105\\fi-1105\\f0\\fs24 ") + rtf + wxT("\\tab");
+        out += wxT("\\tab");
         startofline = false;
       }
       else
       {
         if (startofline)
-          retval += wxT("\\par}\n{\\pard\\s21\\li1105\\lin1105\\f0\\fs24 ") + rtf + wxT("\\n");
+          out += wxT("\\n");
+        else
+          out.Truncate(itemStart);
         startofline = true;
       }
       tmp = tmp->GetNext();
     }
     else
     {
-      if (!tmp->ListToOMML().empty())
+      out.Truncate(itemStart);
+      wxString const omml = tmp->ListToOMML();
+      if (!omml.empty())
       {
         // Math!
 
         // set the style for this line.
         if (startofline)
-          retval += wxT("\\pard\\s21\\li1105\\lin1105\\f0\\fs24 ");
+          out += wxT("\\pard\\s21\\li1105\\lin1105\\f0\\fs24 ");
 
-        retval += OMML2RTF(tmp->ListToOMML());
+        out += OMML2RTF(omml);
 
         startofline = true;
 
@@ -905,7 +994,6 @@ wxString Cell::ListToRTF(bool startofline) const
       }
     }
   }
-  return retval;
 }
 
 void Cell::SelectPointText(wxPoint WXUNUSED(point)) {}
@@ -916,32 +1004,36 @@ void Cell::PasteFromClipboard(bool WXUNUSED(primary)) {}
 
 wxString Cell::ListToXML() const
 {
-  bool highlight = false;
   wxString retval;
+  ListAppendXML(retval);
+  return retval;
+}
+
+void Cell::ListAppendXML(wxString &out) const
+{
+  bool highlight = false;
 
   for (const Cell &tmp : OnList(this))
   {
     if ((tmp.GetHighlight()) && (!highlight))
     {
-      retval += wxT("<hl>\n");
+      out += wxT("<hl>\n");
       highlight = true;
     }
 
     if ((!tmp.GetHighlight()) && (highlight))
     {
-      retval += wxT("</hl>\n");
+      out += wxT("</hl>\n");
       highlight = false;
     }
 
-    retval += tmp.ToXML();
+    tmp.AppendXML(out);
   }
 
   if (highlight)
   {
-    retval += wxT("</hl>\n");
+    out += wxT("</hl>\n");
   }
-
-  return retval;
 }
 
 /***
@@ -418,8 +418,32 @@ public:
    */
   virtual wxRect GetRect(bool all = false) const;
 
-  //! True, if something that affects the cell size has changed.
+  /*! True, if something that affects the cell size has changed.
+
+    \param fontSize The font size the cell is to be drawn at. A null font size
+    asks only if a setting the cell depends on (like the number of displayed
+    digits) has changed.
+   */
   virtual bool NeedsRecalculation(AFontSize fontSize) const;
+
+  /*! True, if this cell's size is partly estimated
+
+    Cells that are expensive to lay out may only measure the parts of them that
+    are near the visible region and estimate the size of the rest.
+   */
+  virtual bool HasEstimatedSize() const { return false; }
+  //! True, if a part of this cell whose size has only been estimated lies in rect
+  virtual bool HasEstimatedSizeIn(const wxRect &rect) const
+  { return HasEstimatedSize() && GetRect().Intersects(rect); }
+
+  /*! True, if this list of cells or any cell nested in it needs to be recalculated
+
+    The nested cells are laid out at font sizes their parents choose, and some
+    of them are only laid out if their parent is broken into lines => they are
+    only checked for changes of the settings they depend on. Everything else
+    that invalidates them invalidates the cells in this list, too.
+   */
+  bool ListNeedsRecalculationDeep(AFontSize fontSize) const;
   
   virtual wxString GetDiffPart() const;
 
@@ -533,6 +557,8 @@ public:
 
   //! Returns the list's representation as a string.
   virtual wxString ListToString() const;
+  //! Append the list's representation as a string to out
+  void ListAppendString(wxString &out) const;
 
   /*! Returns all variable and function names used inside this list of cells.
   
@@ -543,20 +569,40 @@ public:
   virtual wxString ListToMatlab() const;
   //! Convert this list to its LaTeX representation
   virtual wxString ListToTeX() const;
+  //! Append the LaTeX representation of this list to out
+  void ListAppendTeX(wxString &out) const;
+  /*! Append the LaTeX representation of a list enclosed in delimiters to out
+
+    Uses \\left and \\right only if the list contains anything that might be
+    higher than a line of letters and digits.
+   */
+  static void AppendTeXInDelimiters(wxString &out, const Cell *list,
+                                    const wxString &open, const wxString &close);
   //! Convert this list to a representation fit for saving in a .wxmx file
   virtual wxString ListToXML() const;
+  //! Append the representation of this list fit for saving in a .wxmx file to out
+  void ListAppendXML(wxString &out) const;
 
   //! Convert this list to a MathML representation
   virtual wxString ListToMathML(bool startofline = false) const;
+  //! Append the MathML representation of this list to out
+  void ListAppendMathML(wxString &out, bool startofline = false) const;
 
   //! Convert this list to an OMML representation
   virtual wxString ListToOMML(bool startofline = false) const;
+  //! Append the OMML representation of this list to out
+  void ListAppendOMML(wxString &out) const;
 
   //! Convert this list to an RTF representation
   virtual wxString ListToRTF(bool startofline = false) const;
+  //! Append the RTF representation of this list to out
+  void ListAppendRTF(wxString &out, bool startofline = false) const;
 
   //! Returns the cell's representation as a string.
   virtual wxString ToString() const;
+  //! Append the cell's representation as a string to out. See AppendTeX().
+  virtual void AppendString(wxString &out) const
+  { out += ToString(); }
 
   /*! Returns the cell's representation as RTF.
 
@@ -565,6 +611,9 @@ public:
    */
   virtual wxString ToRTF() const
   { return wxEmptyString; }
+  //! Append the cell's representation as RTF to out. See AppendTeX().
+  virtual void AppendRTF(wxString &out) const
+  { out += ToRTF(); }
 
   //! Converts an OMML tag to the corresponding RTF snippet
   static wxString OMML2RTF(wxXmlNode *node);
@@ -582,14 +631,32 @@ public:
     though.
    */
   virtual wxString ToOMML() const;
+  //! Append the cell's representation as OMML to out. See AppendTeX().
+  virtual void AppendOMML(wxString &out) const
+  { out += ToOMML(); }
   //! Convert this cell to its Matlab representation
   virtual wxString ToMatlab() const;
   //! Convert this cell to its LaTeX representation
   virtual wxString ToTeX() const;
+  /*! Append the LaTeX representation of this cell to out
+
+    Cells that contain other cells override this function, as appending to a
+    single string means that the representation of a deeply nested cell isn't
+    copied once for every level of nesting. Their ToTeX() is a wrapper around
+    this function.
+   */
+  virtual void AppendTeX(wxString &out) const
+  { out += ToTeX(); }
   //! Convert this cell to a representation fit for saving in a .wxmx file
   virtual wxString ToXML() const;
-  //! Convert this cell to a representation fit for saving in a .wxmx file
+  //! Append the representation of this cell fit for saving in a .wxmx file to out. See AppendTeX().
+  virtual void AppendXML(wxString &out) const
+  { out += ToXML(); }
+  //! Convert this cell to its MathML representation
   virtual wxString ToMathML() const;
+  //! Append the MathML representation of this cell to out. See AppendTeX().
+  virtual void AppendMathML(wxString &out) const
+  { out += ToMathML(); }
 
   //! Escape a string for RTF
   static wxString RTFescape(wxString, bool MarkDown = false);
@@ -104,8 +104,16 @@ void CellList::AppendCell(Cell *c, std::unique_ptr<Cell> &&head)
     // above would be inappropriate.
     c->GetGroup()->ResetData();
 
+  AppendAfterLast(c->last(), std::move(head));
+}
+
+void CellList::AppendAfterLast(Cell *last, std::unique_ptr<Cell> &&head)
+{
+  wxASSERT(!last->m_next);
+  if (!head)
+    return;
+
   auto *const next = head.get();
-  auto *const last = c->last();
 
   // We want to append to the draw list as well
   // Get the end of the draw list
@@ -173,6 +173,16 @@ public:
   static void AppendCell(const std::unique_ptr<T> &cell, std::unique_ptr<Cell> &&tail)
   { AppendCell(cell.get(), std::move(tail)); }
 
+  /*! Appends a cell to a cell that is known to be the last one of its list.
+
+    Unlike AppendCell() this neither needs to search for the end of the list nor does it
+    reset the data of the GroupCell the list belongs to.
+
+    \param last is the last cell of the list to append to.
+    \param tail is the cell to append. It can be a list, a single cell, or null.
+  */
+  static void AppendAfterLast(Cell *last, std::unique_ptr<Cell> &&tail);
+
   struct SplicedIn
   {
     //! The last cell in the in the list of spliced-in cells - copied from
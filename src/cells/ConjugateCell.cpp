@@ -106,11 +106,19 @@ void ConjugateCell::Draw(wxPoint point)
 }
 
 wxString ConjugateCell::ToString() const
+{
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void ConjugateCell::AppendString(wxString &out) const
 {
   if (IsBrokenIntoLines())
-    return wxEmptyString;
-  else
-    return wxT("conjugate(") + m_innerCell->ListToString() + wxT(")");
+    return;
+  out += wxT("conjugate(");
+  m_innerCell->ListAppendString(out);
+  out += wxT(")");
 }
 
 wxString ConjugateCell::ToMatlab() const
@@ -122,33 +130,64 @@ wxString ConjugateCell::ToMatlab() const
 }
 
 wxString ConjugateCell::ToTeX() const
+{
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void ConjugateCell::AppendTeX(wxString &out) const
 {
   if (IsBrokenIntoLines())
-    return wxEmptyString;
-  else
-    return wxT("\\overline{") + m_innerCell->ListToTeX() + wxT("}");
+    return;
+  out += wxT("\\overline{");
+  m_innerCell->ListAppendTeX(out);
+  out += wxT("}");
 }
 
 wxString ConjugateCell::ToMathML() const
 {
-//  return wxT("<apply><conjugate/><ci>") + m_innerCell->ListToMathML() + wxT("</ci></apply>");
-  return wxT("<mover accent=\"true\">") + m_innerCell->ListToMathML() +
-         wxT("<mo>&#xaf;</mo></mover>\n");
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void ConjugateCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<mover accent=\"true\">");
+  m_innerCell->ListAppendMathML(out);
+  out += wxT("<mo>&#xaf;</mo></mover>\n");
 }
 
 wxString ConjugateCell::ToOMML() const
 {
-  return wxT("<m:bar><m:barPr><m:pos m:val=\"top\"/> </m:barPr><m:e>") +
-         m_innerCell->ListToOMML() + wxT("</m:e></m:bar>");
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void ConjugateCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:bar><m:barPr><m:pos m:val=\"top\"/> </m:barPr><m:e>");
+  m_innerCell->ListAppendOMML(out);
+  out += wxT("</m:e></m:bar>");
 }
 
 wxString ConjugateCell::ToXML() const
 {
-  wxString flags;
-  if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
 
-  return wxT("<cj") + flags + wxT(">") + m_innerCell->ListToXML() + wxT("</cj>");
+void ConjugateCell::AppendXML(wxString &out) const
+{
+  out += wxT("<cj");
+  if (HasHardLineBreak())
+    out += wxT(" breakline=\"true\"");
+  out += wxT(">");
+  m_innerCell->ListAppendXML(out);
+  out += wxT("</cj>");
 }
 
 bool ConjugateCell::BreakUp()
@@ -99,16 +99,22 @@ void DiffCell::Draw(wxPoint point)
 }
 
 wxString DiffCell::ToString() const
+{
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void DiffCell::AppendString(wxString &out) const
 {
   if (IsBrokenIntoLines())
-    return wxEmptyString;
+    return;
   Cell *tmp = m_baseCell->GetNext();
-  wxString s = wxT("'diff(");
+  out += wxT("'diff(");
   if (tmp != NULL)
-    s += tmp->ListToString();
-  s += m_diffCell->ListToString();
-  s += wxT(")");
-  return s;
+    tmp->ListAppendString(out);
+  m_diffCell->ListAppendString(out);
+  out += wxT(")");
 }
 
 wxString DiffCell::ToMatlab() const
@@ -126,51 +132,74 @@ wxString DiffCell::ToMatlab() const
 
 wxString DiffCell::ToTeX() const
 {
-  if (IsBrokenIntoLines())
-    return wxEmptyString;
-  wxString diff = m_diffCell->ListToTeX();
-  wxString function = m_baseCell->ListToTeX();
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
 
+void DiffCell::AppendTeX(wxString &out) const
+{
+  if (IsBrokenIntoLines())
+    return;
+  size_t const diffStart = out.Length();
+  m_diffCell->ListAppendTeX(out);
   if ((*m_configuration)->UsePartialForDiff())
+  {
+    // Only the short d/dx part is post-processed, not the function.
+    wxString diff = out.Mid(diffStart);
     diff.Replace(wxT("\\frac{d}{d"), wxT("\\frac{\\partial}{\\partial"));
-
-  wxString s = diff + function;
-  return s;
+    out.Truncate(diffStart);
+    out += diff;
+  }
+  m_baseCell->ListAppendTeX(out);
 }
 
 wxString DiffCell::ToMathML() const
 {
-  wxString retval;
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
 
-  retval = wxT("<mrow>") + m_diffCell->ListToMathML();
+void DiffCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<mrow>");
+  m_diffCell->ListAppendMathML(out);
   if (m_baseCell)
-    retval += m_baseCell->ListToMathML();
-  retval += wxT("</mrow>\n");
-  // retval = wxT("<apply><diff/><ci>") + m_diffCell->ListToMathML() + wxT("</ci>");
-  // if(m_baseCell)
-  //   retval += wxT("<ci>") + m_baseCell->ListToMathML() + wxT("</ci>") ;
-  // retval += wxT("</apply>");
-  return retval;
+    m_baseCell->ListAppendMathML(out);
+  out += wxT("</mrow>\n");
 }
 
 wxString DiffCell::ToOMML() const
 {
-  wxString retval;
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
 
-  retval = m_diffCell->ListToOMML();
+void DiffCell::AppendOMML(wxString &out) const
+{
+  m_diffCell->ListAppendOMML(out);
   if (m_baseCell)
-    retval += m_baseCell->ListToOMML();
-
-  return retval;
+    m_baseCell->ListAppendOMML(out);
 }
 
 wxString DiffCell::ToXML() const
 {
-  wxString flags;
-  if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
 
-  return wxT("<d") + flags + wxT(">") + m_diffCell->ListToXML() + m_baseCell->ListToXML() + _T("</d>");
+void DiffCell::AppendXML(wxString &out) const
+{
+  out += wxT("<d");
+  if (HasHardLineBreak())
+    out += wxT(" breakline=\"true\"");
+  out += wxT(">");
+  m_diffCell->ListAppendXML(out);
+  m_baseCell->ListAppendXML(out);
+  out += wxT("</d>");
 }
 
 bool DiffCell::BreakUp()
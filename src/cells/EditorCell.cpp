@@ -355,6 +355,7 @@ wxString EditorCell::ToRTF() const
     break;
   case MC_TYPE_INPUT:
   {
+    StyleTextIfNeeded();
     retval += wxT(" ");
     for (std::vector<StyledText>::const_iterator textSnippet = m_styledText.begin();
          textSnippet != m_styledText.end(); ++textSnippet)
@@ -628,7 +629,6 @@ void EditorCell::Recalculate(AFontSize fontsize)
     m_widths.clear();
     m_lastZoomFactor = configuration->GetZoomFactor();
   }
-  StyleText();
   wxDC *dc = configuration->GetDC();
   SetFont();
 
@@ -643,58 +643,104 @@ void EditorCell::Recalculate(AFontSize fontsize)
 
   m_numberOfLines = 1;
 
-  std::vector<StyledText>::const_iterator textSnippet;
-
-  for (    textSnippet = m_styledText.begin();
-    textSnippet != m_styledText.end();
-    ++textSnippet
-    )
+  // Tokenizing is the expensive part of the layout => cells that are far away
+  // from the screen are measured line by line using their unstyled text. They
+  // are styled once they are drawn or edited.
+  m_sizeIsEstimate = !IsActive() && !IsNearVisibleRegion();
+  if (m_sizeIsEstimate)
   {
-    if ((textSnippet->GetText().StartsWith(wxT('\n')) || (textSnippet->GetText().StartsWith(wxT('\r')))))
+    // The soft line breaks from the last time the text was styled are the
+    // best guess we have for where the lines will be broken.
+    m_textStyled = false;
+    wxStringTokenizer lines(m_text, wxT("\n\r"), wxTOKEN_RET_EMPTY_ALL);
+    bool firstLine = true;
+    while (lines.HasMoreTokens())
     {
-      m_numberOfLines++;
-      linewidth = textSnippet->GetIndentPixels();
+      wxString const line = lines.GetNextToken();
+      if (!firstLine)
+        m_numberOfLines++;
+      firstLine = false;
+      dc->GetTextExtent(line, &tokenwidth, &tokenheight);
+      width = wxMax(width, tokenwidth);
     }
-    else
+  }
+  else
+  {
+    StyleText();
+    for (auto const &textSnippet : m_styledText)
     {
-      dc->GetTextExtent(textSnippet->GetText(), &tokenwidth, &tokenheight);
-      linewidth += tokenwidth;
-      width = wxMax(width, linewidth);
+      if ((textSnippet.GetText().StartsWith(wxT('\n')) || (textSnippet.GetText().StartsWith(wxT('\r')))))
+      {
+        m_numberOfLines++;
+        linewidth = textSnippet.GetIndentPixels();
+      }
+      else
+      {
+        dc->GetTextExtent(textSnippet.GetText(), &tokenwidth, &tokenheight);
+        linewidth += tokenwidth;
+        width = wxMax(width, linewidth);
+      }
     }
+  }
 
-    // Handle folding
-    if (m_firstLineOnly)
-      m_numberOfLines = 1;
+  // Handle folding
+  if (m_firstLineOnly)
+    m_numberOfLines = 1;
 
-    // Assign empty lines a minimum width
-    if (m_text == wxEmptyString)
-      width = charWidth;
+  // Assign empty lines a minimum width
+  if (m_text == wxEmptyString)
+    width = charWidth;
 
-    // Add a line border
-    m_width = width + 2 * Scale_Px(2);
+  // Add a line border
+  m_width = width + 2 * Scale_Px(2);
 
-    // Calculate the cell height
-    if(m_firstLineOnly)
-      m_height = m_charHeight + 2 * Scale_Px(2);
-    else
-      m_height = m_numberOfLines * m_charHeight + 2 * Scale_Px(2);
+  // Calculate the cell height
+  if(m_firstLineOnly)
+    m_height = m_charHeight + 2 * Scale_Px(2);
+  else
+    m_height = m_numberOfLines * m_charHeight + 2 * Scale_Px(2);
 
-    if(m_height < m_charHeight + 2 * Scale_Px(2))
-      m_height = (m_charHeight) + 2 * Scale_Px(2);
-    
-    // The center lies in the middle of the 1st line
-    m_center = m_charHeight / 2;
-    Cell::Recalculate(fontsize);
-  }
+  if(m_height < m_charHeight + 2 * Scale_Px(2))
+    m_height = (m_charHeight) + 2 * Scale_Px(2);
+
+  // The center lies in the middle of the 1st line
+  m_center = m_charHeight / 2;
+  Cell::Recalculate(fontsize);
   m_containsChanges = false;
 }
 
+bool EditorCell::IsNearVisibleRegion() const
+{
+  Configuration *configuration = (*m_configuration);
+  // Printouts and exports need every cell's real size
+  if (!configuration->ClipToDrawRegion() || configuration->GetPrinting())
+    return true;
+  // Cells that have never been placed are laid out again once they are
+  // drawn for the first time.
+  if (m_currentPoint.y < 0)
+    return false;
+
+  // Leave a screen's height of margin for scrolling and for the tiles of the
+  // tile cache that reach beyond the visible region.
+  wxRect visible = configuration->GetVisibleWorksheetRegion();
+  visible.Inflate(0, visible.GetHeight());
+  int lines = 1;
+  if (!m_firstLineOnly)
+    for (auto const &ch : m_text)
+      if ((ch == wxT('\n')) || (ch == wxT('\r')))
+        lines++;
+  wxRect const estimate(m_currentPoint.x, m_currentPoint.y - m_charHeight / 2,
+                        1, lines * m_charHeight);
+  return visible.Intersects(estimate);
+}
+
 wxString EditorCell::ToHTML() const
 {
   wxString retval;
 
   for (const auto &tmp : OnList(this))
   {
+    tmp.StyleTextIfNeeded();
     for (const auto &textSnippet : tmp.m_styledText)
     {
       wxString text = PrependNBSP(EscapeHTMLChars(textSnippet.GetText()));
@@ -798,6 +844,7 @@ void EditorCell::Draw(wxPoint point)
   
   if (!IsHidden() && (DrawThisCell()))
   {
+    StyleTextIfNeeded();
     wxRect rect = GetRect();
     int y = rect.GetY();
     
@@ -986,35 +1033,43 @@ void EditorCell::Draw(wxPoint point)
 
     if (m_displayCaret && m_hasFocus && IsActive())
     {
-      unsigned int caretInLine = 0;
-      unsigned int caretInColumn = 0;
+      dc->SetPen(*(wxThePenList->FindOrCreatePen(configuration->GetColor(TS_CURSOR), 1, wxPENSTYLE_SOLID)));
+      dc->SetBrush(*(wxTheBrushList->FindOrCreateBrush(configuration->GetColor(TS_CURSOR), wxBRUSHSTYLE_SOLID)));
+      dc->DrawRectangle(GetCaretRect());
+    }
+
+  }
+}
 
-      PositionToXY(m_positionOfCaret, &caretInColumn, &caretInLine);
+wxRect EditorCell::GetCaretRect()
+{
+  unsigned int caretInLine = 0;
+  unsigned int caretInColumn = 0;
 
-      int lineWidth = GetLineWidth(caretInLine, caretInColumn);
+  PositionToXY(m_positionOfCaret, &caretInColumn, &caretInLine);
+
+  int lineWidth = GetLineWidth(caretInLine, caretInColumn);
+  wxPoint point = GetCurrentPoint();
 
-      dc->SetPen(*(wxThePenList->FindOrCreatePen(configuration->GetColor(TS_CURSOR), 1, wxPENSTYLE_SOLID)));
-      dc->SetBrush(*(wxTheBrushList->FindOrCreateBrush(configuration->GetColor(TS_CURSOR), wxBRUSHSTYLE_SOLID)));
 #if defined(__WXOSX__)
-      // draw 1 pixel shorter caret than on windows
-      dc->DrawRectangle(point.x  + lineWidth - (*m_configuration)->GetCursorWidth(),
-                        point.y + Scale_Px(1) - m_center + caretInLine * m_charHeight,
-                        (*m_configuration)->GetCursorWidth(),
-                        m_charHeight - Scale_Px(5));
+  // draw 1 pixel shorter caret than on windows
+  return wxRect(point.x  + lineWidth - (*m_configuration)->GetCursorWidth(),
+                point.y + Scale_Px(1) - m_center + caretInLine * m_charHeight,
+                (*m_configuration)->GetCursorWidth(),
+                m_charHeight - Scale_Px(5));
 #else
-      dc->DrawRectangle(point.x + + lineWidth-(*m_configuration)->GetCursorWidth()/2,
-                        point.y + Scale_Px(2) - m_center + caretInLine * m_charHeight,
-                        (*m_configuration)->GetCursorWidth(),
-                        m_charHeight- Scale_Px(3));
+  return wxRect(point.x + lineWidth - (*m_configuration)->GetCursorWidth() / 2,
+                point.y + Scale_Px(2) - m_center + caretInLine * m_charHeight,
+                (*m_configuration)->GetCursorWidth(),
+                m_charHeight - Scale_Px(3));
 #endif
-    }
-
-  }
 }
 
 void EditorCell::SetType(CellType type)
 {
   m_widths.clear();
+  // Code and text are styled differently
+  m_textStyled = false;
   Cell::SetType(type);
 }
 
@@ -2627,7 +2682,7 @@ bool EditorCell::AddEnding()
   
   bool endingNeeded = true;
   
-  for (auto const &tok : m_tokens)
+  for (auto const &tok : GetTokens())
   {
     TextStyle itemStyle = tok.GetStyle();
     if ((itemStyle == TS_CODE_ENDOFLINE) || (itemStyle == TS_CODE_LISP))
@@ -2738,6 +2793,7 @@ wxPoint EditorCell::PositionToPoint(int pos)
 
 void EditorCell::SelectPointText(const wxPoint point)
 {
+  StyleTextIfNeeded();
   wxString s;
   SetFont();
 
@@ -3206,6 +3262,7 @@ void EditorCell::PasteFromClipboard(const bool primary)
 
 int EditorCell::GetLineWidth(unsigned int line, int pos)
 {
+  StyleTextIfNeeded();
   // Find the text snippet the line we search for begins with for determining
   // the indentation needed.
   unsigned int currentLine = 1;
@@ -3788,6 +3845,7 @@ void EditorCell::StyleText()
 
   m_wordList.clear();
   m_styledText.clear();
+  m_textStyled = true;
 
   if(m_text == wxEmptyString)
     return;
@@ -3870,8 +3928,12 @@ void EditorCell::SetValue(const wxString &text)
   m_text.Replace(wxT("\u2028"), "\n");
   m_text.Replace(wxT("\u2029"), "\n");
 
-  // Style the text.
-  StyleText();
+  // The text is styled only once it is needed. Until then it has to look like
+  // StyleText() leaves it.
+  m_text.Replace(wxT("\r"), wxT(" "));
+  if (m_type != MC_TYPE_INPUT)
+    m_text.Replace(wxT("\u2022"), wxT("*"));
+  m_textStyled = false;
   ResetData();
 }
 
@@ -105,7 +105,7 @@ public:
   void KeyboardSelectionStartedHere() const;
 
   //! A list of words that might be applicable to the autocomplete function.
-  const auto &GetWordList() const { return m_wordList; }
+  const auto &GetWordList() const { StyleTextIfNeeded(); return m_wordList; }
 
   /*! Expand all tabulators.
 
@@ -152,8 +152,9 @@ public:
   void SetForeground();
 
   /*! Sets the text that is to be displayed.
-    
-    Automatically calls StyleText().
+
+    The text is styled the next time it is needed, which means that cells that
+    are never drawn, evaluated or asked for their tokens are never tokenized.
    */
   void SetValue(const wxString &text) override;
 
@@ -172,6 +173,18 @@ public:
     that this line is to be broken here until the window's width changes.
    */
   void StyleText();
+  //! Calls StyleText(), if the text has changed since it was last styled
+  void StyleTextIfNeeded() const
+  {
+    if (!m_textStyled)
+      const_cast<EditorCell *>(this)->StyleText();
+  }
+  /*! Has this cell's size been estimated from its unstyled text?
+
+    Recalculate() doesn't tokenize cells that are far away from the visible
+    region. Such a cell needs to be recalculated once it is scrolled into view.
+   */
+  bool HasEstimatedSize() const override { return m_sizeIsEstimate; }
   /*! Is Called by StyleText() if this is a code cell */
   void StyleTextCode();
   void StyleTextTexts();
@@ -284,6 +297,12 @@ public:
     m_displayCaret = !m_displayCaret;
   }
 
+  /*! The rectangle the caret occupies on the worksheet
+
+    Used for redrawing only the caret, not the whole cell, when it blinks.
+  */
+  wxRect GetCaretRect();
+
   void SetFocus(bool focus) override
   {
     m_hasFocus = focus;
@@ -296,8 +315,8 @@ public:
       m_width = m_height = -1;
       m_firstLineOnly = show;
     }
-    // Style the text anew.
-    StyleText();
+    // Style the text anew, once it is needed.
+    m_textStyled = false;
   }
 
   bool IsActive() const override;
@@ -463,9 +482,11 @@ public:
   }
 
   //! Get the list of commands, parenthesis, strings and whitespaces in a code cell
-  const MaximaTokenizer::TokenList &GetTokens() const {return m_tokens;}
+  const MaximaTokenizer::TokenList &GetTokens() const { StyleTextIfNeeded(); return m_tokens; }
 
 private:
+  //! Might this cell be shown on the screen soon?
+  bool IsNearVisibleRegion() const;
   //! Did the zoom factor change since the last recalculation?
   bool IsZoomFactorChanged() const;
   //! The zoom factor we had the last time we recalculated this cell.
@@ -664,6 +685,8 @@ private:
     m_isDirty = false;
     m_saveValue = false;
     m_selectionChanged = false;
+    m_sizeIsEstimate = false;
+    m_textStyled = false;
     m_underlined = false;
   }
 
@@ -679,6 +702,10 @@ private:
   bool m_saveValue :1 /* InitBitFields */;
   //! Has the selection changed since the last draw event?
   bool m_selectionChanged : 1 /* InitBitFields */;
+  //! Was our size measured without styling the text?
+  bool m_sizeIsEstimate : 1 /* InitBitFields */;
+  //! Do m_styledText, m_tokens and m_wordList match m_text?
+  bool m_textStyled : 1 /* InitBitFields */;
   //! Does this cell's size have to be recalculated?
   bool m_underlined : 1 /* InitBitFields */;
 };
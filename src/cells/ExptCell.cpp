@@ -125,19 +125,33 @@ void ExptCell::Recalculate(AFontSize fontsize)
 }
 
 wxString ExptCell::ToString() const
+{
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void ExptCell::AppendString(wxString &out) const
 {
   if (m_altCopyText != wxEmptyString)
-    return m_altCopyText;
+  {
+    out += m_altCopyText;
+    return;
+  }
   if (IsBrokenIntoLines())
-    return wxEmptyString;
-  wxString s = m_baseCell->ListToString() + wxT("^");
+    return;
+  m_baseCell->ListAppendString(out);
+  out += wxT("^");
   if (m_isMatrix)
-    s += wxT("^");
+    out += wxT("^");
   if (m_exptCell->IsCompound())
-    s += wxT("(") + m_exptCell->ListToString() + wxT(")");
+  {
+    out += wxT("(");
+    m_exptCell->ListAppendString(out);
+    out += wxT(")");
+  }
   else
-    s += m_exptCell->ListToString();
-  return s;
+    m_exptCell->ListAppendString(out);
 }
 
 wxString ExptCell::ToMatlab() const
@@ -157,12 +171,21 @@ wxString ExptCell::ToMatlab() const
 }
 
 wxString ExptCell::ToTeX() const
+{
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void ExptCell::AppendTeX(wxString &out) const
 {
   if (IsBrokenIntoLines())
-    return wxEmptyString;
-  wxString s = wxT("{{") + m_baseCell->ListToTeX() + wxT("}^{") +
-               m_exptCell->ListToTeX() + wxT("}}");
-  return s;
+    return;
+  out += wxT("{{");
+  m_baseCell->ListAppendTeX(out);
+  out += wxT("}^{");
+  m_exptCell->ListAppendTeX(out);
+  out += wxT("}}");
 }
 
 wxString ExptCell::GetDiffPart() const
@@ -178,29 +201,52 @@ wxString ExptCell::GetDiffPart() const
 
 wxString ExptCell::ToMathML() const
 {
-  return wxT("<msup>") +
-         m_baseCell->ListToMathML() +
-         m_exptCell->ListToMathML() +
-         wxT("</msup>\n");
-//  return wxT("<apply><power/>") + m_baseCell->ListToMathML() + m_exptCell->ListToMathML() + wxT("</apply>");
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void ExptCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<msup>");
+  m_baseCell->ListAppendMathML(out);
+  m_exptCell->ListAppendMathML(out);
+  out += wxT("</msup>\n");
 }
 
 wxString ExptCell::ToOMML() const
 {
-  return wxT("<m:sSup><m:e>") + m_baseCell->ListToOMML() + wxT("</m:e><m:sup>") +
-         m_exptCell->ListToOMML() + wxT("</m:sup></m:sSup>\n");
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void ExptCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:sSup><m:e>");
+  m_baseCell->ListAppendOMML(out);
+  out += wxT("</m:e><m:sup>");
+  m_exptCell->ListAppendOMML(out);
+  out += wxT("</m:sup></m:sSup>\n");
 }
 
 wxString ExptCell::ToXML() const
 {
-//  if (IsBrokenIntoLines())
-//    return wxEmptyString;
-  wxString flags;
-  if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
 
-  return wxT("<e") + flags + wxT("><r>") + m_baseCell->ListToXML() + _T("</r><r>") +
-         m_exptCell->ListToXML() + _T("</r></e>");
+void ExptCell::AppendXML(wxString &out) const
+{
+  out += wxT("<e");
+  if (HasHardLineBreak())
+    out += wxT(" breakline=\"true\"");
+  out += wxT("><r>");
+  m_baseCell->ListAppendXML(out);
+  out += wxT("</r><r>");
+  m_exptCell->ListAppendXML(out);
+  out += wxT("</r></e>");
 }
 
 bool ExptCell::BreakUp()
@@ -171,44 +171,62 @@ void FracCell::Draw(wxPoint point)
 wxString FracCell::ToString() const
 {
   wxString s;
-  if (!IsBrokenIntoLines())
+  AppendString(s);
+  return s;
+}
+
+void FracCell::AppendString(wxString &out) const
+{
+  if (IsBrokenIntoLines())
+    return;
+  if (m_fracStyle == FC_NORMAL)
   {
-    if (m_fracStyle == FC_NORMAL)
+    if (Num()->IsCompound())
     {
-      if (Num()->IsCompound())
-        s += wxT("(") + Num()->ListToString() + wxT(")/");
-      else
-        s += Num()->ListToString() + wxT("/");
-      if (Denom()->IsCompound())
-        s += wxT("(") + Denom()->ListToString() + wxT(")");
-      else
-        s += Denom()->ListToString();
+      out += wxT("(");
+      Num()->ListAppendString(out);
+      out += wxT(")/");
     }
-    else if (m_fracStyle == FC_CHOOSE)
+    else
     {
-      s = wxT("binomial(") + Num()->ListToString() + wxT(",") +
-          Denom()->ListToString() + wxT(")");
+      Num()->ListAppendString(out);
+      out += wxT("/");
+    }
+    if (Denom()->IsCompound())
+    {
+      out += wxT("(");
+      Denom()->ListAppendString(out);
+      out += wxT(")");
     }
     else
+      Denom()->ListAppendString(out);
+  }
+  else if (m_fracStyle == FC_CHOOSE)
+  {
+    out += wxT("binomial(");
+    Num()->ListAppendString(out);
+    out += wxT(",");
+    Denom()->ListAppendString(out);
+    out += wxT(")");
+  }
+  else
+  {
+    Cell *tmp = Denom();
+    while (tmp != NULL)
     {
-      Cell *tmp = Denom();
-      while (tmp != NULL)
-      {
-        tmp = tmp->GetNext();   // Skip the d
-        if (tmp == NULL)
-          break;
-        tmp = tmp->GetNext();   // Skip the *
-        if (tmp == NULL)
-          break;
-        s += tmp->GetDiffPart();
-        tmp = tmp->GetNext();   // Skip the *
-        if (tmp == NULL)
-          break;
-        tmp = tmp->GetNext();
-      }
+      tmp = tmp->GetNext();   // Skip the d
+      if (tmp == NULL)
+        break;
+      tmp = tmp->GetNext();   // Skip the *
+      if (tmp == NULL)
+        break;
+      out += tmp->GetDiffPart();
+      tmp = tmp->GetNext();   // Skip the *
+      if (tmp == NULL)
+        break;
+      tmp = tmp->GetNext();
     }
   }
-  return s;
 }
 
 wxString FracCell::ToMatlab() const
@@ -254,51 +272,85 @@ wxString FracCell::ToMatlab() const
 
 wxString FracCell::ToTeX() const
 {
-  wxString s;
-  if (!IsBrokenIntoLines())
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void FracCell::AppendTeX(wxString &out) const
+{
+  if (IsBrokenIntoLines())
+    return;
+  if (m_fracStyle == FC_CHOOSE)
   {
-    if (m_fracStyle == FC_CHOOSE)
-    {
-      s = wxT("\\begin{pmatrix}") + Num()->ListToTeX() + wxT("\\\\\n") +
-          Denom()->ListToTeX() + wxT("\\end{pmatrix}");
-    }
-    else
-    {
-      s = wxT("\\frac{") + Num()->ListToTeX() + wxT("}{") +
-          Denom()->ListToTeX() + wxT("}");
-    }
+    out += wxT("\\begin{pmatrix}");
+    Num()->ListAppendTeX(out);
+    out += wxT("\\\\\n");
+    Denom()->ListAppendTeX(out);
+    out += wxT("\\end{pmatrix}");
+  }
+  else
+  {
+    out += wxT("\\frac{");
+    Num()->ListAppendTeX(out);
+    out += wxT("}{");
+    Denom()->ListAppendTeX(out);
+    out += wxT("}");
   }
-  return s;
 }
 
 wxString FracCell::ToMathML() const
 {
-  return wxT("<mfrac>") +
-         Num()->ListToMathML() +
-         Denom()->ListToMathML() + wxT("</mfrac>\n");
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void FracCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<mfrac>");
+  Num()->ListAppendMathML(out);
+  Denom()->ListAppendMathML(out);
+  out += wxT("</mfrac>\n");
 }
 
 
 wxString FracCell::ToOMML() const
 {
-  return wxT("<m:f><m:num>") +
-         Num()->ListToOMML() + wxT("</m:num><m:den>") +
-         Denom()->ListToOMML() + wxT("</m:den></m:f>\n");
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void FracCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:f><m:num>");
+  Num()->ListAppendOMML(out);
+  out += wxT("</m:num><m:den>");
+  Denom()->ListAppendOMML(out);
+  out += wxT("</m:den></m:f>\n");
 }
 
 wxString FracCell::ToXML() const
 {
-  wxString s = (m_fracStyle == FC_NORMAL || m_fracStyle == FC_DIFF) ?
-               _T("f") : _T("f line = \"no\"");
-  wxString diffStyle;
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void FracCell::AppendXML(wxString &out) const
+{
+  out += (m_fracStyle == FC_NORMAL || m_fracStyle == FC_DIFF) ?
+    wxT("<f") : wxT("<f line = \"no\"");
   if (m_fracStyle == FC_DIFF)
-    diffStyle = wxT(" diffstyle=\"yes\"");
+    out += wxT(" diffstyle=\"yes\"");
   if (HasHardLineBreak())
-    diffStyle += wxT(" breakline=\"true\"");
-
-  return _T("<") + s + diffStyle + _T("><r>") +
-         Num()->ListToXML() + _T("</r><r>") +
-         Denom()->ListToXML() + _T("</r></f>");
+    out += wxT(" breakline=\"true\"");
+  out += wxT("><r>");
+  Num()->ListAppendXML(out);
+  out += wxT("</r><r>");
+  Denom()->ListAppendXML(out);
+  out += wxT("</r></f>");
 }
 
 void FracCell::SetExponentFlag()
@@ -85,12 +85,23 @@ void FunCell::Draw(wxPoint point)
 }
 
 wxString FunCell::ToString() const
+{
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void FunCell::AppendString(wxString &out) const
 {
   if (IsBrokenIntoLines())
-    return wxEmptyString;
+    return;
   if (m_altCopyText != wxEmptyString)
-    return m_altCopyText;
-  return m_nameCell->ListToString() + m_argCell->ListToString();
+  {
+    out += m_altCopyText;
+    return;
+  }
+  m_nameCell->ListAppendString(out);
+  m_argCell->ListAppendString(out);
 }
 
 wxString FunCell::ToMatlab() const
@@ -105,52 +116,86 @@ wxString FunCell::ToMatlab() const
 
 wxString FunCell::ToTeX() const
 {
-  if (IsBrokenIntoLines())
-    return wxEmptyString;
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
 
-  wxString s;
+void FunCell::AppendTeX(wxString &out) const
+{
+  if (IsBrokenIntoLines())
+    return;
 
+  wxString const name = m_nameCell->ToString();
   if (
-    (m_nameCell->ToString() == wxT("sin")) ||
-    (m_nameCell->ToString() == wxT("cos")) ||
-    (m_nameCell->ToString() == wxT("cosh")) ||
-    (m_nameCell->ToString() == wxT("sinh")) ||
-    (m_nameCell->ToString() == wxT("log")) ||
-    (m_nameCell->ToString() == wxT("cot")) ||
-    (m_nameCell->ToString() == wxT("sec")) ||
-    (m_nameCell->ToString() == wxT("csc")) ||
-    (m_nameCell->ToString() == wxT("tan"))
+    (name == wxT("sin")) ||
+    (name == wxT("cos")) ||
+    (name == wxT("cosh")) ||
+    (name == wxT("sinh")) ||
+    (name == wxT("log")) ||
+    (name == wxT("cot")) ||
+    (name == wxT("sec")) ||
+    (name == wxT("csc")) ||
+    (name == wxT("tan"))
     )
-    s = wxT("\\") + m_nameCell->ToString() + wxT("{") + m_argCell->ListToTeX() + wxT("}");
+  {
+    out += wxT("\\") + name + wxT("{");
+    m_argCell->ListAppendTeX(out);
+    out += wxT("}");
+  }
   else
-    s = m_nameCell->ListToTeX() + m_argCell->ListToTeX();
-  
-  return s;
+  {
+    m_nameCell->ListAppendTeX(out);
+    m_argCell->ListAppendTeX(out);
+  }
 }
 
 wxString FunCell::ToXML() const
 {
-//  if (IsBrokenIntoLines())
-//    return wxEmptyString;
-  wxString flags;
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void FunCell::AppendXML(wxString &out) const
+{
+  out += wxT("<fn");
   if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
-  return wxT("<fn") + flags + wxT("><r>") + m_nameCell->ListToXML() + wxT("</r>") +
-         m_argCell->ListToXML() + wxT("</fn>");
+    out += wxT(" breakline=\"true\"");
+  out += wxT("><r>");
+  m_nameCell->ListAppendXML(out);
+  out += wxT("</r>");
+  m_argCell->ListAppendXML(out);
+  out += wxT("</fn>");
 }
 
 wxString FunCell::ToMathML() const
 {
-//  if (IsBrokenIntoLines())
-//    return wxEmptyString;
-  return wxT("<mrow>") + m_nameCell->ListToMathML() +
-         wxT("<mo>&#x2061;</mo>") + m_argCell->ListToMathML() + wxT("</mrow>\n");
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void FunCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<mrow>");
+  m_nameCell->ListAppendMathML(out);
+  out += wxT("<mo>&#x2061;</mo>");
+  m_argCell->ListAppendMathML(out);
+  out += wxT("</mrow>\n");
 }
 
 wxString FunCell::ToOMML() const
 {
-  return m_nameCell->ListToOMML() +
-         m_argCell->ListToOMML();
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void FunCell::AppendOMML(wxString &out) const
+{
+  m_nameCell->ListAppendOMML(out);
+  m_argCell->ListAppendOMML(out);
 }
 
 bool FunCell::BreakUp()
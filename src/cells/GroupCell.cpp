@@ -37,6 +37,7 @@
 #include "CellPointers.h"
 #include "ImgCell.h"
 #include "MarkDown.h"
+#include "Profiler.h"
 #include "AnimationCell.h"
 #include "TextCell.h"
 #include "LabelCell.h"
@@ -145,8 +146,9 @@ GroupCell::GroupCell(Configuration **config, GroupType groupType, const wxString
   if ((groupType == GC_TYPE_IMAGE) && (initString.Length() > 0))
   {
     std::unique_ptr<Cell> ic;
-    if (wxImage::GetImageCount(initString) < 2) {
-      ic = std::make_unique<ImgCell>(this, m_configuration, initString, std::shared_ptr<wxFileSystem>{} /* system fs */, false);
+    Image::FileContents const file = Image::ReadFile(*m_configuration, initString, false);
+    if (file.frames < 2) {
+      ic = std::make_unique<ImgCell>(this, m_configuration, file);
 
       // Since this is the (only?) place where an ImgCell is constructed when the user manually
       // inserts an image file (not loaded from zip or gnuplot tempfile), set the filename such that reloading the
@@ -154,7 +156,8 @@ GroupCell::GroupCell(Configuration **config, GroupType groupType, const wxString
       static_cast<ImgCell &>(*ic).SetOrigImageFile(initString);
     }
     else
-      ic = std::make_unique<AnimationCell>(this, m_configuration, initString, false);
+      ic = std::make_unique<AnimationCell>(this, m_configuration, file.data,
+                                           wxFileName(initString).GetExt());
     AppendOutput(std::move(ic));
   }
 }
@@ -352,6 +355,9 @@ void GroupCell::SetOutput(std::unique_ptr<Cell> &&output)
     m_cellPointers->m_answerCell = nullptr;
   
   m_output.reset();
+  m_lastInOutput = nullptr;
+  m_firstAppendedOutput = nullptr;
+  m_outputLines = 0;
   AppendOutput(std::move(output));
 }
 
@@ -368,7 +374,12 @@ void GroupCell::RemoveOutput()
     m_cellPointers->m_answerCell = nullptr;
 
   if (GetGroupType() != GC_TYPE_IMAGE)
+  {
     m_output.reset();
+    m_lastInOutput = nullptr;
+    m_outputLines = 0;
+  }
+  m_firstAppendedOutput = nullptr;
 
   m_cellPointers->m_errorList.Remove(this);
   // Calculate the new cell height.
@@ -393,6 +404,12 @@ void GroupCell::AppendOutput(std::unique_ptr<Cell> &&cell)
 {
   wxASSERT_MSG(cell, _("Bug: Trying to append NULL to a group cell."));
   if (!cell) return;
+  Cell *const newLast = cell->last();
+  // Count the new lines the same way DiscardOldestOutput() does
+  for (const Cell &tmp : OnList(cell.get()))
+    if (((&tmp == cell.get()) && !m_output) || tmp.HasHardLineBreak())
+      m_outputLines++;
+  Cell *const lastInOutput = m_lastInOutput.get();
   if (!m_output)
   {
     m_output = std::move(cell);
@@ -400,13 +417,99 @@ void GroupCell::AppendOutput(std::unique_ptr<Cell> &&cell)
     auto *input = GetEditable();
     if (m_groupType == GC_TYPE_CODE && input)
       input->ContainsChanges(false);
+    UpdateCellsInGroup();
+    m_cellsAppended = true;
+  }
+  else if (lastInOutput && !lastInOutput->GetNext())
+  {
+    // We know where the output ends => no need to search for its end.
+    Cell *const first = cell.get();
+    m_cellsInGroup += first->CellsInListRecursive();
+    if (m_cellsAppended)
+    {
+      // A full recalculation is pending, anyway, which will lay out the new cells, too.
+      CellList::AppendAfterLast(lastInOutput, std::move(cell));
+    }
+    else if (first->HasHardLineBreak())
+    {
+      // The new cells begin a new line => RecalculateAppended() needs to lay
+      // out only the new lines.
+      CellList::AppendAfterLast(lastInOutput, std::move(cell));
+      if (!m_firstAppendedOutput)
+        m_firstAppendedOutput = first;
+    }
+    else
+    {
+      // The new cells continue a line that already has been laid out
+      ResetData();
+      CellList::AppendAfterLast(lastInOutput, std::move(cell));
+      m_firstAppendedOutput = nullptr;
+      m_cellsAppended = true;
+    }
   }
   else
+  {
     CellList::AppendCell(m_output, std::move(cell));
+    UpdateCellsInGroup();
+    m_firstAppendedOutput = nullptr;
+    m_cellsAppended = true;
+  }
+  m_lastInOutput = newLast;
+  m_updateConfusableCharWarnings = true;
+}
+
+int GroupCell::DiscardOldestOutput(int lines)
+{
+  if (!m_output || (lines < 1))
+    return 0;
+
+  // The notice that older output has been discarded isn't a line of output:
+  // It stays in front of the output.
+  Cell *const notice = (m_discardNotice == m_output.get()) ? m_discardNotice.get() : nullptr;
+  Cell *const first = notice ? notice->GetNext() : m_output.get();
+  if (!first)
+    return 0;
+
+  // Find the last cell of the oldest lines. Every output line starts with a cell
+  // with a hard line break.
+  Cell *lastDiscarded = {};
+  int discarded = 0;
+  for (Cell &tmp : OnList(first))
+  {
+    if ((&tmp == first) || tmp.HasHardLineBreak())
+    {
+      if (discarded == lines)
+        break;
+      discarded++;
+    }
+    lastDiscarded = &tmp;
+  }
+  // We never discard all of the output.
+  if (!lastDiscarded || !lastDiscarded->GetNext())
+    return 0;
+
+  auto remaining = CellList::SetNext(lastDiscarded, nullptr);
+  if (notice)
+    // Frees the discarded lines
+    CellList::SetNext(notice, std::move(remaining));
+  else
+  {
+    // Tell the user that the output is incomplete.
+    auto newNotice = std::make_unique<TextCell>(this, m_configuration,
+                                                _("[... older output has been discarded]"));
+    newNotice->SetType(MC_TYPE_WARNING);
+    newNotice->ForceBreakLine(true);
+    CellList::SetNext(newNotice.get(), std::move(remaining));
+    m_discardNotice = newNotice.get();
+    m_output = std::move(newNotice);
+  }
 
   UpdateCellsInGroup();
-  m_updateConfusableCharWarnings = true;
+  m_firstAppendedOutput = nullptr;
   m_cellsAppended = true;
+  m_updateConfusableCharWarnings = true;
+  m_outputLines -= discarded;
+  return discarded;
 }
 
 WX_DECLARE_STRING_HASH_MAP(int, CmdsAndVariables);
@@ -475,6 +578,8 @@ void GroupCell::Recalculate()
 {
   if (NeedsRecalculation(EditorFontSize()))
   {
+    Profiler::Scope timer(Profiler::recalculate);
+    Profiler::CellScope cellTimer(this, Profiler::cellLayout);
     Cell::Recalculate((*m_configuration)->GetDefaultFontSize());
     m_mathFontSize = (*m_configuration)->GetMathFontSize();
     Configuration *configuration = (*m_configuration);
@@ -500,8 +605,14 @@ void GroupCell::Recalculate()
     (*m_configuration)->AdjustWorksheetSize(true);
     
     m_cellsAppended = false;
+    m_firstAppendedOutput = nullptr;
     m_clientWidth_old = (*m_configuration)->GetClientWidth();
   }
+  else if (m_firstAppendedOutput)
+  {
+    Profiler::CellScope cellTimer(this, Profiler::cellLayout);
+    RecalculateAppended();
+  }
   // The line breaking will have set our "needs recalculation" flag again.
   UpdateYPosition();
   Cell::Recalculate((*m_configuration)->GetDefaultFontSize());
@@ -518,6 +629,7 @@ void GroupCell::InputHeightChanged()
   EditorCell *editorCell = GetEditable();
   if(editorCell == NULL)
     return;
+  Profiler::CellScope cellTimer(this, Profiler::cellLayout);
   RecalculateInput();
   if(m_output != NULL)
   {
@@ -635,22 +747,77 @@ void GroupCell::RecalculateOutput()
   
   // Recalculate size of cells again: Their size might have changed during breaking
   // lines
+  m_outputHasEstimatedSize = false;
   for (Cell &tmp : OnList(m_output.get()))
   {
     tmp.Recalculate(tmp.IsMath() ?
                     (*m_configuration)->GetMathFontSize() :
                     (*m_configuration)->GetDefaultFontSize());
+    m_outputHasEstimatedSize |= tmp.HasEstimatedSize();
   }
 
   // Calculate the height of the output
-  for (Cell &tmp : OnDrawList(m_output.get()))
+  int const outputWidth = AddOutputLineHeights(m_output.get());
+  m_width = wxMax(m_width, outputWidth);
+  m_outputRect.width = wxMax(m_outputRect.width, m_width);
+}
+
+void GroupCell::RecalculateAppended()
+{
+  Cell *const first = m_firstAppendedOutput.get();
+  m_firstAppendedOutput = nullptr;
+  if (!first || !m_output || IsHidden())
+    return;
+
+  Configuration *configuration = (*m_configuration);
+  m_mathFontSize = configuration->GetMathFontSize();
+
+  // The lines before the new cells keep their layout: Only the new cells need
+  // to go through the steps RecalculateOutput() performs.
+  for (Cell &tmp : OnList(first))
+    tmp.Recalculate(tmp.IsMath() ?
+                    configuration->GetMathFontSize() :
+                    configuration->GetDefaultFontSize());
+
+  if (BreakUpCells(first))
+    for (Cell &tmp : OnList(first))
+      tmp.Recalculate(tmp.IsMath() ?
+                      configuration->GetMathFontSize() :
+                      configuration->GetDefaultFontSize());
+
+  // The first new cell starts a new line => the lines before it aren't affected.
+  BreakLinesFrom(first);
+
+  for (Cell &tmp : OnList(first))
+  {
+    tmp.ResetData();
+    tmp.Recalculate(tmp.IsMath() ?
+                    configuration->GetMathFontSize() :
+                    configuration->GetDefaultFontSize());
+    m_outputHasEstimatedSize |= tmp.HasEstimatedSize();
+  }
+
+  // The new lines may be wider than everything above them
+  int const outputWidth = AddOutputLineHeights(first);
+  m_width = wxMax(m_width, outputWidth);
+  m_outputRect.width = wxMax(m_outputRect.width, m_width);
+  m_height = m_outputRect.GetHeight() + m_inputHeight;
+  // Move all cells that follow the current one down by the amount this cell has grown.
+  configuration->AdjustWorksheetSize(true);
+}
+
+int GroupCell::AddOutputLineHeights(Cell *start)
+{
+  Configuration *configuration = (*m_configuration);
+  int width = 0;
+  for (Cell &tmp : OnDrawList(start))
   {
     if (tmp.BreakLineHere())
     {
       tmp.ResetCellListSizes();
       int height_Delta = tmp.GetHeightList();
-      m_width = wxMax(m_width, tmp.GetLineWidth());
-      m_outputRect.width = wxMax(m_outputRect.width, m_width);
+      width = wxMax(width, tmp.GetLineWidth());
+      m_outputRect.width = wxMax(m_outputRect.width, width);
       m_outputRect.height += height_Delta;
       
       if (tmp.GetPrevious() &&
@@ -661,6 +828,7 @@ void GroupCell::RecalculateOutput()
         m_outputRect.height += MC_LINE_SKIP;
     }
   }
+  return width;
 }
 
 bool GroupCell::NeedsRecalculation(AFontSize fontSize) const
@@ -670,6 +838,24 @@ bool GroupCell::NeedsRecalculation(AFontSize fontSize) const
     (m_clientWidth_old != (*m_configuration)->GetClientWidth()) || m_cellsAppended;
 }
 
+bool GroupCell::HasEstimatedSize() const
+{
+  return m_outputHasEstimatedSize || (GetEditable() && GetEditable()->HasEstimatedSize());
+}
+
+bool GroupCell::HasEstimatedSizeIn(const wxRect &rect) const
+{
+  if (!GetRect().Intersects(rect))
+    return false;
+  if (GetEditable() && GetEditable()->HasEstimatedSizeIn(rect))
+    return true;
+  if (m_outputHasEstimatedSize && !IsHidden())
+    for (const Cell &tmp : OnList(m_output.get()))
+      if (tmp.HasEstimatedSizeIn(rect))
+        return true;
+  return false;
+}
+
 void GroupCell::UpdateYPositionList()
 {
   for (auto &tmp : OnList(this))
@@ -759,6 +945,7 @@ void GroupCell::UpdateOutputPositions()
 
 void GroupCell::Draw(wxPoint const point)
 {
+  Profiler::CellScope cellTimer(this, Profiler::cellDraw);
   Cell::Draw(point);
   Configuration *configuration = (*m_configuration);
   if(NeedsRecalculation((*m_configuration)->GetDefaultFontSize()))
@@ -879,6 +1066,72 @@ void GroupCell::CellUnderPointer(GroupCell *cell)
   m_cellPointers->m_groupCellUnderPointer = cell;
 }
 
+std::int64_t GroupCell::AddCost(Profiler::CellCost cost, std::int64_t microseconds)
+{
+  m_costs.time[cost] += microseconds;
+  return m_costs.Total();
+}
+
+//! The number of colours the cost gutter can have
+static constexpr int costColourSteps = 16;
+
+int GroupCell::CostColourStep() const
+{
+  std::int64_t const maxCost = Profiler::GetMaxCellCost();
+  std::int64_t const cost = m_costs.Total();
+  if ((maxCost <= 0) || (cost <= 0))
+    return -1;
+  return static_cast<int>(wxMin(std::int64_t(costColourSteps), cost * costColourSteps / maxCost));
+}
+
+bool GroupCell::CostGutterChanged()
+{
+  int const step = CostColourStep();
+  if (step == m_costColourStep)
+    return false;
+  m_costColourStep = step;
+  return true;
+}
+
+wxRect GroupCell::GetCostGutterRect() const
+{
+  Configuration *configuration = (*m_configuration);
+  int const width = wxMax(2, configuration->GetCellBracketWidth() / 4);
+  return wxRect(
+    wxMax(0, configuration->GetIndent() - configuration->GetCellBracketWidth() - width - 1),
+    GetRect().GetTop() - 2,
+    width,
+    GetRect().GetHeight() + 5);
+}
+
+void GroupCell::DrawCostGutter()
+{
+  int const step = CostColourStep();
+  if (step < 0)
+    return;
+
+  Configuration *configuration = (*m_configuration);
+  wxRect const gutter = GetCostGutterRect();
+  if (!configuration->InUpdateRegion(gutter))
+    return;
+
+  // Green for cheap cells, red for the most expensive cell of the worksheet.
+  // The colour changes in steps, so the gutter only needs to be redrawn if
+  // the cell's cost has changed by a noticeable amount.
+  double const heat = static_cast<double>(step) / costColourSteps;
+  wxColour const color(static_cast<unsigned char>(255 * heat),
+                       static_cast<unsigned char>(255 * (1 - heat)),
+                       0);
+  wxDC *dc = configuration->GetDC();
+  wxPen const oldPen = dc->GetPen();
+  wxBrush const oldBrush = dc->GetBrush();
+  dc->SetPen(*wxTRANSPARENT_PEN);
+  dc->SetBrush(*(wxTheBrushList->FindOrCreateBrush(color)));
+  dc->DrawRectangle(Cell::CropToUpdateRegion(gutter));
+  dc->SetPen(oldPen);
+  dc->SetBrush(oldBrush);
+}
+
 void GroupCell::DrawBracket()
 {
   // If the current cell doesn't know where it is on the screen we don't
@@ -953,6 +1206,9 @@ void GroupCell::DrawBracket()
   if (configuration->InUpdateRegion(rect))
     dc->DrawRectangle(Cell::CropToUpdateRegion(rect));
 
+  if (Profiler::IsEnabled())
+    DrawCostGutter();
+
   //
   // Mark groupcells currently in queue.
   //
@@ -1059,20 +1315,28 @@ wxRect GroupCell::HideRect()
 
 wxString GroupCell::ToString() const
 {
-  wxString str;
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void GroupCell::AppendString(wxString &out) const
+{
   Configuration *configuration = (*m_configuration);
+  size_t const start = out.Length();
 
   if (m_inputLabel != NULL)
   {
     if ((configuration->ShowCodeCells()) ||
         (m_groupType != GC_TYPE_CODE))
     {
-      str = m_inputLabel->ToString();
+      wxString input = m_inputLabel->ToString();
 
       if (GetEditable() != NULL)
-        str += GetEditable()->ToString();
+        input += GetEditable()->ToString();
 
-      str.Replace(wxT("\n"), wxT("\n\t"));
+      input.Replace(wxT("\n"), wxT("\n\t"));
+      out += input;
     }
   }
 
@@ -1081,13 +1345,12 @@ wxString GroupCell::ToString() const
     bool firstCell = true;
     for (Cell &tmp : OnDrawList(m_output.get()))
     {
-      if (firstCell || (tmp.HasHardLineBreak() && !str.empty()))
-          str += wxT("\n");
-      str += tmp.ToString();
+      if (firstCell || (tmp.HasHardLineBreak() && (out.Length() > start)))
+          out += wxT("\n");
+      tmp.AppendString(out);
       firstCell = false;
     }
   }
-  return str;
 }
 
 wxString GroupCell::ToTeX() const
@@ -1096,43 +1359,49 @@ wxString GroupCell::ToTeX() const
 }
 
 wxString GroupCell::ToRTF() const
+{
+  wxString rtf;
+  AppendRTF(rtf);
+  return rtf;
+}
+
+void GroupCell::AppendRTF(wxString &out) const
 {
   Configuration *configuration = (*m_configuration);
   if (m_groupType == GC_TYPE_PAGEBREAK)
-    return (wxT("\\page "));
+  {
+    out += wxT("\\page ");
+    return;
+  }
 
-  wxString retval;
   if (m_groupType == GC_TYPE_CODE)
   {
     if (m_inputLabel && configuration->ShowCodeCells())
     {
       if (GetPrevious())
-        retval = wxT("\\par}{\\pard\\s22\\li1105\\lin1105\\fi-1105\\f0\\fs24 \n");
+        out += wxT("\\par}{\\pard\\s22\\li1105\\lin1105\\fi-1105\\f0\\fs24 \n");
       else
-        retval += wxT("\\pard\\s22\\li1105\\lin1105\\fi-1105\\f0\\fs24 ");
-      retval += RTFescape(m_inputLabel->ToString());
-      retval += wxT("\\tab\n");
+        out += wxT("\\pard\\s22\\li1105\\lin1105\\fi-1105\\f0\\fs24 ");
+      out += RTFescape(m_inputLabel->ToString());
+      out += wxT("\\tab\n");
     }
     else
     {
       if (GetPrevious())
-        retval = wxT("\\par}\n{\\pard\\s21\\li1105\\lin1105\\f0\\fs24 ");
+        out += wxT("\\par}\n{\\pard\\s21\\li1105\\lin1105\\f0\\fs24 ");
       else
-        retval = wxT("\\pard\\s21\\li1105\\lin1105\\f0\\fs24 ");
+        out += wxT("\\pard\\s21\\li1105\\lin1105\\f0\\fs24 ");
     }
   }
   else
-    retval = wxT("\\par}\n{");
+    out += wxT("\\par}\n{");
 
   if (GetEditable() != NULL)
-    retval += GetEditable()->ToRTF();
+    out += GetEditable()->ToRTF();
 
-  Cell *out = GetLabel();
-  if (out != NULL)
-  {
-    retval += out->ListToRTF(true);
-  }
-  return retval;
+  Cell *output = GetLabel();
+  if (output != NULL)
+    output->ListAppendRTF(out, true);
 }
 
 wxString GroupCell::ToTeX(wxString imgDir, wxString filename, int *imgCounter) const
@@ -1284,7 +1553,8 @@ wxString GroupCell::ToTeXCodeCell(wxString imgDir, wxString filename, int *imgCo
               str += wxT("\\[\\displaystyle ");
               mathMode = true;
             }
-            str += tmp.ToTeX() + wxT("\n");
+            tmp.AppendTeX(str);
+            str += wxT("\n");
             break;
 
           case TS_STRING:
@@ -1302,7 +1572,7 @@ wxString GroupCell::ToTeXCodeCell(wxString imgDir, wxString filename, int *imgCo
               str += wxT("\\[\\displaystyle ");
               mathMode = true;
             }
-            str += tmp.ToTeX();
+            tmp.AppendTeX(str);
             break;
         }
       }
@@ -1352,8 +1622,14 @@ wxString GroupCell::ToTeXImage(Cell *tmp, wxString imgDir, wxString filename, in
 
 wxString GroupCell::ToXML() const
 {
-  wxString str;
-  str = wxT("\n<cell"); // start opening tag
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void GroupCell::AppendXML(wxString &str) const
+{
+  str += wxT("\n<cell"); // start opening tag
   // write "type" according to m_groupType
   switch (m_groupType)
   {
@@ -1411,7 +1687,7 @@ wxString GroupCell::ToXML() const
     case GC_TYPE_PAGEBREAK:
     {
       str += wxT(" type=\"pagebreak\"/>");
-      return str;
+      return;
     }
       break;
     default:
@@ -1436,26 +1712,26 @@ wxString GroupCell::ToXML() const
       if (input != NULL)
       {
         str += wxT("<input>\n");
-        str += input->ListToXML();
+        input->ListAppendXML(str);
         str += wxT("</input>");
       }
       if (output != NULL)
       {
         str += wxT("\n<output>\n");
         str += wxT("<mth>");
-        str += output->ListToXML();
+        output->ListAppendXML(str);
         str += wxT("\n</mth></output>");
       }
       break;
     case GC_TYPE_IMAGE:
       if (input != NULL)
-        str += input->ListToXML();
+        input->ListAppendXML(str);
       if (output != NULL)
-        str += output->ListToXML();
+        output->ListAppendXML(str);
       break;
     case GC_TYPE_TEXT:
       if (input)
-        str += input->ListToXML();
+        input->ListAppendXML(str);
       break;
     case GC_TYPE_TITLE:
     case GC_TYPE_SECTION:
@@ -1464,11 +1740,11 @@ wxString GroupCell::ToXML() const
     case GC_TYPE_HEADING5:
     case GC_TYPE_HEADING6:
       if (input)
-        str += input->ListToXML();
+        input->ListAppendXML(str);
       if (m_hiddenTree)
       {
         str += wxT("<fold>");
-        str += m_hiddenTree->ListToXML();
+        m_hiddenTree->ListAppendXML(str);
         str += wxT("</fold>");
       }
       break;
@@ -1476,14 +1752,12 @@ wxString GroupCell::ToXML() const
     {
       for (const Cell &tmp : OnList(output))
         // cppcheck-suppress useStlAlgorithm
-        str += tmp.ListToXML();
+        tmp.ListAppendXML(str);
 
       break;
     }
   }
   str += wxT("\n</cell>\n");
-
-  return str;
 }
 
 Cell::Range GroupCell::GetInnerCellsInRect(const wxRect &rect) const
@@ -1615,11 +1889,21 @@ void GroupCell::BreakLines()
     m_output->RecalculateList((*m_configuration)->GetMathFontSize());
   }
 
+  BreakLinesFrom(cell);
+  m_output->ResetDataList();
+  ResetCellListSizes();
+}
+
+void GroupCell::BreakLinesFrom(Cell *start)
+{
+  Cell *const cell = m_output.get();
+  if(!cell || !start)
+    return;
 
   // 3rd step: Determine a sane maximum line width
   int fullWidth = (*m_configuration)->GetClientWidth();
   Configuration *configuration = (*m_configuration);
-  int currentWidth = GetLineIndent(cell);
+  int currentWidth = GetLineIndent(start);
   if((cell->GetStyle() != TS_LABEL) && (cell->GetStyle() != TS_USERLABEL))
     fullWidth -= configuration->GetIndent();
 
@@ -1632,7 +1916,7 @@ void GroupCell::BreakLines()
   //4th step: break the output into lines.
   if (!IsHidden()) {
     bool prevBroken = false;
-    for (Cell &tmp : OnDrawList(cell))
+    for (Cell &tmp : OnDrawList(start))
     {
       if (prevBroken) {
         currentWidth += GetLineIndent(&tmp);
@@ -1649,8 +1933,6 @@ void GroupCell::BreakLines()
       currentWidth += cellWidth;
     }
   }
-  m_output->ResetDataList();
-  ResetCellListSizes();
 }
 
 Cell::Range GroupCell::GetCellsInOutput() const
@@ -32,6 +32,7 @@
 
 #include "Cell.h"
 #include "EditorCell.h"
+#include "Profiler.h"
 
 //! All types a GroupCell can be of
 // This enum's elements must be synchronized with (WXMFormat.h) WXMHeaderId.
@@ -131,8 +132,25 @@ public:
   // cppcheck-suppress functionConst
   bool SetEditableContent(const wxString &text);
 
+  /*! Append cells to the output of this GroupCell
+
+    Appending is cheap: The end of the output is remembered and, if the new cells
+    start a new line, the next Recalculate() only lays out the new lines.
+  */
   void AppendOutput(std::unique_ptr<Cell> &&cell);
 
+  /*! Discard the oldest lines of output
+
+    Allows output that scrolls by (for example progress messages) to use a bounded
+    amount of memory. A notice that output has been discarded is placed at the
+    beginning of the output.
+    \returns The number of lines that have been discarded. The notice isn't
+    counted as a line of output.
+  */
+  int DiscardOldestOutput(int lines);
+  //! The number of lines of output, not counting the notice that older output has been discarded
+  int GetOutputLineCount() const { return m_outputLines; }
+
   /*! Remove all output cells attached to this one
 
     If called on an image cell it will not remove the image attached to it (even if the image
@@ -158,6 +176,7 @@ public:
   wxString ToTeX(wxString imgDir, wxString filename, int *imgCounter) const;
 
   wxString ToRTF() const override;
+  void AppendRTF(wxString &out) const override;
 
   wxString ToTeXCodeCell(wxString imgDir, wxString filename, int *imgCounter) const;
 
@@ -166,6 +185,7 @@ public:
   wxString ToTeX() const override;
 
   wxString ToXML() const override;
+  void AppendXML(wxString &out) const override;
 
   void Hide(bool hide) override;
 
@@ -228,6 +248,12 @@ public:
    */
   void RecalculateOutput();
 
+  /*! Lay out the output lines that have been appended since the last recalculation
+
+    Used instead of RecalculateOutput() if the rest of the output hasn't changed.
+   */
+  void RecalculateAppended();
+
   /*! Attempt to split math objects that are wider than the screen into multiple lines.
     
     \retval true, if this action has changed the height of cells.
@@ -240,6 +266,9 @@ public:
   //! Break this cell into lines
   void BreakLines();
 
+  //! Break the output into lines, starting with cell start that begins a line.
+  void BreakLinesFrom(Cell *start);
+
   /*! Reset the input label of the current cell.
 
     Won't do nothing if the cell isn't a code cell and therefore isn't equipped
@@ -341,6 +370,24 @@ public:
   //! Draw the bracket of this cell
   void DrawBracket();
 
+  //! The time this cell has cost while the profiler was recording
+  const Profiler::CellCosts &GetCosts() const { return m_costs; }
+  /*! Adds to the time this cell has cost
+
+    \returns The new total cost of this cell, in µs
+  */
+  std::int64_t AddCost(Profiler::CellCost cost, std::int64_t microseconds);
+  //! Forgets the time this cell has cost
+  void ClearCosts() { m_costs = {}; }
+  /*! Has the colour of the cost gutter changed since the last call?
+
+    The colour changes in steps. If it has changed the gutter needs to be
+    redrawn, which GetCostGutterRect() tells the location of.
+   */
+  bool CostGutterChanged();
+  //! Where DrawCostGutter() draws the bar that tells how expensive this cell is
+  wxRect GetCostGutterRect() const;
+
   //! Is this list of cells empty?
   bool Empty() const;
 
@@ -349,6 +396,7 @@ public:
 
   //! A textual representation of this cell
   wxString ToString() const override;
+  void AppendString(wxString &out) const override;
 
   //! Is this cell part of the evaluation Queue?
   void InEvaluationQueue(bool inQueue) { m_inEvaluationQueue = inQueue; }
@@ -383,9 +431,24 @@ public:
 
 protected:
   bool NeedsRecalculation(AFontSize fontSize) const override;
+  bool HasEstimatedSize() const override;
+  bool HasEstimatedSizeIn(const wxRect &rect) const override;
   int GetInputIndent();
   int GetLineIndent(Cell *cell);
   void UpdateCellsInGroup();
+  /*! Add the heights of the output lines beginning at start to m_outputRect
+
+    \returns The width of the widest of these lines
+   */
+  int AddOutputLineHeights(Cell *start);
+  //! Draws a bar left of the bracket whose color tells how expensive this cell is
+  void DrawCostGutter();
+  //! The step of the colour scale the cost gutter is drawn with; -1 = not drawn
+  int CostColourStep() const;
+
+//** Large objects (32 bytes)
+//**
+  Profiler::CellCosts m_costs;
 
 //** 16-byte objects (16 bytes)
 //**
@@ -407,13 +470,24 @@ protected:
   std::unique_ptr<Cell> m_output;
   // The pointers above point to inner cells and must be kept contiguous.
 
+  //! The last cell of m_output
+  CellPtr<Cell> m_lastInOutput;
+  //! The notice DiscardOldestOutput() has put in front of the output
+  CellPtr<Cell> m_discardNotice;
+  //! The first output cell that has been appended since the output was laid out
+  CellPtr<Cell> m_firstAppendedOutput;
+
 //** 4-byte objects (16 bytes)
 //**
   int m_labelWidth_cached = 0;
   int m_inputWidth, m_inputHeight;
+  //! The number of lines of output, see GetOutputLineCount()
+  int m_outputLines = 0;
 private:
   //! The client width at the time of the last recalculation.
   int m_clientWidth_old = -1;
+  //! The colour step of the cost gutter CostGutterChanged() has last seen
+  int m_costColourStep = -1;
 
 protected:
 //** 2-byte objects (6 bytes)
@@ -440,6 +514,7 @@ protected:
     m_updateConfusableCharWarnings = true;
     m_suppressTooltipMarker = false;
     m_cellsAppended = false;
+    m_outputHasEstimatedSize = false;
   }
 
   //! Does this GroupCell automatically fill in the answer to questions?
@@ -450,6 +525,8 @@ protected:
   //! Suppress the yellow ToolTip marker?
   bool m_suppressTooltipMarker : 1 /* InitBitFields */;
   bool m_cellsAppended : 1; /* InitBitFields */
+  //! Has the size of any of our output cells only been estimated?
+  bool m_outputHasEstimatedSize : 1; /* InitBitFields */
 
   static wxString m_lookalikeChars;
 };
@@ -87,6 +87,16 @@ ImgCell::ImgCell(GroupCell *group, Configuration **config, const wxString &image
   m_drawBoundingBox = false;
 }
 
+ImgCell::ImgCell(GroupCell *group, Configuration **config, const Image::FileContents &file)
+  : ImgCellBase(group, config),
+    m_image(std::make_shared<Image>(m_configuration, file)),
+    m_imageBorderWidth(1)
+{
+  InitBitFields();
+  m_type = MC_TYPE_IMAGE;
+  m_drawBoundingBox = false;
+}
+
 void ImgCell::SetConfiguration(Configuration **config)
 {
   m_configuration = config;
@@ -37,6 +37,8 @@ public:
   ImgCell(GroupCell *group, Configuration **config);
   ImgCell(GroupCell *group, Configuration **config, const wxMemoryBuffer &image, const wxString &type);
   ImgCell(GroupCell *group, Configuration **config, const wxString &image, std::shared_ptr<wxFileSystem> filesystem, bool remove = true);
+  //! Displays the contents of a file Image::ReadFile() has read
+  ImgCell(GroupCell *group, Configuration **config, const Image::FileContents &file);
 
   ImgCell(GroupCell *group, Configuration **config, const wxBitmap &bitmap);
   ImgCell(GroupCell *group, const ImgCell &cell);
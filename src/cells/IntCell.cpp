@@ -297,27 +297,27 @@ void IntCell::Draw(wxPoint point)
 
 wxString IntCell::ToString() const
 {
-  wxString s = wxT("integrate(");
-
-  s += m_base->ListToString();
+  wxString s;
+  AppendString(s);
+  return s;
+}
 
-  Cell *tmp = m_var.get();
-  wxString var;
-  tmp = tmp->GetNext();
-  if (tmp != NULL)
+void IntCell::AppendString(wxString &out) const
+{
+  out += wxT("integrate(");
+  m_base->ListAppendString(out);
+  out += wxT(",");
+  Cell *var = m_var->GetNext();
+  if (var != NULL)
+    var->ListAppendString(out);
+  if (m_intStyle == INT_DEF)
   {
-    var = tmp->ListToString();
+    out += wxT(",");
+    m_under->ListAppendString(out);
+    out += wxT(",");
+    m_over->ListAppendString(out);
   }
-
-  wxString to = m_over->ListToString();
-  wxString from = m_under->ListToString();
-
-  s += wxT(",") + var;
-  if (m_intStyle == INT_DEF)
-    s += wxT(",") + from + wxT(",") + to;
-
-  s += wxT(")");
-  return s;
+  out += wxT(")");
 }
 
 wxString IntCell::ToMatlab() const
@@ -345,110 +345,148 @@ wxString IntCell::ToMatlab() const
 
 wxString IntCell::ToTeX() const
 {
-  wxString s = wxT("\\int");
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
 
-  wxString to = m_over->ListToTeX();
-  wxString from = m_under->ListToTeX();
+void IntCell::AppendTeX(wxString &out) const
+{
+  out += wxT("\\int");
 
   if (m_intStyle == INT_DEF)
-    s += wxT("_{") + from + wxT("}^{") + to + wxT("}");
+  {
+    out += wxT("_{");
+    m_under->ListAppendTeX(out);
+    out += wxT("}^{");
+    m_over->ListAppendTeX(out);
+    out += wxT("}");
+  }
   else
-    s += wxT(" ");
+    out += wxT(" ");
 
-  s += wxT("{\\left. ");
-  s += m_base->ListToTeX();
-  s += m_var->ListToTeX();
-  s += wxT("\\right.}");
-
-  return s;
+  out += wxT("{\\left. ");
+  m_base->ListAppendTeX(out);
+  m_var->ListAppendTeX(out);
+  out += wxT("\\right.}");
 }
 
 wxString IntCell::ToMathML() const
 {
-  wxString base = m_base->ListToMathML();
-
-  wxString var;
-  if (m_var) var = m_var->ListToMathML();
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
 
+void IntCell::AppendMathML(wxString &out) const
+{
+  // The limits are short => we can afford to convert them before we know
+  // where to put them.
   wxString from;
   if (m_under) from = m_under->ListToMathML();
 
   wxString to;
   if (m_over) to = m_over->ListToMathML();
 
-  wxString retval;
+  out += wxT("<mrow>");
   if (from.IsEmpty() && to.IsEmpty())
-    retval = wxT("<mo>&#x222B;</mo>") + base;
+    out += wxT("<mo>&#x222B;</mo>");
   if (from.IsEmpty() && !to.IsEmpty())
-    retval = wxT("<mover><mo>&#x222B;</mo>") + to + wxT("</mover>") + base;
+  {
+    out += wxT("<mover><mo>&#x222B;</mo>");
+    out += to;
+    out += wxT("</mover>");
+  }
   if (!from.IsEmpty() && to.IsEmpty())
-    retval = wxT("<munder><mo>&#x222B;</mo>") + from + wxT("</munder>") + base;
+  {
+    out += wxT("<munder><mo>&#x222B;</mo>");
+    out += from;
+    out += wxT("</munder>");
+  }
   if (!from.IsEmpty() && !to.IsEmpty())
-    retval = wxT("<munderover><mo>&#x222B;</mo>") + from + to + wxT("</munderover>\n") + base;
-  if (!var.IsEmpty())
-    retval = retval + var;
-
-  return (wxT("<mrow>") + retval + wxT("</mrow>"));
+  {
+    out += wxT("<munderover><mo>&#x222B;</mo>");
+    out += from;
+    out += to;
+    out += wxT("</munderover>\n");
+  }
+  m_base->ListAppendMathML(out);
+  if (m_var)
+    m_var->ListAppendMathML(out);
+  out += wxT("</mrow>");
 }
 
 wxString IntCell::ToOMML() const
 {
-  wxString base = m_base->ListToOMML();
-
-  wxString var;
-  if (m_var) var = m_var->ListToOMML();
-
-  wxString from;
-  if (m_under) from = m_under->ListToOMML();
-
-  wxString to;
-  if (m_over) to = m_over->ListToOMML();
-
-  wxString retval;
-
-  retval = wxT("<m:nary><m:naryPr><m:chr>\u222b</m:chr></m:naryPr>");
-  if (from != wxEmptyString)
-    retval += wxT("<m:sub>") + from + wxT("</m:sub>");
-  if (to != wxEmptyString)
-    retval += wxT("<m:sup>") + to + wxT("</m:sup>");
-  retval += wxT("<m:e><m:r>") + base + var + wxT("</m:r></m:e></m:nary>");
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
 
-  return retval;
+void IntCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:nary><m:naryPr><m:chr>\u222b</m:chr></m:naryPr>");
+  if (m_under)
+  {
+    wxString const from = m_under->ListToOMML();
+    if (from != wxEmptyString)
+    {
+      out += wxT("<m:sub>");
+      out += from;
+      out += wxT("</m:sub>");
+    }
+  }
+  if (m_over)
+  {
+    wxString const to = m_over->ListToOMML();
+    if (to != wxEmptyString)
+    {
+      out += wxT("<m:sup>");
+      out += to;
+      out += wxT("</m:sup>");
+    }
+  }
+  out += wxT("<m:e><m:r>");
+  m_base->ListAppendOMML(out);
+  if (m_var)
+    m_var->ListAppendOMML(out);
+  out += wxT("</m:r></m:e></m:nary>");
 }
 
 wxString IntCell::ToXML() const
 {
-  wxString from;
-  if (m_under != NULL)
-    from = m_under->ListToXML();
-  from = wxT("<r>") + from + wxT("</r>");
-
-  wxString to;
-  if (m_over != NULL)
-    to = m_over->ListToXML();
-  to = wxT("<r>") + to + wxT("</r>");
-
-  wxString base;
-  if (m_base != NULL)
-    base = m_base->ListToXML();
-  base = wxT("<r>") + base + wxT("</r>");
-
-  wxString var;
-  if (m_var != NULL)
-    var = m_var->ListToXML();
-  var = wxT("<r>") + var + wxT("</r>");
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
 
-  wxString flags;
+void IntCell::AppendXML(wxString &out) const
+{
+  out += wxT("<in");
   if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
-
+    out += wxT(" breakline=\"true\"");
   if (m_intStyle != INT_DEF)
+    out += wxT(" def=\"false\">");
+  out += wxT(">");
+
+  if (m_intStyle == INT_DEF)
   {
-    flags += wxT(" def=\"false\">");
-    return wxT("<in") + flags + wxT(">") + base + var + wxT("</in>");
+    out += wxT("<r>");
+    if (m_under != NULL)
+      m_under->ListAppendXML(out);
+    out += wxT("</r><r>");
+    if (m_over != NULL)
+      m_over->ListAppendXML(out);
+    out += wxT("</r>");
   }
-  else
-    return wxT("<in") + flags + wxT(">") + from + to + base + var + wxT("</in>");
+
+  out += wxT("<r>");
+  if (m_base != NULL)
+    m_base->ListAppendXML(out);
+  out += wxT("</r><r>");
+  if (m_var != NULL)
+    m_var->ListAppendXML(out);
+  out += wxT("</r></in>");
 }
 
 bool IntCell::BreakUp()
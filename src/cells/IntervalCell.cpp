@@ -227,16 +227,21 @@ void IntervalCell::DrawBigRightOpenBracket(wxDC *dc, wxPoint point)
 wxString IntervalCell::ToString() const
 {
   wxString s;
-  
-  if (!IsBrokenIntoLines())
-      s = wxT("interval(") +
-        m_start->ListToString() +
-        wxT(",") +
-        m_stop->ListToString() +
-        wxT(")");
+  AppendString(s);
   return s;
 }
 
+void IntervalCell::AppendString(wxString &out) const
+{
+  if (IsBrokenIntoLines())
+    return;
+  out += wxT("interval(");
+  m_start->ListAppendString(out);
+  out += wxT(",");
+  m_stop->ListAppendString(out);
+  out += wxT(")");
+}
+
 wxString IntervalCell::ToMatlab() const
 {
   wxString s;
@@ -251,64 +256,88 @@ wxString IntervalCell::ToMatlab() const
 
 wxString IntervalCell::ToTeX() const
 {
-  wxString s;
-  if (!IsBrokenIntoLines())
-  {
-    s = wxT("\\left[ ") +
-      m_start->ListToTeX() +
-      "\\ldots " +
-      m_stop->ListToTeX() +
-      wxT("\\right] ");
-  }
-  return s;
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void IntervalCell::AppendTeX(wxString &out) const
+{
+  if (IsBrokenIntoLines())
+    return;
+  out += wxT("\\left[ ");
+  m_start->ListAppendTeX(out);
+  out += wxT("\\ldots ");
+  m_stop->ListAppendTeX(out);
+  out += wxT("\\right] ");
 }
 
 wxString IntervalCell::ToOMML() const
 {
-  wxString open = m_openBracket->ToString();
-  wxString close = m_closeBracket->ToString();
-  wxString retval = wxString(wxT("<m:d>")) +
-    wxT("<m:dPr m:begChr=\"") + open + wxT("\" m:endChr=\"") +close + wxT("]\" m:grow=\"1\"></m:dPr>") +
-    wxT("<m:e>") + m_start->ListToOMML() + wxT("\u2026") + m_stop->ListToOMML() + wxT("</m:e>") +
-    wxT("</m:d>");
-  return retval;
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void IntervalCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:d><m:dPr m:begChr=\"");
+  out += m_openBracket->ToString();
+  out += wxT("\" m:endChr=\"");
+  out += m_closeBracket->ToString();
+  out += wxT("]\" m:grow=\"1\"></m:dPr><m:e>");
+  m_start->ListAppendOMML(out);
+  out += wxT("\u2026");
+  m_stop->ListAppendOMML(out);
+  out += wxT("</m:e></m:d>");
 }
 
 wxString IntervalCell::ToMathML() const
 {
-  wxString open = m_openBracket->ToString();
-  wxString close = m_closeBracket->ToString();
-  wxString retval = wxString(wxT("<mrow>")) +
-    wxT("<mo>")+open+wxT("</mo>") +
-    m_start->ListToMathML() +
-    wxT(",") +
-    m_stop->ListToMathML() +
-    wxT("<mo>") + close + wxT("</mo>") +
-    wxT("</mrow>\n");
-  
-  return (retval);
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void IntervalCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<mrow><mo>");
+  out += m_openBracket->ToString();
+  out += wxT("</mo>");
+  m_start->ListAppendMathML(out);
+  out += wxT(",");
+  m_stop->ListAppendMathML(out);
+  out += wxT("<mo>");
+  out += m_closeBracket->ToString();
+  out += wxT("</mo></mrow>\n");
 }
 
 wxString IntervalCell::ToXML() const
 {
-  wxString flags = wxT(" interval=\"true\"");
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void IntervalCell::AppendXML(wxString &out) const
+{
+  out += wxT("<fn interval=\"true\"");
   if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
+    out += wxT(" breakline=\"true\"");
   if (m_leftBracketOpensLeft)
-    flags += wxT(" leftBracketOpensLeft=\"true\"");
+    out += wxT(" leftBracketOpensLeft=\"true\"");
   else
-    flags += wxT(" leftBracketOpensLeft=\"false\"");
+    out += wxT(" leftBracketOpensLeft=\"false\"");
   if (m_rightBracketOpensRight)
-    flags += wxT(" rightBracketOpensRight=\"true\"");
+    out += wxT(" rightBracketOpensRight=\"true\"");
   else
-    flags += wxT(" rightBracketOpensRight=\"false\"");
+    out += wxT(" rightBracketOpensRight=\"false\"");
 
-  return wxT("<fn") + flags + wxT("><fnm>interval</fnm>") +
-    wxT("<r><p><r>") +
-    m_start->ListToMathML() +
-    wxT("</r><r>,</r><r>") +
-    m_stop->ListToMathML() +
-    wxT("</r></p></r>") + wxT("</fn>");
+  out += wxT("><fnm>interval</fnm><r><p><r>");
+  m_start->ListAppendMathML(out);
+  out += wxT("</r><r>,</r><r>");
+  m_stop->ListAppendMathML(out);
+  out += wxT("</r></p></r></fn>");
 }
 
 bool IntervalCell::BreakUp()
@@ -119,9 +119,16 @@ void LimitCell::Draw(wxPoint point)
 
 wxString LimitCell::ToString() const
 {
-  wxString s(wxT("limit"));
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void LimitCell::AppendString(wxString &out) const
+{
+  // The variable and the limit are short => we can afford to split them as
+  // strings. The expression is appended to out directly.
   wxString under = m_under->ListToString();
-  wxString base = m_base->ListToString();
   wxString var = under.SubString(0, under.Find(wxT("->")) - 1);
   wxString to = under.SubString(under.Find(wxT("->")) + 2,
 								under.Length() - 1);
@@ -130,8 +137,13 @@ wxString LimitCell::ToString() const
   if (to.Right(1) == wxT("-"))
 	to = to.Left(to.Length() - 1) + wxT(",minus");
 
-  s += wxT("(") + base + wxT(",") + var + wxT(",") + to + wxT(")");
-  return s;
+  out += wxT("limit(");
+  m_base->ListAppendString(out);
+  out += wxT(",");
+  out += var;
+  out += wxT(",");
+  out += to;
+  out += wxT(")");
 }
 
 wxString LimitCell::ToMatlab() const
@@ -153,8 +165,15 @@ wxString LimitCell::ToMatlab() const
 
 wxString LimitCell::ToTeX() const
 {
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void LimitCell::AppendTeX(wxString &out) const
+{
+  // See AppendString()
   wxString under = m_under->ListToTeX();
-  wxString base = m_base->ListToTeX();
   int varEnd = under.Find(wxT("->"));
   int toStart = 0;
   if(varEnd == wxNOT_FOUND)
@@ -171,48 +190,79 @@ wxString LimitCell::ToTeX() const
     toStart = varEnd + 2;
     varEnd -= 1;
   }
-                          
-  wxString var = under.SubString(0, varEnd);
-  wxString to = under.SubString(toStart,
-                                under.Length() - 1);
-  wxString s = wxT("\\lim_{") + var + wxT("\\to ") + to + wxT("}{") + base + wxT("}");
-  return s;
+
+  out += wxT("\\lim_{");
+  out += under.SubString(0, varEnd);
+  out += wxT("\\to ");
+  out += under.SubString(toStart, under.Length() - 1);
+  out += wxT("}{");
+  m_base->ListAppendTeX(out);
+  out += wxT("}");
 }
 
 wxString LimitCell::ToMathML() const
 {
-  wxString base = m_base->ListToMathML();
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
 
+void LimitCell::AppendMathML(wxString &out) const
+{
   wxString from;
   if (m_under) from = m_under->ListToMathML();
 
-  wxString retval;
   if (from.IsEmpty())
-    retval = wxT("<mo>lim</mo>") + base;
+  {
+    out += wxT("<mo>lim</mo>");
+    m_base->ListAppendMathML(out);
+  }
   else
-    retval = wxT("<munder><mo>lim</mo>") + from + wxT("</munder>\n");
-  return (retval);
+  {
+    out += wxT("<munder><mo>lim</mo>");
+    out += from;
+    out += wxT("</munder>\n");
+  }
 }
 
 wxString LimitCell::ToXML() const
 {
-  wxString flags;
-  if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
 
-  return _T("<lm") + flags + wxT("><r>") + m_name->ListToXML() + _T("</r><r>") +
-         m_under->ListToXML() + _T("</r><r>") +
-         m_base->ListToXML() + _T("</r></lm>");
+void LimitCell::AppendXML(wxString &out) const
+{
+  out += wxT("<lm");
+  if (HasHardLineBreak())
+    out += wxT(" breakline=\"true\"");
+  out += wxT("><r>");
+  m_name->ListAppendXML(out);
+  out += wxT("</r><r>");
+  m_under->ListAppendXML(out);
+  out += wxT("</r><r>");
+  m_base->ListAppendXML(out);
+  out += wxT("</r></lm>");
 }
 
 wxString LimitCell::ToOMML() const
+{
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void LimitCell::AppendOMML(wxString &out) const
 {
   wxString under = m_under->ListToOMML();
   under.Replace(wxT("->"), wxT("\u2192"));
 
-  return _T("<m:func><m:fName><m:limLow><m:e><m:r>lim</m:r></m:e><m:lim>") +
-         under + _T("</m:lim></m:limLow></m:fName><m:e>") +
-         m_base->ListToOMML() + _T("</m:e></m:func>");
+  out += wxT("<m:func><m:fName><m:limLow><m:e><m:r>lim</m:r></m:e><m:lim>");
+  out += under;
+  out += wxT("</m:lim></m:limLow></m:fName><m:e>");
+  m_base->ListAppendOMML(out);
+  out += wxT("</m:e></m:func>");
 }
 
 bool LimitCell::BreakUp()
@@ -164,12 +164,24 @@ void ListCell::Draw(wxPoint point)
 wxString ListCell::ToString() const
 {
   wxString s;
+  AppendString(s);
+  return s;
+}
+
+void ListCell::AppendString(wxString &out) const
+{
   if(!m_innerCell)
-    return "[]";
-  
+  {
+    out += wxT("[]");
+    return;
+  }
+
   if (!IsBrokenIntoLines())
-      s = wxT("[") + m_innerCell->ListToString() + wxT("]");
-  return s;
+  {
+    out += wxT("[");
+    m_innerCell->ListAppendString(out);
+    out += wxT("]");
+  }
 }
 
 wxString ListCell::ToMatlab() const
@@ -182,54 +194,70 @@ wxString ListCell::ToMatlab() const
 
 wxString ListCell::ToTeX() const
 {
-  wxString s;
-  if (!IsBrokenIntoLines())
-  {
-    wxString innerCell = m_innerCell->ListToTeX();
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
 
-    // Let's see if the cell contains anything potentially higher than a normal
-    // character.
-    bool needsLeftRight = false;
-    for (size_t i = 0; i < innerCell.Length(); i++)
-      if (!wxIsalnum(innerCell[i]))
-      {
-        needsLeftRight = true;
-        break;
-      }
-    
-    if (needsLeftRight)
-      s = wxT("\\left[ ") + m_innerCell->ListToTeX() + wxT("\\right] ");
-    else
-      s = wxT("[") + m_innerCell->ListToTeX() + wxT("]");
-  }
-  return s;
+void ListCell::AppendTeX(wxString &out) const
+{
+  if (IsBrokenIntoLines())
+    return;
+
+  AppendTeXInDelimiters(out, m_innerCell.get(), wxT("["), wxT("]"));
 }
 
 wxString ListCell::ToOMML() const
 {
-  return wxT("<m:d><m:dPr m:begChr=\"") + XMLescape(m_open->ToString()) + wxT("\" m:endChr=\"") +
-         XMLescape(m_close->ToString()) + wxT("\" m:grow=\"1\"></m:dPr><m:e>") +
-         m_innerCell->ListToOMML() + wxT("</m:e></m:d>");
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void ListCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:d><m:dPr m:begChr=\"");
+  out += XMLescape(m_open->ToString());
+  out += wxT("\" m:endChr=\"");
+  out += XMLescape(m_close->ToString());
+  out += wxT("\" m:grow=\"1\"></m:dPr><m:e>");
+  m_innerCell->ListAppendOMML(out);
+  out += wxT("</m:e></m:d>");
 }
 
 wxString ListCell::ToMathML() const
 {
-  wxString open = m_open->ToString();
-  wxString close = m_close->ToString();
-  return (
-          wxT("<mrow><mo>") + XMLescape(open) + wxT("</mo>") +
-          m_innerCell->ListToMathML() +
-          wxT("<mo>") + XMLescape(close) + wxT("</mo></mrow>\n")
-  );
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void ListCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<mrow><mo>");
+  out += XMLescape(m_open->ToString());
+  out += wxT("</mo>");
+  m_innerCell->ListAppendMathML(out);
+  out += wxT("<mo>");
+  out += XMLescape(m_close->ToString());
+  out += wxT("</mo></mrow>\n");
 }
 
 wxString ListCell::ToXML() const
 {
-  wxString s = m_innerCell->ListToXML();
-  wxString flags;
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void ListCell::AppendXML(wxString &out) const
+{
+  out += wxT("<r list=\"true\"");
   if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
-  return (wxT("<r list=\"true\"") + flags + wxT("><t listdelim=\"true\">[</t>") + s + wxT("<t listdelim=\"true\">]</t></r>"));
+    out += wxT(" breakline=\"true\"");
+  out += wxT("><t listdelim=\"true\">[</t>");
+  m_innerCell->ListAppendXML(out);
+  out += wxT("<t listdelim=\"true\">]</t></r>");
 }
 
 bool ListCell::BreakUp()
@@ -65,11 +65,16 @@ public:
   bool BreakUp() override;
 
   wxString ToMathML() const override;
+  void AppendMathML(wxString &out) const override;
   virtual wxString ToMatlab() const override;
   wxString ToOMML() const override;
+  void AppendOMML(wxString &out) const override;
   virtual wxString ToString() const override;
+  virtual void AppendString(wxString &out) const override;
   virtual wxString ToTeX() const override;
+  virtual void AppendTeX(wxString &out) const override;
   virtual wxString ToXML() const override;
+  virtual void AppendXML(wxString &out) const override;
 
   void SetNextToDraw(Cell *next) override;
 
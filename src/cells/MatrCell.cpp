@@ -30,6 +30,7 @@
 #define wxNO_UNSAFE_WXSTRING_CONV 1
 #include "MatrCell.h"
 #include "CellImpl.h"
+#include <algorithm>
 
 MatrCell::MatrCell(GroupCell *group, Configuration **config) :
     Cell(group, config)
@@ -64,38 +65,66 @@ DEFINE_CELL(MatrCell)
 void MatrCell::Recalculate(AFontSize const fontsize)
 {
   AFontSize const fontsize_entry{ MC_MIN_SIZE, fontsize - 2 };
+  m_widths.resize(m_matWidth, -1);
+  m_dropCenters.resize(m_matHeight, {-1, -1});
+
+  // Only the entries whose size isn't valid any more need to be laid out
+  // again - and only their row and column need to be measured again. A cell
+  // nested deep inside an entry (for example a long number after the number
+  // of displayed digits has changed) invalidates its entry, too. If the
+  // matrix itself needs to be recalculated, everything does.
+  bool const recalculateAll = NeedsRecalculation(fontsize);
   for (unsigned int i = 0; i < m_cells.size(); i++)
+  {
+    if (!recalculateAll && !m_cells[i]->ListNeedsRecalculationDeep(fontsize_entry))
+      continue;
+
     m_cells[i]->RecalculateList(fontsize_entry);
+    if (m_matWidth > 0)
+    {
+      m_widths[i % m_matWidth] = -1;
+      if (i / m_matWidth < m_matHeight)
+        m_dropCenters[i / m_matWidth] = {-1, -1};
+    }
+  }
 
   m_width = 0;
-  m_widths.clear();
+  m_columnPositions.resize(m_matWidth);
   for (unsigned int i = 0; i < m_matWidth; i++)
   {
-    int width = 0;
-    for (unsigned int j = 0; j < m_matHeight; j++)
+    if (m_widths[i] < 0)
     {
-      if((m_matWidth * j + i)<m_cells.size())
-        width = wxMax(width, m_cells[m_matWidth * j + i]->GetFullWidth());
+      int width = 0;
+      for (unsigned int j = 0; j < m_matHeight; j++)
+      {
+        if((m_matWidth * j + i)<m_cells.size())
+          width = wxMax(width, m_cells[m_matWidth * j + i]->GetFullWidth());
+      }
+      m_widths[i] = width;
     }
-    m_widths.emplace_back(width);
-    m_width += (width + Scale_Px(10));
+    m_columnPositions[i] = m_width;
+    m_width += (m_widths[i] + Scale_Px(10));
   }
   if (m_width < Scale_Px(14))
     m_width = Scale_Px(14);
 
   m_height = 0;
-  m_dropCenters.clear();
+  m_rowPositions.resize(m_matHeight);
   for (unsigned int i = 0; i < m_matHeight; i++)
   {
-    int center = 0, drop = 0;
-    for (unsigned int j = 0; j < m_matWidth; j++)
-      if(m_matWidth * i + j < m_cells.size())
-      {
-        center = wxMax(center, m_cells[m_matWidth * i + j]->GetCenterList());
-        drop = wxMax(drop, m_cells[m_matWidth * i + j]->GetMaxDrop());
-      }
-    m_dropCenters.emplace_back(drop, center);
-    m_height += (center + drop + Scale_Px(10));
+    if (m_dropCenters[i].drop < 0)
+    {
+      int center = 0, drop = 0;
+      for (unsigned int j = 0; j < m_matWidth; j++)
+        if(m_matWidth * i + j < m_cells.size())
+        {
+          center = wxMax(center, m_cells[m_matWidth * i + j]->GetCenterList());
+          drop = wxMax(drop, m_cells[m_matWidth * i + j]->GetMaxDrop());
+        }
+      m_dropCenters[i] = {drop, center};
+    }
+    m_rowPositions[i] = m_height;
+    m_height += (m_dropCenters[i].Sum() + Scale_Px(10));
   }
   if (m_height == 0)
     m_height = fontsize + Scale_Px(10);
@@ -112,24 +141,39 @@ void MatrCell::Draw(wxPoint point)
   {
     Configuration *configuration = (*m_configuration);
     wxDC *dc = configuration->GetDC();
-    wxPoint mp;
-    mp.x = point.x + Scale_Px(5);
-    mp.y = point.y - m_center;
-    for (unsigned int i = 0; i < m_matWidth; i++)
+    wxPoint const topLeft(point.x + Scale_Px(5), point.y - m_center + Scale_Px(5));
+
+    // Only the rows and columns that intersect the update region are drawn.
+    unsigned int firstColumn = 0, lastColumn = m_columnPositions.size();
+    unsigned int firstRow = 0, lastRow = m_rowPositions.size();
+    if (configuration->ClipToDrawRegion())
     {
-      mp.y = point.y - m_center + Scale_Px(5);
-      for (unsigned int j = 0; j < m_matHeight; j++)
+      wxRect const updateRegion = configuration->GetUpdateRegion();
+      auto const firstVisible = [](const std::vector<int> &positions, int start) -> unsigned int {
+        auto const pos = std::upper_bound(positions.begin(), positions.end(), start);
+        return (pos == positions.begin()) ? 0 : (pos - positions.begin() - 1);
+      };
+      auto const lastVisible = [](const std::vector<int> &positions, int end) -> unsigned int {
+        return std::upper_bound(positions.begin(), positions.end(), end) - positions.begin();
+      };
+      firstColumn = firstVisible(m_columnPositions, updateRegion.GetLeft() - topLeft.x);
+      lastColumn = lastVisible(m_columnPositions, updateRegion.GetRight() - topLeft.x);
+      firstRow = firstVisible(m_rowPositions, updateRegion.GetTop() - topLeft.y);
+      lastRow = lastVisible(m_rowPositions, updateRegion.GetBottom() - topLeft.y);
+    }
+
+    for (unsigned int i = firstColumn; i < lastColumn; i++)
+    {
+      for (unsigned int j = firstRow; j < lastRow; j++)
       {
         if((j * m_matWidth + i) < m_cells.size())
-          {
-            mp.y += m_dropCenters[j].center;
-            wxPoint mp1(mp);
-            mp1.x = mp.x + (m_widths[i] - m_cells[j * m_matWidth + i]->GetFullWidth()) / 2;
-            m_cells[j * m_matWidth + i]->DrawList(mp1);
-            mp.y += (m_dropCenters[j].drop + Scale_Px(10));
-          }
+        {
+          Cell *const entry = m_cells[j * m_matWidth + i].get();
+          entry->DrawList(wxPoint(topLeft.x + m_columnPositions[i] +
+                                  (m_widths[i] - entry->GetFullWidth()) / 2,
+                                  topLeft.y + m_rowPositions[j] + m_dropCenters[j].center));
+        }
       }
-      mp.x += (m_widths[i] + Scale_Px(10));
     }
     SetPen(1.5);
     if (m_specialMatrix)
@@ -300,23 +344,29 @@ void MatrCell::AddNewCell(std::unique_ptr<Cell> &&cell)
 
 wxString MatrCell::ToString() const
 {
-  wxString s = wxT("matrix(\n");
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void MatrCell::AppendString(wxString &out) const
+{
+  out += wxT("matrix(\n");
   for (unsigned int i = 0; i < m_matHeight; i++)
   {
-    s += wxT("\t\t[");
+    out += wxT("\t\t[");
     for (unsigned int j = 0; j < m_matWidth; j++)
     {
-	  s += m_cells[i * m_matWidth + j]->ListToString();
+      m_cells[i * m_matWidth + j]->ListAppendString(out);
       if (j < m_matWidth - 1)
-        s += wxT(",\t");
+        out += wxT(",\t");
     }
-    s += wxT("]");
+    out += wxT("]");
     if (i < m_matHeight - 1)
-      s += wxT(",");
-    s += wxT("\n");
+      out += wxT(",");
+    out += wxT("\n");
   }
-  s += wxT("\t)");
-  return s;
+  out += wxT("\t)");
 }
 
 wxString MatrCell::ToMatlab() const
@@ -344,119 +394,147 @@ wxString MatrCell::ToMatlab() const
 
 wxString MatrCell::ToTeX() const
 {
-  //ToDo: We ignore colNames and rowNames here. Are they currently in use?
-  wxString s;
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
 
+void MatrCell::AppendTeX(wxString &out) const
+{
+  //ToDo: We ignore colNames and rowNames here. Are they currently in use?
   if (!m_specialMatrix)
   {
     switch(m_parenType)
     {
     case paren_rounded:
-      s = wxT("\\begin{pmatrix}");
+      out += wxT("\\begin{pmatrix}");
       break;
     case   paren_brackets:
     case paren_angled:
     case paren_straight:
-      s = wxT("\\begin{bmatrix}");
+      out += wxT("\\begin{bmatrix}");
       break;
     }
   }
   else
   {
-    s = wxT("\\begin{array}{");
+    out += wxT("\\begin{array}{");
     for (unsigned int j = 0; j < m_matWidth; j++)
-      s += wxT("c");
-    s += wxT("}");
+      out += wxT("c");
+    out += wxT("}");
   }
   for (unsigned int i = 0; i < m_matHeight; i++)
   {
     for (unsigned int j = 0; j < m_matWidth; j++)
     {
-      s += m_cells[i * m_matWidth + j]->ListToTeX();
+      m_cells[i * m_matWidth + j]->ListAppendTeX(out);
       if (j < m_matWidth - 1)
-        s += wxT(" & ");
+        out += wxT(" & ");
     }
     if (i < m_matHeight - 1)
-      s += wxT("\\\\\n");
+      out += wxT("\\\\\n");
   }
   if (!m_specialMatrix)
   {
     switch(m_parenType)
     {
     case paren_rounded:
-      s += wxT("\\end{pmatrix}");
+      out += wxT("\\end{pmatrix}");
       break;
     case   paren_brackets:
     case paren_angled:
     case paren_straight:
-      s += wxT("\\end{bmatrix}");
+      out += wxT("\\end{bmatrix}");
       break;
     }
   }
   else
-    s += wxT("\\end{array}");
-  return s;
+    out += wxT("\\end{array}");
 }
 
 wxString MatrCell::ToMathML() const
 {
-  wxString retval;
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void MatrCell::AppendMathML(wxString &out) const
+{
   if (!m_specialMatrix)
-    retval = wxT("<mrow><mo>(</mo><mrow>");
-  retval += wxT("<mtable>");
+    out += wxT("<mrow><mo>(</mo><mrow>");
+  out += wxT("<mtable>");
 
   for (unsigned int i = 0; i < m_matHeight; i++)
   {
-    retval += wxT("<mtr>");
+    out += wxT("<mtr>");
     for (unsigned int j = 0; j < m_matWidth; j++)
-      retval += wxT("<mtd>") + m_cells[i * m_matWidth + j]->ListToMathML() + wxT("</mtd>");
-    retval += wxT("</mtr>");
+    {
+      out += wxT("<mtd>");
+      m_cells[i * m_matWidth + j]->ListAppendMathML(out);
+      out += wxT("</mtd>");
+    }
+    out += wxT("</mtr>");
   }
-  retval += wxT("</mtable>\n");
+  out += wxT("</mtable>\n");
   if (!m_specialMatrix)
-    retval += wxT("</mrow><mo>)</mo></mrow>\n");
-  return retval;
+    out += wxT("</mrow><mo>)</mo></mrow>\n");
 }
 
 wxString MatrCell::ToOMML() const
 {
-  wxString retval;
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
 
-  retval = wxT("<m:d>");
+void MatrCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:d>");
   if (!m_specialMatrix)
   {
         switch(m_parenType)
     {
     case paren_rounded:
-      retval += wxT("<m:dPr><m:begChr>(</m:begChr><m:endChr>)</m:endChr> <m:grow>\"1\"</m:grow></m:dPr>");
+      out += wxT("<m:dPr><m:begChr>(</m:begChr><m:endChr>)</m:endChr> <m:grow>\"1\"</m:grow></m:dPr>");
       break;
     case   paren_brackets:
-      retval += wxT("<m:dPr><m:begChr>[</m:begChr><m:endChr>]</m:endChr> <m:grow>\"1\"</m:grow></m:dPr>");
+      out += wxT("<m:dPr><m:begChr>[</m:begChr><m:endChr>]</m:endChr> <m:grow>\"1\"</m:grow></m:dPr>");
       break;
     case paren_angled:
-      retval += wxT("<m:dPr><m:begChr>&lt;</m:begChr><m:endChr>&gt;</m:endChr> <m:grow>\"1\"</m:grow></m:dPr>");
+      out += wxT("<m:dPr><m:begChr>&lt;</m:begChr><m:endChr>&gt;</m:endChr> <m:grow>\"1\"</m:grow></m:dPr>");
       break;
     case paren_straight:
-      retval += wxT("<m:dPr><m:begChr>|</m:begChr><m:endChr>|</m:endChr> <m:grow>\"1\"</m:grow></m:dPr>");
+      out += wxT("<m:dPr><m:begChr>|</m:begChr><m:endChr>|</m:endChr> <m:grow>\"1\"</m:grow></m:dPr>");
       break;
     }     
   }
   
-  retval += wxT("<m:e><m:m>");
+  out += wxT("<m:e><m:m>");
 
   for (unsigned int i = 0; i < m_matHeight; i++)
   {
-    retval += wxT("<m:mr>");
+    out += wxT("<m:mr>");
     for (unsigned int j = 0; j < m_matWidth; j++)
-      retval += wxT("<m:e>") + m_cells[i * m_matWidth + j]->ListToOMML() + wxT("</m:e>");
-    retval += wxT("</m:mr>");
+    {
+      out += wxT("<m:e>");
+      m_cells[i * m_matWidth + j]->ListAppendOMML(out);
+      out += wxT("</m:e>");
+    }
+    out += wxT("</m:mr>");
   }
 
-  retval += wxT("</m:m></m:e></m:d>");
-  return retval;
+  out += wxT("</m:m></m:e></m:d>");
 }
 
 wxString MatrCell::ToXML() const
+{
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void MatrCell::AppendXML(wxString &out) const
 {
   wxString flags;
   if (HasHardLineBreak())
@@ -478,26 +556,27 @@ wxString MatrCell::ToXML() const
     break;
   }
 
-  wxString s = wxEmptyString;
   if (m_specialMatrix)
-    s = wxString::Format(
+    out += wxString::Format(
       wxT("<tb") + flags + wxT(" special=\"true\" inference=\"%s\" rownames=\"%s\" colnames=\"%s\">"),
             m_inferenceMatrix ? "true" : "false",
             m_rowNames ? "true" : "false",
             m_colNames ? "true" : "false");
   else
-    s = wxT("<tb") +flags +wxT(">");
+    out += wxT("<tb") +flags +wxT(">");
 
   for (unsigned int i = 0; i < m_matHeight; i++)
   {
-    s += wxT("<mtr>");
+    out += wxT("<mtr>");
     for (unsigned int j = 0; j < m_matWidth; j++)
-      s += wxT("<mtd>") + m_cells[i * m_matWidth + j]->ListToXML() + wxT("</mtd>");
-    s += wxT("</mtr>");
+    {
+      out += wxT("<mtd>");
+      m_cells[i * m_matWidth + j]->ListAppendXML(out);
+      out += wxT("</mtd>");
+    }
+    out += wxT("</mtr>");
   }
-  s += wxT("</tb>");
-
-  return s;
+  out += wxT("</tb>");
 }
 
 void MatrCell::SetDimension()
@@ -50,11 +50,16 @@ public:
   void SetDimension();
 
   wxString ToMathML() const override;
+  void AppendMathML(wxString &out) const override;
   wxString ToMatlab() const override;
   wxString ToOMML() const override;
+  void AppendOMML(wxString &out) const override;
   wxString ToString() const override;
+  void AppendString(wxString &out) const override;
   wxString ToTeX() const override;
+  void AppendTeX(wxString &out) const override;
   wxString ToXML() const override;
+  void AppendXML(wxString &out) const override;
 
   void SetSpecialFlag(bool special) { m_specialMatrix = special; }
 
@@ -81,8 +86,14 @@ private:
   //! Collection of pointers to inner cells.
   std::vector<std::unique_ptr<Cell>> m_cells;
 
+  //! The widths of the columns. -1 = needs to be measured again.
   std::vector<int> m_widths;
+  //! The drops and centers of the rows. -1 = needs to be measured again.
   std::vector<DropCenter> m_dropCenters;
+  //! Where the columns begin, relative to the first one
+  std::vector<int> m_columnPositions;
+  //! Where the rows begin, relative to the first one
+  std::vector<int> m_rowPositions;
 
   unsigned int m_matWidth = 0;
   unsigned int m_matHeight = 0;
@@ -0,0 +1,190 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+/*! \file
+  This file defines the class OutputPreviewCell
+
+  OutputPreviewCell displays a picture of an output that was stored in a .wxmx
+  file until the output has been converted to cells.
+ */
+
+#define wxNO_UNSAFE_WXSTRING_CONV 1
+#include "OutputPreviewCell.h"
+#include "CellImpl.h"
+#include "MathParser.h"
+#include <wx/image.h>
+#include <wx/mstream.h>
+
+OutputPreviewCell::OutputPreviewCell(GroupCell *group, Configuration **config,
+                                     std::unique_ptr<wxXmlNode> &&output, const wxString &wxmxFile,
+                                     const wxMemoryBuffer &png, wxSize size, double zoom) :
+  Cell(group, config),
+  m_output(std::move(output)),
+  m_wxmxFile(wxmxFile),
+  m_png(png),
+  m_pixelSize(size),
+  m_zoom(zoom)
+{
+  if (m_zoom <= 0)
+    m_zoom = 1.0;
+  ForceBreakLine(true);
+}
+
+OutputPreviewCell::OutputPreviewCell(GroupCell *group, const OutputPreviewCell &cell):
+  OutputPreviewCell(group, cell.m_configuration,
+                    std::unique_ptr<wxXmlNode>(new wxXmlNode(*cell.m_output)),
+                    cell.m_wxmxFile, cell.m_png, cell.m_pixelSize, cell.m_zoom)
+{
+  CopyCommonData(cell);
+}
+
+DEFINE_CELL(OutputPreviewCell)
+
+std::unique_ptr<Cell> OutputPreviewCell::ParseOutput(GroupCell *group) const
+{
+  MathParser parser(m_configuration, m_wxmxFile);
+  parser.SetGroup(group);
+  return parser.ParseTag(m_output.get(), false);
+}
+
+void OutputPreviewCell::Recalculate(AFontSize fontsize)
+{
+  Cell::Recalculate(fontsize);
+  // The picture was rendered with the zoom factor m_zoom.
+  m_width = Scale_Px(m_pixelSize.x / m_zoom);
+  m_height = Scale_Px(m_pixelSize.y / m_zoom);
+  m_center = 0;
+}
+
+void OutputPreviewCell::Draw(wxPoint point)
+{
+  Cell::Draw(point);
+  if (!DrawThisCell(point) || !InUpdateRegion())
+  {
+    // The cell isn't drawn => No need to keep the decoded picture for now.
+    ClearCache();
+    return;
+  }
+
+  if (!m_bitmap.IsOk() || (m_bitmap.GetWidth() != m_width) || (m_bitmap.GetHeight() != m_height))
+  {
+    wxMemoryInputStream stream(m_png.GetData(), m_png.GetDataLen());
+    wxImage image(stream, wxBITMAP_TYPE_PNG);
+    if (!image.IsOk())
+      return;
+    if ((image.GetWidth() != m_width) || (image.GetHeight() != m_height))
+      image.Rescale(m_width, m_height, wxIMAGE_QUALITY_HIGH);
+    m_bitmap = wxBitmap(image);
+  }
+
+  // GroupCell::Draw() has indented us as if we were a line of maths, but
+  // the picture begins with the output label.
+  Configuration *configuration = (*m_configuration);
+  int indent = 0;
+  if (configuration->IndentMaths())
+    indent = Scale_Px(configuration->GetLabelWidth()) + 2 * MC_TEXT_PADDING;
+  configuration->GetDC()->DrawBitmap(m_bitmap, point.x - indent, point.y - m_center);
+}
+
+wxString OutputPreviewCell::ToMathML() const
+{
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void OutputPreviewCell::AppendMathML(wxString &out) const
+{
+  if (auto const cells = ParseOutput(GetGroup()))
+    cells->ListAppendMathML(out);
+}
+
+wxString OutputPreviewCell::ToMatlab() const
+{
+  auto const cells = ParseOutput(GetGroup());
+  return cells ? cells->ListToMatlab() : wxString();
+}
+
+wxString OutputPreviewCell::ToOMML() const
+{
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void OutputPreviewCell::AppendOMML(wxString &out) const
+{
+  if (auto const cells = ParseOutput(GetGroup()))
+    cells->ListAppendOMML(out);
+}
+
+wxString OutputPreviewCell::ToRTF() const
+{
+  wxString rtf;
+  AppendRTF(rtf);
+  return rtf;
+}
+
+void OutputPreviewCell::AppendRTF(wxString &out) const
+{
+  if (auto const cells = ParseOutput(GetGroup()))
+    cells->ListAppendRTF(out);
+}
+
+wxString OutputPreviewCell::ToString() const
+{
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void OutputPreviewCell::AppendString(wxString &out) const
+{
+  if (auto const cells = ParseOutput(GetGroup()))
+    cells->ListAppendString(out);
+}
+
+wxString OutputPreviewCell::ToTeX() const
+{
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void OutputPreviewCell::AppendTeX(wxString &out) const
+{
+  if (auto const cells = ParseOutput(GetGroup()))
+    cells->ListAppendTeX(out);
+}
+
+wxString OutputPreviewCell::ToXML() const
+{
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void OutputPreviewCell::AppendXML(wxString &out) const
+{
+  if (auto const cells = ParseOutput(GetGroup()))
+    cells->ListAppendXML(out);
+}
@@ -0,0 +1,97 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#ifndef OUTPUTPREVIEWCELL_H
+#define OUTPUTPREVIEWCELL_H
+
+#include "Cell.h"
+#include <wx/bitmap.h>
+#include <wx/buffer.h>
+#include <wx/xml/xml.h>
+#include <memory>
+
+/*! A picture of an output that hasn't been converted to cells, yet
+
+  .wxmx files can contain pre-rendered pictures of the output of their code
+  cells. While such a file is opened the outputs are displayed as this cell,
+  which only needs to know the picture's size for being laid out. The XML of
+  the output is kept and converted to cells later by
+  Worksheet::ReplaceOutputPreview(): First for the cells that are visible on
+  the screen, then for all others.
+
+  Exports convert the XML to cells every time they are called.
+ */
+class OutputPreviewCell final : public Cell
+{
+public:
+  /*! The constructor
+
+    \param output The <output> element of the code cell
+    \param wxmxFile The URI of the .wxmx file the images in output are stored in
+    \param png The picture of the output
+    \param size The size of the picture [in pixels]
+    \param zoom The zoom factor the picture was rendered for
+   */
+  OutputPreviewCell(GroupCell *group, Configuration **config,
+                    std::unique_ptr<wxXmlNode> &&output, const wxString &wxmxFile,
+                    const wxMemoryBuffer &png, wxSize size, double zoom);
+  OutputPreviewCell(GroupCell *group, const OutputPreviewCell &cell);
+  std::unique_ptr<Cell> Copy(GroupCell *group) const override;
+  const CellTypeInfo &GetInfo() override;
+
+  //! Converts the output this cell is a preview of to cells
+  std::unique_ptr<Cell> ParseOutput(GroupCell *group) const;
+
+  void Recalculate(AFontSize fontsize) override;
+  void Draw(wxPoint point) override;
+  void ClearCache() override { m_bitmap = wxNullBitmap; }
+
+  wxString ToMathML() const override;
+  void AppendMathML(wxString &out) const override;
+  wxString ToMatlab() const override;
+  wxString ToOMML() const override;
+  void AppendOMML(wxString &out) const override;
+  wxString ToRTF() const override;
+  void AppendRTF(wxString &out) const override;
+  wxString ToString() const override;
+  void AppendString(wxString &out) const override;
+  wxString ToTeX() const override;
+  void AppendTeX(wxString &out) const override;
+  wxString ToXML() const override;
+  void AppendXML(wxString &out) const override;
+
+private:
+  //! The <output> element the preview has been rendered from
+  std::unique_ptr<wxXmlNode> m_output;
+  //! The .wxmx file the images the output contains can be read from
+  wxString m_wxmxFile;
+  //! The picture, as PNG data
+  wxMemoryBuffer m_png;
+  //! The picture, scaled to our current size. Only created if we are drawn.
+  wxBitmap m_bitmap;
+  //! The size of the picture [in pixels]
+  wxSize m_pixelSize;
+  //! The zoom factor the picture was rendered for
+  double m_zoom = 1.0;
+};
+
+#endif // OUTPUTPREVIEWCELL_H
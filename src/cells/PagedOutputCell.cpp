@@ -0,0 +1,681 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the class PagedOutputCell
+
+  PagedOutputCell is the Cell that displays outputs that are too long for
+  being converted to cells all at once.
+ */
+
+#define wxNO_UNSAFE_WXSTRING_CONV 1
+#include "PagedOutputCell.h"
+#include "CellImpl.h"
+#include "GroupCell.h"
+#include "MathParser.h"
+#include <algorithm>
+#include <string>
+
+//! The approximate number of chars of XML a page contains
+static constexpr size_t PAGE_LENGTH = 8000;
+//! How many pages are kept converted to cells after they have been drawn
+static constexpr size_t PAGES_IN_MEMORY = 8;
+
+//! Returns the position of the ">" that ends the tag starting at pos
+static size_t FindTagEnd(const std::wstring &xml, size_t pos)
+{
+  wchar_t quote = 0;
+  for (; pos < xml.length(); pos++)
+  {
+    wchar_t const ch = xml[pos];
+    if (quote)
+    {
+      if (ch == quote)
+        quote = 0;
+    }
+    else if ((ch == L'"') || (ch == L'\''))
+      quote = ch;
+    else if (ch == L'>')
+      return pos;
+  }
+  return std::wstring::npos;
+}
+
+//! Returns the position after the comment or processing instruction starting at pos
+static size_t SkipDeclaration(const std::wstring &xml, size_t pos)
+{
+  if (xml.compare(pos, 4, L"<!--") == 0)
+  {
+    pos = xml.find(L"-->", pos);
+    return (pos == std::wstring::npos) ? pos : pos + 3;
+  }
+  pos = xml.find(L'>', pos);
+  return (pos == std::wstring::npos) ? pos : pos + 1;
+}
+
+//! Returns the name of the element whose start tag begins at pos
+static std::wstring TagName(const std::wstring &xml, size_t pos)
+{
+  size_t const end = xml.find_first_of(L" \t\r\n/>", pos + 1);
+  return xml.substr(pos + 1, end - pos - 1);
+}
+
+//! Counts the start tags between start and end
+static size_t CountStartTags(const std::wstring &xml, size_t start, size_t end)
+{
+  size_t count = 0;
+  for (size_t pos = start; pos + 1 < end; pos++)
+    if ((xml[pos] == L'<') && (xml[pos + 1] != L'/') &&
+        (xml[pos + 1] != L'?') && (xml[pos + 1] != L'!'))
+      count++;
+  return count;
+}
+
+//! Removes the listdelim attributes of the elements of xml that aren't nested in other elements
+static std::wstring RemoveTopLevelListDelims(const std::wstring &xml)
+{
+  static const std::wstring attribute = L" listdelim=\"true\"";
+  std::wstring result;
+  result.reserve(xml.length());
+  size_t copied = 0;
+  int depth = 0;
+  size_t pos = 0;
+  while (((pos = xml.find(L'<', pos)) != std::wstring::npos) && (pos + 1 < xml.length()))
+  {
+    wchar_t const next = xml[pos + 1];
+    if ((next == L'?') || (next == L'!'))
+    {
+      pos = SkipDeclaration(xml, pos);
+      if (pos == std::wstring::npos)
+        break;
+      continue;
+    }
+    size_t const tagEnd = FindTagEnd(xml, pos);
+    if (tagEnd == std::wstring::npos)
+      break;
+    if (next == L'/')
+      depth--;
+    else
+    {
+      if (depth == 0)
+      {
+        size_t const attributeStart = xml.find(attribute, pos);
+        if (attributeStart < tagEnd)
+        {
+          result.append(xml, copied, attributeStart - copied);
+          copied = attributeStart + attribute.length();
+        }
+      }
+      if (xml[tagEnd - 1] != L'/')
+        depth++;
+    }
+    pos = tagEnd + 1;
+  }
+  result.append(xml, copied, std::wstring::npos);
+  return result;
+}
+
+PagedOutputCell::PagedOutputCell(GroupCell *group, Configuration **config, wxString &&xml,
+                                 CellType parserStyle, const wxString &userLabel) :
+  Cell(group, config),
+  m_xml(std::move(xml)),
+  m_userLabel(userLabel),
+  m_parserStyle(parserStyle)
+{
+  SplitIntoPages();
+  ForceBreakLine(true);
+}
+
+PagedOutputCell::PagedOutputCell(GroupCell *group, const PagedOutputCell &cell):
+  PagedOutputCell(group, cell.m_configuration, wxString(cell.m_xml),
+                  cell.m_parserStyle, cell.m_userLabel)
+{
+  CopyCommonData(cell);
+}
+
+DEFINE_CELL(PagedOutputCell)
+
+void PagedOutputCell::SplitIntoPages()
+{
+  m_pages.clear();
+  std::wstring const xml = m_xml.ToStdWstring();
+
+  //! An element whose start tag we have seen
+  struct Element
+  {
+    size_t tagStart = 0;
+    size_t contentStart = 0;
+    size_t contentEnd = 0;
+    size_t end = 0;
+    size_t children = 0;
+  };
+
+  // 1st pass: Find the element with the most children and the elements it is
+  // contained in.
+  std::vector<Element> open;
+  Element split;
+  std::vector<Element> splitAncestors;
+  bool rootClosed = false;
+  size_t pos = 0;
+  while ((!rootClosed) && ((pos = xml.find(L'<', pos)) != std::wstring::npos))
+  {
+    if (pos + 1 >= xml.length())
+      return;
+    size_t const tagStart = pos;
+    wchar_t const next = xml[pos + 1];
+    if ((next == L'?') || (next == L'!'))
+    {
+      pos = SkipDeclaration(xml, pos);
+      if (pos == std::wstring::npos)
+        return;
+      continue;
+    }
+    size_t const tagEnd = FindTagEnd(xml, pos);
+    if (tagEnd == std::wstring::npos)
+      return;
+    pos = tagEnd + 1;
+
+    if (next == L'/')
+    {
+      if (open.empty())
+        return;
+      Element element = open.back();
+      open.pop_back();
+      element.contentEnd = tagStart;
+      element.end = pos;
+      if (element.children > split.children)
+      {
+        split = element;
+        if (open.empty())
+          splitAncestors.clear();
+        else
+          splitAncestors.assign(open.begin() + 1, open.end());
+      }
+      if (open.empty())
+      {
+        m_rootName = TagName(xml, element.tagStart);
+        m_contentStart = element.contentStart;
+        m_contentEnd = element.contentEnd;
+        rootClosed = true;
+      }
+    }
+    else
+    {
+      if (!open.empty())
+        open.back().children++;
+      if (xml[tagEnd - 1] != L'/')
+      {
+        Element element;
+        element.tagStart = tagStart;
+        element.contentStart = pos;
+        open.push_back(element);
+      }
+    }
+  }
+  if ((!rootClosed) || (split.children < 2))
+    return;
+
+  // 2nd pass: Combine the children of the split element to pages
+  Page page;
+  page.start = split.contentStart;
+  int depth = 0;
+  pos = split.contentStart;
+  while (((pos = xml.find(L'<', pos)) != std::wstring::npos) && (pos < split.contentEnd))
+  {
+    size_t const tagStart = pos;
+    wchar_t const next = xml[pos + 1];
+    if ((next == L'?') || (next == L'!'))
+    {
+      pos = SkipDeclaration(xml, pos);
+      continue;
+    }
+    size_t const tagEnd = FindTagEnd(xml, pos);
+    pos = tagEnd + 1;
+    if (next == L'/')
+      depth--;
+    else
+    {
+      if ((depth == 0) && (tagStart - page.start >= PAGE_LENGTH))
+      {
+        page.end = tagStart;
+        m_pages.push_back(std::move(page));
+        page = Page();
+        page.start = tagStart;
+      }
+      if (xml[tagEnd - 1] != L'/')
+        depth++;
+    }
+  }
+  page.end = split.contentEnd;
+  m_pages.push_back(std::move(page));
+
+  if (m_pages.size() < 2)
+  {
+    m_pages.clear();
+    return;
+  }
+
+  // The split element itself is dropped: What precedes it and what follows it
+  // is drawn as a page of its own.
+  if (CountStartTags(xml, m_contentStart, split.tagStart) > splitAncestors.size())
+  {
+    m_head = xml.substr(m_contentStart, split.tagStart - m_contentStart);
+    for (auto ancestor = splitAncestors.rbegin(); ancestor != splitAncestors.rend(); ++ancestor)
+      m_head += wxT("</") + TagName(xml, ancestor->tagStart) + wxT(">");
+  }
+  if (CountStartTags(xml, split.end, m_contentEnd) > 0)
+  {
+    for (auto const &ancestor : splitAncestors)
+      m_tail += xml.substr(ancestor.tagStart, ancestor.contentStart - ancestor.tagStart);
+    m_tail += xml.substr(split.end, m_contentEnd - split.end);
+  }
+}
+
+std::unique_ptr<Cell> PagedOutputCell::ParsePage(size_t index) const
+{
+  const Page &page = m_pages[index];
+  wxString xml = wxT("<") + m_rootName + wxT(">");
+  if (index == 0)
+    xml += m_head;
+  // The list delimiters normally are drawn by the list the split element
+  // represented: On a page they have to be drawn as ordinary text. Lists
+  // nested in the page's elements still draw their own delimiters.
+  xml += RemoveTopLevelListDelims(m_xml.Mid(page.start, page.end - page.start).ToStdWstring());
+  if (index == m_pages.size() - 1)
+    xml += m_tail;
+  xml += wxT("</") + m_rootName + wxT(">");
+
+  MathParser parser(m_configuration);
+  parser.SetGroup(GetGroup());
+  parser.SetUserLabel(m_userLabel);
+  return parser.ParseFragment(xml, m_parserStyle);
+}
+
+int PagedOutputCell::GetMaxLineWidth() const
+{
+  // The same width GroupCell::BreakLinesFrom() allows lines to have
+  Configuration *configuration = (*m_configuration);
+  int fullWidth = configuration->GetClientWidth() - configuration->GetIndent() - Scale_Px(1);
+  if (fullWidth < Scale_Px(150))
+    fullWidth = Scale_Px(150);
+  return fullWidth;
+}
+
+int PagedOutputCell::GetLineIndent(const Cell *cell) const
+{
+  if ((cell->GetStyle() != TS_LABEL) &&
+      (cell->GetStyle() != TS_USERLABEL) &&
+      (cell->GetStyle() != TS_MAIN_PROMPT) &&
+      (cell->GetStyle() != TS_OTHER_PROMPT) &&
+      (cell->GetStyle() != TS_ASCIIMATHS) &&
+      (*m_configuration)->IndentMaths())
+    return Scale_Px((*m_configuration)->GetLabelWidth()) + 2 * MC_TEXT_PADDING;
+  return 0;
+}
+
+void PagedOutputCell::LayoutPage(size_t index)
+{
+  Page &page = m_pages[index];
+  page.placedCells.clear();
+  page.height = 0;
+  page.width = 0;
+  page.cells = ParsePage(index);
+  if (!page.cells)
+    return;
+
+  Configuration *configuration = (*m_configuration);
+  int const maxLineWidth = GetMaxLineWidth();
+  for (Cell &tmp : OnList(page.cells.get()))
+    tmp.Recalculate(tmp.IsMath() ?
+                    configuration->GetMathFontSize() :
+                    configuration->GetDefaultFontSize());
+
+  // Convert everything that is wider than a line to 1D objects
+  bool brokenUp = false;
+  for (Cell &tmp : OnDrawList(page.cells.get()))
+    if (tmp.GetWidth() > maxLineWidth)
+      brokenUp |= tmp.BreakUp();
+  if (brokenUp)
+  {
+    page.cells->ResetCellListSizesList();
+    for (Cell &tmp : OnList(page.cells.get()))
+      tmp.Recalculate(tmp.IsMath() ?
+                      configuration->GetMathFontSize() :
+                      configuration->GetDefaultFontSize());
+  }
+
+  // Break the page into lines. GroupCell::Draw() has already indented us as
+  // if we were an ordinary line of maths.
+  int const ownIndent = GetLineIndent(this);
+  size_t lineStart = 0;
+  int x = 0;
+  int center = 0;
+  int drop = 0;
+  auto const finishLine = [&]{
+    for (size_t i = lineStart; i < page.placedCells.size(); i++)
+      page.placedCells[i].point.y = page.height + center;
+    page.height += center + drop;
+    page.width = wxMax(page.width, x - ownIndent);
+    lineStart = page.placedCells.size();
+    center = drop = 0;
+  };
+  for (Cell &tmp : OnDrawList(page.cells.get()))
+  {
+    int const width = tmp.GetWidth();
+    if ((page.placedCells.empty()) ||
+        tmp.HasHardLineBreak() || (x + width >= maxLineWidth))
+    {
+      if (!page.placedCells.empty())
+        finishLine();
+      x = GetLineIndent(&tmp);
+    }
+    page.placedCells.push_back({&tmp, wxPoint(x - ownIndent, 0)});
+    if (!tmp.IsBrokenIntoLines())
+    {
+      center = wxMax(center, tmp.GetCenter());
+      drop = wxMax(drop, tmp.GetDrop());
+    }
+    x += width;
+  }
+  if (!page.placedCells.empty())
+    finishLine();
+}
+
+void PagedOutputCell::UsePage(size_t index)
+{
+  auto const recent = std::find(m_recentPages.begin(), m_recentPages.end(), index);
+  if (recent != m_recentPages.end())
+    m_recentPages.erase(recent);
+  if (!m_pages[index].cells)
+    LayoutPage(index);
+  m_recentPages.insert(m_recentPages.begin(), index);
+
+  while (m_recentPages.size() > PAGES_IN_MEMORY)
+  {
+    Page &page = m_pages[m_recentPages.back()];
+    page.placedCells.clear();
+    page.cells.reset();
+    m_recentPages.pop_back();
+  }
+}
+
+void PagedOutputCell::ReleasePages()
+{
+  for (auto const i : m_recentPages)
+  {
+    m_pages[i].placedCells.clear();
+    m_pages[i].cells.reset();
+  }
+  m_recentPages.clear();
+}
+
+wxRect PagedOutputCell::GetPageRect(const Page &page, wxPoint point) const
+{
+  return wxRect(point.x, point.y - m_center + page.top,
+                wxMax(m_width, 1), wxMax(page.height, 1));
+}
+
+wxPoint PagedOutputCell::GetPositionEstimate() const
+{
+  if ((m_currentPoint.y >= 0) || !GetGroup() || (GetGroup()->GetCurrentPoint().y < 0))
+    return m_currentPoint;
+  wxRect const output = GetGroup()->GetOutputRect();
+  return wxPoint(output.x, output.y + m_center);
+}
+
+bool PagedOutputCell::IsNearVisibleRegion(const Page &page) const
+{
+  Configuration *configuration = (*m_configuration);
+  // Printouts and exports need every page's real size
+  if (!configuration->ClipToDrawRegion() || configuration->GetPrinting())
+    return true;
+  wxPoint const point = GetPositionEstimate();
+  if (point.y < 0)
+    return false;
+
+  // Leave a screen's height of margin for scrolling
+  wxRect visible = configuration->GetVisibleWorksheetRegion();
+  visible.Inflate(0, visible.GetHeight());
+  wxRect const rect = GetPageRect(page, point);
+  return (rect.GetBottom() >= visible.GetTop()) && (rect.GetTop() <= visible.GetBottom());
+}
+
+bool PagedOutputCell::HasEstimatedSize() const
+{
+  return std::any_of(m_pages.begin(), m_pages.end(),
+                     [](const Page &page) { return !page.measured; });
+}
+
+bool PagedOutputCell::HasEstimatedSizeIn(const wxRect &rect) const
+{
+  wxPoint const point = GetPositionEstimate();
+  if (point.y < 0)
+    return false;
+  for (auto const &page : m_pages)
+  {
+    if (page.measured)
+      continue;
+    wxRect const pageRect = GetPageRect(page, point);
+    if ((pageRect.GetBottom() >= rect.GetTop()) && (pageRect.GetTop() <= rect.GetBottom()))
+      return true;
+  }
+  return false;
+}
+
+bool PagedOutputCell::NeedsRecalculation(AFontSize WXUNUSED(fontSize)) const
+{
+  // GroupCell resets the sizes of its output after each layout pass and
+  // recalculates the output several times per pass. Measuring all pages is
+  // expensive, though => We only do so if something that affects our layout
+  // has changed.
+  Configuration *configuration = (*m_configuration);
+  return !m_pagesMeasured ||
+    (m_clientWidth_old != configuration->GetClientWidth()) ||
+    !EqualToWithin(Scale_Px(configuration->GetMathFontSize()), m_fontSize_Scaled, 0.1f) ||
+    !EqualToWithin(Scale_Px(configuration->GetDefaultFontSize()), m_defaultFontSize_Scaled, 0.1f);
+}
+
+void PagedOutputCell::FontsChanged()
+{
+  m_pagesMeasured = false;
+  Cell::FontsChanged();
+}
+
+void PagedOutputCell::Recalculate(AFontSize WXUNUSED(fontsize))
+{
+  Configuration *configuration = (*m_configuration);
+  bool const layoutChanged = NeedsRecalculation(configuration->GetMathFontSize());
+  // Our pages use the font sizes from the configuration.
+  Cell::Recalculate(configuration->GetMathFontSize());
+  if (layoutChanged)
+  {
+    m_clientWidth_old = configuration->GetClientWidth();
+    m_defaultFontSize_Scaled = Scale_Px(configuration->GetDefaultFontSize());
+    m_pagesMeasured = true;
+    // The pages have been laid out for the old configuration.
+    ReleasePages();
+    for (auto &page : m_pages)
+      page.measured = false;
+  }
+  else if (!HasEstimatedSize())
+    return;
+
+  // Pages that have been laid out since the last recalculation are measured
+  // => we know their height.
+  for (auto const i : m_recentPages)
+    m_pages[i].measured = true;
+
+  // Estimating the height of a page needs at least one page we know the
+  // height per char of XML of.
+  if (!m_pages.empty() &&
+      std::none_of(m_pages.begin(), m_pages.end(), [](const Page &page) { return page.measured; }))
+  {
+    UsePage(0);
+    m_pages[0].measured = true;
+  }
+  double measuredHeight = 0;
+  double measuredLength = 0;
+  for (auto const &page : m_pages)
+    if (page.measured)
+    {
+      measuredHeight += page.height;
+      measuredLength += page.end - page.start;
+    }
+  double const heightPerChar = (measuredLength > 0) ? measuredHeight / measuredLength : 0;
+
+  // Measure the pages near the visible region. All other pages keep an
+  // estimate of their height until they are scrolled into view.
+  m_width = 0;
+  m_height = 0;
+  m_center = 0;
+  for (size_t i = 0; i < m_pages.size(); i++)
+  {
+    Page &page = m_pages[i];
+    page.top = m_height;
+    if (!page.measured)
+    {
+      page.height = static_cast<int>(heightPerChar * (page.end - page.start));
+      if (IsNearVisibleRegion(page))
+      {
+        UsePage(i);
+        page.measured = true;
+      }
+    }
+    m_height += page.height;
+    if (page.measured)
+      m_width = wxMax(m_width, page.width);
+  }
+}
+
+void PagedOutputCell::Draw(wxPoint point)
+{
+  Cell::Draw(point);
+  if (!DrawThisCell(point))
+    return;
+
+  Configuration *configuration = (*m_configuration);
+  for (size_t i = 0; i < m_pages.size(); i++)
+  {
+    if (!configuration->InUpdateRegion(GetPageRect(m_pages[i], point)))
+      continue;
+    // Pages that haven't been measured yet are laid out here, but keep the
+    // place their estimated height reserved for them until the next
+    // recalculation.
+    UsePage(i);
+    const Page &page = m_pages[i];
+    for (auto const &placed : page.placedCells)
+      placed.cell->Draw(wxPoint(point.x + placed.point.x,
+                                point.y - m_center + page.top + placed.point.y));
+  }
+}
+
+wxString PagedOutputCell::ToMathML() const
+{
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void PagedOutputCell::AppendMathML(wxString &out) const
+{
+  for (size_t i = 0; i < m_pages.size(); i++)
+    if (auto const cells = ParsePage(i))
+      cells->ListAppendMathML(out);
+}
+
+wxString PagedOutputCell::ToMatlab() const
+{
+  wxString retval;
+  for (size_t i = 0; i < m_pages.size(); i++)
+    if (auto const cells = ParsePage(i))
+      retval += cells->ListToMatlab();
+  return retval;
+}
+
+wxString PagedOutputCell::ToOMML() const
+{
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void PagedOutputCell::AppendOMML(wxString &out) const
+{
+  for (size_t i = 0; i < m_pages.size(); i++)
+    if (auto const cells = ParsePage(i))
+      cells->ListAppendOMML(out);
+}
+
+wxString PagedOutputCell::ToRTF() const
+{
+  wxString rtf;
+  AppendRTF(rtf);
+  return rtf;
+}
+
+void PagedOutputCell::AppendRTF(wxString &out) const
+{
+  for (size_t i = 0; i < m_pages.size(); i++)
+    if (auto const cells = ParsePage(i))
+      cells->ListAppendRTF(out);
+}
+
+wxString PagedOutputCell::ToString() const
+{
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void PagedOutputCell::AppendString(wxString &out) const
+{
+  for (size_t i = 0; i < m_pages.size(); i++)
+    if (auto const cells = ParsePage(i))
+      cells->ListAppendString(out);
+}
+
+wxString PagedOutputCell::ToTeX() const
+{
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void PagedOutputCell::AppendTeX(wxString &out) const
+{
+  for (size_t i = 0; i < m_pages.size(); i++)
+    if (auto const cells = ParsePage(i))
+      cells->ListAppendTeX(out);
+}
+
+wxString PagedOutputCell::ToXML() const
+{
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void PagedOutputCell::AppendXML(wxString &out) const
+{
+  // The XML we got from maxima is what we would generate if we were converted
+  // to cells.
+  out.append(m_xml, m_contentStart, m_contentEnd - m_contentStart);
+}
@@ -0,0 +1,168 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#ifndef PAGEDOUTPUTCELL_H
+#define PAGEDOUTPUTCELL_H
+
+#include "Cell.h"
+#include <vector>
+
+/*! A cell that displays an output that is too long to be laid out at once
+
+  Instead of converting the whole XML maxima sent to cells this cell keeps
+  the XML and splits it into pages of consecutive children of the XML element
+  that has the most children (which normally is the list or sum that makes the
+  output that long). Only the pages near the visible region are laid out in
+  order to know their height; the height of all other pages is estimated from
+  the length of their XML until they are scrolled into view. The cells of the
+  pages that have been drawn most recently are kept in memory.
+
+  Known limitations:
+   - Every page starts a new line.
+   - The elements that surround the split element (parenthesis, for example)
+     are drawn as separate lines before and after the split element.
+ */
+class PagedOutputCell final : public Cell
+{
+public:
+  PagedOutputCell(GroupCell *group, Configuration **config, wxString &&xml,
+                  CellType parserStyle = MC_TYPE_DEFAULT,
+                  const wxString &userLabel = {});
+  PagedOutputCell(GroupCell *group, const PagedOutputCell &cell);
+  std::unique_ptr<Cell> Copy(GroupCell *group) const override;
+  const CellTypeInfo &GetInfo() override;
+
+  //! The number of pages the output has been split into. 1 = cannot be split.
+  size_t GetPageCount() const { return m_pages.size(); }
+
+  bool NeedsRecalculation(AFontSize fontSize) const override;
+  bool HasEstimatedSize() const override;
+  bool HasEstimatedSizeIn(const wxRect &rect) const override;
+  void Recalculate(AFontSize fontsize) override;
+  void Draw(wxPoint point) override;
+
+  wxString ToMathML() const override;
+  void AppendMathML(wxString &out) const override;
+  wxString ToMatlab() const override;
+  wxString ToOMML() const override;
+  void AppendOMML(wxString &out) const override;
+  wxString ToRTF() const override;
+  void AppendRTF(wxString &out) const override;
+  wxString ToString() const override;
+  void AppendString(wxString &out) const override;
+  wxString ToTeX() const override;
+  void AppendTeX(wxString &out) const override;
+  wxString ToXML() const override;
+  void AppendXML(wxString &out) const override;
+
+protected:
+  void FontsChanged() override;
+
+private:
+  //! A cell of a page and where to draw it, relative to the top left of the page.
+  struct PlacedCell
+  {
+    Cell *cell;
+    wxPoint point;
+  };
+
+  //! A range of children of the split XML element
+  struct Page
+  {
+    //! Where the first child of this page starts in m_xml
+    size_t start = 0;
+    //! Where the child after the last child of this page starts in m_xml
+    size_t end = 0;
+    //! The vertical position of this page, relative to the top of the cell
+    int top = 0;
+    int height = 0;
+    int width = 0;
+    //! Has height been measured or just estimated?
+    bool measured = false;
+    //! The cells of this page, if it currently is kept in memory
+    std::unique_ptr<Cell> cells;
+    std::vector<PlacedCell> placedCells;
+  };
+
+  //! Splits m_xml into pages. Leaves m_pages empty if it cannot do so.
+  void SplitIntoPages();
+  //! Converts the XML of one page to cells
+  std::unique_ptr<Cell> ParsePage(size_t index) const;
+  //! Converts a page to cells and determines their positions.
+  void LayoutPage(size_t index);
+  /*! Makes sure that a page is converted to cells and laid out
+
+    Marks the page as the most recently used one and frees the cells of the
+    page that has been used least recently, if too many pages are held in memory.
+   */
+  void UsePage(size_t index);
+  //! Frees the cells of all pages
+  void ReleasePages();
+  //! The rectangle of a page, if the cell is placed at point
+  wxRect GetPageRect(const Page &page, wxPoint point) const;
+  //! Our position, or where our group places its output if we haven't been drawn yet
+  wxPoint GetPositionEstimate() const;
+  //! True, if a page lies in the part of the worksheet that is to be laid out exactly
+  bool IsNearVisibleRegion(const Page &page) const;
+  //! The width the lines of our pages may have
+  int GetMaxLineWidth() const;
+  //! How far GroupCell::Draw() indents a line that starts with cell
+  int GetLineIndent(const Cell *cell) const;
+
+  //** Large objects
+  //**
+  //! The XML maxima sent
+  wxString m_xml;
+  //! The name of the root element of the XML
+  wxString m_rootName;
+  //! The elements before the split element, with the elements that are open there closed
+  wxString m_head;
+  //! The elements after the split element, with the elements that are open there re-opened
+  wxString m_tail;
+  //! The user-defined label the output was parsed with
+  wxString m_userLabel;
+  std::vector<Page> m_pages;
+  //! The pages that currently have cells, the most recently used one first
+  std::vector<size_t> m_recentPages;
+
+  //** 8-byte objects
+  //**
+  //! Where the contents of the root element start in m_xml
+  size_t m_contentStart = 0;
+  //! Where the contents of the root element end in m_xml
+  size_t m_contentEnd = 0;
+
+  //! The client width our pages have been laid out for
+  long m_clientWidth_old = -1;
+
+  //** 4-byte objects
+  //**
+  //! The default font size our pages have been laid out for
+  AFontSize m_defaultFontSize_Scaled;
+  CellType m_parserStyle = MC_TYPE_DEFAULT;
+
+  //** 1-byte objects
+  //**
+  //! Do the page heights match the current configuration?
+  bool m_pagesMeasured = false;
+};
+
+#endif // PAGEDOUTPUTCELL_H
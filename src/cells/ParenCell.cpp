@@ -367,17 +367,29 @@ void ParenCell::Draw(wxPoint point)
 wxString ParenCell::ToString() const
 {
   wxString s;
+  AppendString(s);
+  return s;
+}
+
+void ParenCell::AppendString(wxString &out) const
+{
   if(!m_innerCell)
-    return "()";
-  
+  {
+    out += wxT("()");
+    return;
+  }
+
   if (!IsBrokenIntoLines())
   {
     if (m_print)
-      s = wxT("(") + m_innerCell->ListToString() + wxT(")");
+    {
+      out += wxT("(");
+      m_innerCell->ListAppendString(out);
+      out += wxT(")");
+    }
     else
-      s = m_innerCell->ListToString();
+      m_innerCell->ListAppendString(out);
   }
-  return s;
 }
 
 wxString ParenCell::ToMatlab() const
@@ -395,63 +407,86 @@ wxString ParenCell::ToMatlab() const
 
 wxString ParenCell::ToTeX() const
 {
-  wxString s;
-  if (!IsBrokenIntoLines())
-  {
-    wxString innerCell = m_innerCell->ListToTeX();
-
-    // Let's see if the cell contains anything potentially higher than a normal
-    // character.
-    bool needsLeftRight = false;
-    for (size_t i = 0; i < innerCell.Length(); i++)
-      if (!wxIsalnum(innerCell[i]))
-      {
-        needsLeftRight = true;
-        break;
-      }
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
 
-    if (m_print)
-    {
-      if (needsLeftRight)
-        s = wxT("\\left( ") + m_innerCell->ListToTeX() + wxT("\\right) ");
-      else
-        s = wxT("(") + m_innerCell->ListToTeX() + wxT(")");
-    }
-    else
-      s = m_innerCell->ListToTeX();
+void ParenCell::AppendTeX(wxString &out) const
+{
+  if (IsBrokenIntoLines())
+    return;
+  if (!m_print)
+  {
+    m_innerCell->ListAppendTeX(out);
+    return;
   }
-  return s;
+
+  AppendTeXInDelimiters(out, m_innerCell.get(), wxT("("), wxT(")"));
 }
 
 wxString ParenCell::ToOMML() const
 {
-  return wxT("<m:d><m:dPr m:begChr=\"") + XMLescape(m_open->ToString()) + wxT("\" m:endChr=\"") +
-         XMLescape(m_close->ToString()) + wxT("\" m:grow=\"1\"></m:dPr><m:e>") +
-         m_innerCell->ListToOMML() + wxT("</m:e></m:d>");
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void ParenCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:d><m:dPr m:begChr=\"");
+  out += XMLescape(m_open->ToString());
+  out += wxT("\" m:endChr=\"");
+  out += XMLescape(m_close->ToString());
+  out += wxT("\" m:grow=\"1\"></m:dPr><m:e>");
+  m_innerCell->ListAppendOMML(out);
+  out += wxT("</m:e></m:d>");
 }
 
 wxString ParenCell::ToMathML() const
 {
-  if (!m_print) return m_innerCell->ListToMathML();
-
-  wxString open = m_open->ToString();
-  wxString close = m_close->ToString();
-  return (
-          wxT("<mrow><mo>") + XMLescape(open) + wxT("</mo>") +
-          m_innerCell->ListToMathML() +
-          wxT("<mo>") + XMLescape(close) + wxT("</mo></mrow>\n")
-  );
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void ParenCell::AppendMathML(wxString &out) const
+{
+  if (!m_print)
+  {
+    m_innerCell->ListAppendMathML(out);
+    return;
+  }
+
+  out += wxT("<mrow><mo>");
+  out += XMLescape(m_open->ToString());
+  out += wxT("</mo>");
+  m_innerCell->ListAppendMathML(out);
+  out += wxT("<mo>");
+  out += XMLescape(m_close->ToString());
+  out += wxT("</mo></mrow>\n");
 }
 
 wxString ParenCell::ToXML() const
 {
-//  if(IsBrokenIntoLines())
-//    return wxEmptyString;
-  wxString s = m_innerCell->ListToXML();
-  wxString flags;
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void ParenCell::AppendXML(wxString &out) const
+{
+  if (!m_print)
+  {
+    m_innerCell->ListAppendXML(out);
+    return;
+  }
+  out += wxT("<r><p");
   if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
-  return ((m_print) ? _T("<r><p") + flags + wxT(">") + s + _T("</p></r>") : s);
+    out += wxT(" breakline=\"true\"");
+  out += wxT(">");
+  m_innerCell->ListAppendXML(out);
+  out += wxT("</p></r>");
 }
 
 bool ParenCell::BreakUp()
@@ -119,12 +119,24 @@ void SetCell::Draw(wxPoint point)
 wxString SetCell::ToString() const
 {
   wxString s;
+  AppendString(s);
+  return s;
+}
+
+void SetCell::AppendString(wxString &out) const
+{
   if(!m_innerCell)
-    return "[]";
-  
+  {
+    out += wxT("[]");
+    return;
+  }
+
   if (!IsBrokenIntoLines())
-      s = wxT("{") + m_innerCell->ListToString() + wxT("}");
-  return s;
+  {
+    out += wxT("{");
+    m_innerCell->ListAppendString(out);
+    out += wxT("}");
+  }
 }
 
 wxString SetCell::ToMatlab() const
@@ -137,34 +149,32 @@ wxString SetCell::ToMatlab() const
 
 wxString SetCell::ToTeX() const
 {
-  wxString s;
-  if (!IsBrokenIntoLines())
-  {
-    wxString innerCell = m_innerCell->ListToTeX();
-
-    // Let's see if the cell contains anything potentially higher than a normal
-    // character.
-    bool needsLeftRight = false;
-    for (size_t i = 0; i < innerCell.Length(); i++)
-      if (!wxIsalnum(innerCell[i]))
-      {
-        needsLeftRight = true;
-        break;
-      }
-    
-    if (needsLeftRight)
-      s = wxT("\\left{ ") + m_innerCell->ListToTeX() + wxT("\\right} ");
-    else
-      s = wxT("{") + m_innerCell->ListToTeX() + wxT("}");
-  }
-  return s;
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void SetCell::AppendTeX(wxString &out) const
+{
+  if (IsBrokenIntoLines())
+    return;
+
+  AppendTeXInDelimiters(out, m_innerCell.get(), wxT("{"), wxT("}"));
 }
 
 wxString SetCell::ToXML() const
 {
-  wxString s = m_innerCell->ListToXML();
-  wxString flags;
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void SetCell::AppendXML(wxString &out) const
+{
+  out += wxT("<r set=\"true\"");
   if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
-  return (wxT("<r set=\"true\"") + flags + wxT("><t listdelim=\"true\">{</t>") + s + wxT("<t listdelim=\"true\">}</t></r>"));
+    out += wxT(" breakline=\"true\"");
+  out += wxT("><t listdelim=\"true\">{</t>");
+  m_innerCell->ListAppendXML(out);
+  out += wxT("<t listdelim=\"true\">}</t></r>");
 }
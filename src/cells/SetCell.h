@@ -59,8 +59,11 @@ public:
 
   wxString ToMatlab() const override;
   wxString ToString() const override;
+  void AppendString(wxString &out) const override;
   wxString ToTeX() const override;
+  void AppendTeX(wxString &out) const override;
   wxString ToXML() const override;
+  void AppendXML(wxString &out) const override;
 };
 
 #endif // SETCELL_H
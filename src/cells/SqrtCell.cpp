@@ -240,11 +240,19 @@ void SqrtCell::Draw(wxPoint point)
 }
 
 wxString SqrtCell::ToString() const
+{
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void SqrtCell::AppendString(wxString &out) const
 {
   if (IsBrokenIntoLines())
-    return wxEmptyString;
-  else
-    return wxT("sqrt(") + m_innerCell->ListToString() + wxT(")");
+    return;
+  out += wxT("sqrt(");
+  m_innerCell->ListAppendString(out);
+  out += wxT(")");
 }
 
 wxString SqrtCell::ToMatlab() const
@@ -256,33 +264,64 @@ wxString SqrtCell::ToMatlab() const
 }
 
 wxString SqrtCell::ToTeX() const
+{
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void SqrtCell::AppendTeX(wxString &out) const
 {
   if (IsBrokenIntoLines())
-    return wxEmptyString;
-  else
-    return wxT("\\sqrt{") + m_innerCell->ListToTeX() + wxT("}");
+    return;
+  out += wxT("\\sqrt{");
+  m_innerCell->ListAppendTeX(out);
+  out += wxT("}");
 }
 
 wxString SqrtCell::ToMathML() const
 {
-  return wxT("<msqrt>") + m_innerCell->ListToMathML() + wxT("</msqrt>\n");
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void SqrtCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<msqrt>");
+  m_innerCell->ListAppendMathML(out);
+  out += wxT("</msqrt>\n");
 }
 
 wxString SqrtCell::ToOMML() const
 {
-  return wxT("<m:rad><m:radPr m:degHide=\"1\"></m:radPr><m:deg></m:deg><m:e>") + m_innerCell->ListToOMML() +
-         wxT("</m:e></m:rad>\n");
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void SqrtCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:rad><m:radPr m:degHide=\"1\"></m:radPr><m:deg></m:deg><m:e>");
+  m_innerCell->ListAppendOMML(out);
+  out += wxT("</m:e></m:rad>\n");
 }
 
 wxString SqrtCell::ToXML() const
 {
-//  if (IsBrokenIntoLines())
-//    return wxEmptyString;
-  wxString flags;
-  if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
 
-  return wxT("<q") + flags + wxT(">") + m_innerCell->ListToXML() + wxT("</q>");
+void SqrtCell::AppendXML(wxString &out) const
+{
+  out += wxT("<q");
+  if (HasHardLineBreak())
+    out += wxT(" breakline=\"true\"");
+  out += wxT(">");
+  m_innerCell->ListAppendXML(out);
+  out += wxT("</q>");
 }
 
 bool SqrtCell::BreakUp()
@@ -84,17 +84,31 @@ void SubCell::Draw(wxPoint point)
 }
 
 wxString SubCell::ToString() const
+{
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void SubCell::AppendString(wxString &out) const
 {
   if (m_altCopyText != wxEmptyString)
-    return m_altCopyText;
+  {
+    out += m_altCopyText;
+    return;
+  }
 
-  wxString s;
   if (m_baseCell->IsCompound())
-    s += wxT("(") + m_baseCell->ListToString() + wxT(")");
+  {
+    out += wxT("(");
+    m_baseCell->ListAppendString(out);
+    out += wxT(")");
+  }
   else
-    s += m_baseCell->ListToString();
-  s += wxT("[") + m_indexCell->ListToString() + wxT("]");
-  return s;
+    m_baseCell->ListAppendString(out);
+  out += wxT("[");
+  m_indexCell->ListAppendString(out);
+  out += wxT("]");
 }
 
 wxString SubCell::ToMatlab() const
@@ -115,43 +129,83 @@ wxString SubCell::ToMatlab() const
 
 wxString SubCell::ToTeX() const
 {
-  wxString s;
-  wxString base = m_baseCell->ListToTeX();
-  wxString index = m_indexCell->ListToTeX();
-  if (base.Length() > 1)
-    s = wxT("{{") + base + wxT("}_");
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void SubCell::AppendTeX(wxString &out) const
+{
+  // Base and index need braces if they are longer than a single character.
+  // Writing the brace up front and removing it from short contents means
+  // that nested contents are never moved.
+  out += wxT("{");
+  size_t const baseBrace = out.Length();
+  out += wxT("{");
+  m_baseCell->ListAppendTeX(out);
+  if (out.Length() - baseBrace > 2)
+    out += wxT("}");
   else
-    s = wxT("{") + base + wxT("_");
-  if (index.Length() > 1)
-    s += wxT("{") + index + wxT("}}");
+    out.erase(baseBrace, 1);
+  out += wxT("_");
+  size_t const indexBrace = out.Length();
+  out += wxT("{");
+  m_indexCell->ListAppendTeX(out);
+  if (out.Length() - indexBrace > 2)
+    out += wxT("}");
   else
-    s += index + wxT("}");
-  return s;
+    out.erase(indexBrace, 1);
+  out += wxT("}");
 }
 
 wxString SubCell::ToMathML() const
 {
-  return wxT("<msub>") +
-         m_baseCell->ListToMathML() +
-         m_indexCell->ListToMathML() +
-         wxT("</msub>\n");
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void SubCell::AppendMathML(wxString &out) const
+{
+  out += wxT("<msub>");
+  m_baseCell->ListAppendMathML(out);
+  m_indexCell->ListAppendMathML(out);
+  out += wxT("</msub>\n");
 }
 
 wxString SubCell::ToOMML() const
 {
-  return wxT("<m:sSub><m:e>") + m_baseCell->ListToOMML() + wxT("</m:e><m:sub>") +
-         m_indexCell->ListToOMML() + wxT("</m:sub></m:sSub>\n");
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void SubCell::AppendOMML(wxString &out) const
+{
+  out += wxT("<m:sSub><m:e>");
+  m_baseCell->ListAppendOMML(out);
+  out += wxT("</m:e><m:sub>");
+  m_indexCell->ListAppendOMML(out);
+  out += wxT("</m:sub></m:sSub>\n");
 }
 
 wxString SubCell::ToXML() const
 {
-  wxString flags;
-  if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
 
+void SubCell::AppendXML(wxString &out) const
+{
+  out += wxT("<i");
+  if (HasHardLineBreak())
+    out += wxT(" breakline=\"true\"");
   if (m_altCopyText != wxEmptyString)
-    flags += wxT(" altCopy=\"") + XMLescape(m_altCopyText) + wxT("\"");
-  
-  return wxT("<i") + flags + wxT("><r>") + m_baseCell->ListToXML() + wxT("</r><r>") +
-           m_indexCell->ListToXML() + wxT("</r></i>");
+    out += wxT(" altCopy=\"") + XMLescape(m_altCopyText) + wxT("\"");
+  out += wxT("><r>");
+  m_baseCell->ListAppendXML(out);
+  out += wxT("</r><r>");
+  m_indexCell->ListAppendXML(out);
+  out += wxT("</r></i>");
 }
@@ -216,31 +216,49 @@ void SubSupCell::Draw(wxPoint point)
 }
 
 wxString SubSupCell::ToString() const
+{
+  wxString s;
+  AppendString(s);
+  return s;
+}
+
+void SubSupCell::AppendString(wxString &out) const
 {
   if (m_altCopyText != wxEmptyString)
-    return m_altCopyText;
+  {
+    out += m_altCopyText;
+    return;
+  }
 
-  wxString s;
   if (m_baseCell->IsCompound())
-    s += "(" + m_baseCell->ListToString() + ")";
+  {
+    out += "(";
+    m_baseCell->ListAppendString(out);
+    out += ")";
+  }
   else
-    s += m_baseCell->ListToString();
+    m_baseCell->ListAppendString(out);
   if (m_scriptCells.empty())
   {
-    s += "[" + m_postSubCell->ListToString() + "]";
-    s += "^";
+    out += "[";
+    m_postSubCell->ListAppendString(out);
+    out += "]";
+    out += "^";
     if (m_postSupCell->IsCompound())
-      s += "(";
-    s += m_postSupCell->ListToString();
+      out += "(";
+    m_postSupCell->ListAppendString(out);
     if (m_postSupCell->IsCompound())
-      s += ")";
+      out += ")";
   }
   else
   {
     for (auto &cell : m_scriptCells)
-      s += "[" + cell->ListToString() + "]";
+    {
+      out += "[";
+      cell->ListAppendString(out);
+      out += "]";
+    }
   }
-  return s;
 }
 
 wxString SubSupCell::ToMatlab() const
@@ -279,162 +297,207 @@ wxString SubSupCell::ToMatlab() const
 
 wxString SubSupCell::ToTeX() const
 {
-  wxString s;
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void SubSupCell::AppendTeX(wxString &out) const
+{
+  auto const appendScript = [&out](const char *type, const Cell *script) {
+    out += type;
+    out += "{";
+    script->ListAppendTeX(out);
+    out += "}";
+  };
 
   if (m_scriptCells.empty())
   {
     if ((*m_configuration)->TeXExponentsAfterSubscript())
     {
-      s = "{{{" + m_baseCell->ListToTeX() + "}";
+      out += "{{{";
+      m_baseCell->ListAppendTeX(out);
+      out += "}";
       if(m_postSubCell)
-        s += "_{" + m_postSubCell->ListToTeX() + "}";
-      s += "}";
+        appendScript("_", m_postSubCell.get());
+      out += "}";
       if(m_postSupCell)
-        s += "^{" + m_postSupCell->ListToTeX() + "}";
-      s += "}";
+        appendScript("^", m_postSupCell.get());
+      out += "}";
     }
     else
     {
-      s = "{{" + m_baseCell->ListToTeX() + "}";
+      out += "{{";
+      m_baseCell->ListAppendTeX(out);
+      out += "}";
       if(m_postSubCell)
-        s +="_{" + m_postSubCell->ListToTeX() + "}";
+        appendScript("_", m_postSubCell.get());
       if(m_postSupCell)
-        s += "^{" + m_postSupCell->ListToTeX() + "}";
-      s += "}";
+        appendScript("^", m_postSupCell.get());
+      out += "}";
     }
   }
   else
   {
     if(m_preSupCell || m_preSubCell)
     {
-      s = "{}";
+      out += "{}";
       if(m_preSupCell)
-        s += "^{" + m_preSupCell->ListToTeX() + "}";
+        appendScript("^", m_preSupCell.get());
       if(m_preSubCell)
-        s += "^{" + m_preSubCell->ListToTeX() + "}";
+        appendScript("^", m_preSubCell.get());
     }
-    s += "{" + m_baseCell->ListToTeX() + "}";
+    out += "{";
+    m_baseCell->ListAppendTeX(out);
+    out += "}";
     if(m_postSupCell)
-      s += "^{" + m_postSupCell->ListToTeX() + "}";
+      appendScript("^", m_postSupCell.get());
     if(m_postSubCell)
-      s += "^{" + m_postSubCell->ListToTeX() + "}";
+      appendScript("^", m_postSubCell.get());
   }
-  return s;
 }
 
 wxString SubSupCell::ToMathML() const
 {
-  wxString retval;
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
+
+void SubSupCell::AppendMathML(wxString &out) const
+{
+  auto const appendScript = [&out](const Cell *script) {
+    if (script)
+    {
+      out += "<mrow>";
+      script->ListAppendMathML(out);
+      out += "</mrow>";
+    }
+    else
+      out += "<none/>";
+  };
+
   if (m_scriptCells.empty())
   {
-    retval = "<msubsup>" +
-      m_baseCell->ListToMathML();
+    out += "<msubsup>";
+    m_baseCell->ListAppendMathML(out);
     if(m_postSubCell)
-      retval += m_postSubCell->ListToMathML();
+      m_postSubCell->ListAppendMathML(out);
     else
-      retval += "<mrow/>";
+      out += "<mrow/>";
     if(m_postSupCell)
-      m_postSupCell->ListToMathML();
+      m_postSupCell->ListAppendMathML(out);
     else
-      retval += "<mrow/>";
-    retval += "</msubsup>\n";
+      out += "<mrow/>";
+    out += "</msubsup>\n";
   }
   else
   {
-    retval = "<mmultiscripts>" + m_baseCell->ListToMathML();
+    out += "<mmultiscripts>";
+    m_baseCell->ListAppendMathML(out);
     if(m_postSupCell || m_postSubCell)
     {
-      if(m_postSubCell)
-        retval += "<mrow>" + m_postSubCell->ListToMathML() + "</mrow>";
-      else
-        retval += "<none/>";
-      if(m_postSupCell)
-        retval += "<mrow>" + m_postSupCell->ListToMathML() + "</mrow>";
-      else
-        retval += "<none/>";
+      appendScript(m_postSubCell.get());
+      appendScript(m_postSupCell.get());
     }
     if(m_preSupCell || m_preSubCell)
     {
-      retval += "<mprescripts/>";
-      if(m_preSubCell)
-        retval += "<mrow>" + m_preSubCell->ListToMathML() + "</mrow>";
-      else
-        retval += "<none/>";
-      if(m_preSupCell)
-        retval += "<mrow>" + m_preSupCell->ListToMathML() + "</mrow>";
-      else
-        retval += "<none/>";
+      out += "<mprescripts/>";
+      appendScript(m_preSubCell.get());
+      appendScript(m_preSupCell.get());
     }
-    retval += "</mmultiscripts>\n";
+    out += "</mmultiscripts>\n";
   }
-  return retval;
 }
 wxString SubSupCell::ToOMML() const
 {
-  wxString retval;
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void SubSupCell::AppendOMML(wxString &out) const
+{
+  auto const appendScript = [&out](const Cell *script) {
+    if (script)
+      script->ListAppendOMML(out);
+    else
+      out += "<m:r></m:r>";
+  };
+
   if(m_preSupCell || m_preSubCell)
   {
-    retval += "<m:sSubSup><m:e><m:r></m:r></m:e><m:sub>";
-    if(m_preSubCell)
-      retval += m_preSubCell->ListToOMML();
-    else
-      retval += "<m:r></m:r>";
-    retval += "</m:sub><m:sup>";
-    if(m_preSupCell)
-      retval += m_preSupCell->ListToOMML();
-    else
-      retval += "<m:r></m:r>";
-    retval += "</m:sup></m:sSubSup>\n";
+    out += "<m:sSubSup><m:e><m:r></m:r></m:e><m:sub>";
+    appendScript(m_preSubCell.get());
+    out += "</m:sub><m:sup>";
+    appendScript(m_preSupCell.get());
+    out += "</m:sup></m:sSubSup>\n";
   }
-  retval += "<m:sSubSup><m:e>" + m_baseCell->ListToOMML() + "</m:e><m:sub>";
-  if(m_postSubCell)
-    retval += m_postSubCell->ListToOMML();
-  else
-    retval += "<m:r></m:r>";
-  retval += "</m:sub><m:sup>";
-  if(m_postSupCell)
-    retval += m_postSupCell->ListToOMML();
-  else
-    retval += "<m:r></m:r>";
-  retval += "</m:sup></m:sSubSup>\n";
-  return retval;
+  out += "<m:sSubSup><m:e>";
+  m_baseCell->ListAppendOMML(out);
+  out += "</m:e><m:sub>";
+  appendScript(m_postSubCell.get());
+  out += "</m:sub><m:sup>";
+  appendScript(m_postSupCell.get());
+  out += "</m:sup></m:sSubSup>\n";
 }
 
 wxString SubSupCell::ToXML() const
 {
-  wxString flags;
-  if (HasHardLineBreak())
-    flags += " breakline=\"true\"";
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
 
+void SubSupCell::AppendXML(wxString &out) const
+{
+  out += "<ie";
+  if (HasHardLineBreak())
+    out += " breakline=\"true\"";
   if (m_altCopyText != wxEmptyString)
-    flags += " altCopy=\"" + XMLescape(m_altCopyText) + "\"";
+    out += " altCopy=\"" + XMLescape(m_altCopyText) + "\"";
+  out += "><r>";
+  m_baseCell->ListAppendXML(out);
+  out += "</r>";
 
-  wxString retval;
   if (m_scriptCells.empty())
   {
-    retval = "<ie" + flags + "><r>" + m_baseCell->ListToXML()
-      + "</r><r>";
+    out += "<r>";
     if(m_postSubCell)
-      retval += m_postSubCell->ListToXML();
-    retval += "</r><r>";
+      m_postSubCell->ListAppendXML(out);
+    out += "</r><r>";
     if(m_postSupCell)
-      retval += m_postSupCell->ListToXML();
-    retval += "</r></ie>";
+      m_postSupCell->ListAppendXML(out);
+    out += "</r>";
   }
   else
   {
-    retval = "<ie" + flags + "><r>" + m_baseCell->ListToXML() + "</r>";
     if(m_preSupCell)
-      retval += "<r pos=\"presup\">" + m_preSupCell->ListToXML() + "</r>";
+    {
+      out += "<r pos=\"presup\">";
+      m_preSupCell->ListAppendXML(out);
+      out += "</r>";
+    }
     if(m_preSubCell)
-      retval += "<r pos=\"presub\">" + m_preSubCell->ListToXML() + "</r>";
+    {
+      out += "<r pos=\"presub\">";
+      m_preSubCell->ListAppendXML(out);
+      out += "</r>";
+    }
     if(m_postSupCell)
-      retval += "<r pos=\"postsup\">" + m_postSupCell->ListToXML() + "</r>";
+    {
+      out += "<r pos=\"postsup\">";
+      m_postSupCell->ListAppendXML(out);
+      out += "</r>";
+    }
     if(m_postSubCell)
-      retval += "<r pos=\"postsub\">" + m_postSubCell->ListToXML() + "</r>";
-    retval += "</ie>";
+    {
+      out += "<r pos=\"postsub\">";
+      m_postSubCell->ListAppendXML(out);
+      out += "</r>";
+    }
   }
-  return retval;
+  out += "</ie>";
 }
 
 wxString SubSupCell::GetDiffPart() const
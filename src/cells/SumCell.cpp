@@ -223,25 +223,20 @@ void SumCell::Draw(wxPoint point)
 
 wxString SumCell::ToString() const
 {
-  if (m_altCopyText != wxEmptyString)
-    return m_altCopyText;
-
   wxString s;
-  if (m_sumStyle == SM_SUM)
-    s = wxT("sum(");
-  else
-    s = wxT("product(");
-  
-  if (m_over->ListToString() == wxEmptyString)
+  AppendString(s);
+  return s;
+}
+
+void SumCell::AppendString(wxString &out) const
+{
+  if (m_altCopyText != wxEmptyString)
   {
-    if(m_sumStyle == SM_PROD)
-      s = wxT("lprod(");
-    else
-      s = wxT("lsum(");
+    out += m_altCopyText;
+    return;
   }
-  
-  s += Base()->ListToString();
 
+  // The limits are short => we can afford to convert them to strings first.
   Cell *tmp = m_under.get();
   wxString var = tmp->ToString();
   wxString from;
@@ -253,12 +248,33 @@ wxString SumCell::ToString() const
       from = tmp->ListToString();
   }
   wxString to = m_over->ListToString();
-  s += wxT(",") + var + wxT(",") + from;
+
   if (to != wxEmptyString)
-    s += wxT(",") + to + wxT(")");
+  {
+    if (m_sumStyle == SM_SUM)
+      out += wxT("sum(");
+    else
+      out += wxT("product(");
+  }
   else
-    s = wxT("l") + s + wxT(")");
-  return s;
+  {
+    if(m_sumStyle == SM_PROD)
+      out += wxT("llprod(");
+    else
+      out += wxT("llsum(");
+  }
+
+  Base()->ListAppendString(out);
+  out += wxT(",");
+  out += var;
+  out += wxT(",");
+  out += from;
+  if (to != wxEmptyString)
+  {
+    out += wxT(",");
+    out += to;
+  }
+  out += wxT(")");
 }
 
 wxString SumCell::ToMatlab() const
@@ -291,51 +307,79 @@ wxString SumCell::ToMatlab() const
 
 wxString SumCell::ToTeX() const
 {
-  wxString s;
+  wxString tex;
+  AppendTeX(tex);
+  return tex;
+}
+
+void SumCell::AppendTeX(wxString &out) const
+{
   if (m_sumStyle == SM_SUM)
-    s = wxT("\\sum");
+    out += wxT("\\sum");
   else
-    s = wxT("\\prod");
-
-
-  s += wxT("_{") + m_under->ListToTeX() + wxT("}");
-  wxString to = m_over->ListToTeX();
-  if (to.Length())
-    s += wxT("^{") + to + wxT("}");
-
+    out += wxT("\\prod");
+
+  out += wxT("_{");
+  m_under->ListAppendTeX(out);
+  out += wxT("}");
+  size_t const toStart = out.Length();
+  out += wxT("^{");
+  m_over->ListAppendTeX(out);
+  if (out.Length() == toStart + 2)
+    out.Truncate(toStart);
+  else
+    out += wxT("}");
 
-  s += wxT("{\\left. ");
-  s += Base()->ListToTeX();
-  s += wxT("\\right.}");
-  return s;
+  out += wxT("{\\left. ");
+  Base()->ListAppendTeX(out);
+  out += wxT("\\right.}");
 }
 
 wxString SumCell::ToOMML() const
 {
-  wxString base = Base()->ListToOMML();
+  wxString omml;
+  AppendOMML(omml);
+  return omml;
+}
+
+void SumCell::AppendOMML(wxString &out) const
+{
   wxString from = m_under ? m_under->ListToOMML() : wxString{};
   wxString to = m_over ? m_over->ListToOMML() : wxString{};
 
-  wxString retval;
-
-  retval = wxT("<m:nary><m:naryPr><m:chr>");
+  out += wxT("<m:nary><m:naryPr><m:chr>");
   if (m_sumStyle == SM_SUM)
-    retval += wxT("\u2211");
+    out += wxT("\u2211");
   else
-    retval += wxT("\u220F");
+    out += wxT("\u220F");
 
-  retval += wxT("</m:chr></m:naryPr>");
+  out += wxT("</m:chr></m:naryPr>");
   if (from != wxEmptyString)
-    retval += wxT("<m:sub>") + from + wxT("</m:sub>");
+  {
+    out += wxT("<m:sub>");
+    out += from;
+    out += wxT("</m:sub>");
+  }
   if (to != wxEmptyString)
-    retval += wxT("<m:sup>") + to + wxT("</m:sup>");
-  retval += wxT("<m:e>") + base + wxT("</m:e></m:nary>");
-
-  return retval;
+  {
+    out += wxT("<m:sup>");
+    out += to;
+    out += wxT("</m:sup>");
+  }
+  out += wxT("<m:e>");
+  Base()->ListAppendOMML(out);
+  out += wxT("</m:e></m:nary>");
 }
 
 
 wxString SumCell::ToXML() const
+{
+  wxString xml;
+  AppendXML(xml);
+  return xml;
+}
+
+void SumCell::AppendXML(wxString &out) const
 {
   wxString type(wxT("sum"));
 
@@ -349,51 +393,62 @@ wxString SumCell::ToXML() const
       type = wxT("lsum");
   }
 
-  wxString flags;
+  out += wxT("<sm type=\"");
   if (HasHardLineBreak())
-    flags += wxT(" breakline=\"true\"");
-    
-  return wxT("<sm type=\"") + flags + type + wxT("\"><r>") + m_under->ListToXML() + _T("</r><r>") +
-         m_over->ListToXML() + _T("</r><r>") +
-         Base()->ListToXML() + _T("</r></sm>");
+    out += wxT(" breakline=\"true\"");
+  out += type + wxT("\"><r>");
+  m_under->ListAppendXML(out);
+  out += wxT("</r><r>");
+  m_over->ListAppendXML(out);
+  out += wxT("</r><r>");
+  Base()->ListAppendXML(out);
+  out += wxT("</r></sm>");
 }
 
 wxString SumCell::ToMathML() const
 {
-  wxString base = Base()->ListToMathML();
+  wxString mathML;
+  AppendMathML(mathML);
+  return mathML;
+}
 
+void SumCell::AppendMathML(wxString &out) const
+{
   wxString from;
   if (m_under) from = m_under->ListToMathML();
 
   wxString to;
   if (m_over) to = m_over->ListToMathML();
 
-  wxString retval;
+  wxString const op = (m_sumStyle == SM_SUM) ? wxT("<mo>&#x2211;</mo>") : wxT("<mo>&#x220F;</mo>");
 
-  if (m_sumStyle == SM_SUM)
+  out += wxT("<mrow>");
+  if (from.IsEmpty() && to.IsEmpty())
+    out += op;
+  if (from.IsEmpty() && !to.IsEmpty())
   {
-    if (from.IsEmpty() && to.IsEmpty())
-      retval = wxT("<mo>&#x2211;</mo>") + base;
-    if (from.IsEmpty() && !to.IsEmpty())
-      retval = wxT("<mover><mo>&#x2211;</mo>") + to + wxT("</mover>") + base;
-    if (!from.IsEmpty() && to.IsEmpty())
-      retval = wxT("<munder><mo>&#x2211;</mo>") + from + wxT("</munder>") + base;
-    if (!from.IsEmpty() && !to.IsEmpty())
-      retval = wxT("<munderover><mo>&#x2211;</mo>") + from + to + wxT("</munderover>") + base;
+    out += wxT("<mover>");
+    out += op;
+    out += to;
+    out += wxT("</mover>");
   }
-  else
+  if (!from.IsEmpty() && to.IsEmpty())
+  {
+    out += wxT("<munder>");
+    out += op;
+    out += from;
+    out += wxT("</munder>");
+  }
+  if (!from.IsEmpty() && !to.IsEmpty())
   {
-    // A product
-    if (from.IsEmpty() && to.IsEmpty())
-      retval = wxT("<mo>&#x220F;</mo>") + base;
-    if (from.IsEmpty() && !to.IsEmpty())
-      retval = wxT("<mover><mo>&#x220F;</mo>") + to + wxT("</mover>") + base;
-    if (!from.IsEmpty() && to.IsEmpty())
-      retval = wxT("<munder><mo>&#x220F;</mo>") + from + wxT("</munder>") + base;
-    if (!from.IsEmpty() && !to.IsEmpty())
-      retval = wxT("<munderover><mo>&#x220F;</mo>") + from + to + wxT("</munderover>") + base;
+    out += wxT("<munderover>");
+    out += op;
+    out += from;
+    out += to;
+    out += wxT("</munderover>");
   }
-  return (wxT("<mrow>") + retval + wxT("</mrow>"));
+  Base()->ListAppendMathML(out);
+  out += wxT("</mrow>");
 }
 
 void SumCell::Unbreak()
@@ -94,7 +94,7 @@ bool Svgout::Layout()
   return true;
 }
 
-static wxDataFormat &Format()
+const wxDataFormat &Svgout::GetDataFormat()
 {
   static wxDataFormat format(wxT("image/svg+xml"));
   return format;
@@ -102,10 +102,10 @@ static wxDataFormat &Format()
 
 std::unique_ptr<wxCustomDataObject> Svgout::GetDataObject()
 {
-  return m_cmn.GetDataObject(Format());
+  return m_cmn.GetDataObject(GetDataFormat());
 }
 
 bool Svgout::ToClipboard()
 {
-  return m_cmn.ToClipboard(Format());
+  return m_cmn.ToClipboard(GetDataFormat());
 }
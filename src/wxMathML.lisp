@@ -94,7 +94,10 @@
 	       (tmp-x (wxxml-string-substitute "&#13;" #\Return tmp-x))
 	       (tmp-x (wxxml-string-substitute "&#13;" #\Linefeed tmp-x))
 	       (tmp-x (wxxml-string-substitute "&#13;" #\Newline tmp-x))
-	       (tmp-x (wxxml-string-substitute "&quot;" #\" tmp-x)))
+	       (tmp-x (wxxml-string-substitute "&quot;" #\" tmp-x))
+	       ;; ^A starts a frame and isn't allowed in XML, anyway.
+	       ;; Display it as the "start of heading" symbol instead.
+	       (tmp-x (wxxml-string-substitute "&#x2401;" (code-char 1) tmp-x)))
 	  tmp-x)
       x))
 
@@ -102,12 +105,45 @@
   (defun wxxml-alt-copy-text (x)
     (wxxml-fix-string (format nil "~{~a~}" (mstring x))))
     
+  ;; Length-prefixed framing of the messages wxMaxima parses.
+  ;; A frame is ^A, a type character, the payload's length in bytes, ^B and the
+  ;; payload. wxMaxima can hand a frame to its worksheet as soon as the last byte
+  ;; has arrived instead of waiting for a newline or a timeout.
+  (defvar *wx-framed-output* nil "Send structured output to wxMaxima in frames?")
+
+  ;; The length of a string in bytes, once it has been encoded as UTF-8
+  (defun wx-utf8-length (str)
+    #+gcl (length str)
+    #-gcl (let ((len 0))
+	    (loop for c across str do
+		  (let ((code (char-code c)))
+		    (incf len (cond ((< code #x80) 1)
+				    ((< code #x800) 2)
+				    ((< code #x10000) 3)
+				    (t 4)))))
+	    len))
+
+  (defun wx-send-frame (type str)
+    (if *wx-framed-output*
+	(format t "~c~c~d~c~a"
+		(code-char 1) type (wx-utf8-length str) (code-char 2) str)
+      (princ str)))
+
+  ;; Called by wxMaxima if it wants frames. The empty hello frame tells
+  ;; wxMaxima we understood.
+  (defun wx-enable-framing ()
+    (finish-output)
+    (setq *wx-framed-output* t)
+    (wx-send-frame #\H "")
+    (finish-output))
+
   ;; Allow the user to communicate what to display in the statusbar whilst
   ;; the current program is running
   (defun $wxstatusbar (&rest status)
     (finish-output)
-    (format t "<statusbar>~a</statusbar>~%" (wxxml-fix-string
-					     (apply '$sconcat status)))
+    (wx-send-frame #\S (format nil "<statusbar>~a</statusbar>~%"
+			       (wxxml-fix-string
+				(apply '$sconcat status))))
     (finish-output)
     )
 
@@ -1295,8 +1331,9 @@
     (finish-output)
     (let ((*print-circle* nil)
 	  (*wxxml-mratp* (format nil "~{~a~}" (cdr (checkrat x)))))
-      (mapc #'princ
-	    (wxxml x '("<math>") '("</math>") 'mparen 'mparen)))
+      (wx-send-frame #\M
+		     (format nil "~{~a~}"
+			     (wxxml x '("<math>") '("</math>") 'mparen 'mparen))))
     (finish-output)
     )
 
@@ -33,6 +33,8 @@
 #define wxNO_UNSAFE_WXSTRING_CONV 1
 #include <wx/notifmsg.h>
 #include "MaximaTokenizer.h"
+#include "CommandPreprocessor.h"
+#include "Profiler.h"
 #if defined __WXMSW__
 //#include <wchar.h>
 #endif
@@ -1105,8 +1107,8 @@ wxMaxima::wxMaxima(wxWindow *parent, int id, wxLocale *locale, const wxString ti
           wxCommandEventHandler(wxMaxima::InsertMenu), NULL, this);
   Connect(Worksheet::Worksheet::popid_never_autoanswer, wxEVT_MENU,
           wxCommandEventHandler(wxMaxima::InsertMenu), NULL, this);
-  Connect(history_ctrl_id, wxEVT_LISTBOX_DCLICK,
-          wxCommandEventHandler(wxMaxima::HistoryDClick), NULL, this);
+  Connect(history_ctrl_id, wxEVT_LIST_ITEM_ACTIVATED,
+          wxListEventHandler(wxMaxima::HistoryDClick), NULL, this);
   Connect(structure_ctrl_id, wxEVT_LIST_ITEM_ACTIVATED,
           wxListEventHandler(wxMaxima::TableOfContentsSelection), NULL, this);
   Connect(menu_stats_histogram, wxEVT_BUTTON,
@@ -1205,6 +1207,7 @@ void wxMaxima::StartAutoSaveTimer()
 
 wxMaxima::~wxMaxima()
 {
+  m_importer.reset();
   KillMaxima(false);
   MyApp::DelistTopLevelWindow(this);
 
@@ -1310,7 +1313,20 @@ TextCell *wxMaxima::ConsoleAppend(wxString s, CellType type, const wxString &use
   if (t.IsEmpty())
     return NULL;
 
-  if (m_maxOutputCellsPerCommand > 0)
+  if ((m_maxOutputCellsPerCommand > 0) && (m_worksheet->m_configuration->KeepNewestOutput()))
+  {
+    // Discard the oldest lines. This is done in batches so the output isn't laid
+    // out anew for every new line. Both the limit and the group count lines of
+    // output, not the strings maxima has sent.
+    GroupCell *group = m_worksheet->GetInsertGroup();
+    if (group &&
+        (group->GetOutputLineCount() > m_maxOutputCellsPerCommand + m_maxOutputCellsPerCommand / 4))
+    {
+      group->DiscardOldestOutput(group->GetOutputLineCount() - m_maxOutputCellsPerCommand);
+      m_worksheet->ScheduleRecalculation(group);
+    }
+  }
+  else if (m_maxOutputCellsPerCommand > 0)
   {
     // If we already have output more lines than we are allowed, we inform the user
     // about this and return.
@@ -1402,9 +1418,14 @@ void wxMaxima::DoConsoleAppend(wxString s, CellType type, AppendOpt opts, const
 
   s.Replace(wxT("\n"), wxT(" "), true);
 
+  GroupCell *const group = m_worksheet->GetInsertGroup();
   m_parser.SetUserLabel(userLabel);
-  m_parser.SetGroup(m_worksheet->GetInsertGroup());
-  std::unique_ptr<Cell> cell(m_parser.ParseLine(s, type));
+  m_parser.SetGroup(group);
+  std::unique_ptr<Cell> cell;
+  {
+    Profiler::CellScope cellTimer(group, Profiler::cellParse);
+    cell = m_parser.ParseLine(s, type);
+  }
   m_parser.SetGroup(nullptr);
 
   wxASSERT_MSG(cell, _("There was an error in generated XML!\n\n"
@@ -1475,10 +1496,16 @@ TextCell *wxMaxima::DoRawConsoleAppend(wxString s, CellType type, AppendOpt opts
       incompleteTextCell->SetValue(newVal);
       if (ownedCell)
         m_worksheet->InsertLine(std::move(ownedCell));
+      else
+      {
+        // A line that already was laid out has changed its length.
+        GroupCell *group = m_worksheet->GetInsertGroup();
+        if (group)
+          m_worksheet->Recalculate(group);
+      }
       if(s.IsEmpty())
       {
-        incompleteTextCell->GetGroup()->ResetSize();
-        incompleteTextCell->GetGroup()->Recalculate();
+        m_worksheet->RequestRedraw();
         return incompleteTextCell;
       }
     }
@@ -1517,10 +1544,11 @@ TextCell *wxMaxima::DoRawConsoleAppend(wxString s, CellType type, AppendOpt opts
     m_worksheet->InsertLine(std::move(tree), true);
   }
 
+  // InsertLine() has already scheduled laying out the new output: All lines
+  // that arrive before wxMaxima is idle again are laid out in one go.
   if(cell)
   {
     m_worksheet->m_configuration->AdjustWorksheetSize();
-    m_worksheet->Recalculate(cell->GetGroup());
     if (scrollToCaret)
       m_worksheet->ScrollToCaret();
     m_worksheet->RequestRedraw();
@@ -1528,17 +1556,9 @@ TextCell *wxMaxima::DoRawConsoleAppend(wxString s, CellType type, AppendOpt opts
   return cell;
 }
 
-/*! Remove empty statements
- *
- * We need to remove any statement which would be considered empty
- * and thus cause an error. Comments within non-empty expressions seem to
- * be fine.
- *
- * What we need to remove is any statements which are any amount of whitespace
- * and any amount of comments, in any order, ended by a semicolon,
- * and nothing else.
+/*! Remove comments from a :lisp command
  *
- * The most that should be left over is a single empty statement, ";".
+ * Empty statements in maxima commands are removed by the CommandPreprocessor.
  *
  * @param s The command string from which to remove comment expressions.
  */
@@ -1556,8 +1576,6 @@ void wxMaxima::StripLispComments(wxString &s)
       s = s.SubString(0, commentStart - 1) + s.SubString(commentEnd, s.length());
     }
   }
-  else
-    m_blankStatementRegEx.Replace(&s, wxT(";"));
 }
 
 void wxMaxima::SendMaxima(wxString s, bool addToHistory)
@@ -1565,11 +1583,13 @@ void wxMaxima::SendMaxima(wxString s, bool addToHistory)
   // Normally we catch parenthesis errors before adding cells to the
   // evaluation queue. But if the error is introduced only after the
   // cell is placed in the evaluation queue we need to catch it here.
-  int index;
-  wxString parenthesisError = GetUnmatchedParenthesisState(s,index);
+  // The same pass over the command converts unicode operators, removes
+  // empty statements and finds the definitions autocompletion needs.
+  CommandPreprocessor command(s, m_worksheet->m_configuration);
+  wxString parenthesisError = command.GetError();
   if (parenthesisError.IsEmpty())
   {
-    s = m_worksheet->UnicodeToMaxima(s);
+    s.swap(command.GetCommand());
 
     if ((m_xmlInspector) && (IsPaneDisplayed(menu_pane_xmlInspector)))
       m_xmlInspector->Add_ToMaxima(s);
@@ -1579,49 +1599,22 @@ void wxMaxima::SendMaxima(wxString s, bool addToHistory)
     if (addToHistory)
       AddToHistory(s);
 
-    StripLispComments(s);
-
     if (s.StartsWith(wxT(":lisp ")) || s.StartsWith(wxT(":lisp\n")))
+    {
+      StripLispComments(s);
       s.Replace(wxT("\n"), wxT(" "));
+    }
 
     s.Trim(true);
     s.Append(wxT("\n"));
 
-    /// Check for function/variable definitions
-    wxStringTokenizer commands(s, wxT(";$"));
-    while (commands.HasMoreTokens())
+    /// Tell the autocompletion about function/variable definitions
+    for (auto const &var : command.GetVariables())
+      m_worksheet->AddSymbol(var);
+    for (auto const &fun : command.GetFunctions())
     {
-      wxString line = commands.GetNextToken();
-      if (m_varRegEx.Matches(line))
-        m_worksheet->AddSymbol(m_varRegEx.GetMatch(line, 1));
-
-      if (m_funRegEx.Matches(line))
-      {
-        wxString funName = m_funRegEx.GetMatch(line, 1);
-        m_worksheet->AddSymbol(funName);
-
-        /// Create a template from the input
-        wxString args = m_funRegEx.GetMatch(line, 2);
-        wxStringTokenizer argTokens(args, wxT(","));
-        funName << wxT("(");
-        int count = 0;
-        while (argTokens.HasMoreTokens())
-        {
-          if (count > 0)
-            funName << wxT(",");
-          wxString a = argTokens.GetNextToken().Trim().Trim(false);
-          if (a != wxEmptyString)
-          {
-            if (a[0] == '[')
-              funName << wxT("[<") << a.SubString(1, a.Length() - 2) << wxT(">]");
-            else
-              funName << wxT("<") << a << wxT(">");
-            count++;
-          }
-        }
-        funName << wxT(")");
-        m_worksheet->AddSymbol(funName, AutoComplete::tmplte);
-      }
+      m_worksheet->AddSymbol(fun.name);
+      m_worksheet->AddSymbol(fun.functionTemplate, AutoComplete::tmplte);
     }
 
     if ((m_client) && (m_client->IsConnected()) && (s.Length() >= 1))
@@ -1634,8 +1627,7 @@ void wxMaxima::SendMaxima(wxString s, bool addToHistory)
       else
         StatusMaximaBusy(waiting);
 
-      wxScopedCharBuffer const data_raw = s.utf8_str();
-      m_client->Write(data_raw.data(), data_raw.length());
+      m_client->Write(s);
       m_statusBar->NetworkStatus(StatusBar::transmit);
     }
   }
@@ -2316,6 +2308,7 @@ void wxMaxima::ReadFirstPrompt(wxString &data)
     {
       wxLogMessage(_("Starting evaluation of the document"));
       m_evalOnStartup = false;
+      FinishImport();
       m_worksheet->AddDocumentToEvaluationQueue();
       EvaluationQueueLength(m_worksheet->m_evaluationQueue.Size(), m_worksheet->m_evaluationQueue.CommandsLeftInCell());
       TriggerEvaluation();
@@ -3228,6 +3221,10 @@ void wxMaxima::ReadPrompt(wxString &data)
   {
     // Maxima displayed a new main prompt => We don't have a question
     m_worksheet->QuestionAnswered();
+    // The command the working group has sent is finished.
+    if (m_worksheet->GetWorkingGroup())
+      Profiler::AddCellCost(m_worksheet->GetWorkingGroup(), Profiler::cellEvaluation,
+                            Profiler::Clock::now() - m_commandSent);
     // And we can remove one command from the evaluation queue.
     m_worksheet->m_evaluationQueue.RemoveFirst();
 
@@ -3392,23 +3389,36 @@ bool wxMaxima::OpenMACFile(const wxString &file, Worksheet *document, bool clear
 
   bool xMaximaFile = file.Lower().EndsWith(wxT(".out"));
 
-  // open mac file
-  wxTextFile inputFile(file);
-
-  if (!inputFile.Open())
+  if (ImportInBackground(file, clearDocument))
   {
-    LoggingMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"), wxOK | wxICON_EXCLAMATION);
-    StatusMaximaBusy(waiting);
-    RightStatusText(_("File could not be opened"));
-    return false;
+    m_importer.reset();
+    document->ClearDocument();
+    m_importer = std::make_unique<DocumentImporter>(
+      file, xMaximaFile ? DocumentImporter::xMaximaOutput : DocumentImporter::mac, document);
   }
+  else
+  {
+    // open mac file
+    wxTextFile inputFile(file);
 
-  if (clearDocument)
-    document->ClearDocument();
+    if (!inputFile.Open())
+    {
+      LoggingMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"), wxOK | wxICON_EXCLAMATION);
+      StatusMaximaBusy(waiting);
+      RightStatusText(_("File could not be opened"));
+      return false;
+    }
 
-  auto tree = Format::ParseMACFile(inputFile, xMaximaFile, &document->m_configuration);
+    if (clearDocument)
+    {
+      m_importer.reset();
+      document->ClearDocument();
+    }
+
+    auto tree = Format::ParseMACFile(inputFile, xMaximaFile, &document->m_configuration);
 
-  document->InsertGroupCells(std::move(tree), nullptr);
+    document->InsertGroupCells(std::move(tree), nullptr);
+  }
 
   if (clearDocument)
   {
@@ -3447,35 +3457,52 @@ bool wxMaxima::OpenWXMFile(const wxString &file, Worksheet *document, bool clear
   RightStatusText(_("Opening file"));
   wxWindowUpdateLocker noUpdates(document);
 
-  // open wxm file
-  wxTextFile inputFile(file);
-
-  if (!inputFile.Open())
+  bool const inBackground = ImportInBackground(file, clearDocument);
+  std::unique_ptr<GroupCell> tree;
+  if (inBackground)
   {
-    LoggingMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"), wxOK | wxICON_EXCLAMATION);
-    StatusMaximaBusy(waiting);
-    RightStatusText(_("File could not be opened"));
-    return false;
+    if (!DocumentImporter::HasWXMHeader(file))
+    {
+      LoggingMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"), wxOK | wxICON_EXCLAMATION);
+      return false;
+    }
   }
-
-  if (inputFile.GetFirstLine() != Format::WXMFirstLine)
+  else
   {
+    // open wxm file
+    wxTextFile inputFile(file);
+
+    if (!inputFile.Open())
+    {
+      LoggingMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"), wxOK | wxICON_EXCLAMATION);
+      StatusMaximaBusy(waiting);
+      RightStatusText(_("File could not be opened"));
+      return false;
+    }
+
+    if (inputFile.GetFirstLine() != Format::WXMFirstLine)
+    {
+      inputFile.Close();
+      LoggingMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"), wxOK | wxICON_EXCLAMATION);
+      return false;
+    }
+
+    tree = Format::ParseWXMFile(inputFile, &m_worksheet->m_configuration);
     inputFile.Close();
-    LoggingMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"), wxOK | wxICON_EXCLAMATION);
-    return false;
   }
 
-  auto tree = Format::ParseWXMFile(inputFile, &m_worksheet->m_configuration);
-  inputFile.Close();
-
   // from here on code is identical for wxm and wxmx
   if (clearDocument)
   {
+    m_importer.reset();
     document->ClearDocument();
     StartMaxima();
   }
 
-  document->InsertGroupCells(std::move(tree)); // this also requests a recalculate
+  if (inBackground)
+    m_importer = std::make_unique<DocumentImporter>(file, DocumentImporter::wxm, document);
+  else
+    document->InsertGroupCells(std::move(tree)); // this also requests a recalculate
 
   if (clearDocument)
   {
@@ -3500,6 +3527,21 @@ bool wxMaxima::OpenWXMFile(const wxString &file, Worksheet *document, bool clear
   return true;
 }
 
+bool wxMaxima::ImportInBackground(const wxString &file, bool clearDocument) const
+{
+  // Batch mode needs the whole document before it can start evaluating it.
+  return clearDocument && !m_exitAfterEval && !m_evalOnStartup &&
+    DocumentImporter::IsWorthStreaming(file);
+}
+
+void wxMaxima::FinishImport()
+{
+  if (!m_importer)
+    return;
+  m_importer->Finish();
+  m_importer.reset();
+}
+
 wxString wxMaxima::ReadPotentiallyUnclosedTag(wxStringTokenizer &lines, wxString firstLine)
 {
   wxString result = firstLine + wxT("\n");
@@ -3565,6 +3607,7 @@ bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document, bool clea
   //    an entry that creates valid empty .wxmx files.
   if (wxFile(file, wxFile::read).Eof())
   {
+    m_importer.reset();
     document->ClearDocument();
     StartMaxima();
 
@@ -3789,11 +3832,13 @@ bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document, bool clea
 
   // Read the worksheet's contents.
   wxXmlNode *xmlcells = xmldoc.GetRoot();
-  auto tree = CreateTreeFromXMLNode(xmlcells, wxmxURI);
+  OutputPreviews previews = ReadOutputPreviews(wxmxURI);
+  auto tree = CreateTreeFromXMLNode(xmlcells, wxmxURI, &previews);
 
   // from here on code is identical for wxm and wxmx
   if (clearDocument)
   {
+    m_importer.reset();
     document->ClearDocument();
     StartMaxima();
     long int zoom = 100;
@@ -3803,6 +3848,8 @@ bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document, bool clea
   }
 
   document->InsertGroupCells(std::move(tree)); // this also requests a recalculate
+  if (!previews.empty())
+    document->OutputPreviewsLoaded();
   if (clearDocument)
   {
     m_worksheet->m_currentFile = file;
@@ -3908,6 +3955,7 @@ bool wxMaxima::OpenXML(const wxString &file, Worksheet *document)
   wxXmlNode *xmlcells = xmldoc.GetRoot();
   auto tree = CreateTreeFromXMLNode(xmlcells, file);
 
+  m_importer.reset();
   document->ClearDocument();
   StartMaxima();
   document->InsertGroupCells(std::move(tree)); // this also requests a recalculate
@@ -3922,7 +3970,54 @@ bool wxMaxima::OpenXML(const wxString &file, Worksheet *document)
   return true;
 }
 
-std::unique_ptr<GroupCell> wxMaxima::CreateTreeFromXMLNode(wxXmlNode *xmlcells, const wxString &wxmxfilename)
+wxMaxima::OutputPreviews wxMaxima::ReadOutputPreviews(const wxString &wxmxURI)
+{
+  OutputPreviews previews;
+  wxFileSystem fs;
+  std::unique_ptr<wxFSFile> indexFile(fs.OpenFile(wxmxURI + wxT("#zip:previews/index.xml")));
+  if (!indexFile)
+    return previews;
+
+  wxXmlDocument index;
+  if (!index.Load(*(indexFile->GetStream()), wxT("UTF-8")) ||
+      (index.GetRoot()->GetName() != wxT("previews")))
+    return previews;
+
+  long zoom = 100;
+  if (!index.GetRoot()->GetAttribute(wxT("zoom"), wxT("100")).ToLong(&zoom) || (zoom <= 0))
+    zoom = 100;
+
+  for (wxXmlNode *node = index.GetRoot()->GetChildren(); node; node = node->GetNext())
+  {
+    if (node->GetName() != wxT("preview"))
+      continue;
+    long cell, width, height;
+    if (!node->GetAttribute(wxT("cell")).ToLong(&cell) ||
+        !node->GetAttribute(wxT("width")).ToLong(&width) ||
+        !node->GetAttribute(wxT("height")).ToLong(&height))
+      continue;
+
+    std::unique_ptr<wxFSFile> png(
+      fs.OpenFile(wxmxURI + wxString::Format(wxT("#zip:previews/%li.png"), cell)));
+    if (!png)
+      continue;
+    MathParser::OutputPreview &preview = previews[cell];
+    wxInputStream *stream = png->GetStream();
+    while (stream->IsOk() && !stream->Eof())
+    {
+      constexpr size_t chunkSize = 8192;
+      auto *buf = preview.png.GetAppendBuf(chunkSize);
+      stream->Read(buf, chunkSize);
+      preview.png.UngetAppendBuf(stream->LastRead());
+    }
+    preview.size = wxSize(width, height);
+    preview.zoom = zoom / 100.0;
+  }
+  return previews;
+}
+
+std::unique_ptr<GroupCell> wxMaxima::CreateTreeFromXMLNode(wxXmlNode *xmlcells, const wxString &wxmxfilename,
+                                                           const OutputPreviews *previews)
 {
   // Show a busy cursor as long as we export a .gif file (which might be a lengthy
   // action).
@@ -3936,10 +4031,18 @@ std::unique_ptr<GroupCell> wxMaxima::CreateTreeFromXMLNode(wxXmlNode *xmlcells,
   if (xmlcells)
     xmlcells = xmlcells->GetChildren();
 
+  // The number of the cell, as counted by Worksheet::WriteOutputPreviews()
+  long cellNumber = 0;
   for (; xmlcells; xmlcells = xmlcells->GetNext())
   {
     if (xmlcells->GetType() != wxXML_TEXT_NODE)
     {
+      if (previews)
+      {
+        auto const preview = previews->find(cellNumber);
+        mp.SetOutputPreview((preview != previews->end()) ? &preview->second : NULL);
+      }
+      cellNumber++;
       bool ok = tree.DynamicAppend(mp.ParseTag(xmlcells, false));
       if (!ok && warning)
       {
@@ -3971,6 +4074,14 @@ void wxMaxima::SetupVariables()
   wxLogMessage(_("Sending maxima the info how to express 2d maths as XML"));
   wxMathML wxmathml(m_worksheet->m_configuration);
   SendMaxima(wxmathml.GetCmd());
+  if (m_worksheet->m_configuration->FramedMaximaProtocol())
+  {
+    // If the wxMathML.lisp we use doesn't know about frames maxima simply
+    // won't send any and we continue to work the old way.
+    wxLogMessage(_("Asking maxima to send length-prefixed messages"));
+    m_client->EnableFraming();
+    SendMaxima(wxT(":lisp-quiet (ignore-errors (wx-enable-framing))\n"));
+  }
   wxString cmd;
 
 #if defined (__WXOSX__)
@@ -4216,12 +4327,6 @@ void wxMaxima::ShowHelp(const wxString &keyword)
 
 void wxMaxima::ShowMaximaHelp(wxString keyword)
 {
-  if(m_worksheet->m_helpfileanchorsThread)
-  {
-    m_worksheet->m_helpfileanchorsThread->join();
-    m_worksheet->m_helpfileanchorsThread.reset();
-  }
-
   if(keyword.StartsWith("(%i"))
     keyword = "inchar";
   if(keyword.StartsWith("(%o"))
@@ -4232,9 +4337,7 @@ void wxMaxima::ShowMaximaHelp(wxString keyword)
   MaximaHelpFile.Replace("\\", "/", true);
 #endif
 
-  wxBusyCursor crs;
-  m_worksheet->CompileHelpFileAnchors();
-  keyword = m_worksheet->m_helpFileAnchors[keyword];
+  keyword = m_worksheet->GetHelpFileAnchor(keyword);
   if(keyword.IsEmpty())
     keyword = "Function-and-Variable-Index";
   if(!MaximaHelpFile.IsEmpty())
@@ -4266,6 +4369,7 @@ bool wxMaxima::InterpretDataFromMaxima(const wxString &newData)
 {
   if (newData.empty())
     return false;
+  Profiler::Scope timer(Profiler::interpretData);
 
   if(!m_worksheet->m_evaluationQueue.Empty())
     m_fastResponseTimer.StartOnce(120);
@@ -4492,6 +4596,10 @@ void wxMaxima::OnIdle(wxIdleEvent &event)
     return;
   }
 
+  // Convert the outputs of a .wxmx file that are displayed as pictures to
+  // cells, one at a time. The tasks below still get their turn in this pass.
+  bool const outputPreviewsLeft = (m_worksheet != NULL) && m_worksheet->ReplaceOutputPreview();
+
   // If wxMaxima has to open a file on startup we wait for that until we have
   // a valid draw context for size calculations.
   //
@@ -4539,7 +4647,7 @@ void wxMaxima::OnIdle(wxIdleEvent &event)
     return;
   }
 
-  if (m_ipc.DrainQueue())
+  if (m_ipc.DrainQueue() || outputPreviewsLeft)
   {
     event.RequestMore();
     return;
@@ -4604,6 +4712,8 @@ void wxMaxima::PrintMenu(wxCommandEvent &event)
 {
   if(m_worksheet != NULL)
     m_worksheet->CloseAutoCompletePopup();
+  // We want to print the whole file, not the part that already has been loaded
+  FinishImport();
 
   switch (event.GetId())
   {
@@ -5013,6 +5123,9 @@ bool wxMaxima::SaveFile(bool forceSave)
   // Show a busy cursor as long as we export a file.
   wxBusyCursor crs;
 
+  // We don't want to save half of a file that is still being loaded
+  FinishImport();
+
   wxString file = m_worksheet->m_currentFile;
   wxString fileExt = wxT("wxmx");
   int ext = 0;
@@ -5395,6 +5508,7 @@ bool wxMaxima::AutoSave()
   if(!SaveNecessary())
     return true;
 
+  FinishImport();
   bool savedWas = m_worksheet->IsSaved();
   wxString oldTempFile = m_tempfileName;
   wxString oldFilename = m_worksheet->m_currentFile;
@@ -5516,6 +5630,8 @@ void wxMaxima::FileMenu(wxCommandEvent &event)
 
     case menu_export_html:
     {
+      // We don't want to export half of a file that is still being loaded
+      FinishImport();
       // Determine a sane default file name;
       wxString file = m_worksheet->m_currentFile;
 
@@ -5862,6 +5978,8 @@ void wxMaxima::EditMenu(wxCommandEvent &event)
       m_worksheet->CutToClipboard();
     break;
   case wxID_SELECTALL:
+    // "All" includes the part of the file that still is being loaded
+    FinishImport();
     m_worksheet->SelectAll();
     break;
   case wxID_PASTE:
@@ -6281,6 +6399,7 @@ void wxMaxima::MaximaMenu(wxCommandEvent &event)
     case menu_evaluate_all_visible:
     case ToolBar::tb_eval_all:
     {
+      FinishImport();
       m_worksheet->m_evaluationQueue.Clear();
       m_worksheet->ResetInputPrompts();
       EvaluationQueueLength(0);
@@ -6294,6 +6413,7 @@ void wxMaxima::MaximaMenu(wxCommandEvent &event)
       break;
     case menu_evaluate_all:
     {
+      FinishImport();
       m_worksheet->m_evaluationQueue.Clear();
       m_worksheet->ResetInputPrompts();
       EvaluationQueueLength(0);
@@ -9075,6 +9195,7 @@ void wxMaxima::PopupMenu(wxCommandEvent &event)
   }
   break;
   case ToolBar::tb_evaluate_rest:
+    FinishImport();
     m_worksheet->AddRestToEvaluationQueue();
     EvaluationQueueLength(m_worksheet->m_evaluationQueue.Size(), m_worksheet->m_evaluationQueue.CommandsLeftInCell());
     TriggerEvaluation();
@@ -9595,103 +9716,10 @@ void wxMaxima::EvaluateEvent(wxCommandEvent &WXUNUSED(event))
 
 wxString wxMaxima::GetUnmatchedParenthesisState(wxString text,int &index)
 {
-  text.Trim(true);
-  text.Trim(false);
-  if(text.IsEmpty())
-    return (wxEmptyString);
-  if (text.EndsWith(wxT("\\")))
-    return (_("Cell ends in a backslash"));
-
-
-  index = 0;
-  bool endingNeeded = true;
-  wxChar lastnonWhitespace;
-  wxChar lastnonWhitespace_Next = wxT(' ');
-  std::list<wxChar> delimiters;
-
-  for (auto const &tok : MaximaTokenizer(text, m_worksheet->m_configuration).PopTokens())
-  {
-    auto &itemText = tok.GetText();
-    const TextStyle itemStyle = tok.GetStyle();
-    index += itemText.Length();
-
-    lastnonWhitespace = lastnonWhitespace_Next;
-
-    // Handle comments
-    if(itemStyle == TS_CODE_COMMENT)
-    {
-      if(!itemText.EndsWith("*/"))
-        return (_("Unterminated comment."));
-      continue;
-    }
-
-    wxChar firstC = itemText[0];
-    wxChar lastC = itemText.Last();
-
-    // Remember the last non-whitespace character that isn't part
-    // of a comment.
-    if((firstC != ' ') && (firstC != '\t') && (firstC != '\r') && (firstC != '\n'))
-      lastnonWhitespace_Next = lastC;
-
-    // Handle opening parenthesis
-    if(itemText == "(")
-    {
-      delimiters.push_back(wxT(')'));
-      continue;
-    }
-    if(itemText == "[")
-    {
-      delimiters.push_back(wxT(']'));
-      continue;
-    }
-    if(itemText == "{")
-    {
-      delimiters.push_back(wxT('}'));
-      continue;
-    }
-
-    // Handle closing parenthesis
-    if((itemText == ')') || (itemText == ']') || (itemText == '}'))
-    {
-      endingNeeded = true;
-      if (delimiters.empty()) return (_("Mismatched parenthesis"));
-      if (firstC != delimiters.back()) return (_("Mismatched parenthesis"));
-      delimiters.pop_back();
-      if (lastnonWhitespace == wxT(','))
-        return (_("Comma directly followed by a closing parenthesis"));
-      continue;
-    }
-
-    if(itemStyle == TS_CODE_STRING)
-    {
-      endingNeeded = true;
-      if(!itemText.EndsWith("\""))
-        return (_("Unterminated string."));
-      continue;
-    }
-
-    if(itemStyle == TS_CODE_ENDOFLINE)
-    {
-      if(!delimiters.empty())
-        return _("Un-closed parenthesis on encountering ; or $");
-      endingNeeded = false;
-      continue;
-    }
-
-    if(itemStyle == TS_CODE_LISP)
-    {
-      endingNeeded = false;
-      continue;
-    }
-  }
-
-  if (!delimiters.empty())
-    return _("Un-closed parenthesis");
-
-  if((endingNeeded) && (!m_worksheet->m_configuration->InLispMode()))
-    return _("No dollar ($) or semicolon (;) at the end of command");
-  else
-    return wxEmptyString;
+  CommandPreprocessor command(text, m_worksheet->m_configuration,
+                              CommandPreprocessor::checkOnly);
+  index = command.GetErrorIndex();
+  return command.GetError();
 }
 
 //! Tries to evaluate next group cell in queue
@@ -9804,6 +9832,7 @@ void wxMaxima::TriggerEvaluation()
 
       SendMaxima(m_configCommands);
       SendMaxima(text, true);
+      m_commandSent = Profiler::Clock::now();
       m_maximaBusy = true;
       // Now that we have sent a command we need to query all variable values anew
       m_varNamesToQuery = m_worksheet->m_variablesPane->GetEscapedVarnames();
@@ -10256,10 +10285,10 @@ void wxMaxima::NetworkDClick(wxCommandEvent &WXUNUSED(event))
   m_manager.Update();
 }
 
-void wxMaxima::HistoryDClick(wxCommandEvent &event)
+void wxMaxima::HistoryDClick(wxListEvent &event)
 {
   m_worksheet->CloseAutoCompletePopup();
-  m_worksheet->OpenHCaret(event.GetString(), GC_TYPE_CODE);
+  m_worksheet->OpenHCaret(m_history->GetShownCommand(event.GetIndex()), GC_TYPE_CODE);
   m_worksheet->SetFocus();
 }
 
@@ -10488,9 +10517,6 @@ bool wxMaxima::m_exitOnError = false;
 wxString wxMaxima::m_extraMaximaArgs;
 int wxMaxima::m_exitCode = 0;
 //wxRegEx  wxMaxima::m_outputPromptRegEx(wxT("<lbl>.*</lbl>"));
-wxRegEx  wxMaxima::m_funRegEx(wxT("^ *([[:alnum:]%_]+) *\\(([[:alnum:]%_,[[.].] ]*)\\) *:="));
-wxRegEx  wxMaxima::m_varRegEx(wxT("^ *([[:alnum:]%_]+) *:"));
-wxRegEx  wxMaxima::m_blankStatementRegEx(wxT("(^;)|((^|;)(((\\/\\*.*\\*\\/)?([[:space:]]*))+;)+)"));
 wxRegEx  wxMaxima::m_sbclCompilationRegEx(wxT("; compiling (.* \\.*)"));
 wxRegEx  wxMaxima::m_gnuplotErrorRegex(wxT("\".*\\.gnuplot\", line [0-9][0-9]*: "));
 wxString wxMaxima::m_promptPrefix(wxT("<PROMPT>"));
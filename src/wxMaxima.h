@@ -35,6 +35,8 @@
 #include "MathParser.h"
 #include "MaximaIPC.h"
 #include "Dirstructure.h"
+#include "DocumentImporter.h"
+#include "Profiler.h"
 #include <wx/socket.h>
 #include <wx/config.h>
 #include <wx/process.h>
@@ -47,6 +49,7 @@
 #include <wx/buffer.h>
 #include <wx/power.h>
 #include <memory>
+#include <unordered_map>
 #ifdef __WXMSW__
 #include <windows.h>
 #endif
@@ -203,6 +206,8 @@ private:
   int m_oldFindFlags;
   //! On opening a new file we only need a new maxima process if the old one ever evaluated cells.
   bool m_hasEvaluatedCells;
+  //! When the command maxima currently works on has been sent
+  Profiler::Clock::time_point m_commandSent;
   //! Searches for maxima's output prompts
 //  static wxRegEx m_outputPromptRegEx;
   //! The number of output cells the current command has produced so far.
@@ -409,7 +414,7 @@ protected:
   void NetworkDClick(wxCommandEvent &ev);
 
   //! Issued on double click on a history item
-  void HistoryDClick(wxCommandEvent &event);
+  void HistoryDClick(wxListEvent &event);
 
   //! Issued on double click on a table of contents item
   void TableOfContentsSelection(wxListEvent &event);
@@ -614,11 +619,28 @@ protected:
   //! Opens a wxm file
   bool OpenWXMFile(const wxString &file, Worksheet *document, bool clearDocument = true);
 
+  //! Shall this .wxm, .mac or .out file be loaded in the background?
+  bool ImportInBackground(const wxString &file, bool clearDocument) const;
+
+  //! Waits until a file that is loaded in the background has been loaded completely
+  void FinishImport();
+
   //! Opens a wxmx file
   bool OpenWXMXFile(const wxString &file, Worksheet *document, bool clearDocument = true);
 
-  //! Loads a wxmx description
-  std::unique_ptr<GroupCell> CreateTreeFromXMLNode(wxXmlNode *xmlcells, const wxString &wxmxfilename = {});
+  //! The pictures of the outputs stored in a .wxmx file, by the number of the cell
+  using OutputPreviews = std::unordered_map<long, MathParser::OutputPreview>;
+
+  //! Reads the pictures of the outputs a .wxmx file contains, if it contains any
+  static OutputPreviews ReadOutputPreviews(const wxString &wxmxURI);
+
+  /*! Loads a wxmx description
+
+    \param previews The pictures the outputs of the top-level cells are to be
+           displayed as until they have been converted to cells.
+   */
+  std::unique_ptr<GroupCell> CreateTreeFromXMLNode(wxXmlNode *xmlcells, const wxString &wxmxfilename = {},
+                                                   const OutputPreviews *previews = NULL);
 
   /*! Saves the current file
 
@@ -645,6 +667,8 @@ protected:
     return m_CWD;
   }
 
+  //! Appends the cells of a file that is loaded in the background
+  std::unique_ptr<DocumentImporter> m_importer;
   std::unique_ptr<Maxima> m_client;
   /*! The Right Way to delete a wxSocketServer
 
@@ -750,9 +774,6 @@ protected:
   //! The Char the current command starts at in the current WorkingGroup
   int m_commandIndex;
   wxFindReplaceData m_findData;
-  static wxRegEx m_funRegEx;
-  static wxRegEx m_varRegEx;
-  static wxRegEx m_blankStatementRegEx;
   static wxRegEx m_sbclCompilationRegEx;
   MathParser m_parser;
   bool m_maximaBusy;
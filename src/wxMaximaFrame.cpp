@@ -291,6 +291,19 @@ wxMaximaFrame::wxMaximaFrame(wxWindow *parent, int id, const wxString &title,
                     FloatingSize(m_logPane->GetEffectiveMinSize()).
                     Left());
 
+  PerformancePane *performancePane = new PerformancePane(this, m_worksheet, wxID_ANY);
+  m_manager.AddPane(performancePane,
+                    wxAuiPaneInfo().Name("performance").
+                    CloseButton(true).PinButton(false).
+                    Gripper(false).
+                    TopDockable(true).
+                    BottomDockable(true).
+                    LeftDockable(true).
+                    RightDockable(true).
+                    PaneBorder(true).
+                    FloatingSize(performancePane->GetEffectiveMinSize()).
+                    Left());
+
   m_worksheet->m_variablesPane = new Variablespane(this, wxID_ANY);
   wxWindowUpdateLocker variablesBlocker(m_worksheet->m_variablesPane);
   m_manager.AddPane(m_worksheet->m_variablesPane,
@@ -389,6 +402,7 @@ wxMaximaFrame::wxMaximaFrame(wxWindow *parent, int id, const wxString &title,
   m_manager.GetPane("math") = m_manager.GetPane("math").PinButton(false).Show(false).Movable(true);
   m_manager.GetPane("format") = m_manager.GetPane("format").PinButton(false).Show(false).Movable(true);
   m_manager.GetPane("log") = m_manager.GetPane("log").PinButton(false).Show(false).Movable(true);
+  m_manager.GetPane("performance") = m_manager.GetPane("performance").PinButton(false).Show(false).Movable(true);
 
   m_manager.GetPane("unicode") = m_manager.GetPane("unicode").
     Show(false).Gripper(false).CloseButton(true).PinButton(false).Movable(true);
@@ -453,6 +467,8 @@ wxMaximaFrame::wxMaximaFrame(wxWindow *parent, int id, const wxString &title,
 
   m_manager.GetPane(wxT("log")) =
     m_manager.GetPane(wxT("log")).Caption(_("Debug messages")).CloseButton(true).Resizable().Gripper(false).PaneBorder(true).Movable(true);
+  m_manager.GetPane(wxT("performance")) =
+    m_manager.GetPane(wxT("performance")).Caption(_("Performance")).CloseButton(true).Resizable().Gripper(false).PaneBorder(true).Movable(true);
   m_manager.GetPane(wxT("variables")) =
     m_manager.GetPane(wxT("variables")).Caption(_("Variables")).CloseButton(true).Resizable().Gripper(false).PaneBorder(true).Movable(true);
   m_manager.GetPane(wxT("math")) = m_manager.GetPane(wxT("math")).Caption(_("General Math")).
@@ -764,6 +780,7 @@ void wxMaximaFrame::SetupMenu()
   m_Maxima_Panes_Sub->AppendCheckItem(menu_pane_format, _("Insert Cell\tAlt+Shift+C"));
   m_Maxima_Panes_Sub->AppendCheckItem(menu_pane_draw, _("Plot using Draw"));
   m_Maxima_Panes_Sub->AppendCheckItem(menu_pane_log,   _("Debug messages"));
+  m_Maxima_Panes_Sub->AppendCheckItem(menu_pane_performance, _("Performance"));
   m_Maxima_Panes_Sub->AppendCheckItem(menu_pane_variables,   _("Variables"));
   m_Maxima_Panes_Sub->AppendCheckItem(menu_pane_xmlInspector, _("Raw XML monitor"));
   m_Maxima_Panes_Sub->AppendSeparator();
@@ -1640,6 +1657,9 @@ bool wxMaximaFrame::IsPaneDisplayed(Event id)
     case menu_pane_symbols:
       displayed = m_manager.GetPane(wxT("symbols")).IsShown();
       break;
+    case menu_pane_performance:
+      displayed = m_manager.GetPane(wxT("performance")).IsShown();
+      break;
     case menu_pane_format:
       displayed = m_manager.GetPane(wxT("format")).IsShown();
       break;
@@ -1663,6 +1683,7 @@ void wxMaximaFrame::DockAllSidebars(wxCommandEvent & WXUNUSED(ev))
   m_manager.GetPane(wxT("stats")).Dock();
   m_manager.GetPane(wxT("greek")).Dock();
   m_manager.GetPane(wxT("log")).Dock();
+  m_manager.GetPane(wxT("performance")).Dock();
   m_manager.GetPane(wxT("unicode")).Dock();
   m_manager.GetPane(wxT("variables")).Dock();
   m_manager.GetPane(wxT("symbols")).Dock();
@@ -1686,6 +1707,7 @@ void wxMaximaFrame::ShowPane(Event id, bool show)
       m_manager.GetPane(wxT("greek")).Show(false);
       m_manager.GetPane(wxT("unicode")).Show(false);
       m_manager.GetPane(wxT("log")).Show(false);
+      m_manager.GetPane(wxT("performance")).Show(false);
       m_manager.GetPane(wxT("variables")).Show(false);
       m_manager.GetPane(wxT("draw")).Show(false);
       m_manager.GetPane(wxT("symbols")).Show(false);
@@ -1728,6 +1750,9 @@ void wxMaximaFrame::ShowPane(Event id, bool show)
     case menu_pane_symbols:
       m_manager.GetPane(wxT("symbols")).Show(show);
       break;
+    case menu_pane_performance:
+      m_manager.GetPane(wxT("performance")).Show(show);
+      break;
     case menu_pane_stats:
       m_manager.GetPane(wxT("stats")).Show(show);
       break;
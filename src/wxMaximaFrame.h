@@ -48,6 +48,7 @@ surrounding the worksheet.
 #include "MainMenuBar.h"
 #include "History.h"
 #include "XmlInspector.h"
+#include "PerformancePane.h"
 #include "StatusBar.h"
 #include "LogPane.h"
 #include "ButtonWrapSizer.h"
@@ -110,6 +111,7 @@ public:
     menu_pane_variables, //!< Both the "toggle the variables pane" command and the "variables" pane
     menu_pane_draw,      //!< Both the "toggle the draw pane" command for the "draw" pane
     menu_pane_symbols,   //!< Both the "toggle the symbols pane" command for the "symbols" pane
+    menu_pane_performance, //!< Both the "toggle the performance pane" command and the "performance" pane
     /*! Both used as the "toggle the stats pane" command and as the ID of the stats pane
 
       Since this enum is also used for iterating over the panes it is vital 
@@ -39,14 +39,19 @@ GroupCell::GroupCell(const GroupCell &cell) : GroupCell(cell.m_configuration, ce
 GroupCell::GroupCell(GroupCell *WXUNUSED(cell1), const GroupCell &cell) : GroupCell(cell.m_configuration, cell.m_groupType) {}
 GroupCell::~GroupCell() {}
 wxString GroupCell::ToString() const { return {}; }
+void GroupCell::AppendString(wxString &) const {}
 bool GroupCell::NeedsRecalculation(AFontSize) const { return {}; }
+bool GroupCell::HasEstimatedSize() const { return {}; }
+bool GroupCell::HasEstimatedSizeIn(const wxRect &) const { return {}; }
 void GroupCell::Draw(wxPoint) {}
 wxRect GroupCell::GetRect(bool) const { return {}; }
 void GroupCell::Recalculate() {}
 void GroupCell::Hide(bool) {}
 wxString GroupCell::ToXML() const { return {}; }
+void GroupCell::AppendXML(wxString &) const {}
 wxString GroupCell::ToTeX() const { return {}; }
 wxString GroupCell::ToRTF() const { return {}; }
+void GroupCell::AppendRTF(wxString &) const {}
 Cell::Range GroupCell::GetInnerCellsInRect(const wxRect &) const { return {}; }
 const wxString &GroupCell::GetToolTip(wxPoint) const { return wxm::emptyString; }
 bool GroupCell::AddEnding() { return {}; }
@@ -0,0 +1,72 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "ManualAnchors.cpp"
+#include <catch2/catch.hpp>
+#include <cstring>
+
+SCENARIO("ManualAnchors finds the keyword anchors of the manual") {
+  GIVEN("Anchors of the current and of older manuals") {
+    const char html[] =
+      "<p><span id=\"diff\"></span><span id=\"index-diff\"></span>\n"
+      "<a name=\"g_t_0025solve\"></a> text <span id=\"bar\" class=\"x\">\n"
+      "<span id=\"foo_002d1\"></span><span id=\"is_005f\"></span><span id=\"";
+    ManualAnchors::List anchors;
+    ManualAnchors::Scan(html, std::strlen(html), anchors);
+    THEN("Only anchors that describe a keyword are found, in order") {
+      REQUIRE(anchors.size() == 4);
+      REQUIRE(anchors[0].first == wxT("diff"));
+      REQUIRE(anchors[0].second == wxT("diff"));
+      REQUIRE(anchors[1].first == wxT("%solve"));
+      REQUIRE(anchors[1].second == wxT("g_t_0025solve"));
+      REQUIRE(anchors[2].first == wxT("bar"));
+      REQUIRE(anchors[2].second == wxT("bar"));
+      REQUIRE(anchors[3].first == wxT("is_"));
+      REQUIRE(anchors[3].second == wxT("is_005f"));
+    }
+  }
+  GIVEN("Anchors whose tags aren't complete") {
+    const char html[] =
+      "<span id=\"broken\" class=\"x\"\n<span id=\"unquoted>\n<span id=\"ok\">";
+    ManualAnchors::List anchors;
+    ManualAnchors::Scan(html, std::strlen(html), anchors);
+    THEN("Only the complete tag is used") {
+      REQUIRE(anchors.size() == 1);
+      REQUIRE(anchors[0].first == wxT("ok"));
+    }
+  }
+}
+
+SCENARIO("ManualAnchors decodes escaped chars in anchors") {
+  REQUIRE(ManualAnchors::KeywordFromId("_003c_003d", 10) == wxT("<="));
+  REQUIRE(ManualAnchors::KeywordFromId("a_0020b", 7) == wxT("a_0020b"));
+  REQUIRE(ManualAnchors::KeywordFromId("Function-and-Variable-Index", 27).IsEmpty());
+  REQUIRE(ManualAnchors::KeywordFromId("g_tplot2d", 9) == wxT("plot2d"));
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
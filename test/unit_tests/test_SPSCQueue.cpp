@@ -0,0 +1,92 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2022 The wxMaxima developers
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "SPSCQueue.h"
+#include <catch2/catch.hpp>
+#include <string>
+#include <thread>
+
+SCENARIO("An SPSCQueue hands out elements in order") {
+  GIVEN("An empty queue") {
+    SPSCQueue<std::string, 4> queue;
+    std::string value;
+    REQUIRE(queue.IsEmpty());
+    REQUIRE(!queue.Pop(value));
+
+    WHEN("Elements are pushed") {
+      REQUIRE(queue.Push("a"));
+      REQUIRE(queue.Push("b"));
+      REQUIRE(queue.Push("c"));
+      THEN("It reports being full before it overwrites anything") {
+        std::string d = "d";
+        REQUIRE(!queue.Push(std::move(d)));
+        REQUIRE(d == "d");
+      }
+      THEN("They are popped in the order they were pushed") {
+        REQUIRE(queue.Pop(value));
+        REQUIRE(value == "a");
+        REQUIRE(queue.Pop(value));
+        REQUIRE(value == "b");
+        REQUIRE(queue.Push("d"));
+        REQUIRE(queue.Pop(value));
+        REQUIRE(value == "c");
+        REQUIRE(queue.Pop(value));
+        REQUIRE(value == "d");
+        REQUIRE(queue.IsEmpty());
+      }
+    }
+  }
+}
+
+SCENARIO("An SPSCQueue transports data between two threads") {
+  SPSCQueue<int, 16> queue;
+  constexpr int count = 100000;
+  std::thread producer([&queue]{
+    for (int i = 0; i < count; i++)
+      while (!queue.Push(int(i)))
+        std::this_thread::yield();
+  });
+  int expected = 0;
+  bool inOrder = true;
+  while (expected < count)
+  {
+    int value;
+    if (queue.Pop(value))
+    {
+      inOrder = inOrder && (value == expected);
+      expected++;
+    }
+    else
+      std::this_thread::yield();
+  }
+  producer.join();
+  REQUIRE(inOrder);
+  REQUIRE(queue.IsEmpty());
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, const char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
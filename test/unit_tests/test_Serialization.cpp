@@ -0,0 +1,143 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#include <wx/log.h>
+
+wxLogNull dontLog;
+
+#define CATCH_CONFIG_RUNNER
+#include "FontAttribs.cpp"
+#include "FontCache.cpp"
+#include "StringUtils.cpp"
+#include "TestStubs.cpp"
+#include "TextCell.cpp"
+#include "TextStyle.cpp"
+#include "VisiblyInvalidCell.cpp"
+
+#include "SqrtCell.cpp"
+
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+//! The number of bytes allocated while g_countAllocations is set
+static std::atomic<std::size_t> g_allocatedBytes{0};
+static std::atomic<bool> g_countAllocations{false};
+
+void *operator new(std::size_t size)
+{
+  if (g_countAllocations)
+    g_allocatedBytes += size;
+  if (void *ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+void Configuration::SetZoomFactor(double newzoom)
+{
+  if (newzoom > GetMaxZoomFactor())
+    newzoom = GetMaxZoomFactor();
+  if (newzoom < GetMinZoomFactor())
+    newzoom = GetMinZoomFactor();
+
+  m_zoomFactor = newzoom;
+}
+
+//! Creates depth square roots nested into each other around an "x"
+static std::unique_ptr<Cell> NestedRoots(GroupCell *group, Configuration **config, int depth)
+{
+  std::unique_ptr<Cell> cell = std::make_unique<TextCell>(group, config, wxT("x"));
+  for (int i = 0; i < depth; i++)
+    cell = std::make_unique<SqrtCell>(group, config, std::move(cell));
+  return cell;
+}
+
+//! The number of bytes serialize allocates while converting cell
+static std::size_t BytesAllocated(const Cell *cell,
+                                  const std::function<wxString(const Cell *)> &serialize)
+{
+  g_allocatedBytes = 0;
+  g_countAllocations = true;
+  wxString result = serialize(cell);
+  g_countAllocations = false;
+  REQUIRE(!result.empty());
+  return g_allocatedBytes;
+}
+
+SCENARIO("Serializing nested cells allocates linearly in the nesting depth") {
+  wxBitmap bitmap(128, 128);
+  wxMemoryDC dc(bitmap);
+  Configuration configuration(&dc);
+  configuration.SetZoomFactor(1.0);
+
+  Configuration *pConfig = &configuration;
+  Configuration **config = &pConfig;
+  GroupCell group(config, GC_TYPE_TEXT);
+
+  // Concatenating the result of every nesting level would copy the
+  // inner text once per level, which makes the allocated bytes grow
+  // with the square of the depth: doubling the depth quadruples them.
+  // Appending to one buffer only doubles them.
+  constexpr int depth = 400;
+  auto const shallow = NestedRoots(&group, config, depth);
+  auto const deep = NestedRoots(&group, config, 2 * depth);
+
+  std::vector<std::pair<const char *, std::function<wxString(const Cell *)>>> const formats = {
+    {"TeX", [](const Cell *cell) { return cell->ListToTeX(); }},
+    {"XML", [](const Cell *cell) { return cell->ListToXML(); }},
+    {"MathML", [](const Cell *cell) { return cell->ListToMathML(); }},
+    {"OMML", [](const Cell *cell) { return cell->ListToOMML(); }},
+    {"String", [](const Cell *cell) { return cell->ListToString(); }},
+  };
+
+  for (auto const &format : formats)
+    GIVEN(std::string("a ") + format.first + " serialization")
+    {
+      auto const shallowBytes = BytesAllocated(shallow.get(), format.second);
+      auto const deepBytes = BytesAllocated(deep.get(), format.second);
+      INFO(format.first << ": " << shallowBytes << " bytes at depth " << depth
+           << ", " << deepBytes << " bytes at depth " << 2 * depth);
+      THEN("doubling the depth less than triples the allocated bytes")
+        REQUIRE(deepBytes < 3 * shallowBytes);
+    }
+}
+
+class MyApp : public wxApp
+{
+public:
+  Catch::Session catchSession;
+  int OnRun() override {
+    return catchSession.run();
+  }
+};
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, char *argv[])
+{
+  auto *app = new MyApp;
+  app->catchSession.applyCommandLine(argc, argv);
+  return wxEntry(argc, argv);
+}